@@ -94,6 +94,10 @@ extern int32_t tsElectInterval;
 extern int32_t tsHeartbeatInterval;
 extern int32_t tsHeartbeatTimeout;
 extern int32_t tsSnapReplMaxWaitN;
+extern int32_t tsSyncBatchEntries;
+extern int32_t tsSyncBatchBytes;
+extern int32_t tsSyncLeaderLeaseMs;
+extern bool    tsSyncSnapCompress;
 
 // arbitrator
 extern int32_t tsArbHeartBeatIntervalSec;
@@ -155,6 +159,10 @@ extern char    *tsSvrCrashReportUri;
 extern int32_t tsQueryBufferSize;  // maximum allowed usage buffer size in MB for each data node during query processing
 extern int64_t tsQueryBufferSizeBytes;    // maximum allowed usage buffer size in byte for each data node
 extern int32_t tsCacheLazyLoadThreshold;  // cost threshold for last/last_row loading cache as much as possible
+extern bool    tsMetaPrefixKey;           // prefix compress the keys of the meta name and tag indexes of new vnodes
+extern bool    tsLastCacheWarmup;         // warm up the last cache in background at vnode start
+extern char    tsLastCacheWarmupStbs[];   // super tables to warm up, empty means all
+extern int32_t tsLastCacheWarmupRate;     // tables per second of the warm up, 0 means no limit
 
 // query client
 extern int32_t tsQueryPolicy;
@@ -231,6 +239,16 @@ extern int64_t tsmaDataDeleteMark;
 
 // wal
 extern int64_t tsWalFsyncDataSizeLimit;
+extern int32_t tsWalPreallocSize;
+extern int32_t tsWalSegmentPoolSize;
+extern char    tsWalCompressor[];
+extern int32_t tsWalCompressMinSize;
+extern int32_t tsWalReplayDecodeAhead;
+extern int32_t tsWalTailCacheSize;
+
+// tsdb
+extern bool    tsTsdbDirectWrite;
+extern int32_t tsTsdbDirectWriteSyncPages;
 
 // internal
 extern int32_t tsTransPullupInterval;
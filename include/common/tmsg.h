@@ -1683,6 +1683,7 @@ typedef struct {
   int64_t numOfBatchInsertSuccessReqs;
   int32_t numOfCachedTables;
   int32_t learnerProgress;  // use one reservered
+  int32_t cacheWarmupProgress;
 } SVnodeLoad;
 
 typedef struct {
@@ -36,8 +36,9 @@ extern "C" {
 #define CACHESCAN_RETRIEVE_LAST_ROW    0x4
 #define CACHESCAN_RETRIEVE_LAST        0x8
 
-#define META_READER_LOCK   0x0
-#define META_READER_NOLOCK 0x1
+#define META_READER_LOCK     0x0
+#define META_READER_NOLOCK   0x1
+#define META_READER_SNAPSHOT 0x2  // read a snapshot of meta instead of holding the meta lock
 
 #define STREAM_STATE_BUFF_HASH 1
 #define STREAM_STATE_BUFF_SORT 2
@@ -86,6 +87,7 @@ typedef struct SMetaEntry {
 typedef struct SMetaReader {
   int32_t            flags;
   void*              pMeta;
+  void*              pSnap;
   SDecoder           coder;
   SMetaEntry         me;
   void*              pBuf;
@@ -254,6 +256,8 @@ typedef struct SStoreMeta {
 
   int32_t (*getTableTags)(void* pVnode, uint64_t suid, SArray* uidList);
   int32_t (*getTableTagsByUid)(void* pVnode, int64_t suid, SArray* uidList);
+  // tag columns of the tables in uidList, or of all child tables if it is empty, from the columnar tag store
+  int32_t (*getTableTagCols)(void* pVnode, uint64_t suid, SArray* pColList, SArray* uidList, SSDataBlock** ppBlock);
   const void* (*extractTagVal)(const void* tag, int16_t type, STagVal* tagVal);  // todo remove it
 
   int32_t (*getTableUidByName)(void* pVnode, char* tbName, uint64_t* uid);
@@ -265,10 +269,11 @@ typedef struct SStoreMeta {
   int32_t (*metaPutTbGroupToCache)(void* pVnode, uint64_t suid, const void* pKey, int32_t keyLen, void* pPayload,
                                    int32_t payloadLen);
 
+  // pChanged gets the child tables changed since the cached list was computed, pVer the version to put it back with
   int32_t (*getCachedTableList)(void* pVnode, tb_uid_t suid, const uint8_t* pKey, int32_t keyLen, SArray* pList1,
-                                bool* acquireRes);
+                                bool* acquireRes, SArray* pChanged, int64_t* pVer);
   int32_t (*putCachedTableList)(void* pVnode, uint64_t suid, const void* pKey, int32_t keyLen, void* pPayload,
-                                int32_t payloadLen, double selectivityRatio);
+                                int32_t payloadLen, double selectivityRatio, int64_t ver);
 
   void* (*storeGetIndexInfo)(void *pVnode);
   void* (*getInvertIndex)(void* pVnode);
@@ -187,6 +187,20 @@ SIndexTerm* indexTermCreate(int64_t suid, SIndexOperOnColumn operType, uint8_t c
                             int32_t nColName, const char* colVal, int32_t nColVal);
 void        indexTermDestroy(SIndexTerm* p);
 
+/*
+ * merge of index caches into tfiles
+ */
+typedef struct SIndexMergeStat {
+  int64_t nMerge;       // merges finished
+  int64_t nMergeFail;   // merges failed
+  int64_t mergeTimeUs;  // total time spent in merges
+  int64_t nInFlight;    // merges scheduled but not finished
+  int64_t nStall;       // writes blocked until a merge finished
+  int64_t stallTimeUs;  // total time writes were blocked
+} SIndexMergeStat;
+
+void indexGetMergeStat(SIndex* index, SIndexMergeStat* pStat);
+
 /*
  * rebuild index
  */
@@ -43,6 +43,13 @@ extern "C" {
 #define WAL_FILE_LEN      (WAL_PATH_LEN + 32)
 #define WAL_MAGIC         0xFAFBFCFDF4F3F2F1ULL
 #define WAL_SCAN_BUF_SIZE (1024 * 1024 * 3)
+#define WAL_SEG_POOL_MAX  16
+#define WAL_SPARSE_IDX_STEP  16
+#define WAL_SPARSE_IDX_FILES 8
+
+// the high nibble of SWalCont.protoVer keeps the L2 codec of a compressed body, whose first 4 bytes are the raw length
+#define WAL_BODY_CODEC(protoVer)       (((uint8_t)(protoVer)) >> 4)
+#define WAL_PROTO_WITH_CODEC(ver, alg) ((int8_t)(((alg) << 4) | ((ver)&0x0F)))
 
 typedef enum {
   TAOS_WAL_SKIP = 0,
@@ -120,6 +127,22 @@ typedef struct SWal {
   // ctl
   int64_t       refId;
   TdThreadMutex mutex;
+  // segment pool, bit i is set if recycle slot i holds a preallocated segment
+  int64_t segPoolMask;
+  // body compression, L2 codec or L2_UNKNOWN if disabled
+  uint8_t compressAlg;
+  // read cache, segments readers have open and the hot tail of the write file
+  TdThreadRwlock segRefLock;
+  SArray        *pSegRefs;  // SArray<SWalSegRef>, a pooled segment must not be one of them
+  TdThreadRwlock tailLock;
+  char          *tailBuf;
+  int64_t        tailCap;
+  int64_t        tailFileFirstVer;
+  int64_t        tailStart;
+  int64_t        tailLen;
+  // sparse version -> offset index of the most recent segments
+  TdThreadRwlock sparseIdxLock;
+  SArray        *pSparseIdx;  // SArray<SWalSparseIdx>
   // ref
   SHashObj *pRefHash;  // refId -> SWalRef
   // path
@@ -153,6 +176,7 @@ struct SWalReader {
   TdFilePtr pIdxFile;
   int64_t   curFileFirstVer;
   int64_t   curVersion;
+  int64_t   curOffset;
   int64_t skipToVersion;  // skip data and jump to destination version, usually used by stream resume ignoring untreated
                           // data
   int64_t        capacity;
@@ -182,7 +206,7 @@ int32_t walWriteWithSyncInfo(SWal *, int64_t index, tmsg_t msgType, SWalSyncInfo
 // -1 will be returned for failed writes
 int64_t walAppendLog(SWal *, int64_t index, tmsg_t msgType, SWalSyncInfo syncMeta, const void *body, int32_t bodyLen);
 
-void walFsync(SWal *, bool force);
+int32_t walFsync(SWal *, bool force);
 
 // apis for lifecycle management
 int32_t walCommit(SWal *, int64_t ver);
@@ -65,6 +65,7 @@ typedef struct TdFile *TdFilePtr;
 #define TD_FILE_STREAM        0x0100  // Only support taosFprintfFile, taosGetLineFile, taosEOFFile
 #define TD_FILE_WRITE_THROUGH 0x0200
 #define TD_FILE_CLOEXEC       0x0400
+#define TD_FILE_DIRECT        0x0800  // Bypass page cache, buffers/offsets/sizes must be aligned
 
 TdFilePtr taosOpenFile(const char *path, int32_t tdFileOptions);
 TdFilePtr taosCreateFile(const char *path, int32_t tdFileOptions);
@@ -90,6 +91,12 @@ bool    taosCheckExistFile(const char *pathname);
 int64_t taosLSeekFile(TdFilePtr pFile, int64_t offset, int32_t whence);
 int32_t taosFtruncateFile(TdFilePtr pFile, int64_t length);
 int32_t taosFsyncFile(TdFilePtr pFile);
+int32_t taosFdatasyncFile(TdFilePtr pFile);
+int32_t taosFallocateFile(TdFilePtr pFile, int64_t offset, int64_t len);
+
+// read only shared mapping of the first size bytes, NULL if mapping is not possible
+void   *taosMmapReadOnlyFile(TdFilePtr pFile, int64_t size);
+int32_t taosMunmapFile(void *ptr, int64_t size);
 
 int64_t taosReadFile(TdFilePtr pFile, void *buf, int64_t count);
 int64_t taosPReadFile(TdFilePtr pFile, void *buf, int64_t count, int64_t offset);
@@ -111,6 +118,7 @@ int32_t taosRemoveFile(const char *path);
 void taosGetTmpfilePath(const char *inputTmpDir, const char *fileNamePrefix, char *dstPath);
 
 int64_t taosFSendFile(TdFilePtr pFileOut, TdFilePtr pFileIn, int64_t *offset, int64_t size);
+int64_t taosFCopyFileRange(TdFilePtr pFileOut, TdFilePtr pFileIn, int64_t *offset, int64_t size);
 
 bool taosValidFile(TdFilePtr pFile);
 
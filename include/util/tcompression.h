@@ -245,6 +245,8 @@ typedef struct {
   __data_decompress_l2_fn_t decomprFn;
 } TCmprL2FnSet;
 
+extern TCmprL2FnSet compressL2Dict[];
+
 typedef enum {
   L1_UNKNOWN = 0,
   L1_SIMPLE_8B,
@@ -278,6 +280,7 @@ typedef struct {
 } TCmprLvlSet;
 
 int32_t tcompressDebug(uint32_t cmprAlg, uint8_t *l1Alg, uint8_t *l2Alg, uint8_t *level);
+int8_t  tsGetCompressL2Level(uint8_t alg, uint8_t lvl);
 
 #define DEFINE_VAR(cmprAlg)                   \
   uint8_t l1 = COMPRESS_L1_TYPE_U32(cmprAlg); \
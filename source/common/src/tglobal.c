@@ -81,6 +81,12 @@ int32_t tsElectInterval = 25 * 1000;
 int32_t tsHeartbeatInterval = 1000;
 int32_t tsHeartbeatTimeout = 20 * 1000;
 int32_t tsSnapReplMaxWaitN = 128;
+// raft entries coalesced into one append entries msg, 1 means no batching. Followers older than batching assert
+// that a msg holds one entry, so raise it only once every replica runs a version that splits them.
+int32_t tsSyncBatchEntries = 1;
+int32_t tsSyncBatchBytes = 1024 * 1024;  // size limit of a batched append entries msg
+int32_t tsSyncLeaderLeaseMs = 0;         // leader lease renewed by heartbeat acks, 0 means disabled
+bool    tsSyncSnapCompress = false;      // compress snapshot blocks sent to receivers supporting it
 
 // mnode
 int64_t tsMndSdbWriteDelta = 200;
@@ -220,6 +226,10 @@ char    tsTagFilterCache = 0;
 int32_t tsQueryBufferSize = -1;
 int64_t tsQueryBufferSizeBytes = -1;
 int32_t tsCacheLazyLoadThreshold = 500;
+bool    tsMetaPrefixKey = false;
+bool    tsLastCacheWarmup = false;        // load last cache of super tables in background at vnode start
+char    tsLastCacheWarmupStbs[1024] = "";  // comma separated super table names to warm up, empty means all
+int32_t tsLastCacheWarmupRate = 10000;    // tables per second of each vnode, 0 means no limit
 
 int32_t  tsDiskCfgNum = 0;
 SDiskCfg tsDiskCfg[TFS_MAX_DISKS] = {0};
@@ -263,6 +273,16 @@ bool    tsStartUdfd = true;
 
 // wal
 int64_t tsWalFsyncDataSizeLimit = (100 * 1024 * 1024L);
+int32_t tsWalPreallocSize = 0;          // MB reserved for each new wal segment, 0 means disabled
+int32_t tsWalSegmentPoolSize = 2;       // number of removed wal segments kept for reuse
+char    tsWalCompressor[16] = "none";   // none, lz4 or zstd
+int32_t tsWalCompressMinSize = 4096;    // bodies smaller than this are stored raw
+int32_t tsWalReplayDecodeAhead = 1024;  // submits decoded ahead of apply during replay, 0 means disabled
+int32_t tsWalTailCacheSize = 1024;      // KB, last bytes of the write file kept for readers, 0 means disabled
+
+// tsdb
+bool    tsTsdbDirectWrite = false;         // write data/stt/head files with O_DIRECT, reads stay buffered
+int32_t tsTsdbDirectWriteSyncPages = 256;  // fdatasync after this many direct pages, 0 means only on commit
 
 // ttl
 bool    tsTtlChangeOnWrite = false;  // if true, ttl delete time changes on last write
@@ -688,6 +708,10 @@ static int32_t taosAddServerCfg(SConfig *pCfg) {
   if (cfgAddInt32(pCfg, "syncHeartbeatInterval", tsHeartbeatInterval, 10, 1000 * 60 * 24 * 2, CFG_SCOPE_SERVER, CFG_DYN_NONE) != 0) return -1;
   if (cfgAddInt32(pCfg, "syncHeartbeatTimeout", tsHeartbeatTimeout, 10, 1000 * 60 * 24 * 2, CFG_SCOPE_SERVER, CFG_DYN_NONE) != 0) return -1;
   if (cfgAddInt32(pCfg, "syncSnapReplMaxWaitN", tsSnapReplMaxWaitN, 16, (TSDB_SYNC_SNAP_BUFFER_SIZE >> 2), CFG_SCOPE_SERVER, CFG_DYN_NONE) != 0) return -1;
+  if (cfgAddInt32(pCfg, "syncBatchEntries", tsSyncBatchEntries, 1, (TSDB_SYNC_LOG_BUFFER_SIZE >> 4), CFG_SCOPE_SERVER, CFG_DYN_ENT_SERVER) != 0) return -1;
+  if (cfgAddInt32(pCfg, "syncBatchBytes", tsSyncBatchBytes, 1024, TSDB_MAX_MSG_SIZE >> 1, CFG_SCOPE_SERVER, CFG_DYN_ENT_SERVER) != 0) return -1;
+  if (cfgAddInt32(pCfg, "syncLeaderLeaseMs", tsSyncLeaderLeaseMs, 0, 60 * 1000, CFG_SCOPE_SERVER, CFG_DYN_NONE) != 0) return -1;
+  if (cfgAddBool(pCfg, "syncSnapCompress", tsSyncSnapCompress, CFG_SCOPE_SERVER, CFG_DYN_ENT_SERVER) != 0) return -1;
 
   if (cfgAddInt32(pCfg, "arbHeartBeatIntervalSec", tsArbHeartBeatIntervalSec, 1, 60 * 24 * 2, CFG_SCOPE_SERVER, CFG_DYN_NONE) != 0) return -1;
   if (cfgAddInt32(pCfg, "arbCheckSyncIntervalSec", tsArbCheckSyncIntervalSec, 1, 60 * 24 * 2, CFG_SCOPE_SERVER, CFG_DYN_NONE) != 0) return -1;
@@ -747,6 +771,14 @@ static int32_t taosAddServerCfg(SConfig *pCfg) {
   if (cfgAddInt32(pCfg, "timeseriesThreshold", tsTimeSeriesThreshold, 0, 2000, CFG_SCOPE_SERVER, CFG_DYN_ENT_SERVER) != 0) return -1;
 
   if (cfgAddInt64(pCfg, "walFsyncDataSizeLimit", tsWalFsyncDataSizeLimit, 100 * 1024 * 1024, INT64_MAX, CFG_SCOPE_SERVER, CFG_DYN_NONE) != 0) return -1;
+  if (cfgAddInt32(pCfg, "walPreallocSize", tsWalPreallocSize, 0, 1024, CFG_SCOPE_SERVER, CFG_DYN_ENT_SERVER) != 0) return -1;
+  if (cfgAddInt32(pCfg, "walSegmentPoolSize", tsWalSegmentPoolSize, 0, 16, CFG_SCOPE_SERVER, CFG_DYN_ENT_SERVER) != 0) return -1;
+  if (cfgAddString(pCfg, "walCompressor", tsWalCompressor, CFG_SCOPE_SERVER, CFG_DYN_NONE) != 0) return -1;
+  if (cfgAddInt32(pCfg, "walCompressMinSize", tsWalCompressMinSize, 64, INT32_MAX, CFG_SCOPE_SERVER, CFG_DYN_ENT_SERVER) != 0) return -1;
+  if (cfgAddInt32(pCfg, "walReplayDecodeAhead", tsWalReplayDecodeAhead, 0, 65536, CFG_SCOPE_SERVER, CFG_DYN_ENT_SERVER) != 0) return -1;
+  if (cfgAddInt32(pCfg, "walTailCacheSize", tsWalTailCacheSize, 0, 1024 * 1024, CFG_SCOPE_SERVER, CFG_DYN_NONE) != 0) return -1;
+  if (cfgAddBool(pCfg, "tsdbDirectWrite", tsTsdbDirectWrite, CFG_SCOPE_SERVER, CFG_DYN_NONE) != 0) return -1;
+  if (cfgAddInt32(pCfg, "tsdbDirectWriteSyncPages", tsTsdbDirectWriteSyncPages, 0, INT32_MAX, CFG_SCOPE_SERVER, CFG_DYN_ENT_SERVER) != 0) return -1;
 
   if (cfgAddBool(pCfg, "udf", tsStartUdfd, CFG_SCOPE_SERVER, CFG_DYN_NONE) != 0) return -1;
   if (cfgAddString(pCfg, "udfdResFuncs", tsUdfdResFuncs, CFG_SCOPE_SERVER, CFG_DYN_NONE) != 0) return -1;
@@ -761,6 +793,10 @@ static int32_t taosAddServerCfg(SConfig *pCfg) {
   if (cfgAddInt32(pCfg, "concurrentCheckpoint", tsMaxConcurrentCheckpoint, 1, 10, CFG_SCOPE_SERVER, CFG_DYN_ENT_SERVER) != 0) return -1;
 
   if (cfgAddInt32(pCfg, "cacheLazyLoadThreshold", tsCacheLazyLoadThreshold, 0, 100000, CFG_SCOPE_SERVER, CFG_DYN_ENT_SERVER) != 0) return -1;
+  if (cfgAddBool(pCfg, "metaPrefixKey", tsMetaPrefixKey, CFG_SCOPE_SERVER, CFG_DYN_NONE) != 0) return -1;
+  if (cfgAddBool(pCfg, "lastCacheWarmup", tsLastCacheWarmup, CFG_SCOPE_SERVER, CFG_DYN_NONE) != 0) return -1;
+  if (cfgAddString(pCfg, "lastCacheWarmupStbs", tsLastCacheWarmupStbs, CFG_SCOPE_SERVER, CFG_DYN_NONE) != 0) return -1;
+  if (cfgAddInt32(pCfg, "lastCacheWarmupRate", tsLastCacheWarmupRate, 0, INT32_MAX, CFG_SCOPE_SERVER, CFG_DYN_ENT_SERVER) != 0) return -1;
 
   if (cfgAddFloat(pCfg, "fPrecision", tsFPrecision, 0.0f, 100000.0f, CFG_SCOPE_SERVER, CFG_DYN_NONE) != 0) return -1;
   if (cfgAddFloat(pCfg, "dPrecision", tsDPrecision, 0.0f, 1000000.0f, CFG_SCOPE_SERVER, CFG_DYN_NONE) != 0) return -1;
@@ -1196,11 +1232,23 @@ static int32_t taosSetServerCfg(SConfig *pCfg) {
   tsTimeSeriesThreshold = cfgGetItem(pCfg, "timeseriesThreshold")->i32;
 
   tsWalFsyncDataSizeLimit = cfgGetItem(pCfg, "walFsyncDataSizeLimit")->i64;
+  tsWalPreallocSize = cfgGetItem(pCfg, "walPreallocSize")->i32;
+  tsWalSegmentPoolSize = cfgGetItem(pCfg, "walSegmentPoolSize")->i32;
+  tstrncpy(tsWalCompressor, cfgGetItem(pCfg, "walCompressor")->str, sizeof(tsWalCompressor));
+  tsWalCompressMinSize = cfgGetItem(pCfg, "walCompressMinSize")->i32;
+  tsWalReplayDecodeAhead = cfgGetItem(pCfg, "walReplayDecodeAhead")->i32;
+  tsWalTailCacheSize = cfgGetItem(pCfg, "walTailCacheSize")->i32;
+  tsTsdbDirectWrite = cfgGetItem(pCfg, "tsdbDirectWrite")->bval;
+  tsTsdbDirectWriteSyncPages = cfgGetItem(pCfg, "tsdbDirectWriteSyncPages")->i32;
 
   tsElectInterval = cfgGetItem(pCfg, "syncElectInterval")->i32;
   tsHeartbeatInterval = cfgGetItem(pCfg, "syncHeartbeatInterval")->i32;
   tsHeartbeatTimeout = cfgGetItem(pCfg, "syncHeartbeatTimeout")->i32;
   tsSnapReplMaxWaitN = cfgGetItem(pCfg, "syncSnapReplMaxWaitN")->i32;
+  tsSyncBatchEntries = cfgGetItem(pCfg, "syncBatchEntries")->i32;
+  tsSyncBatchBytes = cfgGetItem(pCfg, "syncBatchBytes")->i32;
+  tsSyncLeaderLeaseMs = cfgGetItem(pCfg, "syncLeaderLeaseMs")->i32;
+  tsSyncSnapCompress = cfgGetItem(pCfg, "syncSnapCompress")->bval;
 
   tsArbHeartBeatIntervalSec = cfgGetItem(pCfg, "arbHeartBeatIntervalSec")->i32;
   tsArbCheckSyncIntervalSec = cfgGetItem(pCfg, "arbCheckSyncIntervalSec")->i32;
@@ -1219,6 +1267,10 @@ static int32_t taosSetServerCfg(SConfig *pCfg) {
   }
 
   tsCacheLazyLoadThreshold = cfgGetItem(pCfg, "cacheLazyLoadThreshold")->i32;
+  tsMetaPrefixKey = cfgGetItem(pCfg, "metaPrefixKey")->bval;
+  tsLastCacheWarmup = cfgGetItem(pCfg, "lastCacheWarmup")->bval;
+  tstrncpy(tsLastCacheWarmupStbs, cfgGetItem(pCfg, "lastCacheWarmupStbs")->str, sizeof(tsLastCacheWarmupStbs));
+  tsLastCacheWarmupRate = cfgGetItem(pCfg, "lastCacheWarmupRate")->i32;
 
   tsFPrecision = cfgGetItem(pCfg, "fPrecision")->fval;
   tsDPrecision = cfgGetItem(pCfg, "dPrecision")->fval;
@@ -1573,6 +1625,15 @@ static int32_t taosCfgDynamicOptionsForServer(SConfig *pCfg, const char *name) {
                                          {"ttlBatchDropNum", &tsTtlBatchDropNum},
                                          {"ttlFlushThreshold", &tsTtlFlushThreshold},
                                          {"ttlPushInterval", &tsTtlPushIntervalSec},
+                                         {"tsdbDirectWriteSyncPages", &tsTsdbDirectWriteSyncPages},
+                                         {"walPreallocSize", &tsWalPreallocSize},
+                                         {"walSegmentPoolSize", &tsWalSegmentPoolSize},
+                                         {"walCompressMinSize", &tsWalCompressMinSize},
+                                         {"walReplayDecodeAhead", &tsWalReplayDecodeAhead},
+                                         {"syncBatchEntries", &tsSyncBatchEntries},
+                                         {"syncBatchBytes", &tsSyncBatchBytes},
+                                         {"syncSnapCompress", &tsSyncSnapCompress},
+                                         {"lastCacheWarmupRate", &tsLastCacheWarmupRate},
                                          {"s3MigrateIntervalSec", &tsS3MigrateIntervalSec},
                                          {"s3MigrateEnabled", &tsS3MigrateEnabled},
                                          //{"s3BlockSize", &tsS3BlockSize},
@@ -1329,7 +1329,7 @@ int32_t tSerializeSStatusReq(void *buf, int32_t bufLen, SStatusReq *pReq) {
     SVnodeLoad *pload = taosArrayGet(pReq->pVloads, i);
     int64_t     reserved = 0;
     if (tEncodeI64(&encoder, pload->syncTerm) < 0) return -1;
-    if (tEncodeI64(&encoder, reserved) < 0) return -1;
+    if (tEncodeI64(&encoder, pload->cacheWarmupProgress) < 0) return -1;
     if (tEncodeI64(&encoder, reserved) < 0) return -1;
     if (tEncodeI64(&encoder, reserved) < 0) return -1;
   }
@@ -1388,6 +1388,7 @@ int32_t tDeserializeSStatusReq(void *buf, int32_t bufLen, SStatusReq *pReq) {
   for (int32_t i = 0; i < vlen; ++i) {
     SVnodeLoad vload = {0};
     vload.syncTerm = -1;
+    vload.cacheWarmupProgress = -1;
 
     if (tDecodeI32(&decoder, &vload.vgId) < 0) return -1;
     if (tDecodeI8(&decoder, &vload.syncState) < 0) return -1;
@@ -1448,6 +1449,7 @@ int32_t tDeserializeSStatusReq(void *buf, int32_t bufLen, SStatusReq *pReq) {
       int64_t     reserved = 0;
       if (tDecodeI64(&decoder, &pLoad->syncTerm) < 0) return -1;
       if (tDecodeI64(&decoder, &reserved) < 0) return -1;
+      pLoad->cacheWarmupProgress = (int32_t)reserved;
       if (tDecodeI64(&decoder, &reserved) < 0) return -1;
       if (tDecodeI64(&decoder, &reserved) < 0) return -1;
     }
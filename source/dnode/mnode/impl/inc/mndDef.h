@@ -429,6 +429,7 @@ typedef struct {
   int64_t    startTimeMs;
   ESyncRole  nodeRole;
   int32_t    learnerProgress;
+  int32_t    cacheWarmupProgress;
 } SVnodeGid;
 
 typedef struct {
@@ -704,6 +704,7 @@ static int32_t mndProcessStatusReq(SRpcMsg *pReq) {
             pVload->roleTimeMs = statusReq.rebootTime;
           }
           stateChanged = mndUpdateVnodeState(pVgroup->vgId, pGid, pVload);
+          pGid->cacheWarmupProgress = pVload->cacheWarmupProgress;
           break;
         }
       }
@@ -1182,6 +1182,11 @@ static int32_t mndRetrieveVnodes(SRpcMsg *pReq, SShowObj *pShow, SSDataBlock *pB
       pColInfo = taosArrayGet(pBlock->pDataBlock, cols++);
       colDataSetVal(pColInfo, numOfRows, (const char *)&pGid->syncRestore, false);
 
+      // percent of tables whose last cache is loaded, null when no warm up runs
+      int32_t cacheWarmup = (isDnodeOnline) ? pGid->cacheWarmupProgress : -1;
+      pColInfo = taosArrayGet(pBlock->pDataBlock, cols++);
+      colDataSetVal(pColInfo, numOfRows, (const char *)&cacheWarmup, cacheWarmup < 0);
+
       numOfRows++;
       sdbRelease(pSdb, pDnode);
     }
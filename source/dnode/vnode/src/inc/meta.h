@@ -27,6 +27,7 @@ extern "C" {
 typedef struct SMetaIdx   SMetaIdx;
 typedef struct SMetaDB    SMetaDB;
 typedef struct SMetaCache SMetaCache;
+typedef struct SMetaTagStore SMetaTagStore;
 
 // metaDebug ==================
 // clang-format off
@@ -42,6 +43,9 @@ typedef struct SMetaCache SMetaCache;
 int32_t metaRLock(SMeta* pMeta);
 int32_t metaWLock(SMeta* pMeta);
 int32_t metaULock(SMeta* pMeta);
+// read a snapshot of meta, falls back to the read lock and returns NULL if no snapshot can be taken
+TXN* metaSnapshotBegin(SMeta* pMeta);
+void metaSnapshotEnd(SMeta* pMeta, TXN* pSnap);
 
 // metaEntry ==================
 int metaEncodeEntry(SEncoder* pCoder, const SMetaEntry* pME);
@@ -74,6 +78,14 @@ int32_t metaStatsCacheGet(SMeta* pMeta, int64_t uid, SMetaStbStats* pInfo);
 void    metaUpdateStbStats(SMeta* pMeta, int64_t uid, int64_t deltaCtb, int32_t deltaCol);
 int32_t metaUidFilterCacheGet(SMeta* pMeta, uint64_t suid, const void* pKey, int32_t keyLen, LRUHandle** pHandle);
 
+// metaTagStore ==================
+int32_t metaTagStoreOpen(SMeta* pMeta);
+void    metaTagStoreClose(SMeta* pMeta);
+void    metaTagStoreReset(SMeta* pMeta);
+void    metaTagStoreUpsert(SMeta* pMeta, tb_uid_t suid, tb_uid_t uid, const STag* pTag);
+void    metaTagStoreDrop(SMeta* pMeta, tb_uid_t suid, tb_uid_t uid);
+void    metaTagStoreClear(SMeta* pMeta, tb_uid_t suid);
+
 struct SMeta {
   TdThreadRwlock lock;
 
@@ -104,7 +116,8 @@ struct SMeta {
 
   SMetaIdx* pIdx;
 
-  SMetaCache* pCache;
+  SMetaCache*    pCache;
+  SMetaTagStore* pTagStore;
 };
 
 typedef struct {
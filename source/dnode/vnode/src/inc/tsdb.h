@@ -355,7 +355,15 @@ typedef struct {
   int    flush_count;
 } SCacheFlushState;
 
+// progress of the last cache warm up, read by the vnode load without holding the warm up itself
+typedef struct {
+  int8_t  scheduled;
+  int64_t total;   // tables scheduled
+  int64_t loaded;  // tables done
+} SCacheWarmupStat;
+
 typedef struct SCompMonitor SCompMonitor;
+typedef struct SCacheWarmup SCacheWarmup;
 
 struct STsdb {
   char *               path;
@@ -377,6 +385,8 @@ struct STsdb {
   TdThreadMutex        pgMutex;
   struct STFileSystem *pFS;  // new
   SRocksCache          rCache;
+  SCacheWarmup        *pWarmup;
+  SCacheWarmupStat     warmupStat;
   SCompMonitor         *pCompMonitor;
   struct {
     SVHashTable *ht;
@@ -665,6 +675,8 @@ typedef struct {
   int32_t     fid;
   int64_t     cid;
   int64_t     blkno;
+  uint8_t     directIO;   // opened with TD_FILE_DIRECT, pBuf is aligned
+  int32_t     nUnsynced;  // direct pages written since last fdatasync
 } STsdbFD;
 
 struct SDelFWriter {
@@ -937,6 +949,7 @@ int32_t tsdbOpenCache(STsdb *pTsdb);
 void    tsdbCloseCache(STsdb *pTsdb);
 int32_t tsdbCacheRowFormatUpdate(STsdb *pTsdb, tb_uid_t suid, tb_uid_t uid, int64_t version, int32_t nRow, SRow **aRow);
 int32_t tsdbCacheColFormatUpdate(STsdb *pTsdb, tb_uid_t suid, tb_uid_t uid, SBlockData *pBlockData);
+int32_t tsdbCacheUpdateOrBatch(STsdb *pTsdb, tb_uid_t suid, tb_uid_t uid, SArray *updCtxArray);
 int32_t tsdbCacheDel(STsdb *pTsdb, tb_uid_t suid, tb_uid_t uid, TSKEY sKey, TSKEY eKey);
 
 int32_t tsdbCacheInsertLast(SLRUCache *pCache, tb_uid_t uid, TSDBROW *row, STsdb *pTsdb);
@@ -955,6 +968,9 @@ int32_t tsdbCacheDeleteLastrow(SLRUCache *pCache, tb_uid_t uid, TSKEY eKey);
 int32_t tsdbCacheDeleteLast(SLRUCache *pCache, tb_uid_t uid, TSKEY eKey);
 int32_t tsdbCacheDelete(SLRUCache *pCache, tb_uid_t uid, TSKEY eKey);
 
+// tsdbCacheRead.c
+int32_t tsdbCacherowsReaderLoad(void *pReader, int32_t type);
+
 // ========== inline functions ==========
 static FORCE_INLINE int32_t tsdbKeyCmprFn(const void *p1, const void *p2) {
   TSDBKEY *pKey1 = (TSDBKEY *)p1;
@@ -127,6 +127,13 @@ bool    vnodeShouldRollback(SVnode* pVnode);
 int64_t vnodeClusterId(SVnode* pVnode);
 int32_t vnodeNodeId(SVnode* pVnode);
 int32_t vnodeSyncOpen(SVnode* pVnode, char* path, int32_t vnodeVersion);
+// vnodeReplay.c
+int32_t      vnodeReplayOpen(SVnode* pVnode);
+void         vnodeReplayClose(SVnode* pVnode);
+void         vnodeReplayDecodeAhead(SVnode* pVnode, const SRpcMsg* pMsg, int64_t ver);
+SSubmitReq2* vnodeReplayTake(SVnode* pVnode, int64_t ver);
+void         vnodeReplayDrop(SVnode* pVnode, int64_t ver);
+
 int32_t vnodeSyncStart(SVnode* pVnode);
 void    vnodeSyncPreClose(SVnode* pVnode);
 void    vnodeSyncPostClose(SVnode* pVnode);
@@ -22,6 +22,7 @@ extern const int   tkAuditStbNum;
 #endif
 
 #define TAG_FILTER_RES_KEY_LEN  32
+#define TAG_FILTER_MAX_CHANGES  4096
 #define META_CACHE_BASE_BUCKET  1024
 #define META_CACHE_STATS_BUCKET 16
 
@@ -42,8 +43,22 @@ typedef struct SMetaStbStatsEntry {
 typedef struct STagFilterResEntry {
   SList    list;      // the linked list of md5 digest, extracted from the serialized tag query condition
   uint32_t hitTimes;  // queried times for current super table
+  int64_t  ver;       // bumped by each child table created, altered or dropped
+  int64_t  minVer;    // changes up to it are forgotten, a result computed before it is not cached
+  SArray*  pChanged;  // STagFilterChange, child tables changed since the oldest cached uid list was computed
 } STagFilterResEntry;
 
+// list item of the uid list cache, the digest of the tag condition and the version the uid list is computed at
+typedef struct STagFilterResKey {
+  uint64_t digest[2];
+  int64_t  ver;
+} STagFilterResKey;
+
+typedef struct STagFilterChange {
+  int64_t  ver;
+  tb_uid_t uid;
+} STagFilterChange;
+
 struct SMetaCache {
   // child, normal, super, table entry cache
   struct SEntryCache {
@@ -113,6 +128,7 @@ static void statsCacheClose(SMeta* pMeta) {
 static void freeCacheEntryFp(void* param) {
   STagFilterResEntry** p = param;
   tdListEmpty(&(*p)->list);
+  taosArrayDestroy((*p)->pChanged);
   taosMemoryFreeClear(*p);
 }
 
@@ -525,8 +541,25 @@ static void initCacheKey(uint64_t* buf, const SHashObj* pHashMap, uint64_t suid,
   ASSERT(keyLen == sizeof(uint64_t) * 2);
 }
 
+static STagFilterResKey* uidCacheFindKey(STagFilterResEntry* pEntry, const uint64_t* digest) {
+  SListIter iter = {0};
+  tdListInitIter(&pEntry->list, &iter, TD_LIST_FORWARD);
+
+  SListNode* pNode = NULL;
+  while ((pNode = tdListNext(&iter)) != NULL) {
+    STagFilterResKey* pKey = (STagFilterResKey*)pNode->data;
+    if (pKey->digest[0] == digest[0] && pKey->digest[1] == digest[1]) {
+      return pKey;
+    }
+  }
+
+  return NULL;
+}
+
+// the cached uid list is returned along with the child tables changed since it was computed, the caller evaluates the
+// tag condition on them again and puts the refreshed list back with the returned version
 int32_t metaGetCachedTableUidList(void* pVnode, tb_uid_t suid, const uint8_t* pKey, int32_t keyLen, SArray* pList1,
-                                  bool* acquireRes) {
+                                  bool* acquireRes, SArray* pChanged, int64_t* pVer) {
   SMeta*  pMeta = ((SVnode*)pVnode)->pMeta;
   int32_t vgId = TD_VID(pMeta->pVnode);
 
@@ -542,6 +575,9 @@ int32_t metaGetCachedTableUidList(void* pVnode, tb_uid_t suid, const uint8_t* pK
   taosThreadMutexLock(pLock);
   pMeta->pCache->sTagFilterResCache.accTimes += 1;
 
+  STagFilterResEntry** pEntry = taosHashGet(pTableMap, &suid, sizeof(uint64_t));
+  *pVer = (pEntry != NULL) ? (*pEntry)->ver : 0;
+
   LRUHandle* pHandle = taosLRUCacheLookup(pCache, key, TAG_FILTER_RES_KEY_LEN);
   if (pHandle == NULL) {
     taosThreadMutexUnlock(pLock);
@@ -549,8 +585,10 @@ int32_t metaGetCachedTableUidList(void* pVnode, tb_uid_t suid, const uint8_t* pK
   }
 
   // do some book mark work after acquiring the filter result from cache
-  STagFilterResEntry** pEntry = taosHashGet(pTableMap, &suid, sizeof(uint64_t));
-  if (NULL == pEntry) {
+  STagFilterResKey* pResKey = (pEntry != NULL) ? uidCacheFindKey(*pEntry, (const uint64_t*)pKey) : NULL;
+  if (NULL == pResKey) {
+    taosLRUCacheRelease(pCache, pHandle, false);
+    taosThreadMutexUnlock(pLock);
     metaError("meta/cache: pEntry should not be NULL.");
     return TSDB_CODE_FAILED;
   }
@@ -563,6 +601,15 @@ int32_t metaGetCachedTableUidList(void* pVnode, tb_uid_t suid, const uint8_t* pK
   // set the result into the buffer
   taosArrayAddBatch(pList1, p + sizeof(int32_t), size);
 
+  // the change list is ordered by version
+  int32_t nChange = taosArrayGetSize((*pEntry)->pChanged);
+  for (int32_t i = 0; i < nChange; i++) {
+    STagFilterChange* pChange = taosArrayGet((*pEntry)->pChanged, i);
+    if (pChange->ver > pResKey->ver) {
+      taosArrayPush(pChanged, &pChange->uid);
+    }
+  }
+
   (*pEntry)->hitTimes += 1;
 
   uint32_t acc = pMeta->pCache->sTagFilterResCache.accTimes;
@@ -625,15 +672,43 @@ static int32_t addNewEntry(SHashObj* pTableEntry, const void* pKey, int32_t keyL
   }
 
   p->hitTimes = 0;
+  p->ver = 0;
+  p->minVer = 0;
+  p->pChanged = NULL;
   tdListInit(&p->list, keyLen);
   taosHashPut(pTableEntry, &suid, sizeof(uint64_t), &p, POINTER_BYTES);
-  tdListAppend(&p->list, pKey);
+  if (pKey != NULL) {
+    tdListAppend(&p->list, pKey);
+  }
   return 0;
 }
 
+// forget the changes that every cached uid list has seen already
+static void uidCacheTrimChanges(STagFilterResEntry* pEntry) {
+  int64_t   minVer = pEntry->ver;
+  SListIter iter = {0};
+  tdListInitIter(&pEntry->list, &iter, TD_LIST_FORWARD);
+
+  SListNode* pNode = NULL;
+  while ((pNode = tdListNext(&iter)) != NULL) {
+    minVer = TMIN(minVer, ((STagFilterResKey*)pNode->data)->ver);
+  }
+
+  int32_t nChange = taosArrayGetSize(pEntry->pChanged);
+  int32_t nTrim = 0;
+  while (nTrim < nChange && ((STagFilterChange*)taosArrayGet(pEntry->pChanged, nTrim))->ver <= minVer) {
+    nTrim++;
+  }
+
+  if (nTrim > 0) {
+    taosArrayPopFrontBatch(pEntry->pChanged, nTrim);
+  }
+  pEntry->minVer = TMAX(pEntry->minVer, minVer);
+}
+
 // check both the payload size and selectivity ratio
 int32_t metaUidFilterCachePut(void* pVnode, uint64_t suid, const void* pKey, int32_t keyLen, void* pPayload,
-                              int32_t payloadLen, double selectivityRatio) {
+                              int32_t payloadLen, double selectivityRatio, int64_t ver) {
   int32_t code = 0;
   SMeta*  pMeta = ((SVnode*)pVnode)->pMeta;
   int32_t vgId = TD_VID(pMeta->pVnode);
@@ -664,30 +739,40 @@ int32_t metaUidFilterCachePut(void* pVnode, uint64_t suid, const void* pKey, int
   taosThreadMutexLock(pLock);
   STagFilterResEntry** pEntry = taosHashGet(pTableEntry, &suid, sizeof(uint64_t));
   if (pEntry == NULL) {
-    code = addNewEntry(pTableEntry, pKey, keyLen, suid);
+    code = addNewEntry(pTableEntry, NULL, sizeof(STagFilterResKey), suid);
     if (code != TSDB_CODE_SUCCESS) {
+      taosMemoryFree(pPayload);
       goto _end;
     }
-  } else {  // check if it exists or not
-    size_t size = listNEles(&(*pEntry)->list);
-    if (size == 0) {
-      tdListAppend(&(*pEntry)->list, pKey);
-    } else {
-      SListNode* pNode = listHead(&(*pEntry)->list);
-      uint64_t*  p = (uint64_t*)pNode->data;
-      if (p[1] == ((uint64_t*)pKey)[1] && p[0] == ((uint64_t*)pKey)[0]) {
-        // we have already found the existed items, no need to added to cache anymore.
-        taosThreadMutexUnlock(pLock);
-        return TSDB_CODE_SUCCESS;
-      } else {  // not equal, append it
-        tdListAppend(&(*pEntry)->list, pKey);
-      }
+    pEntry = taosHashGet(pTableEntry, &suid, sizeof(uint64_t));
+  }
+
+  // computed before the changes that are not tracked anymore
+  if (ver < (*pEntry)->minVer) {
+    taosMemoryFree(pPayload);
+    goto _end;
+  }
+
+  STagFilterResKey* pResKey = uidCacheFindKey(*pEntry, pKey);
+  if (pResKey != NULL) {
+    if (pResKey->ver >= ver) {
+      // we have already found the existed items, no need to added to cache anymore.
+      taosMemoryFree(pPayload);
+      goto _end;
     }
+
+    // a refreshed uid list replaces the older one, its list item is removed along with it
+    taosLRUCacheErase(pCache, key, TAG_FILTER_RES_KEY_LEN);
   }
 
+  STagFilterResKey resKey = {.digest = {((uint64_t*)pKey)[0], ((uint64_t*)pKey)[1]}, .ver = ver};
+  tdListAppend(&(*pEntry)->list, &resKey);
+
   // add to cache.
   (void)taosLRUCacheInsert(pCache, key, TAG_FILTER_RES_KEY_LEN, pPayload, payloadLen, freeUidCachePayload, NULL,
                            TAOS_LRU_PRIORITY_LOW, NULL);
+  uidCacheTrimChanges(*pEntry);
+
 _end:
   taosThreadMutexUnlock(pLock);
   metaDebug("vgId:%d, suid:%" PRIu64 " list cache added into cache, total:%d, tables:%d", vgId, suid,
@@ -696,39 +781,100 @@ _end:
   return code;
 }
 
-// remove the lru cache that are expired due to the tags value update, or creating, or dropping, of child tables
-int32_t metaUidCacheClear(SMeta* pMeta, uint64_t suid) {
-  uint64_t  p[4] = {0};
-  int32_t   vgId = TD_VID(pMeta->pVnode);
-  SHashObj* pEntryHashMap = pMeta->pCache->sTagFilterResCache.pTableEntry;
-
+static void uidCacheClearImpl(SMeta* pMeta, uint64_t suid, STagFilterResEntry* pEntry) {
+  uint64_t p[4] = {0};
   uint64_t dummy[2] = {0};
-  initCacheKey(p, pEntryHashMap, suid, (char*)&dummy[0], 16);
+  initCacheKey(p, pMeta->pCache->sTagFilterResCache.pTableEntry, suid, (char*)&dummy[0], 16);
+
+  pEntry->hitTimes = 0;
+
+  SListIter iter = {0};
+  tdListInitIter(&pEntry->list, &iter, TD_LIST_FORWARD);
+
+  SListNode* pNode = NULL;
+  while ((pNode = tdListNext(&iter)) != NULL) {
+    setMD5DigestInKey(p, pNode->data, 2 * sizeof(uint64_t));
+    taosLRUCacheErase(pMeta->pCache->sTagFilterResCache.pUidResCache, p, TAG_FILTER_RES_KEY_LEN);
+  }
+
+  tdListEmpty(&pEntry->list);
+
+  // a uid list computed before now would miss the changes dropped here
+  pEntry->ver += 1;
+  pEntry->minVer = pEntry->ver;
+  taosArrayClear(pEntry->pChanged);
+}
 
+// remove the lru cache that are expired due to the super table being dropped
+int32_t metaUidCacheClear(SMeta* pMeta, uint64_t suid) {
+  int32_t        vgId = TD_VID(pMeta->pVnode);
+  SHashObj*      pEntryHashMap = pMeta->pCache->sTagFilterResCache.pTableEntry;
   TdThreadMutex* pLock = &pMeta->pCache->sTagFilterResCache.lock;
   taosThreadMutexLock(pLock);
 
   STagFilterResEntry** pEntry = taosHashGet(pEntryHashMap, &suid, sizeof(uint64_t));
-  if (pEntry == NULL || listNEles(&(*pEntry)->list) == 0) {
+  if (pEntry == NULL) {
     taosThreadMutexUnlock(pLock);
     return TSDB_CODE_SUCCESS;
   }
 
-  (*pEntry)->hitTimes = 0;
+  uidCacheClearImpl(pMeta, suid, *pEntry);
+  taosThreadMutexUnlock(pLock);
 
-  SListIter iter = {0};
-  tdListInitIter(&(*pEntry)->list, &iter, TD_LIST_FORWARD);
+  metaDebug("vgId:%d suid:%" PRId64 " cached related tag filter uid list cleared", vgId, suid);
+  return TSDB_CODE_SUCCESS;
+}
 
-  SListNode* pNode = NULL;
-  while ((pNode = tdListNext(&iter)) != NULL) {
-    setMD5DigestInKey(p, pNode->data, 2 * sizeof(uint64_t));
-    taosLRUCacheErase(pMeta->pCache->sTagFilterResCache.pUidResCache, p, TAG_FILTER_RES_KEY_LEN);
+// the child table is created, altered or dropped. The cached uid lists of its super table are kept, and only this
+// table is evaluated again when they are hit
+int32_t metaUidCacheUpdate(SMeta* pMeta, uint64_t suid, tb_uid_t uid) {
+  int32_t        vgId = TD_VID(pMeta->pVnode);
+  SHashObj*      pEntryHashMap = pMeta->pCache->sTagFilterResCache.pTableEntry;
+  TdThreadMutex* pLock = &pMeta->pCache->sTagFilterResCache.lock;
+  taosThreadMutexLock(pLock);
+
+  // the entry is kept even without a cached list, so that a list being computed right now is known to be stale
+  STagFilterResEntry** pEntry = taosHashGet(pEntryHashMap, &suid, sizeof(uint64_t));
+  if (pEntry == NULL) {
+    int32_t code = addNewEntry(pEntryHashMap, NULL, sizeof(STagFilterResKey), suid);
+    if (code != TSDB_CODE_SUCCESS) {
+      taosThreadMutexUnlock(pLock);
+      return code;
+    }
+    pEntry = taosHashGet(pEntryHashMap, &suid, sizeof(uint64_t));
   }
 
-  tdListEmpty(&(*pEntry)->list);
-  taosThreadMutexUnlock(pLock);
+  STagFilterResEntry* p = *pEntry;
+  p->ver += 1;
+
+  if (listNEles(&p->list) == 0) {
+    // no cached list to keep up to date
+    p->minVer = p->ver;
+    taosArrayClear(p->pChanged);
+  } else if (taosArrayGetSize(p->pChanged) >= TAG_FILTER_MAX_CHANGES) {
+    // too many tables to evaluate one by one, start over
+    uidCacheClearImpl(pMeta, suid, p);
+    metaDebug("vgId:%d suid:%" PRId64 " too many child tables changed, cached tag filter uid list cleared", vgId,
+              suid);
+  } else {
+    if (p->pChanged == NULL) {
+      p->pChanged = taosArrayInit(16, sizeof(STagFilterChange));
+      if (p->pChanged == NULL) {
+        uidCacheClearImpl(pMeta, suid, p);
+        taosThreadMutexUnlock(pLock);
+        return TSDB_CODE_OUT_OF_MEMORY;
+      }
+    }
 
-  metaDebug("vgId:%d suid:%" PRId64 " cached related tag filter uid list cleared", vgId, suid);
+    STagFilterChange change = {.ver = p->ver, .uid = uid};
+    if (taosArrayPush(p->pChanged, &change) == NULL) {
+      uidCacheClearImpl(pMeta, suid, p);
+      taosThreadMutexUnlock(pLock);
+      return TSDB_CODE_OUT_OF_MEMORY;
+    }
+  }
+
+  taosThreadMutexUnlock(pLock);
   return TSDB_CODE_SUCCESS;
 }
 
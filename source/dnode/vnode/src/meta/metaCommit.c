@@ -63,12 +63,19 @@ int  metaPrepareAsyncCommit(SMeta *pMeta) {
 // abort the meta txn
 int metaAbort(SMeta *pMeta) {
   if (!pMeta->txn) return 0;
+
+  // readers without a snapshot must not see the pages reverted
+  metaWLock(pMeta);
   int code = tdbAbort(pMeta->pEnv, pMeta->txn);
+  metaULock(pMeta);
   if (code) {
     metaError("vgId:%d, failed to abort meta since %s", TD_VID(pMeta->pVnode), tstrerror(terrno));
   } else {
     pMeta->txn = NULL;
   }
 
+  // the tag store may hold values of the aborted txn
+  metaTagStoreReset(pMeta);
+
   return code;
 }
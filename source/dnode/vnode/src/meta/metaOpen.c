@@ -97,8 +97,9 @@ int metaOpen(SVnode *pVnode, SMeta **ppMeta, int8_t rollback) {
     goto _err;
   }
 
-  // open pNameIdx
-  ret = tdbTbOpen("name.idx", -1, sizeof(tb_uid_t), NULL, pMeta->pEnv, &pMeta->pNameIdx, 0);
+  // open pNameIdx, the page format of name.idx and tag.idx is set when they are created
+  int32_t idxFlags = tsMetaPrefixKey ? TDB_TB_PREFIX_KEY : 0;
+  ret = tdbTbOpenWithFlags("name.idx", -1, sizeof(tb_uid_t), NULL, pMeta->pEnv, &pMeta->pNameIdx, 0, idxFlags);
   if (ret < 0) {
     metaError("vgId:%d, failed to open meta name index since %s", TD_VID(pVnode), tstrerror(terrno));
     goto _err;
@@ -129,7 +130,7 @@ int metaOpen(SVnode *pVnode, SMeta **ppMeta, int8_t rollback) {
     goto _err;
   }
 
-  ret = tdbTbOpen("tag.idx", -1, 0, tagIdxKeyCmpr, pMeta->pEnv, &pMeta->pTagIdx, 0);
+  ret = tdbTbOpenWithFlags("tag.idx", -1, 0, tagIdxKeyCmpr, pMeta->pEnv, &pMeta->pTagIdx, 0, idxFlags);
   if (ret < 0) {
     metaError("vgId:%d, failed to open meta tag index since %s", TD_VID(pVnode), tstrerror(terrno));
     goto _err;
@@ -188,6 +189,16 @@ int metaOpen(SVnode *pVnode, SMeta **ppMeta, int8_t rollback) {
     goto _err;
   }
 
+  code = metaTagStoreOpen(pMeta);
+  if (code) {
+    terrno = code;
+    metaError("vgId:%d, failed to open meta tag store since %s", TD_VID(pVnode), tstrerror(terrno));
+    goto _err;
+  }
+
+  // readers can pin a snapshot of meta instead of waiting on the meta lock
+  tdbSnapshotEnable(pMeta->pEnv);
+
   metaDebug("vgId:%d, meta is opened", TD_VID(pVnode));
 
   *ppMeta = pMeta;
@@ -220,6 +231,7 @@ int metaUpgrade(SVnode *pVnode, SMeta **ppMeta) {
       metaError("vgId:%d, failed to upgrade meta ttl, meta commit failed since %s", TD_VID(pVnode), tstrerror(terrno));
       goto _err;
     }
+    metaSnapshotPublish(pMeta);
   }
 
   return TSDB_CODE_SUCCESS;
@@ -264,10 +276,31 @@ int32_t metaULock(SMeta *pMeta) {
   return ret;
 }
 
+// called by the writer once a whole write op is applied, snapshots taken from now on see it
+int metaSnapshotPublish(SMeta *pMeta) { return tdbSnapshotPublish(pMeta->pEnv); }
+
+TXN *metaSnapshotBegin(SMeta *pMeta) {
+  TXN *pSnap = NULL;
+  if (tdbSnapshotBegin(pMeta->pEnv, &pSnap) < 0) {
+    metaRLock(pMeta);
+    return NULL;
+  }
+  return pSnap;
+}
+
+void metaSnapshotEnd(SMeta *pMeta, TXN *pSnap) {
+  if (pSnap) {
+    tdbSnapshotEnd(pMeta->pEnv, pSnap);
+  } else {
+    metaULock(pMeta);
+  }
+}
+
 static void metaCleanup(SMeta **ppMeta) {
   SMeta *pMeta = *ppMeta;
   if (pMeta) {
     if (pMeta->pEnv) metaAbort(pMeta);
+    if (pMeta->pTagStore) metaTagStoreClose(pMeta);
     if (pMeta->pCache) metaCacheClose(pMeta);
 #ifdef BUILD_NO_CALL
     if (pMeta->pIdx) metaCloseIdx(pMeta);
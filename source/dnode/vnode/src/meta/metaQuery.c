@@ -27,7 +27,12 @@ void metaReaderDoInit(SMetaReader *pReader, SMeta *pMeta, int32_t flags) {
   memset(pReader, 0, sizeof(*pReader));
   pReader->pMeta = pMeta;
   pReader->flags = flags;
-  if (pReader->pMeta && !(flags & META_READER_NOLOCK)) {
+  if (pReader->pMeta && (flags & META_READER_SNAPSHOT)) {
+    pReader->pSnap = metaSnapshotBegin(pMeta);
+    if (pReader->pSnap) {
+      pReader->flags |= META_READER_NOLOCK;
+    }
+  } else if (pReader->pMeta && !(flags & META_READER_NOLOCK)) {
     metaRLock(pMeta);
   }
 }
@@ -43,6 +48,10 @@ void metaReaderClear(SMetaReader *pReader) {
   if (pReader->pMeta && !(pReader->flags & META_READER_NOLOCK)) {
     metaULock(pReader->pMeta);
   }
+  if (pReader->pSnap) {
+    tdbSnapshotEnd(((SMeta *)pReader->pMeta)->pEnv, pReader->pSnap);
+    pReader->pSnap = NULL;
+  }
   tDecoderClear(&pReader->coder);
   tdbFree(pReader->pBuf);
 }
@@ -52,7 +61,7 @@ int metaGetTableEntryByVersion(SMetaReader *pReader, int64_t version, tb_uid_t u
   STbDbKey tbDbKey = {.version = version, .uid = uid};
 
   // query table.db
-  if (tdbTbGet(pMeta->pTbDb, &tbDbKey, sizeof(tbDbKey), &pReader->pBuf, &pReader->szBuf) < 0) {
+  if (tdbTbGetWithTxn(pMeta->pTbDb, &tbDbKey, sizeof(tbDbKey), &pReader->pBuf, &pReader->szBuf, pReader->pSnap) < 0) {
     terrno = TSDB_CODE_PAR_TABLE_NOT_EXIST;
     goto _err;
   }
@@ -73,14 +82,14 @@ _err:
 
 bool metaIsTableExist(void *pVnode, tb_uid_t uid) {
   SVnode *pVnodeObj = pVnode;
-  metaRLock(pVnodeObj->pMeta);  // query uid.idx
+  TXN    *pSnap = metaSnapshotBegin(pVnodeObj->pMeta);  // query uid.idx
 
-  if (tdbTbGet(pVnodeObj->pMeta->pUidIdx, &uid, sizeof(uid), NULL, NULL) < 0) {
-    metaULock(pVnodeObj->pMeta);
+  if (tdbTbGetWithTxn(pVnodeObj->pMeta->pUidIdx, &uid, sizeof(uid), NULL, NULL, pSnap) < 0) {
+    metaSnapshotEnd(pVnodeObj->pMeta, pSnap);
     return false;
   }
 
-  metaULock(pVnodeObj->pMeta);
+  metaSnapshotEnd(pVnodeObj->pMeta, pSnap);
   return true;
 }
 
@@ -89,7 +98,7 @@ int metaReaderGetTableEntryByUid(SMetaReader *pReader, tb_uid_t uid) {
   int64_t version1;
 
   // query uid.idx
-  if (tdbTbGet(pMeta->pUidIdx, &uid, sizeof(uid), &pReader->pBuf, &pReader->szBuf) < 0) {
+  if (tdbTbGetWithTxn(pMeta->pUidIdx, &uid, sizeof(uid), &pReader->pBuf, &pReader->szBuf, pReader->pSnap) < 0) {
     terrno = TSDB_CODE_PAR_TABLE_NOT_EXIST;
     return -1;
   }
@@ -115,7 +124,7 @@ int metaGetTableEntryByName(SMetaReader *pReader, const char *name) {
   tb_uid_t uid;
 
   // query name.idx
-  if (tdbTbGet(pMeta->pNameIdx, name, strlen(name) + 1, &pReader->pBuf, &pReader->szBuf) < 0) {
+  if (tdbTbGetWithTxn(pMeta->pNameIdx, name, strlen(name) + 1, &pReader->pBuf, &pReader->szBuf, pReader->pSnap) < 0) {
     terrno = TSDB_CODE_PAR_TABLE_NOT_EXIST;
     return -1;
   }
@@ -129,14 +138,14 @@ tb_uid_t metaGetTableEntryUidByName(SMeta *pMeta, const char *name) {
   int      nData = 0;
   tb_uid_t uid = 0;
 
-  metaRLock(pMeta);
+  TXN *pSnap = metaSnapshotBegin(pMeta);
 
-  if (tdbTbGet(pMeta->pNameIdx, name, strlen(name) + 1, &pData, &nData) == 0) {
+  if (tdbTbGetWithTxn(pMeta->pNameIdx, name, strlen(name) + 1, &pData, &nData, pSnap) == 0) {
     uid = *(tb_uid_t *)pData;
     tdbFree(pData);
   }
 
-  metaULock(pMeta);
+  metaSnapshotEnd(pMeta, pSnap);
 
   return uid;
 }
@@ -144,7 +153,7 @@ tb_uid_t metaGetTableEntryUidByName(SMeta *pMeta, const char *name) {
 int metaGetTableNameByUid(void *pVnode, uint64_t uid, char *tbName) {
   int         code = 0;
   SMetaReader mr = {0};
-  metaReaderDoInit(&mr, ((SVnode *)pVnode)->pMeta, META_READER_LOCK);
+  metaReaderDoInit(&mr, ((SVnode *)pVnode)->pMeta, META_READER_SNAPSHOT);
   code = metaReaderGetTableEntryByUid(&mr, uid);
   if (code < 0) {
     metaReaderClear(&mr);
@@ -160,7 +169,7 @@ int metaGetTableNameByUid(void *pVnode, uint64_t uid, char *tbName) {
 int metaGetTableSzNameByUid(void *meta, uint64_t uid, char *tbName) {
   int         code = 0;
   SMetaReader mr = {0};
-  metaReaderDoInit(&mr, (SMeta *)meta, META_READER_LOCK);
+  metaReaderDoInit(&mr, (SMeta *)meta, META_READER_SNAPSHOT);
   code = metaReaderGetTableEntryByUid(&mr, uid);
   if (code < 0) {
     metaReaderClear(&mr);
@@ -175,12 +184,13 @@ int metaGetTableSzNameByUid(void *meta, uint64_t uid, char *tbName) {
 int metaGetTableUidByName(void *pVnode, char *tbName, uint64_t *uid) {
   int         code = 0;
   SMetaReader mr = {0};
-  metaReaderDoInit(&mr, ((SVnode *)pVnode)->pMeta, META_READER_LOCK);
+  metaReaderDoInit(&mr, ((SVnode *)pVnode)->pMeta, META_READER_SNAPSHOT);
 
   SMetaReader *pReader = &mr;
 
   // query name.idx
-  if (tdbTbGet(((SMeta *)pReader->pMeta)->pNameIdx, tbName, strlen(tbName) + 1, &pReader->pBuf, &pReader->szBuf) < 0) {
+  if (tdbTbGetWithTxn(((SMeta *)pReader->pMeta)->pNameIdx, tbName, strlen(tbName) + 1, &pReader->pBuf, &pReader->szBuf,
+                      pReader->pSnap) < 0) {
     terrno = TSDB_CODE_PAR_TABLE_NOT_EXIST;
     metaReaderClear(&mr);
     return -1;
@@ -196,7 +206,7 @@ int metaGetTableUidByName(void *pVnode, char *tbName, uint64_t *uid) {
 int metaGetTableTypeByName(void *pVnode, char *tbName, ETableType *tbType) {
   int         code = 0;
   SMetaReader mr = {0};
-  metaReaderDoInit(&mr, ((SVnode *)pVnode)->pMeta, META_READER_LOCK);
+  metaReaderDoInit(&mr, ((SVnode *)pVnode)->pMeta, META_READER_SNAPSHOT);
 
   code = metaGetTableEntryByName(&mr, tbName);
   if (code == 0) *tbType = mr.me.type;
@@ -216,7 +226,7 @@ int metaReadNext(SMetaReader *pReader) {
 int metaGetTableTtlByUid(void *meta, uint64_t uid, int64_t *ttlDays) {
   int         code = -1;
   SMetaReader mr = {0};
-  metaReaderDoInit(&mr, (SMeta *)meta, META_READER_LOCK);
+  metaReaderDoInit(&mr, (SMeta *)meta, META_READER_SNAPSHOT);
   code = metaReaderGetTableEntryByUid(&mr, uid);
   if (code < 0) {
     goto _exit;
@@ -1216,14 +1226,15 @@ int32_t metaFilterTableIds(void *pVnode, SMetaFltParam *arg, SArray *pUids) {
   pCursor->cid = param->cid;
   pCursor->type = param->type;
 
-  metaRLock(pMeta);
+  // the scan runs in a snapshot, table creation and commits go on meanwhile
+  TXN *pSnap = metaSnapshotBegin(pMeta);
 
-  if (tdbTbGet(pMeta->pUidIdx, &param->suid, sizeof(tb_uid_t), &pData, &nData) != 0) {
+  if (tdbTbGetWithTxn(pMeta->pUidIdx, &param->suid, sizeof(tb_uid_t), &pData, &nData, pSnap) != 0) {
     goto END;
   }
   tbDbKey.uid = param->suid;
   tbDbKey.version = ((SUidIdxVal *)pData)[0].version;
-  tdbTbGet(pMeta->pTbDb, &tbDbKey, sizeof(tbDbKey), &pData, &nData);
+  tdbTbGetWithTxn(pMeta->pTbDb, &tbDbKey, sizeof(tbDbKey), &pData, &nData, pSnap);
 
   tDecoderInit(&dc, pData, nData);
   ret = metaDecodeEntry(&dc, &oStbEntry);
@@ -1243,7 +1254,7 @@ int32_t metaFilterTableIds(void *pVnode, SMetaFltParam *arg, SArray *pUids) {
     goto END;
   }
 
-  ret = tdbTbcOpen(pMeta->pTagIdx, &pCursor->pCur, NULL);
+  ret = tdbTbcOpen(pMeta->pTagIdx, &pCursor->pCur, pSnap);
   if (ret != 0) {
     goto END;
   }
@@ -1351,8 +1362,8 @@ int32_t metaFilterTableIds(void *pVnode, SMetaFltParam *arg, SArray *pUids) {
   } while (1);
 
 END:
-  if (pCursor->pMeta) metaULock(pCursor->pMeta);
   if (pCursor->pCur) tdbTbcClose(pCursor->pCur);
+  metaSnapshotEnd(pMeta, pSnap);
   if (oStbEntry.pBuf) taosMemoryFree(oStbEntry.pBuf);
   tDecoderClear(&dc);
   tdbFree(pData);
@@ -1365,41 +1376,33 @@ END:
   return ret;
 }
 
-static int32_t metaGetTableTagByUid(SMeta *pMeta, int64_t suid, int64_t uid, void **tag, int32_t *len, bool lock) {
-  int ret = 0;
-  if (lock) {
-    metaRLock(pMeta);
-  }
-
+static int32_t metaGetTableTagByUid(SMeta *pMeta, int64_t suid, int64_t uid, void **tag, int32_t *len, TXN *pSnap) {
   SCtbIdxKey ctbIdxKey = {.suid = suid, .uid = uid};
-  ret = tdbTbGet(pMeta->pCtbIdx, &ctbIdxKey, sizeof(SCtbIdxKey), tag, len);
-  if (lock) {
-    metaULock(pMeta);
-  }
-
-  return ret;
+  return tdbTbGetWithTxn(pMeta->pCtbIdx, &ctbIdxKey, sizeof(SCtbIdxKey), tag, len, pSnap);
 }
 
 int32_t metaGetTableTagsByUids(void *pVnode, int64_t suid, SArray *uidList) {
   SMeta        *pMeta = ((SVnode *)pVnode)->pMeta;
   const int32_t LIMIT = 128;
 
+  TXN    *pSnap = NULL;
   int32_t isLock = false;
   int32_t sz = uidList ? taosArrayGetSize(uidList) : 0;
   for (int i = 0; i < sz; i++) {
     STUidTagInfo *p = taosArrayGet(uidList, i);
 
-    if (i % LIMIT == 0) {
-      if (isLock) metaULock(pMeta);
+    // a snapshot is pinned for the whole list, without one the lock is released every LIMIT tables
+    if (i % LIMIT == 0 && (i == 0 || !pSnap)) {
+      if (isLock) metaSnapshotEnd(pMeta, pSnap);
 
-      metaRLock(pMeta);
+      pSnap = metaSnapshotBegin(pMeta);
       isLock = true;
     }
 
     //    if (taosHashGet(tags, &p->uid, sizeof(tb_uid_t)) == NULL) {
     void   *val = NULL;
     int32_t len = 0;
-    if (metaGetTableTagByUid(pMeta, suid, p->uid, &val, &len, false) == 0) {
+    if (metaGetTableTagByUid(pMeta, suid, p->uid, &val, &len, pSnap) == 0) {
       p->pTagVal = taosMemoryMalloc(len);
       memcpy(p->pTagVal, val, len);
       tdbFree(val);
@@ -1409,7 +1412,7 @@ int32_t metaGetTableTagsByUids(void *pVnode, int64_t suid, SArray *uidList) {
     }
   }
   //  }
-  if (isLock) metaULock(pMeta);
+  if (isLock) metaSnapshotEnd(pMeta, pSnap);
   return 0;
 }
 
@@ -1475,6 +1478,20 @@ int32_t metaGetInfo(SMeta *pMeta, int64_t uid, SMetaInfo *pInfo, SMetaReader *pR
   int     nData = 0;
   int     lock = 0;
 
+  if (pReader && pReader->pSnap) {
+    // the cache follows the latest writes, a snapshot looks the table up in its own version and leaves the cache
+    if (tdbTbGetWithTxn(pMeta->pUidIdx, &uid, sizeof(uid), &pData, &nData, pReader->pSnap) < 0) {
+      code = TSDB_CODE_NOT_FOUND;
+      goto _exit;
+    }
+
+    pInfo->uid = uid;
+    pInfo->suid = ((SUidIdxVal *)pData)->suid;
+    pInfo->version = ((SUidIdxVal *)pData)->version;
+    pInfo->skmVer = ((SUidIdxVal *)pData)->skmVer;
+    goto _exit;
+  }
+
   if (pReader && !(pReader->flags & META_READER_NOLOCK)) {
     lock = 1;
   }
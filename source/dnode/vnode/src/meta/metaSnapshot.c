@@ -200,6 +200,7 @@ int32_t metaSnapWrite(SMetaSnapWriter* pWriter, uint8_t* pData, uint32_t nData)
 
   code = metaHandleEntry(pMeta, &metaEntry);
   VND_CHECK_CODE(code, line, _err);
+  metaSnapshotPublish(pMeta);
 
   tDecoderClear(pDecoder);
   return code;
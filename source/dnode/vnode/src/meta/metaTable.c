@@ -519,6 +519,9 @@ int metaAlterSTable(SMeta *pMeta, int64_t version, SVCreateStbReq *pReq) {
   // update uid index
   metaUpdateUidIdx(pMeta, &nStbEntry);
 
+  // tags may have been added, dropped or widened
+  metaTagStoreClear(pMeta, pReq->suid);
+
   // metaStatsCacheDrop(pMeta, nStbEntry.uid);
 
   if (updStat) {
@@ -944,7 +947,6 @@ int metaCreateTable(SMeta *pMeta, int64_t ver, SVCreateTbReq *pReq, STableMetaRs
 
     metaWLock(pMeta);
     metaUpdateStbStats(pMeta, me.ctbEntry.suid, 1, 0);
-    metaUidCacheClear(pMeta, me.ctbEntry.suid);
     metaTbGroupCacheClear(pMeta, me.ctbEntry.suid);
     metaULock(pMeta);
 
@@ -971,6 +973,11 @@ int metaCreateTable(SMeta *pMeta, int64_t ver, SVCreateTbReq *pReq, STableMetaRs
 
   if (metaHandleEntry(pMeta, &me) < 0) goto _err;
 
+  // the table is visible now, the cached tag filter results take it in when they are hit next time
+  if (me.type == TSDB_CHILD_TABLE) {
+    metaUidCacheUpdate(pMeta, me.ctbEntry.suid, me.uid);
+  }
+
   metaTimeSeriesNotifyCheck(pMeta);
 
   if (pMetaRsp) {
@@ -1004,6 +1011,428 @@ _err:
   return -1;
 }
 
+// batch create of child tables ======================
+// The child tables of one create or submit request are validated one by one as metaCreateTable does, then their
+// entries go into each table and index in key order, all under one write lock.
+
+typedef struct {
+  int32_t      iReq;
+  SMetaEntry   me;
+  STbDbKey     tbDbKey;
+  SUidIdxVal   uidIdxVal;
+  SCtbIdxKey   ctbIdxKey;
+  SBtimeIdxKey btimeKey;
+  void        *pVal;
+  int32_t      vLen;
+} SMetaNewCtb;
+
+typedef struct {
+  tb_uid_t suid;
+  int32_t  nCols;
+  int8_t   sysTbl;
+  int64_t  nNew;
+} SMetaNewCtbStb;
+
+static int32_t metaNewCtbCmpr(const void *p1, const void *p2) {
+  const SMetaNewCtb *pCtb1 = *(const SMetaNewCtb **)p1;
+  const SMetaNewCtb *pCtb2 = *(const SMetaNewCtb **)p2;
+
+  if (pCtb1->ctbIdxKey.suid != pCtb2->ctbIdxKey.suid) {
+    return pCtb1->ctbIdxKey.suid < pCtb2->ctbIdxKey.suid ? -1 : 1;
+  }
+  if (pCtb1->ctbIdxKey.uid != pCtb2->ctbIdxKey.uid) {
+    return pCtb1->ctbIdxKey.uid < pCtb2->ctbIdxKey.uid ? -1 : 1;
+  }
+  return 0;
+}
+
+static int metaEncodeNewCtb(SMetaNewCtb *pCtb) {
+  SEncoder coder = {0};
+  int32_t  ret = 0;
+
+  tEncodeSize(metaEncodeEntry, &pCtb->me, pCtb->vLen, ret);
+  if (ret < 0) return -1;
+
+  pCtb->pVal = taosMemoryMalloc(pCtb->vLen);
+  if (pCtb->pVal == NULL) {
+    terrno = TSDB_CODE_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  tEncoderInit(&coder, pCtb->pVal, pCtb->vLen);
+  ret = metaEncodeEntry(&coder, &pCtb->me);
+  tEncoderClear(&coder);
+
+  return ret;
+}
+
+// the tag.idx keys of the child tables of one super table, apCtb is sorted by suid
+static int metaBuildNewCtbTagIdx(SMeta *pMeta, SMetaNewCtb **apCtb, int32_t nCtb, SArray *aKV) {
+  tb_uid_t   suid = apCtb[0]->me.ctbEntry.suid;
+  void      *pData = NULL;
+  int        nData = 0;
+  STbDbKey   tbDbKey = {0};
+  SMetaEntry stbEntry = {0};
+  SDecoder   dc = {0};
+  int32_t    ret = 0;
+
+  // the super table entry is read once for all its new child tables
+  if (tdbTbGet(pMeta->pUidIdx, &suid, sizeof(tb_uid_t), &pData, &nData) != 0) {
+    metaError("vgId:%d, failed to get stable suid:%" PRId64 " for batch create", TD_VID(pMeta->pVnode), suid);
+    terrno = TSDB_CODE_TDB_INVALID_TABLE_ID;
+    ret = -1;
+    goto _exit;
+  }
+  tbDbKey.uid = suid;
+  tbDbKey.version = ((SUidIdxVal *)pData)[0].version;
+  tdbTbGet(pMeta->pTbDb, &tbDbKey, sizeof(tbDbKey), &pData, &nData);
+
+  tDecoderInit(&dc, pData, nData);
+  ret = metaDecodeEntry(&dc, &stbEntry);
+  if (ret < 0 || stbEntry.stbEntry.schemaTag.pSchema == NULL) {
+    goto _exit;
+  }
+
+  SSchemaWrapper *pTagSchema = &stbEntry.stbEntry.schemaTag;
+  if (pTagSchema->nCols == 1 && pTagSchema->pSchema[0].type == TSDB_DATA_TYPE_JSON) {
+    for (int32_t i = 0; i < nCtb; i++) {
+      ret = metaSaveJsonVarToIdx(pMeta, &apCtb[i]->me, &pTagSchema->pSchema[0]);
+      if (ret < 0) goto _exit;
+    }
+    goto _exit;
+  }
+
+  for (int32_t i = 0; i < nCtb; i++) {
+    const SMetaEntry *pME = &apCtb[i]->me;
+
+    for (int32_t iCol = 0; iCol < pTagSchema->nCols; iCol++) {
+      const SSchema *pTagColumn = &pTagSchema->pSchema[iCol];
+      const void    *pTagData = NULL;
+      int32_t        nTagData = 0;
+      STagIdxKey    *pTagIdxKey = NULL;
+      int32_t        nTagIdxKey = 0;
+
+      if (!IS_IDX_ON(pTagColumn)) continue;
+
+      STagVal tagVal = {.cid = pTagColumn->colId};
+      if (tTagGet((const STag *)pME->ctbEntry.pTags, &tagVal)) {
+        if (IS_VAR_DATA_TYPE(pTagColumn->type)) {
+          pTagData = tagVal.pData;
+          nTagData = (int32_t)tagVal.nData;
+        } else {
+          pTagData = &(tagVal.i64);
+          nTagData = tDataTypes[pTagColumn->type].bytes;
+        }
+      } else if (!IS_VAR_DATA_TYPE(pTagColumn->type)) {
+        nTagData = tDataTypes[pTagColumn->type].bytes;
+      }
+
+      if (metaCreateTagIdxKey(suid, pTagColumn->colId, pTagData, nTagData, pTagColumn->type, pME->uid, &pTagIdxKey,
+                              &nTagIdxKey) < 0) {
+        ret = -1;
+        goto _exit;
+      }
+
+      TKV kv = {.pKey = pTagIdxKey, .kLen = nTagIdxKey};
+      if (taosArrayPush(aKV, &kv) == NULL) {
+        taosMemoryFree(pTagIdxKey);
+        terrno = TSDB_CODE_OUT_OF_MEMORY;
+        ret = -1;
+        goto _exit;
+      }
+    }
+  }
+
+_exit:
+  tDecoderClear(&dc);
+  tdbFree(pData);
+  return ret;
+}
+
+static int metaSaveNewCtbs(SMeta *pMeta, SMetaNewCtb *aCtb, int32_t nCtb) {
+  SMetaNewCtb **apCtb = taosMemoryMalloc(nCtb * sizeof(SMetaNewCtb *));
+  TKV          *aKV = taosMemoryMalloc(nCtb * sizeof(TKV));
+  SArray       *aTagKV = taosArrayInit(nCtb, sizeof(TKV));
+  int32_t       code = 0;
+  int32_t       line = 0;
+
+  if (apCtb == NULL || aKV == NULL || aTagKV == NULL) {
+    terrno = TSDB_CODE_OUT_OF_MEMORY;
+    taosMemoryFree(apCtb);
+    taosMemoryFree(aKV);
+    taosArrayDestroy(aTagKV);
+    return -1;
+  }
+
+  for (int32_t i = 0; i < nCtb; i++) {
+    if (metaEncodeNewCtb(&aCtb[i]) < 0) {
+      code = -1;
+      line = __LINE__;
+      goto _exit;
+    }
+    apCtb[i] = &aCtb[i];
+  }
+  taosSort(apCtb, nCtb, sizeof(SMetaNewCtb *), metaNewCtbCmpr);
+
+  metaWLock(pMeta);
+
+  // save to table.db
+  for (int32_t i = 0; i < nCtb; i++) {
+    aKV[i] = (TKV){.pKey = &aCtb[i].tbDbKey, .kLen = sizeof(STbDbKey), .pVal = aCtb[i].pVal, .vLen = aCtb[i].vLen};
+  }
+  code = tdbTbPutBatch(pMeta->pTbDb, aKV, nCtb, pMeta->txn);
+  VND_CHECK_CODE(code, line, _unlock);
+
+  // update uid.idx
+  for (int32_t i = 0; i < nCtb; i++) {
+    SMetaInfo info;
+    metaGetEntryInfo(&aCtb[i].me, &info);
+    metaCacheUpsert(pMeta, &info);
+
+    aCtb[i].uidIdxVal = (SUidIdxVal){.suid = info.suid, .version = info.version, .skmVer = info.skmVer};
+    aKV[i] = (TKV){.pKey = &aCtb[i].me.uid, .kLen = sizeof(tb_uid_t), .pVal = &aCtb[i].uidIdxVal,
+                   .vLen = sizeof(SUidIdxVal)};
+  }
+  code = tdbTbPutBatch(pMeta->pUidIdx, aKV, nCtb, pMeta->txn);
+  VND_CHECK_CODE(code, line, _unlock);
+
+  // update name.idx
+  for (int32_t i = 0; i < nCtb; i++) {
+    aKV[i] = (TKV){.pKey = aCtb[i].me.name, .kLen = strlen(aCtb[i].me.name) + 1, .pVal = &aCtb[i].me.uid,
+                   .vLen = sizeof(tb_uid_t)};
+  }
+  code = tdbTbPutBatch(pMeta->pNameIdx, aKV, nCtb, pMeta->txn);
+  VND_CHECK_CODE(code, line, _unlock);
+
+  // update ctb.idx
+  for (int32_t i = 0; i < nCtb; i++) {
+    const SMetaEntry *pME = &aCtb[i].me;
+    aKV[i] = (TKV){.pKey = &aCtb[i].ctbIdxKey, .kLen = sizeof(SCtbIdxKey), .pVal = pME->ctbEntry.pTags,
+                   .vLen = ((STag *)(pME->ctbEntry.pTags))->len};
+  }
+  code = tdbTbPutBatch(pMeta->pCtbIdx, aKV, nCtb, pMeta->txn);
+  VND_CHECK_CODE(code, line, _unlock);
+  for (int32_t i = 0; i < nCtb; i++) {
+    metaTagStoreUpsert(pMeta, apCtb[i]->me.ctbEntry.suid, apCtb[i]->me.uid, (const STag *)apCtb[i]->me.ctbEntry.pTags);
+  }
+
+  // update tag.idx, the keys of all super tables are put in one batch
+  for (int32_t i = 0, j = 0; i < nCtb; i = j) {
+    for (j = i + 1; j < nCtb && apCtb[j]->me.ctbEntry.suid == apCtb[i]->me.ctbEntry.suid; j++) {
+    }
+    code = metaBuildNewCtbTagIdx(pMeta, apCtb + i, j - i, aTagKV);
+    VND_CHECK_CODE(code, line, _unlock);
+  }
+  code = tdbTbPutBatch(pMeta->pTagIdx, TARRAY_DATA(aTagKV), taosArrayGetSize(aTagKV), pMeta->txn);
+  VND_CHECK_CODE(code, line, _unlock);
+
+  // update ctime.idx
+  for (int32_t i = 0; i < nCtb; i++) {
+    aKV[i] = (TKV){.pKey = &aCtb[i].btimeKey, .kLen = sizeof(SBtimeIdxKey)};
+  }
+  code = tdbTbPutBatch(pMeta->pBtimeIdx, aKV, nCtb, pMeta->txn);
+  VND_CHECK_CODE(code, line, _unlock);
+
+  for (int32_t i = 0; i < nCtb; i++) {
+    code = metaUpdateTtl(pMeta, &aCtb[i].me);
+    VND_CHECK_CODE(code, line, _unlock);
+  }
+
+_unlock:
+  metaULock(pMeta);
+
+_exit:
+  if (code) {
+    metaError("vgId:%d, failed to save %d child tables since %s at line:%d, ver:%" PRId64, TD_VID(pMeta->pVnode), nCtb,
+              terrstr(), line, aCtb[0].me.version);
+  }
+  for (int32_t i = 0; i < taosArrayGetSize(aTagKV); i++) {
+    taosMemoryFree((void *)((TKV *)taosArrayGet(aTagKV, i))->pKey);
+  }
+  for (int32_t i = 0; i < nCtb; i++) {
+    taosMemoryFreeClear(aCtb[i].pVal);
+  }
+  taosArrayDestroy(aTagKV);
+  taosMemoryFree(aKV);
+  taosMemoryFree(apCtb);
+  return code ? -1 : 0;
+}
+
+// validate a child table request against the super table and the tables already in meta or in the batch
+static int32_t metaCheckNewCtb(SMeta *pMeta, SVCreateTbReq *pReq, SSHashObj *pStbs, SSHashObj *pNames,
+                               SMetaNewCtb *aCtb, SMetaNewCtbStb **ppStb) {
+  int32_t         nStbName = strlen(pReq->ctb.stbName);
+  SMetaNewCtbStb *pStb = tSimpleHashGet(pStbs, pReq->ctb.stbName, nStbName);
+  SMetaReader     mr = {0};
+
+  if (pStb == NULL) {
+    SMetaNewCtbStb stb = {.suid = metaGetTableEntryUidByName(pMeta, pReq->ctb.stbName)};
+    stb.sysTbl = metaTbInFilterCache(pMeta, pReq->ctb.stbName, 1);
+    if (stb.suid != 0 && !stb.sysTbl) {
+      metaGetStbStats(pMeta->pVnode, stb.suid, 0, &stb.nCols);
+    }
+    if (tSimpleHashPut(pStbs, pReq->ctb.stbName, nStbName, &stb, sizeof(stb)) != 0) {
+      return TSDB_CODE_OUT_OF_MEMORY;
+    }
+    pStb = tSimpleHashGet(pStbs, pReq->ctb.stbName, nStbName);
+  }
+
+  if (pStb->suid != pReq->ctb.suid) {
+    return TSDB_CODE_PAR_TABLE_NOT_EXIST;
+  }
+
+  int32_t *pIdx = tSimpleHashGet(pNames, pReq->name, strlen(pReq->name));
+  if (pIdx) {
+    if (pReq->ctb.suid != aCtb[*pIdx].me.ctbEntry.suid) {
+      return TSDB_CODE_TDB_TABLE_IN_OTHER_STABLE;
+    }
+    pReq->uid = aCtb[*pIdx].me.uid;
+    return TSDB_CODE_TDB_TABLE_ALREADY_EXIST;
+  }
+
+  metaReaderDoInit(&mr, pMeta, META_READER_LOCK);
+  if (metaGetTableEntryByName(&mr, pReq->name) == 0) {
+    int32_t code = TSDB_CODE_TDB_TABLE_ALREADY_EXIST;
+    if (pReq->ctb.suid != mr.me.ctbEntry.suid) {
+      code = TSDB_CODE_TDB_TABLE_IN_OTHER_STABLE;
+    } else {
+      pReq->uid = mr.me.uid;
+    }
+    metaReaderClear(&mr);
+    return code;
+  }
+  metaReaderClear(&mr);
+
+  if (!pStb->sysTbl && ((terrno = grantCheck(TSDB_GRANT_TIMESERIES)) < 0)) {
+    return terrno;
+  }
+
+  *ppStb = pStb;
+  return TSDB_CODE_SUCCESS;
+}
+
+int metaCreateTables(SMeta *pMeta, int64_t ver, SVCreateTbReq **ppReq, SVCreateTbRsp *aRsp, int32_t nReq) {
+  SVnodeStats *pStats = &pMeta->pVnode->config.vndStats;
+  SMetaNewCtb *aCtb = taosMemoryCalloc(nReq, sizeof(SMetaNewCtb));
+  SSHashObj   *pNames = tSimpleHashInit(nReq, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY));
+  SSHashObj   *pStbs = tSimpleHashInit(4, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY));
+  int32_t      nCtb = 0;
+
+  for (int32_t iReq = 0; iReq < nReq; iReq++) {
+    SVCreateTbReq  *pReq = ppReq[iReq];
+    SVCreateTbRsp  *pRsp = &aRsp[iReq];
+    SMetaNewCtbStb *pStb = NULL;
+
+    pRsp->code = TSDB_CODE_SUCCESS;
+    pRsp->pMeta = NULL;
+
+    if (aCtb == NULL || pNames == NULL || pStbs == NULL || pReq->type != TSDB_CHILD_TABLE) {
+      // a normal table created here is found by name when a later request of the batch has the same name
+      int32_t *pIdx = pNames ? tSimpleHashGet(pNames, pReq->name, strlen(pReq->name)) : NULL;
+      if (pReq->type == TSDB_NORMAL_TABLE && pIdx) {
+        pReq->uid = aCtb[*pIdx].me.uid;
+        pRsp->code = TSDB_CODE_TDB_TABLE_ALREADY_EXIST;
+      } else if (metaCreateTable(pMeta, ver, pReq, &pRsp->pMeta) < 0) {
+        pRsp->code = terrno;
+      }
+      continue;
+    }
+
+    pRsp->code = metaCheckNewCtb(pMeta, pReq, pStbs, pNames, aCtb, &pStb);
+    if (pRsp->code != TSDB_CODE_SUCCESS) {
+      if (pRsp->code != TSDB_CODE_TDB_TABLE_ALREADY_EXIST) {
+        metaError("vgId:%d, failed to create table:%s type:child table since %s", TD_VID(pMeta->pVnode), pReq->name,
+                  tstrerror(pRsp->code));
+      }
+      continue;
+    }
+
+    if (tSimpleHashPut(pNames, pReq->name, strlen(pReq->name), &nCtb, sizeof(nCtb)) != 0) {
+      pRsp->code = TSDB_CODE_OUT_OF_MEMORY;
+      continue;
+    }
+
+    SMetaNewCtb *pCtb = &aCtb[nCtb++];
+    SMetaEntry  *pME = &pCtb->me;
+    pCtb->iReq = iReq;
+    pME->version = ver;
+    pME->type = TSDB_CHILD_TABLE;
+    pME->uid = pReq->uid;
+    pME->name = pReq->name;
+    pME->ctbEntry.btime = pReq->btime;
+    pME->ctbEntry.ttlDays = pReq->ttl;
+    pME->ctbEntry.commentLen = pReq->commentLen;
+    pME->ctbEntry.comment = pReq->comment;
+    pME->ctbEntry.suid = pReq->ctb.suid;
+    pME->ctbEntry.pTags = pReq->ctb.pTag;
+
+    pCtb->tbDbKey = (STbDbKey){.version = ver, .uid = pME->uid};
+    pCtb->ctbIdxKey = (SCtbIdxKey){.suid = pME->ctbEntry.suid, .uid = pME->uid};
+    pCtb->btimeKey = (SBtimeIdxKey){.btime = pME->ctbEntry.btime, .uid = pME->uid};
+
+    ++pStats->numOfCTables;
+    if (!pStb->sysTbl) {
+      pStats->numOfTimeSeries += pStb->nCols - 1;
+    }
+    pStb->nNew++;
+  }
+
+  if (nCtb > 0) {
+    SMetaNewCtbStb *pStb = NULL;
+    int32_t         iter = 0;
+    int32_t         code = TSDB_CODE_SUCCESS;
+
+    metaWLock(pMeta);
+    while ((pStb = tSimpleHashIterate(pStbs, pStb, &iter))) {
+      if (pStb->nNew == 0) continue;
+      metaUpdateStbStats(pMeta, pStb->suid, pStb->nNew, 0);
+      metaTbGroupCacheClear(pMeta, pStb->suid);
+    }
+    metaULock(pMeta);
+
+    if (!TSDB_CACHE_NO(pMeta->pVnode->config)) {
+      for (int32_t i = 0; i < nCtb; i++) {
+        tsdbCacheNewTable(pMeta->pVnode->pTsdb, aCtb[i].me.uid, aCtb[i].me.ctbEntry.suid, NULL);
+      }
+    }
+
+    if (metaSaveNewCtbs(pMeta, aCtb, nCtb) < 0) {
+      code = terrno;
+    }
+
+    // a table that failed to be saved is left out when it is evaluated again
+    for (int32_t i = 0; i < nCtb; i++) {
+      metaUidCacheUpdate(pMeta, aCtb[i].me.ctbEntry.suid, aCtb[i].me.uid);
+    }
+
+    for (int32_t i = 0; i < nCtb; i++) {
+      SVCreateTbReq *pReq = ppReq[aCtb[i].iReq];
+      SVCreateTbRsp *pRsp = &aRsp[aCtb[i].iReq];
+
+      pRsp->code = code;
+      if (code) continue;
+
+      pRsp->pMeta = taosMemoryCalloc(1, sizeof(STableMetaRsp));
+      if (pRsp->pMeta) {
+        pRsp->pMeta->tableType = TSDB_CHILD_TABLE;
+        pRsp->pMeta->tuid = pReq->uid;
+        pRsp->pMeta->suid = pReq->ctb.suid;
+        strcpy(pRsp->pMeta->tbName, pReq->name);
+      }
+      metaDebug("vgId:%d, table:%s uid %" PRId64 " is created, type:%" PRId8, TD_VID(pMeta->pVnode), pReq->name,
+                pReq->uid, pReq->type);
+    }
+
+    metaTimeSeriesNotifyCheck(pMeta);
+    pMeta->changed = true;
+  }
+
+  tSimpleHashCleanup(pStbs);
+  tSimpleHashCleanup(pNames);
+  taosMemoryFree(aCtb);
+  return 0;
+}
+
 int metaDropTable(SMeta *pMeta, int64_t version, SVDropTbReq *pReq, SArray *tbUids, tb_uid_t *tbUid) {
   void    *pData = NULL;
   int      nData = 0;
@@ -1321,10 +1750,11 @@ static int metaDropTableByUid(SMeta *pMeta, tb_uid_t uid, int *type, tb_uid_t *p
 
   if (e.type == TSDB_CHILD_TABLE) {
     tdbTbDelete(pMeta->pCtbIdx, &(SCtbIdxKey){.suid = e.ctbEntry.suid, .uid = uid}, sizeof(SCtbIdxKey), pMeta->txn);
+    metaTagStoreDrop(pMeta, e.ctbEntry.suid, uid);
 
     --pMeta->pVnode->config.vndStats.numOfCTables;
     metaUpdateStbStats(pMeta, e.ctbEntry.suid, -1, 0);
-    metaUidCacheClear(pMeta, e.ctbEntry.suid);
+    metaUidCacheUpdate(pMeta, e.ctbEntry.suid, uid);
     metaTbGroupCacheClear(pMeta, e.ctbEntry.suid);
     /*
     if (!TSDB_CACHE_NO(pMeta->pVnode->config)) {
@@ -1349,6 +1779,7 @@ static int metaDropTableByUid(SMeta *pMeta, tb_uid_t uid, int *type, tb_uid_t *p
     metaStatsCacheDrop(pMeta, uid);
     metaUidCacheClear(pMeta, uid);
     metaTbGroupCacheClear(pMeta, uid);
+    metaTagStoreClear(pMeta, uid);
     --pMeta->pVnode->config.vndStats.numOfSTables;
   }
 
@@ -1825,8 +2256,9 @@ static int metaUpdateTableTagVal(SMeta *pMeta, int64_t version, SVAlterTbReq *pA
   SCtbIdxKey ctbIdxKey = {.suid = ctbEntry.ctbEntry.suid, .uid = uid};
   tdbTbUpsert(pMeta->pCtbIdx, &ctbIdxKey, sizeof(ctbIdxKey), ctbEntry.ctbEntry.pTags,
               ((STag *)(ctbEntry.ctbEntry.pTags))->len, pMeta->txn);
+  metaTagStoreUpsert(pMeta, ctbEntry.ctbEntry.suid, uid, (const STag *)ctbEntry.ctbEntry.pTags);
 
-  metaUidCacheClear(pMeta, ctbEntry.ctbEntry.suid);
+  metaUidCacheUpdate(pMeta, ctbEntry.ctbEntry.suid, uid);
   metaTbGroupCacheClear(pMeta, ctbEntry.ctbEntry.suid);
 
   metaUpdateChangeTime(pMeta, ctbEntry.uid, pAlterTbReq->ctimeMs);
@@ -2432,8 +2864,12 @@ int metaUpdateChangeTimeWithLock(SMeta *pMeta, tb_uid_t uid, int64_t changeTimeM
 static int metaUpdateCtbIdx(SMeta *pMeta, const SMetaEntry *pME) {
   SCtbIdxKey ctbIdxKey = {.suid = pME->ctbEntry.suid, .uid = pME->uid};
 
-  return tdbTbUpsert(pMeta->pCtbIdx, &ctbIdxKey, sizeof(ctbIdxKey), pME->ctbEntry.pTags,
-                     ((STag *)(pME->ctbEntry.pTags))->len, pMeta->txn);
+  int ret = tdbTbUpsert(pMeta->pCtbIdx, &ctbIdxKey, sizeof(ctbIdxKey), pME->ctbEntry.pTags,
+                        ((STag *)(pME->ctbEntry.pTags))->len, pMeta->txn);
+  if (ret == 0) {
+    metaTagStoreUpsert(pMeta, pME->ctbEntry.suid, pME->uid, (const STag *)pME->ctbEntry.pTags);
+  }
+  return ret;
 }
 
 int metaCreateTagIdxKey(tb_uid_t suid, int32_t cid, const void *pTagData, int32_t nTagData, int8_t type, tb_uid_t uid,
@@ -0,0 +1,610 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "meta.h"
+
+// Columnar copy of the tag values of child tables, kept per super table. A super table gets a store the first time
+// its tags are filtered, and a tag column is materialized the first time it shows up in a filter. From then on the
+// store is kept up to date by child table create, drop and tag update. Each child table owns a dense slot; fixed
+// width tags are kept as an array indexed by slot, var width tags as dictionary codes indexed by slot.
+
+#define TAG_STORE_MIN_SLOTS   1024
+#define TAG_STORE_DICT_EXTRA  1024
+#define TAG_STORE_NULL_CODE   (-1)
+#define TAG_STORE_BUILD_RETRY 2
+
+typedef struct {
+  int16_t   cid;
+  int8_t    type;
+  int32_t   bytes;  // width of a value, dictionary codes for var types
+  char     *pData;  // one value per slot
+  uint8_t  *pNull;  // one flag per slot, fixed width types only
+  SHashObj *pDict;  // value -> code, var types only
+  SArray   *aDict;  // code -> value with var header, var types only
+  int32_t   emptyCode;  // code of the empty string, which the dictionary hash can not take as a key
+} STagStoreCol;
+
+typedef struct {
+  tb_uid_t  suid;
+  int32_t   nSlot;
+  int32_t   capSlot;
+  int32_t   nLive;
+  tb_uid_t *aUid;    // 0 for a free slot
+  SHashObj *pSlot;   // uid -> slot
+  SArray   *aFree;   // free slots
+  SArray   *aOrder;  // slots ordered by uid, built by the first filter without a uid list
+  SArray   *aNew;    // slots created since aOrder was last merged
+  SArray   *aDead;   // slots dropped since aOrder was last merged, freed by the merge
+  SArray   *aCol;    // STagStoreCol
+} STagStoreStb;
+
+struct SMetaTagStore {
+  TdThreadRwlock lock;
+  SHashObj      *pStb;  // suid -> STagStoreStb*
+};
+
+static void tagStoreColClear(STagStoreCol *pCol) {
+  taosMemoryFreeClear(pCol->pData);
+  taosMemoryFreeClear(pCol->pNull);
+  taosHashCleanup(pCol->pDict);
+  pCol->pDict = NULL;
+  taosArrayDestroyP(pCol->aDict, taosMemoryFree);
+  pCol->aDict = NULL;
+}
+
+static void tagStoreStbDestroy(STagStoreStb *pStb) {
+  if (pStb == NULL) return;
+
+  for (int32_t i = 0; i < taosArrayGetSize(pStb->aCol); i++) {
+    tagStoreColClear(taosArrayGet(pStb->aCol, i));
+  }
+  taosArrayDestroy(pStb->aCol);
+  taosArrayDestroy(pStb->aOrder);
+  taosArrayDestroy(pStb->aNew);
+  taosArrayDestroy(pStb->aDead);
+  taosArrayDestroy(pStb->aFree);
+  taosHashCleanup(pStb->pSlot);
+  taosMemoryFree(pStb->aUid);
+  taosMemoryFree(pStb);
+}
+
+static STagStoreStb *tagStoreStbCreate(tb_uid_t suid) {
+  STagStoreStb *pStb = taosMemoryCalloc(1, sizeof(STagStoreStb));
+  if (pStb == NULL) {
+    terrno = TSDB_CODE_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  pStb->suid = suid;
+  pStb->pSlot = taosHashInit(TAG_STORE_MIN_SLOTS, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT), false, HASH_NO_LOCK);
+  pStb->aFree = taosArrayInit(16, sizeof(int32_t));
+  pStb->aNew = taosArrayInit(16, sizeof(int32_t));
+  pStb->aDead = taosArrayInit(16, sizeof(int32_t));
+  pStb->aCol = taosArrayInit(4, sizeof(STagStoreCol));
+  if (pStb->pSlot == NULL || pStb->aFree == NULL || pStb->aNew == NULL || pStb->aDead == NULL || pStb->aCol == NULL) {
+    tagStoreStbDestroy(pStb);
+    terrno = TSDB_CODE_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  return pStb;
+}
+
+static int32_t tagStoreColReserve(STagStoreCol *pCol, int32_t oldCap, int32_t newCap) {
+  if (newCap == 0) return 0;
+
+  char *pData = taosMemoryRealloc(pCol->pData, (int64_t)newCap * pCol->bytes);
+  if (pData == NULL) return -1;
+  pCol->pData = pData;
+
+  if (IS_VAR_DATA_TYPE(pCol->type)) {
+    for (int32_t i = oldCap; i < newCap; i++) {
+      ((int32_t *)pCol->pData)[i] = TAG_STORE_NULL_CODE;
+    }
+  } else {
+    uint8_t *pNull = taosMemoryRealloc(pCol->pNull, newCap);
+    if (pNull == NULL) return -1;
+    pCol->pNull = pNull;
+    memset(pCol->pNull + oldCap, 1, newCap - oldCap);
+  }
+
+  return 0;
+}
+
+static int32_t tagStoreStbReserve(STagStoreStb *pStb, int32_t nSlot) {
+  if (nSlot <= pStb->capSlot) return 0;
+
+  int32_t newCap = TMAX(pStb->capSlot * 2, TAG_STORE_MIN_SLOTS);
+  while (newCap < nSlot) newCap *= 2;
+
+  tb_uid_t *aUid = taosMemoryRealloc(pStb->aUid, newCap * sizeof(tb_uid_t));
+  if (aUid == NULL) goto _err;
+  pStb->aUid = aUid;
+  memset(pStb->aUid + pStb->capSlot, 0, (newCap - pStb->capSlot) * sizeof(tb_uid_t));
+
+  for (int32_t i = 0; i < taosArrayGetSize(pStb->aCol); i++) {
+    if (tagStoreColReserve(taosArrayGet(pStb->aCol, i), pStb->capSlot, newCap) < 0) goto _err;
+  }
+
+  pStb->capSlot = newCap;
+  return 0;
+
+_err:
+  // columns may be larger than capSlot now, which does no harm
+  terrno = TSDB_CODE_OUT_OF_MEMORY;
+  return -1;
+}
+
+static void tagStoreStbDropOrder(STagStoreStb *pStb) {
+  taosArrayDestroy(pStb->aOrder);
+  pStb->aOrder = NULL;
+  taosArrayAddAll(pStb->aFree, pStb->aDead);
+  taosArrayClear(pStb->aDead);
+  taosArrayClear(pStb->aNew);
+}
+
+static int32_t tagStoreStbGetSlot(STagStoreStb *pStb, tb_uid_t uid, bool create) {
+  int32_t *pSlot = taosHashGet(pStb->pSlot, &uid, sizeof(uid));
+  if (pSlot) return *pSlot;
+  if (!create) return -1;
+
+  int32_t slot;
+  if (taosArrayGetSize(pStb->aFree) > 0) {
+    slot = *(int32_t *)taosArrayPop(pStb->aFree);
+  } else {
+    if (tagStoreStbReserve(pStb, pStb->nSlot + 1) < 0) return -1;
+    slot = pStb->nSlot++;
+  }
+
+  if (taosHashPut(pStb->pSlot, &uid, sizeof(uid), &slot, sizeof(slot)) < 0) {
+    taosArrayPush(pStb->aFree, &slot);
+    return -1;
+  }
+
+  pStb->aUid[slot] = uid;
+  pStb->nLive++;
+  if (pStb->aOrder && taosArrayPush(pStb->aNew, &slot) == NULL) {
+    tagStoreStbDropOrder(pStb);
+  }
+  return slot;
+}
+
+static STagStoreCol *tagStoreStbGetCol(STagStoreStb *pStb, int16_t cid) {
+  for (int32_t i = 0; i < taosArrayGetSize(pStb->aCol); i++) {
+    STagStoreCol *pCol = taosArrayGet(pStb->aCol, i);
+    if (pCol->cid == cid) return pCol;
+  }
+  return NULL;
+}
+
+static STagStoreCol *tagStoreStbAddCol(STagStoreStb *pStb, const SColumnInfo *pInfo) {
+  STagStoreCol col = {.cid = pInfo->colId, .type = pInfo->type, .emptyCode = TAG_STORE_NULL_CODE};
+
+  if (IS_VAR_DATA_TYPE(col.type)) {
+    col.bytes = sizeof(int32_t);
+    col.pDict = taosHashInit(64, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, HASH_NO_LOCK);
+    col.aDict = taosArrayInit(64, POINTER_BYTES);
+    if (col.pDict == NULL || col.aDict == NULL) goto _err;
+  } else {
+    col.bytes = tDataTypes[col.type].bytes;
+  }
+
+  if (tagStoreColReserve(&col, 0, pStb->capSlot) < 0) goto _err;
+  if (taosArrayPush(pStb->aCol, &col) == NULL) goto _err;
+
+  return taosArrayGetLast(pStb->aCol);
+
+_err:
+  tagStoreColClear(&col);
+  terrno = TSDB_CODE_OUT_OF_MEMORY;
+  return NULL;
+}
+
+static int32_t tagStoreColGetCode(STagStoreCol *pCol, const uint8_t *pData, uint32_t nData) {
+  if (nData == 0 && pCol->emptyCode != TAG_STORE_NULL_CODE) return pCol->emptyCode;
+  if (nData > 0) {
+    int32_t *pCode = taosHashGet(pCol->pDict, pData, nData);
+    if (pCode) return *pCode;
+  }
+
+  char *pVal = taosMemoryMalloc(nData + VARSTR_HEADER_SIZE);
+  if (pVal == NULL) return TAG_STORE_NULL_CODE;
+  varDataSetLen(pVal, nData);
+  memcpy(varDataVal(pVal), pData, nData);
+
+  int32_t code = taosArrayGetSize(pCol->aDict);
+  if (taosArrayPush(pCol->aDict, &pVal) == NULL) {
+    taosMemoryFree(pVal);
+    return TAG_STORE_NULL_CODE;
+  }
+  if (nData == 0) {
+    pCol->emptyCode = code;
+  } else if (taosHashPut(pCol->pDict, pData, nData, &code, sizeof(code)) < 0) {
+    taosArrayPop(pCol->aDict);
+    taosMemoryFree(pVal);
+    return TAG_STORE_NULL_CODE;
+  }
+
+  return code;
+}
+
+static int32_t tagStoreColSet(STagStoreCol *pCol, int32_t slot, const STag *pTag) {
+  STagVal tagVal = {.cid = pCol->cid};
+  bool    find = (pTag != NULL) && tTagGet(pTag, &tagVal);
+
+  if (IS_VAR_DATA_TYPE(pCol->type)) {
+    int32_t code = TAG_STORE_NULL_CODE;
+    if (find && (code = tagStoreColGetCode(pCol, tagVal.pData, tagVal.nData)) == TAG_STORE_NULL_CODE) {
+      terrno = TSDB_CODE_OUT_OF_MEMORY;
+      return -1;
+    }
+    ((int32_t *)pCol->pData)[slot] = code;
+  } else {
+    pCol->pNull[slot] = !find;
+    if (find) memcpy(pCol->pData + (int64_t)slot * pCol->bytes, &tagVal.i64, pCol->bytes);
+  }
+
+  return 0;
+}
+
+// dictionaries only grow, so a super table whose var tags churn a lot is dropped and built again on the next filter
+static bool tagStoreStbDictBloated(STagStoreStb *pStb) {
+  for (int32_t i = 0; i < taosArrayGetSize(pStb->aCol); i++) {
+    STagStoreCol *pCol = taosArrayGet(pStb->aCol, i);
+    if (pCol->aDict && taosArrayGetSize(pCol->aDict) > 2 * pStb->nLive + TAG_STORE_DICT_EXTRA) return true;
+  }
+  return false;
+}
+
+static int32_t tagStoreSlotCmpr(const void *p1, const void *p2, const void *param) {
+  const tb_uid_t *aUid = param;
+  tb_uid_t        uid1 = aUid[*(int32_t *)p1];
+  tb_uid_t        uid2 = aUid[*(int32_t *)p2];
+
+  return (uid1 < uid2) ? -1 : ((uid1 > uid2) ? 1 : 0);
+}
+
+static bool tagStoreStbOrderReady(STagStoreStb *pStb) {
+  return pStb->aOrder && taosArrayGetSize(pStb->aNew) == 0 && taosArrayGetSize(pStb->aDead) == 0;
+}
+
+// the first call sorts every slot, later calls sort the slots created since and merge them into the order, so child
+// tables created between filters do not cost a full sort. Dropped slots are only reused after the merge skipped them.
+static SArray *tagStoreStbGetOrder(STagStoreStb *pStb) {
+  if (tagStoreStbOrderReady(pStb)) return pStb->aOrder;
+
+  SArray *aOrder = taosArrayInit(pStb->nLive, sizeof(int32_t));
+  if (aOrder == NULL) return NULL;
+
+  if (pStb->aOrder == NULL) {
+    for (int32_t slot = 0; slot < pStb->nSlot; slot++) {
+      if (pStb->aUid[slot] != 0) taosArrayPush(aOrder, &slot);
+    }
+    taosqsort(aOrder->pData, taosArrayGetSize(aOrder), sizeof(int32_t), pStb->aUid, tagStoreSlotCmpr);
+  } else {
+    SArray *aNew = pStb->aNew;
+    int32_t nOld = taosArrayGetSize(pStb->aOrder);
+    int32_t nNew = taosArrayGetSize(aNew);
+    int32_t i = 0, j = 0;
+
+    taosqsort(aNew->pData, nNew, sizeof(int32_t), pStb->aUid, tagStoreSlotCmpr);
+    while (i < nOld || j < nNew) {
+      int32_t oldSlot = (i < nOld) ? *(int32_t *)taosArrayGet(pStb->aOrder, i) : -1;
+      int32_t newSlot = (j < nNew) ? *(int32_t *)taosArrayGet(aNew, j) : -1;
+
+      if (oldSlot >= 0 && pStb->aUid[oldSlot] == 0) {
+        i++;
+      } else if (newSlot >= 0 && pStb->aUid[newSlot] == 0) {
+        j++;
+      } else if (newSlot < 0 || (oldSlot >= 0 && pStb->aUid[oldSlot] < pStb->aUid[newSlot])) {
+        taosArrayPush(aOrder, &oldSlot);
+        i++;
+      } else {
+        taosArrayPush(aOrder, &newSlot);
+        j++;
+      }
+    }
+  }
+
+  tagStoreStbDropOrder(pStb);
+  pStb->aOrder = aOrder;
+  return aOrder;
+}
+
+int32_t metaTagStoreOpen(SMeta *pMeta) {
+  SMetaTagStore *pStore = taosMemoryCalloc(1, sizeof(SMetaTagStore));
+  if (pStore == NULL) {
+    return TSDB_CODE_OUT_OF_MEMORY;
+  }
+
+  pStore->pStb = taosHashInit(16, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT), false, HASH_NO_LOCK);
+  if (pStore->pStb == NULL) {
+    taosMemoryFree(pStore);
+    return TSDB_CODE_OUT_OF_MEMORY;
+  }
+  taosThreadRwlockInit(&pStore->lock, NULL);
+
+  pMeta->pTagStore = pStore;
+  return 0;
+}
+
+void metaTagStoreClose(SMeta *pMeta) {
+  SMetaTagStore *pStore = pMeta->pTagStore;
+  if (pStore == NULL) return;
+
+  metaTagStoreReset(pMeta);
+  taosHashCleanup(pStore->pStb);
+  taosThreadRwlockDestroy(&pStore->lock);
+  taosMemoryFreeClear(pMeta->pTagStore);
+}
+
+void metaTagStoreReset(SMeta *pMeta) {
+  SMetaTagStore *pStore = pMeta->pTagStore;
+  if (pStore == NULL) return;
+
+  taosThreadRwlockWrlock(&pStore->lock);
+  void *pIter = taosHashIterate(pStore->pStb, NULL);
+  while (pIter) {
+    tagStoreStbDestroy(*(STagStoreStb **)pIter);
+    pIter = taosHashIterate(pStore->pStb, pIter);
+  }
+  taosHashClear(pStore->pStb);
+  taosThreadRwlockUnlock(&pStore->lock);
+}
+
+void metaTagStoreUpsert(SMeta *pMeta, tb_uid_t suid, tb_uid_t uid, const STag *pTag) {
+  SMetaTagStore *pStore = pMeta->pTagStore;
+  if (pStore == NULL) return;
+
+  taosThreadRwlockWrlock(&pStore->lock);
+  STagStoreStb **ppStb = taosHashGet(pStore->pStb, &suid, sizeof(suid));
+  if (ppStb == NULL) {
+    taosThreadRwlockUnlock(&pStore->lock);
+    return;
+  }
+
+  STagStoreStb *pStb = *ppStb;
+  int32_t       slot = tagStoreStbGetSlot(pStb, uid, true);
+  int32_t       code = (slot < 0) ? -1 : 0;
+  for (int32_t i = 0; code == 0 && i < taosArrayGetSize(pStb->aCol); i++) {
+    code = tagStoreColSet(taosArrayGet(pStb->aCol, i), slot, pTag);
+  }
+
+  // a store that failed to take the table, or whose dictionaries outgrew it, is built again when needed
+  if (code < 0 || tagStoreStbDictBloated(pStb)) {
+    taosHashRemove(pStore->pStb, &suid, sizeof(suid));
+    tagStoreStbDestroy(pStb);
+  }
+  taosThreadRwlockUnlock(&pStore->lock);
+}
+
+void metaTagStoreDrop(SMeta *pMeta, tb_uid_t suid, tb_uid_t uid) {
+  SMetaTagStore *pStore = pMeta->pTagStore;
+  if (pStore == NULL) return;
+
+  taosThreadRwlockWrlock(&pStore->lock);
+  STagStoreStb **ppStb = taosHashGet(pStore->pStb, &suid, sizeof(suid));
+  if (ppStb == NULL) {
+    taosThreadRwlockUnlock(&pStore->lock);
+    return;
+  }
+
+  STagStoreStb *pStb = *ppStb;
+  int32_t       slot = tagStoreStbGetSlot(pStb, uid, false);
+  if (slot >= 0) {
+    for (int32_t i = 0; i < taosArrayGetSize(pStb->aCol); i++) {
+      tagStoreColSet(taosArrayGet(pStb->aCol, i), slot, NULL);
+    }
+    pStb->aUid[slot] = 0;
+    pStb->nLive--;
+    taosHashRemove(pStb->pSlot, &uid, sizeof(uid));
+    if (pStb->aOrder == NULL) {
+      taosArrayPush(pStb->aFree, &slot);
+    } else if (taosArrayPush(pStb->aDead, &slot) == NULL) {
+      tagStoreStbDropOrder(pStb);
+    }
+  }
+  taosThreadRwlockUnlock(&pStore->lock);
+}
+
+void metaTagStoreClear(SMeta *pMeta, tb_uid_t suid) {
+  SMetaTagStore *pStore = pMeta->pTagStore;
+  if (pStore == NULL) return;
+
+  taosThreadRwlockWrlock(&pStore->lock);
+  STagStoreStb **ppStb = taosHashGet(pStore->pStb, &suid, sizeof(suid));
+  if (ppStb) {
+    STagStoreStb *pStb = *ppStb;
+    taosHashRemove(pStore->pStb, &suid, sizeof(suid));
+    tagStoreStbDestroy(pStb);
+  }
+  taosThreadRwlockUnlock(&pStore->lock);
+}
+
+// the store can serve the filter if every tag column it asks for is there with the same type
+static bool tagStoreStbHasCols(STagStoreStb *pStb, SArray *pColList) {
+  for (int32_t i = 0; i < taosArrayGetSize(pColList); i++) {
+    SColumnInfo *pInfo = taosArrayGet(pColList, i);
+    if (pInfo->colId == -1) continue;
+
+    STagStoreCol *pCol = tagStoreStbGetCol(pStb, pInfo->colId);
+    if (pCol == NULL || pCol->type != pInfo->type) return false;
+  }
+  return true;
+}
+
+// scan the ctb index under the meta read lock, so no create, drop or tag update can slip in between
+static int32_t tagStoreBuild(SMeta *pMeta, tb_uid_t suid, SArray *pColList, bool needOrder) {
+  SMetaTagStore *pStore = pMeta->pTagStore;
+  SMCtbCursor   *pCur = metaOpenCtbCursor(pMeta->pVnode, suid, 1);
+  if (pCur == NULL) return -1;
+
+  taosThreadRwlockWrlock(&pStore->lock);
+
+  bool           created = false;
+  STagStoreStb  *pStb = NULL;
+  STagStoreStb **ppStb = taosHashGet(pStore->pStb, &suid, sizeof(suid));
+  if (ppStb) {
+    pStb = *ppStb;
+  } else {
+    pStb = tagStoreStbCreate(suid);
+    if (pStb == NULL) goto _err;
+    created = true;
+  }
+
+  int32_t nOldCol = taosArrayGetSize(pStb->aCol);
+  for (int32_t i = 0; i < taosArrayGetSize(pColList); i++) {
+    SColumnInfo *pInfo = taosArrayGet(pColList, i);
+    if (pInfo->colId == -1) continue;
+
+    STagStoreCol *pCol = tagStoreStbGetCol(pStb, pInfo->colId);
+    if (pCol && pCol->type != pInfo->type) goto _err;
+    if (pCol == NULL && tagStoreStbAddCol(pStb, pInfo) == NULL) goto _err;
+  }
+
+  int32_t nLive = 0;
+  int32_t nCol = taosArrayGetSize(pStb->aCol);
+  if (created || nOldCol < nCol) {
+    while (1) {
+      tb_uid_t uid = metaCtbCursorNext(pCur);
+      if (uid == 0) break;
+
+      int32_t slot = tagStoreStbGetSlot(pStb, uid, created);
+      if (slot < 0) goto _err;
+
+      for (int32_t i = created ? 0 : nOldCol; i < nCol; i++) {
+        if (tagStoreColSet(taosArrayGet(pStb->aCol, i), slot, pCur->pVal) < 0) goto _err;
+      }
+    }
+  }
+
+  if (needOrder && tagStoreStbGetOrder(pStb) == NULL) goto _err;
+  if (created && taosHashPut(pStore->pStb, &suid, sizeof(suid), &pStb, POINTER_BYTES) < 0) goto _err;
+  nLive = pStb->nLive;
+
+  taosThreadRwlockUnlock(&pStore->lock);
+  metaCloseCtbCursor(pCur);
+  metaDebug("vgId:%d, suid:%" PRId64 " tag store built, tables:%d columns:%d", TD_VID(pMeta->pVnode), suid, nLive,
+            nCol);
+  return 0;
+
+_err:
+  if (pStb) {
+    if (!created) taosHashRemove(pStore->pStb, &suid, sizeof(suid));
+    tagStoreStbDestroy(pStb);
+  }
+  taosThreadRwlockUnlock(&pStore->lock);
+  metaCloseCtbCursor(pCur);
+  return -1;
+}
+
+// called with the store read locked, aOrder is built beforehand if the uid list is empty
+static int32_t tagStoreFillBlock(STagStoreStb *pStb, SArray *pColList, SArray *pUidTagList, SSDataBlock **ppBlock) {
+  SArray      *aOrder = NULL;
+  SSDataBlock *pBlock = NULL;
+  int32_t      numOfTables = taosArrayGetSize(pUidTagList);
+
+  // without a uid list every child table is returned, in uid order like the ctb index
+  if (numOfTables == 0) {
+    aOrder = pStb->aOrder;
+    numOfTables = taosArrayGetSize(aOrder);
+    if (taosArrayEnsureCap(pUidTagList, numOfTables) < 0) goto _err;
+    for (int32_t i = 0; i < numOfTables; i++) {
+      STUidTagInfo info = {.uid = pStb->aUid[*(int32_t *)taosArrayGet(aOrder, i)]};
+      taosArrayPush(pUidTagList, &info);
+    }
+  }
+
+  pBlock = createDataBlock();
+  if (pBlock == NULL) goto _err;
+
+  for (int32_t i = 0; i < taosArrayGetSize(pColList); ++i) {
+    SColumnInfoData colInfo = {0};
+    colInfo.info = *(SColumnInfo *)taosArrayGet(pColList, i);
+    blockDataAppendColInfo(pBlock, &colInfo);
+  }
+
+  if (blockDataEnsureCapacity(pBlock, numOfTables) != 0) goto _err;
+  pBlock->info.rows = numOfTables;
+
+  for (int32_t j = 0; j < taosArrayGetSize(pBlock->pDataBlock); j++) {
+    SColumnInfoData *pColInfo = taosArrayGet(pBlock->pDataBlock, j);
+    if (pColInfo->info.colId == -1) continue;  // tbname is left to the caller
+
+    STagStoreCol *pCol = tagStoreStbGetCol(pStb, pColInfo->info.colId);
+    bool          isVar = IS_VAR_DATA_TYPE(pCol->type);
+
+    for (int32_t i = 0; i < numOfTables; i++) {
+      int32_t slot = aOrder ? *(int32_t *)taosArrayGet(aOrder, i)
+                            : tagStoreStbGetSlot(pStb, ((STUidTagInfo *)taosArrayGet(pUidTagList, i))->uid, false);
+      if (slot < 0) {
+        colDataSetNULL(pColInfo, i);
+      } else if (isVar) {
+        int32_t code = ((int32_t *)pCol->pData)[slot];
+        if (code == TAG_STORE_NULL_CODE) {
+          colDataSetNULL(pColInfo, i);
+        } else if (colDataSetVal(pColInfo, i, taosArrayGetP(pCol->aDict, code), false) != 0) {
+          goto _err;
+        }
+      } else if (pCol->pNull[slot]) {
+        colDataSetNULL(pColInfo, i);
+      } else {
+        colDataSetVal(pColInfo, i, pCol->pData + (int64_t)slot * pCol->bytes, false);
+      }
+    }
+  }
+
+  *ppBlock = pBlock;
+  return 0;
+
+_err:
+  if (aOrder) taosArrayClear(pUidTagList);
+  blockDataDestroy(pBlock);
+  return -1;
+}
+
+int32_t metaGetTableTagCols(void *pVnode, uint64_t suid, SArray *pColList, SArray *pUidTagList,
+                            SSDataBlock **ppBlock) {
+  SMeta         *pMeta = ((SVnode *)pVnode)->pMeta;
+  SMetaTagStore *pStore = pMeta->pTagStore;
+  bool           hasTag = false;
+
+  *ppBlock = NULL;
+  if (pStore == NULL) return -1;
+
+  // json tags are kept as a whole and tbname is not a tag, neither is worth a column
+  for (int32_t i = 0; i < taosArrayGetSize(pColList); i++) {
+    SColumnInfo *pInfo = taosArrayGet(pColList, i);
+    if (pInfo->colId == -1) continue;
+    if (pInfo->type == TSDB_DATA_TYPE_JSON) return -1;
+    hasTag = true;
+  }
+  if (!hasTag) return -1;
+
+  bool needOrder = taosArrayGetSize(pUidTagList) == 0;
+  for (int32_t retry = 0; retry < TAG_STORE_BUILD_RETRY; retry++) {
+    taosThreadRwlockRdlock(&pStore->lock);
+    STagStoreStb **ppStb = taosHashGet(pStore->pStb, &suid, sizeof(suid));
+    if (ppStb && tagStoreStbHasCols(*ppStb, pColList) && (!needOrder || tagStoreStbOrderReady(*ppStb))) {
+      int32_t code = tagStoreFillBlock(*ppStb, pColList, pUidTagList, ppBlock);
+      taosThreadRwlockUnlock(&pStore->lock);
+      return code;
+    }
+    taosThreadRwlockUnlock(&pStore->lock);
+
+    if (tagStoreBuild(pMeta, suid, pColList, needOrder) < 0) break;
+  }
+
+  return -1;
+}
@@ -1006,7 +1006,8 @@ static void tsdbCacheUpdateLastCol(SLastCol *pLastCol, SRowKey *pRowKey, SColVal
   }
 }
 
-static int32_t tsdbCacheUpdate(STsdb *pTsdb, tb_uid_t suid, tb_uid_t uid, SArray *updCtxArray) {
+// caller holds lruMutex; *pPut is set when rocks writes were queued and the write batch needs a flush
+static int32_t tsdbCacheUpdateNoLock(STsdb *pTsdb, tb_uid_t suid, tb_uid_t uid, SArray *updCtxArray, bool *pPut) {
   if (!updCtxArray || TARRAY_SIZE(updCtxArray) == 0) {
     return 0;
   }
@@ -1017,7 +1018,6 @@ static int32_t tsdbCacheUpdate(STsdb *pTsdb, tb_uid_t suid, tb_uid_t uid, SArray
   SArray    *remainCols = NULL;
   SLRUCache *pCache = pTsdb->lruCache;
 
-  taosThreadMutexLock(&pTsdb->lruMutex);
   for (int i = 0; i < num_keys; ++i) {
     SLastUpdateCtx *updCtx = (SLastUpdateCtx *)taosArrayGet(updCtxArray, i);
 
@@ -1072,7 +1072,7 @@ static int32_t tsdbCacheUpdate(STsdb *pTsdb, tb_uid_t suid, tb_uid_t uid, SArray
     rocksdb_writebatch_t *wb = pTsdb->rCache.writebatch;
     for (int i = 0; i < num_keys; ++i) {
       SIdxKey        *idxKey = &((SIdxKey *)TARRAY_DATA(remainCols))[i];
-      SLastUpdateCtx *updCtx = (SLastUpdateCtx *)taosArrayGet(updCtxArray, i);
+      SLastUpdateCtx *updCtx = (SLastUpdateCtx *)taosArrayGet(updCtxArray, idxKey->idx);
       SRowKey        *pRowKey = &updCtx->tsdbRowKey.key;
       SColVal        *pColVal = &updCtx->colVal;
 
@@ -1134,7 +1134,7 @@ static int32_t tsdbCacheUpdate(STsdb *pTsdb, tb_uid_t suid, tb_uid_t uid, SArray
       rocksdb_free(values_list[i]);
     }
 
-    rocksMayWrite(pTsdb, true, false, true);
+    *pPut = true;
 
     taosMemoryFree(keys_list);
     taosMemoryFree(keys_list_sizes);
@@ -1144,12 +1144,210 @@ static int32_t tsdbCacheUpdate(STsdb *pTsdb, tb_uid_t suid, tb_uid_t uid, SArray
     taosArrayDestroy(remainCols);
   }
 
+  return code;
+}
+
+static int32_t tsdbCacheUpdate(STsdb *pTsdb, tb_uid_t suid, tb_uid_t uid, SArray *updCtxArray) {
+  if (!updCtxArray || TARRAY_SIZE(updCtxArray) == 0) {
+    return 0;
+  }
+
+  int32_t code = 0;
+  bool    put = false;
+
+  taosThreadMutexLock(&pTsdb->lruMutex);
+
+  code = tsdbCacheUpdateNoLock(pTsdb, suid, uid, updCtxArray, &put);
+  if (put) {
+    rocksMayWrite(pTsdb, true, false, true);
+  }
+
   taosThreadMutexUnlock(&pTsdb->lruMutex);
 
+  return code;
+}
+
+/*
+ * Submit batching: while a batch is open, the per-table row/col format updates only collect their update contexts.
+ * Contexts of the same (uid, lflag, cid) are merged down to the newest one, and tsdbCacheUpdateBatchEnd applies all
+ * tables of the submit under a single lruMutex acquisition with a single rocksdb write batch flush.
+ *
+ * A batch belongs to the call that opened it and is only reachable from the opening thread, rsma levels insert from
+ * several threads at once.
+ */
+typedef struct {
+  tb_uid_t suid;
+  tb_uid_t uid;
+  SArray  *ctxArray;  // SArray<SLastUpdateCtx>
+} STbUpdCtx;
+
+struct SCacheUpdBatch {
+  STsdb          *pTsdb;
+  SCacheUpdBatch *pPrev;    // batch this one is nested in
+  SArray         *aTbUpd;   // SArray<STbUpdCtx>
+  SSHashObj      *pTbIdx;   // uid -> index in aTbUpd
+  SSHashObj      *pKeyIdx;  // SLastKey -> index in STbUpdCtx.ctxArray
+};
+
+static threadlocal SCacheUpdBatch *tsdbUpdBatch = NULL;
+
+static void tsdbCacheUpdateBatchDestroy(SCacheUpdBatch *pBatch) {
+  if (pBatch) {
+    for (int32_t i = 0; i < TARRAY_SIZE(pBatch->aTbUpd); ++i) {
+      STbUpdCtx *pTbUpd = TARRAY_GET_ELEM(pBatch->aTbUpd, i);
+      taosArrayDestroy(pTbUpd->ctxArray);
+    }
+    taosArrayDestroy(pBatch->aTbUpd);
+    tSimpleHashCleanup(pBatch->pTbIdx);
+    tSimpleHashCleanup(pBatch->pKeyIdx);
+    taosMemoryFree(pBatch);
+  }
+}
+
+int32_t tsdbCacheUpdateBatchBegin(STsdb *pTsdb, SCacheUpdBatch **ppBatch) {
+  int32_t code = 0;
+  int32_t lino = 0;
+
+  SCacheUpdBatch *pBatch = taosMemoryCalloc(1, sizeof(*pBatch));
+  if (pBatch == NULL) {
+    TSDB_CHECK_CODE(code = TSDB_CODE_OUT_OF_MEMORY, lino, _exit);
+  }
+
+  pBatch->pTsdb = pTsdb;
+  pBatch->aTbUpd = taosArrayInit(16, sizeof(STbUpdCtx));
+  pBatch->pTbIdx = tSimpleHashInit(16, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT));
+  pBatch->pKeyIdx = tSimpleHashInit(256, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY));
+  if (pBatch->aTbUpd == NULL || pBatch->pTbIdx == NULL || pBatch->pKeyIdx == NULL) {
+    tsdbCacheUpdateBatchDestroy(pBatch);
+    pBatch = NULL;
+    TSDB_CHECK_CODE(code = TSDB_CODE_OUT_OF_MEMORY, lino, _exit);
+  }
+
+  pBatch->pPrev = tsdbUpdBatch;
+  tsdbUpdBatch = pBatch;
+
 _exit:
+  if (code) {
+    tsdbError("vgId:%d %s failed at line %d since %s", TD_VID(pTsdb->pVnode), __func__, lino, tstrerror(code));
+  }
+  *ppBatch = pBatch;
   return code;
 }
 
+static int32_t tsdbCacheUpdateBatchAdd(SCacheUpdBatch *pBatch, tb_uid_t suid, tb_uid_t uid, SArray *updCtxArray) {
+  int32_t code = 0;
+  int32_t lino = 0;
+
+  STsdb     *pTsdb = pBatch->pTsdb;
+  STbUpdCtx *pTbUpd = NULL;
+  int32_t    iTb = 0;
+
+  int32_t *pTbIdx = tSimpleHashGet(pBatch->pTbIdx, &uid, sizeof(uid));
+  if (pTbIdx) {
+    iTb = *pTbIdx;
+    pTbUpd = TARRAY_GET_ELEM(pBatch->aTbUpd, iTb);
+  } else {
+    STbUpdCtx tbUpd = {.suid = suid, .uid = uid};
+    tbUpd.ctxArray = taosArrayInit(TARRAY_SIZE(updCtxArray), sizeof(SLastUpdateCtx));
+    if (tbUpd.ctxArray == NULL) {
+      TSDB_CHECK_CODE(code = TSDB_CODE_OUT_OF_MEMORY, lino, _exit);
+    }
+
+    iTb = TARRAY_SIZE(pBatch->aTbUpd);
+    if (taosArrayPush(pBatch->aTbUpd, &tbUpd) == NULL) {
+      taosArrayDestroy(tbUpd.ctxArray);
+      TSDB_CHECK_CODE(code = TSDB_CODE_OUT_OF_MEMORY, lino, _exit);
+    }
+    code = tSimpleHashPut(pBatch->pTbIdx, &uid, sizeof(uid), &iTb, sizeof(iTb));
+    TSDB_CHECK_CODE(code, lino, _exit);
+
+    pTbUpd = TARRAY_GET_ELEM(pBatch->aTbUpd, iTb);
+  }
+
+  for (int32_t i = 0; i < TARRAY_SIZE(updCtxArray); ++i) {
+    SLastUpdateCtx *pNew = TARRAY_GET_ELEM(updCtxArray, i);
+    if (pNew->lflag == LFLAG_LAST && !COL_VAL_IS_VALUE(&pNew->colVal)) {
+      continue;
+    }
+
+    SLastKey key = {.lflag = pNew->lflag, .uid = uid, .cid = pNew->colVal.cid};
+
+    int32_t *pCtxIdx = tSimpleHashGet(pBatch->pKeyIdx, &key, ROCKS_KEY_LEN);
+    if (pCtxIdx) {
+      // keep the newest one, same rule as the cache itself
+      SLastUpdateCtx *pOld = TARRAY_GET_ELEM(pTbUpd->ctxArray, *pCtxIdx);
+      int32_t         cmp_res = tRowKeyCompare(&pOld->tsdbRowKey.key, &pNew->tsdbRowKey.key);
+      if (cmp_res < 0 || (cmp_res == 0 && !COL_VAL_IS_NONE(&pNew->colVal))) {
+        *pOld = *pNew;
+      }
+      continue;
+    }
+
+    int32_t iCtx = TARRAY_SIZE(pTbUpd->ctxArray);
+    if (taosArrayPush(pTbUpd->ctxArray, pNew) == NULL) {
+      TSDB_CHECK_CODE(code = TSDB_CODE_OUT_OF_MEMORY, lino, _exit);
+    }
+    code = tSimpleHashPut(pBatch->pKeyIdx, &key, ROCKS_KEY_LEN, &iCtx, sizeof(iCtx));
+    TSDB_CHECK_CODE(code, lino, _exit);
+  }
+
+_exit:
+  if (code) {
+    tsdbError("vgId:%d %s failed at line %d since %s", TD_VID(pTsdb->pVnode), __func__, lino, tstrerror(code));
+  }
+  return code;
+}
+
+int32_t tsdbCacheUpdateBatchEnd(STsdb *pTsdb, SCacheUpdBatch *pBatch) {
+  int32_t code = 0;
+
+  if (pBatch == NULL) {
+    return 0;
+  }
+  tsdbUpdBatch = pBatch->pPrev;
+
+  if (TARRAY_SIZE(pBatch->aTbUpd) > 0) {
+    bool put = false;
+
+    taosThreadMutexLock(&pTsdb->lruMutex);
+
+    for (int32_t i = 0; i < TARRAY_SIZE(pBatch->aTbUpd); ++i) {
+      STbUpdCtx *pTbUpd = TARRAY_GET_ELEM(pBatch->aTbUpd, i);
+
+      int32_t lcode = tsdbCacheUpdateNoLock(pTsdb, pTbUpd->suid, pTbUpd->uid, pTbUpd->ctxArray, &put);
+      if (lcode && code == 0) {
+        code = lcode;
+      }
+    }
+
+    if (put) {
+      rocksMayWrite(pTsdb, true, false, true);
+    }
+
+    taosThreadMutexUnlock(&pTsdb->lruMutex);
+  }
+
+  tsdbCacheUpdateBatchDestroy(pBatch);
+  return code;
+}
+
+int32_t tsdbCacheUpdateOrBatch(STsdb *pTsdb, tb_uid_t suid, tb_uid_t uid, SArray *updCtxArray) {
+  if (!updCtxArray || TARRAY_SIZE(updCtxArray) == 0) {
+    return 0;
+  }
+
+  for (SCacheUpdBatch *pBatch = tsdbUpdBatch; pBatch; pBatch = pBatch->pPrev) {
+    if (pBatch->pTsdb == pTsdb) {
+      if (tsdbCacheUpdateBatchAdd(pBatch, suid, uid, updCtxArray) == 0) {
+        return 0;
+      }
+      break;
+    }
+  }
+
+  return tsdbCacheUpdate(pTsdb, suid, uid, updCtxArray);
+}
+
 int32_t tsdbCacheRowFormatUpdate(STsdb *pTsdb, tb_uid_t suid, tb_uid_t uid, int64_t version, int32_t nRow,
                                  SRow **aRow) {
   int32_t code = 0;
@@ -1221,7 +1419,7 @@ int32_t tsdbCacheRowFormatUpdate(STsdb *pTsdb, tb_uid_t suid, tb_uid_t uid, int6
   }
 
   // 3. do update
-  tsdbCacheUpdate(pTsdb, suid, uid, ctxArray);
+  tsdbCacheUpdateOrBatch(pTsdb, suid, uid, ctxArray);
 
 _exit:
   taosMemoryFreeClear(pTSchema);
@@ -1294,7 +1492,7 @@ int32_t tsdbCacheColFormatUpdate(STsdb *pTsdb, tb_uid_t suid, tb_uid_t uid, SBlo
   tsdbRowClose(&iter);
 
   // 3. do update
-  tsdbCacheUpdate(pTsdb, suid, uid, ctxArray);
+  tsdbCacheUpdateOrBatch(pTsdb, suid, uid, ctxArray);
 
 _exit:
   taosMemoryFreeClear(pTSchema);
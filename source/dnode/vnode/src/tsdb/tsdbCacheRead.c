@@ -533,3 +533,43 @@ _end:
 
   return code;
 }
+
+// fill the last cache of all tables of the reader without producing result rows, used by the warm up
+int32_t tsdbCacherowsReaderLoad(void* pReader, int32_t type) {
+  if (pReader == NULL) {
+    return TSDB_CODE_INVALID_PARA;
+  }
+
+  SCacheRowsReader* pr = pReader;
+  int32_t           code = TSDB_CODE_SUCCESS;
+  SArray*           pRow = taosArrayInit(TARRAY_SIZE(pr->pCidList), sizeof(SLastCol));
+  if (pRow == NULL) {
+    return TSDB_CODE_OUT_OF_MEMORY;
+  }
+
+  pr->type = CACHESCAN_RETRIEVE_TYPE_ALL | type;
+  int8_t ltype = (pr->type & CACHESCAN_RETRIEVE_LAST) >> 3;
+
+  taosThreadMutexLock(&pr->readerMutex);
+  code = tsdbTakeReadSnap2((STsdbReader*)pr, tsdbCacheQueryReseek, &pr->pReadSnap);
+  if (code != TSDB_CODE_SUCCESS) {
+    goto _end;
+  }
+
+  STableKeyInfo* pTableList = pr->pTableList;
+  for (int32_t i = 0; i < pr->numOfTables; ++i) {
+    tsdbCacheGetBatch(pr->pTsdb, pTableList[i].uid, pRow, pr, ltype);
+    taosArrayClearEx(pRow, freeItem);
+  }
+
+_end:
+  tsdbUntakeReadSnap2((STsdbReader*)pr, pr->pReadSnap, true);
+  if (pr->pCurFileSet) {
+    pr->pCurFileSet = NULL;
+  }
+
+  taosThreadMutexUnlock(&pr->readerMutex);
+
+  taosArrayDestroy(pRow);
+  return code;
+}
@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tsdb.h"
+#include "vnd.h"
+
+/*
+ * Background warm up of the last cache at vnode start.
+ *
+ * The child tables of the selected super tables are cut into chunks, and each chunk is loaded through a cache rows
+ * reader, exactly as a last/last_row query would do. Chunks are spread over several channels of the vnode-warmup
+ * async pool so that they load in parallel, and a shared tables-per-second budget keeps the disks free for the
+ * foreground. Progress is reported with the vnode load and shown in ins_vnodes.
+ */
+
+#define TSDB_CACHE_WARMUP_CHANNELS 4
+#define TSDB_CACHE_WARMUP_CHUNK    256
+#define TSDB_CACHE_WARMUP_ASYNC    3  // vnode-warmup
+
+struct SCacheWarmup {
+  int8_t       stop;
+  int64_t      startMs;
+  int64_t      claimed;  // tables taken by tasks, for rate limit
+  SVAChannelID channels[TSDB_CACHE_WARMUP_CHANNELS];
+};
+
+typedef struct {
+  STsdb   *pTsdb;
+  tb_uid_t suid;
+  SArray  *pUids;  // SArray<tb_uid_t>
+} SCacheWarmupTask;
+
+static void tsdbCacheWarmupTaskFree(void *arg) {
+  SCacheWarmupTask *pTask = arg;
+  if (pTask) {
+    taosArrayDestroy(pTask->pUids);
+    taosMemoryFree(pTask);
+  }
+}
+
+static bool tsdbCacheWarmupSelected(STsdb *pTsdb, tb_uid_t suid) {
+  if (tsLastCacheWarmupStbs[0] == '\0') {
+    return true;
+  }
+
+  char name[TSDB_TABLE_NAME_LEN] = {0};
+  if (metaGetTableSzNameByUid(pTsdb->pVnode->pMeta, suid, name) < 0) {
+    return false;
+  }
+
+  bool  selected = false;
+  char *stbs = taosStrdup(tsLastCacheWarmupStbs);
+  char *pStbs = stbs;
+  char *pStb = NULL;
+  while (pStbs && (pStb = strsep(&pStbs, ",")) != NULL) {
+    strtrim(pStb);
+    if (strcmp(pStb, name) == 0) {
+      selected = true;
+      break;
+    }
+  }
+
+  taosMemoryFree(stbs);
+  return selected;
+}
+
+static void tsdbCacheWarmupThrottle(SCacheWarmup *pWarmup, int32_t nTables) {
+  int64_t claimed = atomic_fetch_add_64(&pWarmup->claimed, nTables);
+  int32_t rate = tsLastCacheWarmupRate;
+  if (rate <= 0) {
+    return;
+  }
+
+  int64_t dueMs = pWarmup->startMs + claimed * 1000 / rate;
+  while (!atomic_load_8(&pWarmup->stop)) {
+    int64_t waitMs = dueMs - taosGetTimestampMs();
+    if (waitMs <= 0) {
+      break;
+    }
+    taosMsleep(TMIN(waitMs, 100));
+  }
+}
+
+static int32_t tsdbCacheWarmupLoad(STsdb *pTsdb, tb_uid_t suid, SArray *pUids) {
+  int32_t code = 0;
+  int32_t lino = 0;
+
+  SVnode        *pVnode = pTsdb->pVnode;
+  int32_t        nTables = TARRAY_SIZE(pUids);
+  STableKeyInfo *pTableList = NULL;
+  STSchema      *pSchema = NULL;
+  SArray        *pCidList = NULL;
+  int32_t       *pSlotIds = NULL;
+  void          *pReader = NULL;
+  SColumnInfo    pkCol = {0};
+  int32_t        numOfPks = 0;
+  char           idstr[64];
+
+  pSchema = metaGetTbTSchema(pVnode->pMeta, suid, -1, 1);
+  if (pSchema == NULL) {
+    // dropped meanwhile
+    goto _exit;
+  }
+
+  pTableList = taosMemoryCalloc(nTables, sizeof(STableKeyInfo));
+  pCidList = taosArrayInit(pSchema->numOfCols, sizeof(int16_t));
+  pSlotIds = taosMemoryCalloc(pSchema->numOfCols, sizeof(int32_t));
+  if (pTableList == NULL || pCidList == NULL || pSlotIds == NULL) {
+    TSDB_CHECK_CODE(code = TSDB_CODE_OUT_OF_MEMORY, lino, _exit);
+  }
+
+  for (int32_t i = 0; i < nTables; ++i) {
+    pTableList[i].uid = *(tb_uid_t *)taosArrayGet(pUids, i);
+  }
+
+  for (int32_t i = 0; i < pSchema->numOfCols; ++i) {
+    taosArrayPush(pCidList, &pSchema->columns[i].colId);
+    pSlotIds[i] = i;
+  }
+
+  if (pSchema->numOfCols > 1 && (pSchema->columns[1].flags & COL_IS_KEY)) {
+    pkCol.colId = pSchema->columns[1].colId;
+    pkCol.type = pSchema->columns[1].type;
+    pkCol.bytes = pSchema->columns[1].bytes;
+    numOfPks = 1;
+  }
+
+  snprintf(idstr, sizeof(idstr), "vgId:%d cache warmup suid:%" PRId64, TD_VID(pVnode), suid);
+  code = tsdbCacherowsReaderOpen(pVnode, CACHESCAN_RETRIEVE_TYPE_ALL | CACHESCAN_RETRIEVE_LAST_ROW, pTableList, nTables,
+                                 pSchema->numOfCols, pCidList, pSlotIds, suid, &pReader, idstr, NULL, &pkCol, numOfPks);
+  if (code == TSDB_CODE_PAR_TABLE_NOT_EXIST) {
+    code = 0;
+    goto _exit;
+  }
+  TSDB_CHECK_CODE(code, lino, _exit);
+
+  if (TSDB_CACHE_LAST_ROW(pVnode->config)) {
+    code = tsdbCacherowsReaderLoad(pReader, CACHESCAN_RETRIEVE_LAST_ROW);
+    TSDB_CHECK_CODE(code, lino, _exit);
+  }
+
+  if (TSDB_CACHE_LAST(pVnode->config)) {
+    code = tsdbReuseCacherowsReader(pReader, pTableList, nTables);
+    TSDB_CHECK_CODE(code, lino, _exit);
+
+    code = tsdbCacherowsReaderLoad(pReader, CACHESCAN_RETRIEVE_LAST);
+    TSDB_CHECK_CODE(code, lino, _exit);
+  }
+
+_exit:
+  if (code) {
+    tsdbError("vgId:%d %s failed at line %d since %s, suid:%" PRId64, TD_VID(pVnode), __func__, lino, tstrerror(code),
+              suid);
+  }
+  tsdbCacherowsReaderClose(pReader);
+  taosArrayDestroy(pCidList);
+  taosMemoryFree(pSlotIds);
+  taosMemoryFree(pTableList);
+  taosMemoryFree(pSchema);
+  return code;
+}
+
+static int32_t tsdbCacheWarmupExec(void *arg) {
+  SCacheWarmupTask *pTask = arg;
+  STsdb            *pTsdb = pTask->pTsdb;
+  SCacheWarmup     *pWarmup = pTsdb->pWarmup;
+  SCacheWarmupStat *pStat = &pTsdb->warmupStat;
+  int32_t           nTables = TARRAY_SIZE(pTask->pUids);
+
+  tsdbCacheWarmupThrottle(pWarmup, nTables);
+  if (!atomic_load_8(&pWarmup->stop)) {
+    (void)tsdbCacheWarmupLoad(pTsdb, pTask->suid, pTask->pUids);
+  }
+
+  int64_t loaded = atomic_add_fetch_64(&pStat->loaded, nTables);
+  if (!atomic_load_8(&pWarmup->stop) && atomic_load_8(&pStat->scheduled) && loaded == atomic_load_64(&pStat->total)) {
+    tsdbInfo("vgId:%d, last cache warmup finished, tables:%" PRId64 ", elapsed:%" PRId64 "ms", TD_VID(pTsdb->pVnode),
+             loaded, taosGetTimestampMs() - pWarmup->startMs);
+  }
+
+  tsdbCacheWarmupTaskFree(pTask);
+  return 0;
+}
+
+static int32_t tsdbCacheWarmupSchedule(STsdb *pTsdb, tb_uid_t suid, int32_t *pChannel) {
+  int32_t code = 0;
+  int32_t lino = 0;
+
+  SCacheWarmup     *pWarmup = pTsdb->pWarmup;
+  SCacheWarmupStat *pStat = &pTsdb->warmupStat;
+  SArray           *pUids = taosArrayInit(1024, sizeof(tb_uid_t));
+  if (pUids == NULL) {
+    TSDB_CHECK_CODE(code = TSDB_CODE_OUT_OF_MEMORY, lino, _exit);
+  }
+
+  code = vnodeGetCtbIdList(pTsdb->pVnode, suid, pUids);
+  TSDB_CHECK_CODE(code, lino, _exit);
+
+  for (int32_t start = 0; start < TARRAY_SIZE(pUids); start += TSDB_CACHE_WARMUP_CHUNK) {
+    int32_t nTables = TMIN(TSDB_CACHE_WARMUP_CHUNK, TARRAY_SIZE(pUids) - start);
+
+    SCacheWarmupTask *pTask = taosMemoryCalloc(1, sizeof(*pTask));
+    if (pTask == NULL) {
+      TSDB_CHECK_CODE(code = TSDB_CODE_OUT_OF_MEMORY, lino, _exit);
+    }
+    pTask->pTsdb = pTsdb;
+    pTask->suid = suid;
+    pTask->pUids = taosArrayInit(nTables, sizeof(tb_uid_t));
+    if (pTask->pUids == NULL) {
+      tsdbCacheWarmupTaskFree(pTask);
+      TSDB_CHECK_CODE(code = TSDB_CODE_OUT_OF_MEMORY, lino, _exit);
+    }
+    taosArrayAddBatch(pTask->pUids, taosArrayGet(pUids, start), nTables);
+
+    atomic_add_fetch_64(&pStat->total, nTables);
+
+    SVAChannelID *pChannelID = &pWarmup->channels[(*pChannel)++ % TSDB_CACHE_WARMUP_CHANNELS];
+    code = vnodeAsync(pChannelID, EVA_PRIORITY_LOW, tsdbCacheWarmupExec, tsdbCacheWarmupTaskFree, pTask, NULL);
+    if (code) {
+      atomic_sub_fetch_64(&pStat->total, nTables);
+      tsdbCacheWarmupTaskFree(pTask);
+      TSDB_CHECK_CODE(code, lino, _exit);
+    }
+  }
+
+_exit:
+  if (code) {
+    tsdbError("vgId:%d %s failed at line %d since %s, suid:%" PRId64, TD_VID(pTsdb->pVnode), __func__, lino,
+              tstrerror(code), suid);
+  }
+  taosArrayDestroy(pUids);
+  return code;
+}
+
+int32_t tsdbCacheWarmupStart(STsdb *pTsdb) {
+  int32_t code = 0;
+  int32_t lino = 0;
+
+  if (!tsLastCacheWarmup || pTsdb == NULL || pTsdb->pWarmup || TSDB_CACHE_NO(pTsdb->pVnode->config)) {
+    return 0;
+  }
+
+  SCacheWarmup *pWarmup = NULL;
+  SArray       *pSuids = NULL;
+  int32_t       iChannel = 0;
+
+  pWarmup = taosMemoryCalloc(1, sizeof(*pWarmup));
+  if (pWarmup == NULL) {
+    TSDB_CHECK_CODE(code = TSDB_CODE_OUT_OF_MEMORY, lino, _exit);
+  }
+  pWarmup->startMs = taosGetTimestampMs();
+  for (int32_t i = 0; i < TSDB_CACHE_WARMUP_CHANNELS; ++i) {
+    code = vnodeAChannelInit(TSDB_CACHE_WARMUP_ASYNC, &pWarmup->channels[i]);
+    TSDB_CHECK_CODE(code, lino, _exit);
+  }
+  pTsdb->pWarmup = pWarmup;
+
+  pSuids = taosArrayInit(16, sizeof(tb_uid_t));
+  if (pSuids == NULL) {
+    TSDB_CHECK_CODE(code = TSDB_CODE_OUT_OF_MEMORY, lino, _exit);
+  }
+
+  code = vnodeGetStbIdList(pTsdb->pVnode, 0, pSuids);
+  TSDB_CHECK_CODE(code, lino, _exit);
+
+  for (int32_t i = 0; i < TARRAY_SIZE(pSuids); ++i) {
+    tb_uid_t suid = *(tb_uid_t *)taosArrayGet(pSuids, i);
+    if (!tsdbCacheWarmupSelected(pTsdb, suid)) {
+      continue;
+    }
+
+    code = tsdbCacheWarmupSchedule(pTsdb, suid, &iChannel);
+    TSDB_CHECK_CODE(code, lino, _exit);
+  }
+
+  atomic_store_8(&pTsdb->warmupStat.scheduled, 1);
+  tsdbInfo("vgId:%d, last cache warmup started, tables:%" PRId64 ", rate:%d", TD_VID(pTsdb->pVnode),
+           atomic_load_64(&pTsdb->warmupStat.total), tsLastCacheWarmupRate);
+
+_exit:
+  if (code) {
+    tsdbError("vgId:%d %s failed at line %d since %s", TD_VID(pTsdb->pVnode), __func__, lino, tstrerror(code));
+    if (pWarmup) {
+      // tasks scheduled so far go on, the progress just covers them
+      atomic_store_8(&pTsdb->warmupStat.scheduled, 1);
+      if (pTsdb->pWarmup == NULL) {
+        for (int32_t i = 0; i < TSDB_CACHE_WARMUP_CHANNELS; ++i) {
+          if (pWarmup->channels[i].id > 0) {
+            (void)vnodeAChannelDestroy(&pWarmup->channels[i], false);
+          }
+        }
+        taosMemoryFree(pWarmup);
+      }
+    }
+  }
+  taosArrayDestroy(pSuids);
+  return code;
+}
+
+void tsdbCacheWarmupStop(STsdb *pTsdb) {
+  SCacheWarmup *pWarmup = pTsdb->pWarmup;
+  if (pWarmup == NULL) {
+    return;
+  }
+
+  atomic_store_8(&pWarmup->stop, 1);
+  for (int32_t i = 0; i < TSDB_CACHE_WARMUP_CHANNELS; ++i) {
+    (void)vnodeAChannelDestroy(&pWarmup->channels[i], true);
+  }
+
+  SCacheWarmupStat *pStat = &pTsdb->warmupStat;
+  tsdbInfo("vgId:%d, last cache warmup stopped, loaded:%" PRId64 " of %" PRId64, TD_VID(pTsdb->pVnode),
+           atomic_load_64(&pStat->loaded), atomic_load_64(&pStat->total));
+
+  atomic_store_64(&pStat->total, 0);
+  atomic_store_64(&pStat->loaded, 0);
+  atomic_store_8(&pStat->scheduled, 0);
+
+  taosMemoryFree(pWarmup);
+  pTsdb->pWarmup = NULL;
+}
+
+// percent of tables loaded, -1 if no warm up is running on this vnode
+int32_t tsdbCacheWarmupProgress(STsdb *pTsdb) {
+  if (pTsdb == NULL) {
+    return -1;
+  }
+
+  SCacheWarmupStat *pStat = &pTsdb->warmupStat;
+  int64_t           total = atomic_load_64(&pStat->total);
+  int64_t           loaded = atomic_load_64(&pStat->loaded);
+  if (total <= 0 || (loaded >= total && atomic_load_8(&pStat->scheduled))) {
+    return -1;
+  }
+
+  return (int32_t)TMIN(loaded * 100 / total, 99);
+}
@@ -18,6 +18,20 @@
 #include "tsdb.h"
 #include "vnd.h"
 
+#define TSDB_DIRECT_IO_ALIGN 4096
+
+static int8_t tsdbDirectIOWarned = 0;
+
+static bool tsdbUseDirectIO(STsdbFD *pFD) {
+#if defined(LINUX)
+  // only local files of writers go direct, readers keep using the page cache
+  return tsTsdbDirectWrite && (pFD->flag & TD_FILE_WRITE) && pFD->lcn <= 1 &&
+         pFD->szPage % TSDB_DIRECT_IO_ALIGN == 0;
+#else
+  return false;
+#endif
+}
+
 static int32_t tsdbOpenFileImpl(STsdbFD *pFD) {
   int32_t     code = 0;
   const char *path = pFD->path;
@@ -25,7 +39,23 @@ static int32_t tsdbOpenFileImpl(STsdbFD *pFD) {
   int32_t     flag = pFD->flag;
   int64_t     lc_size = 0;
 
-  pFD->pFD = taosOpenFile(path, flag);
+  if (tsdbUseDirectIO(pFD)) {
+    pFD->pFD = taosOpenFile(path, flag | TD_FILE_DIRECT);
+    if (pFD->pFD == NULL && errno == EINVAL) {
+      // each file falls back on its own, the warning is given once per process
+      if (atomic_val_compare_exchange_8(&tsdbDirectIOWarned, 0, 1) == 0) {
+        tsdbWarn("file:%s, O_DIRECT not supported by file system, fall back to buffered write", path);
+      } else {
+        tsdbDebug("file:%s, O_DIRECT not supported by file system, fall back to buffered write", path);
+      }
+    } else if (pFD->pFD != NULL) {
+      pFD->directIO = 1;
+    }
+  }
+
+  if (pFD->pFD == NULL) {
+    pFD->pFD = taosOpenFile(path, flag);
+  }
   if (pFD->pFD == NULL) {
     if (tsS3Enabled && pFD->lcn > 1 && !strncmp(path + strlen(path) - 5, ".data", 5)) {
       char lc_path[TSDB_FILENAME_LEN];
@@ -96,7 +126,12 @@ static int32_t tsdbOpenFileImpl(STsdbFD *pFD) {
     */
   }
 
-  pFD->pBuf = taosMemoryCalloc(1, szPage);
+  if (pFD->directIO) {
+    pFD->pBuf = taosMemoryMallocAlign(TSDB_DIRECT_IO_ALIGN, szPage);
+    if (pFD->pBuf) memset(pFD->pBuf, 0, szPage);
+  } else {
+    pFD->pBuf = taosMemoryCalloc(1, szPage);
+  }
   if (pFD->pBuf == NULL) {
     code = TSDB_CODE_OUT_OF_MEMORY;
     // taosCloseFile(&pFD->pFD);
@@ -227,6 +262,15 @@ static int32_t tsdbWriteFilePage(STsdbFD *pFD, int32_t encryptAlgorithm, char *e
       goto _exit;
     }
 
+    // batch the fdatasync of direct writes so the device cache is drained along the way instead of at commit
+    if (pFD->directIO && tsTsdbDirectWriteSyncPages > 0 && ++pFD->nUnsynced >= tsTsdbDirectWriteSyncPages) {
+      if (taosFdatasyncFile(pFD->pFD) < 0) {
+        code = TAOS_SYSTEM_ERROR(errno);
+        goto _exit;
+      }
+      pFD->nUnsynced = 0;
+    }
+
     if (pFD->szFile < pFD->pgno) {
       pFD->szFile = pFD->pgno;
     }
@@ -615,7 +659,14 @@ int32_t tsdbFsyncFile(STsdbFD *pFD, int32_t encryptAlgorithm, char *encryptKey)
   code = tsdbWriteFilePage(pFD, encryptAlgorithm, encryptKey);
   if (code) goto _exit;
 
-  if (taosFsyncFile(pFD->pFD) < 0) {
+  if (pFD->directIO) {
+    // data already bypassed the page cache, only the device cache and the file size need to be flushed
+    if (taosFdatasyncFile(pFD->pFD) < 0) {
+      code = TAOS_SYSTEM_ERROR(errno);
+      goto _exit;
+    }
+    pFD->nUnsynced = 0;
+  } else if (taosFsyncFile(pFD->pFD) < 0) {
     code = TAOS_SYSTEM_ERROR(errno);
     goto _exit;
   }
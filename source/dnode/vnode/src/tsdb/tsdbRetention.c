@@ -48,8 +48,10 @@ static int64_t tsdbCopyFileWithLimitedSpeed(TdFilePtr from, TdFilePtr to, int64_
   while (remain > 0) {
     int64_t n;
     int64_t last = taosGetTimestampMs();
-    if ((n = taosFSendFile(to, from, &offset, TMIN(limit, remain))) < 0) {
+    if ((n = taosFCopyFileRange(to, from, &offset, TMIN(limit, remain))) < 0) {
       return -1;
+    } else if (n == 0) {
+      break;
     }
 
     total += n;
@@ -89,7 +91,7 @@ static int32_t tsdbDoCopyFileLC(SRTNer *rtner, const STFileObj *from, const STFi
   SVnodeCfg *pCfg = &rtner->tsdb->pVnode->config;
   int64_t    chunksize = (int64_t)pCfg->tsdbPageSize * pCfg->s3ChunkSize;
   int64_t    lc_size = tsdbLogicToFileSize(to->size, rtner->szPage) - chunksize * (to->lcn - 1);
-  int64_t    n = taosFSendFile(fdTo, fdFrom, 0, lc_size);
+  int64_t    n = tsdbCopyFileWithLimitedSpeed(fdFrom, fdTo, lc_size, tsRetentionSpeedLimitMB);
   if (n < 0) {
     code = TAOS_SYSTEM_ERROR(errno);
     TSDB_CHECK_CODE(code, lino, _exit);
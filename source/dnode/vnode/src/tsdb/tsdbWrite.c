@@ -47,11 +47,15 @@ int tsdbInsertData(STsdb *pTsdb, int64_t version, SSubmitReq2 *pMsg, SSubmitRsp2
   }
 
   // loop to insert
+  SCacheUpdBatch *pBatch = NULL;
+  (void)tsdbCacheUpdateBatchBegin(pTsdb, &pBatch);
   for (int32_t i = 0; i < arrSize; ++i) {
     if ((terrno = tsdbInsertTableData(pTsdb, version, taosArrayGet(pMsg->aSubmitTbData, i), &affectedrows)) < 0) {
+      (void)tsdbCacheUpdateBatchEnd(pTsdb, pBatch);
       return -1;
     }
   }
+  (void)tsdbCacheUpdateBatchEnd(pTsdb, pBatch);
 
   if (pRsp != NULL) {
     // pRsp->affectedRows = affectedrows;
@@ -118,7 +118,7 @@ struct SVAsync {
   SVHashTable *taskTable;
 };
 
-SVAsync *vnodeAsyncs[3];
+SVAsync *vnodeAsyncs[4];
 #define MIN_ASYNC_ID 1
 #define MAX_ASYNC_ID (sizeof(vnodeAsyncs) / sizeof(vnodeAsyncs[0]) - 1)
 
@@ -465,6 +465,11 @@ int32_t vnodeAsyncOpen(int32_t numOfThreads) {
   TSDB_CHECK_CODE(code, lino, _exit);
   vnodeAsyncSetWorkers(2, numOfThreads);
 
+  // vnode-warmup
+  code = vnodeAsyncInit(&vnodeAsyncs[3], "vnode-warmup");
+  TSDB_CHECK_CODE(code, lino, _exit);
+  vnodeAsyncSetWorkers(3, numOfThreads);
+
 _exit:
   return 0;
 }
@@ -472,6 +477,7 @@ _exit:
 int32_t vnodeAsyncClose() {
   vnodeAsyncDestroy(&vnodeAsyncs[1]);
   vnodeAsyncDestroy(&vnodeAsyncs[2]);
+  vnodeAsyncDestroy(&vnodeAsyncs[3]);
   return 0;
 }
 
@@ -86,6 +86,7 @@ void initMetadataAPI(SStoreMeta* pMeta) {
   pMeta->extractTagVal = (const void* (*)(const void*, int16_t, STagVal*))metaGetTableTagVal;
   pMeta->getTableTags = metaGetTableTags;
   pMeta->getTableTagsByUid = metaGetTableTagsByUids;
+  pMeta->getTableTagCols = metaGetTableTagCols;
 
   pMeta->getTableUidByName = metaGetTableUidByName;
   pMeta->getTableTypeByName = metaGetTableTypeByName;
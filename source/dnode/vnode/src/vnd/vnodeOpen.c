@@ -477,6 +477,11 @@ SVnode *vnodeOpen(const char *path, int32_t diskPrimary, STfs *pTfs, SMsgCb msgC
     goto _err;
   }
 
+  if (vnodeReplayOpen(pVnode) < 0) {
+    vError("vgId:%d, failed to open replay since %s", TD_VID(pVnode), tstrerror(terrno));
+    goto _err;
+  }
+
   // open sync
   vInfo("vgId:%d, start to open sync, changeVersion:%d", TD_VID(pVnode), info.config.syncCfg.changeVersion);
   if (vnodeSyncOpen(pVnode, dir, info.config.syncCfg.changeVersion)) {
@@ -520,6 +525,7 @@ _err:
   if (pVnode->pSma) smaClose(pVnode->pSma);
   if (pVnode->pMeta) metaClose(&pVnode->pMeta);
   if (pVnode->freeList) vnodeCloseBufPool(pVnode);
+  vnodeReplayClose(pVnode);
 
   taosMemoryFree(pVnode);
   return NULL;
@@ -537,6 +543,7 @@ void vnodeClose(SVnode *pVnode) {
     vnodeAWait(&pVnode->commitTask);
     vnodeAChannelDestroy(&pVnode->commitChannel, true);
     vnodeSyncClose(pVnode);
+    vnodeReplayClose(pVnode);
     vnodeQueryClose(pVnode);
     tqClose(pVnode->pTq);
     walClose(pVnode->pWal);
@@ -557,6 +564,9 @@ void vnodeClose(SVnode *pVnode) {
 // start the sync timer after the queue is ready
 int32_t vnodeStart(SVnode *pVnode) {
   ASSERT(pVnode);
+  if (pVnode->pTsdb) {
+    (void)tsdbCacheWarmupStart(pVnode->pTsdb);
+  }
   return vnodeSyncStart(pVnode);
 }
 
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "vnd.h"
+
+// While the vnode replays its wal at open, the sync thread reads entries and hands them to the apply queue one by
+// one. Submit requests are decoded right there, so decoding overlaps with the apply thread writing the previous
+// entries. The decoded request points into the message body, which lives until the apply thread is done with it.
+
+static void vnodeReplayFreeReq(SSubmitReq2 *pReq) {
+  tDestroySubmitReq(pReq, TSDB_MSG_FLG_DECODE);
+  taosMemoryFree(pReq);
+}
+
+int32_t vnodeReplayOpen(SVnode *pVnode) {
+  pVnode->pReplayReqs = taosHashInit(64, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT), false, HASH_ENTRY_LOCK);
+  if (pVnode->pReplayReqs == NULL) {
+    terrno = TSDB_CODE_OUT_OF_MEMORY;
+    return -1;
+  }
+  return 0;
+}
+
+void vnodeReplayClose(SVnode *pVnode) {
+  if (pVnode->pReplayReqs == NULL) return;
+
+  void *pIter = taosHashIterate(pVnode->pReplayReqs, NULL);
+  while (pIter) {
+    vnodeReplayFreeReq(*(SSubmitReq2 **)pIter);
+    pIter = taosHashIterate(pVnode->pReplayReqs, pIter);
+  }
+  taosHashCleanup(pVnode->pReplayReqs);
+  pVnode->pReplayReqs = NULL;
+}
+
+void vnodeReplayDecodeAhead(SVnode *pVnode, const SRpcMsg *pMsg, int64_t ver) {
+  if (pVnode->restored || pVnode->pReplayReqs == NULL || pMsg->msgType != TDMT_VND_SUBMIT || pMsg->code != 0) {
+    return;
+  }
+  if (taosHashGetSize(pVnode->pReplayReqs) >= atomic_load_32(&tsWalReplayDecodeAhead)) {
+    return;
+  }
+
+  SSubmitReq2Msg *pSubmitMsg = (SSubmitReq2Msg *)pMsg->pCont;
+  if (pMsg->contLen <= sizeof(SSubmitReq2Msg) || pSubmitMsg->version == 0) {
+    // old format requests are converted by the apply thread
+    return;
+  }
+
+  SSubmitReq2 *pReq = taosMemoryCalloc(1, sizeof(SSubmitReq2));
+  if (pReq == NULL) return;
+
+  SDecoder dc = {0};
+  tDecoderInit(&dc, pSubmitMsg->data, pMsg->contLen - sizeof(SSubmitReq2Msg));
+  if (tDecodeSubmitReq(&dc, pReq) < 0) {
+    // leave it to the apply thread, which reports the error
+    tDecoderClear(&dc);
+    vnodeReplayFreeReq(pReq);
+    return;
+  }
+  tDecoderClear(&dc);
+
+  if (taosHashPut(pVnode->pReplayReqs, &ver, sizeof(ver), &pReq, POINTER_BYTES) != 0) {
+    vnodeReplayFreeReq(pReq);
+  }
+}
+
+SSubmitReq2 *vnodeReplayTake(SVnode *pVnode, int64_t ver) {
+  if (pVnode->pReplayReqs == NULL || taosHashGetSize(pVnode->pReplayReqs) == 0) {
+    return NULL;
+  }
+
+  SSubmitReq2 **ppReq = taosHashGet(pVnode->pReplayReqs, &ver, sizeof(ver));
+  if (ppReq == NULL) {
+    return NULL;
+  }
+
+  SSubmitReq2 *pReq = *ppReq;
+  (void)taosHashRemove(pVnode->pReplayReqs, &ver, sizeof(ver));
+  return pReq;
+}
+
+void vnodeReplayDrop(SVnode *pVnode, int64_t ver) {
+  SSubmitReq2 *pReq = vnodeReplayTake(pVnode, ver);
+  if (pReq) vnodeReplayFreeReq(pReq);
+}
@@ -717,9 +717,11 @@ int32_t vnodeProcessWriteMsg(SVnode *pVnode, SRpcMsg *pMsg, int64_t ver, SRpcMsg
   }
 
 _exit:
+  metaSnapshotPublish(pVnode->pMeta);
   return 0;
 
 _err:
+  metaSnapshotPublish(pVnode->pMeta);
   vError("vgId:%d, process %s request failed since %s, ver:%" PRId64, TD_VID(pVnode), TMSG_INFO(pMsg->msgType),
          tstrerror(terrno), ver);
   return -1;
@@ -1059,6 +1061,9 @@ static int32_t vnodeProcessCreateTbReq(SVnode *pVnode, int64_t ver, void *pReq,
   STbUidStore       *pStore = NULL;
   SArray            *tbUids = NULL;
   SArray            *tbNames = NULL;
+  SVCreateTbReq    **ppCreateReq = NULL;
+  SVCreateTbRsp     *aCreateRsp = NULL;
+  int32_t            nCreateReq = 0;
 
   pRsp->msgType = TDMT_VND_CREATE_TABLE_RSP;
   pRsp->code = TSDB_CODE_SUCCESS;
@@ -1082,10 +1087,17 @@ static int32_t vnodeProcessCreateTbReq(SVnode *pVnode, int64_t ver, void *pReq,
     goto _exit;
   }
 
-  // loop to create table
+  ppCreateReq = taosMemoryMalloc(req.nReqs * sizeof(SVCreateTbReq *));
+  aCreateRsp = taosMemoryCalloc(req.nReqs, sizeof(SVCreateTbRsp));
+  if (req.nReqs > 0 && (ppCreateReq == NULL || aCreateRsp == NULL)) {
+    rcode = -1;
+    terrno = TSDB_CODE_OUT_OF_MEMORY;
+    goto _exit;
+  }
+
+  // validate hash, the tables of this vnode are created in one batch
   for (int32_t iReq = 0; iReq < req.nReqs; iReq++) {
     pCreateReq = req.pReqs + iReq;
-    memset(&cRsp, 0, sizeof(cRsp));
 
     if (tsEnableAudit && tsEnableAuditCreateTable) {
       char *str = taosMemoryCalloc(1, TSDB_TABLE_FNAME_LEN);
@@ -1098,24 +1110,32 @@ static int32_t vnodeProcessCreateTbReq(SVnode *pVnode, int64_t ver, void *pReq,
       taosArrayPush(tbNames, &str);
     }
 
-    // validate hash
     sprintf(tbName, "%s.%s", pVnode->config.dbname, pCreateReq->name);
     if (vnodeValidateTableHash(pVnode, tbName) < 0) {
+      vError("vgId:%d create-table:%s failed due to hash value mismatch", TD_VID(pVnode), tbName);
+      continue;
+    }
+    ppCreateReq[nCreateReq++] = pCreateReq;
+  }
+
+  metaCreateTables(pVnode->pMeta, ver, ppCreateReq, aCreateRsp, nCreateReq);
+
+  for (int32_t iReq = 0, iCreate = 0; iReq < req.nReqs; iReq++) {
+    pCreateReq = req.pReqs + iReq;
+    memset(&cRsp, 0, sizeof(cRsp));
+
+    if (iCreate >= nCreateReq || ppCreateReq[iCreate] != pCreateReq) {
       cRsp.code = TSDB_CODE_VND_HASH_MISMATCH;
       taosArrayPush(rsp.pArray, &cRsp);
-      vError("vgId:%d create-table:%s failed due to hash value mismatch", TD_VID(pVnode), tbName);
       continue;
     }
 
-    // do create table
-    if (metaCreateTable(pVnode->pMeta, ver, pCreateReq, &cRsp.pMeta) < 0) {
-      if (pCreateReq->flags & TD_CREATE_IF_NOT_EXISTS && terrno == TSDB_CODE_TDB_TABLE_ALREADY_EXIST) {
+    cRsp = aCreateRsp[iCreate++];
+    if (cRsp.code != TSDB_CODE_SUCCESS) {
+      if (pCreateReq->flags & TD_CREATE_IF_NOT_EXISTS && cRsp.code == TSDB_CODE_TDB_TABLE_ALREADY_EXIST) {
         cRsp.code = TSDB_CODE_SUCCESS;
-      } else {
-        cRsp.code = terrno;
       }
     } else {
-      cRsp.code = TSDB_CODE_SUCCESS;
       tdFetchTbUidList(pVnode->pSma, &pStore, pCreateReq->ctb.suid, pCreateReq->uid);
       taosArrayPush(tbUids, &pCreateReq->uid);
       vnodeUpdateMetaRsp(pVnode, cRsp.pMeta);
@@ -1170,6 +1190,8 @@ static int32_t vnodeProcessCreateTbReq(SVnode *pVnode, int64_t ver, void *pReq,
   }
 
 _exit:
+  taosMemoryFree(ppCreateReq);
+  taosMemoryFree(aCreateRsp);
   tDeleteSVCreateTbBatchReq(&req);
   taosArrayDestroyEx(rsp.pArray, tFreeSVCreateTbRsp);
   taosArrayDestroy(tbUids);
@@ -1621,11 +1643,13 @@ static int32_t vnodeProcessSubmitReq(SVnode *pVnode, int64_t ver, void *pReq, in
   int32_t code = 0;
   terrno = 0;
 
-  SSubmitReq2 *pSubmitReq = &(SSubmitReq2){0};
-  SSubmitRsp2 *pSubmitRsp = &(SSubmitRsp2){0};
-  SArray      *newTbUids = NULL;
-  int32_t      ret;
-  SEncoder     ec = {0};
+  SSubmitReq2    *pSubmitReq = &(SSubmitReq2){0};
+  SSubmitRsp2    *pSubmitRsp = &(SSubmitRsp2){0};
+  SArray         *newTbUids = NULL;
+  SCacheUpdBatch *pUpdBatch = NULL;
+  int32_t         nCreateTb = 0;
+  int32_t         ret;
+  SEncoder        ec = {0};
 
   pRsp->code = TSDB_CODE_SUCCESS;
 
@@ -1643,16 +1667,22 @@ static int32_t vnodeProcessSubmitReq(SVnode *pVnode, int64_t ver, void *pReq, in
       goto _exit;
     }
   } else {
-    // decode
+    // decode, or take the request decoded ahead during wal replay
     pReq = POINTER_SHIFT(pReq, sizeof(SSubmitReq2Msg));
     len -= sizeof(SSubmitReq2Msg);
-    SDecoder dc = {0};
-    tDecoderInit(&dc, pReq, len);
-    if (tDecodeSubmitReq(&dc, pSubmitReq) < 0) {
-      code = TSDB_CODE_INVALID_MSG;
-      goto _exit;
+    SSubmitReq2 *pDecoded = vnodeReplayTake(pVnode, ver);
+    if (pDecoded) {
+      *pSubmitReq = *pDecoded;
+      taosMemoryFree(pDecoded);
+    } else {
+      SDecoder dc = {0};
+      tDecoderInit(&dc, pReq, len);
+      if (tDecodeSubmitReq(&dc, pSubmitReq) < 0) {
+        code = TSDB_CODE_INVALID_MSG;
+        goto _exit;
+      }
+      tDecoderClear(&dc);
     }
-    tDecoderClear(&dc);
   }
 
   // scan
@@ -1769,24 +1799,42 @@ static int32_t vnodeProcessSubmitReq(SVnode *pVnode, int64_t ver, void *pReq, in
 
   vDebug("vgId:%d, submit block size %d", TD_VID(pVnode), (int32_t)taosArrayGetSize(pSubmitReq->aSubmitTbData));
 
-  // loop to handle
+  // collect last cache updates of all tables and apply them once
+  (void)tsdbCacheUpdateBatchBegin(pVnode->pTsdb, &pUpdBatch);
+
+  // create the tables of the request in one batch, before any data goes in
   for (int32_t i = 0; i < TARRAY_SIZE(pSubmitReq->aSubmitTbData); ++i) {
     SSubmitTbData *pSubmitTbData = taosArrayGet(pSubmitReq->aSubmitTbData, i);
+    if (pSubmitTbData->pCreateTbReq) nCreateTb++;
+  }
+
+  if (nCreateTb > 0) {
+    SVCreateTbReq **ppCreateTbReq = taosMemoryMalloc(nCreateTb * sizeof(SVCreateTbReq *));
+    if (ppCreateTbReq == NULL || (pSubmitRsp->aCreateTbRsp = taosArrayInit(nCreateTb, sizeof(SVCreateTbRsp))) == NULL) {
+      taosMemoryFree(ppCreateTbReq);
+      code = TSDB_CODE_OUT_OF_MEMORY;
+      goto _exit;
+    }
+
+    for (int32_t i = 0, iCreate = 0; i < TARRAY_SIZE(pSubmitReq->aSubmitTbData); ++i) {
+      SSubmitTbData *pSubmitTbData = taosArrayGet(pSubmitReq->aSubmitTbData, i);
+      if (pSubmitTbData->pCreateTbReq) ppCreateTbReq[iCreate++] = pSubmitTbData->pCreateTbReq;
+    }
+
+    SVCreateTbRsp *aCreateTbRsp = taosArrayReserve(pSubmitRsp->aCreateTbRsp, nCreateTb);
+    metaCreateTables(pVnode->pMeta, ver, ppCreateTbReq, aCreateTbRsp, nCreateTb);
+    taosMemoryFree(ppCreateTbReq);
+  }
+
+  // loop to handle
+  for (int32_t i = 0, iCreate = 0; i < TARRAY_SIZE(pSubmitReq->aSubmitTbData); ++i) {
+    SSubmitTbData *pSubmitTbData = taosArrayGet(pSubmitReq->aSubmitTbData, i);
 
     // create table
     if (pSubmitTbData->pCreateTbReq) {
-      // alloc if need
-      if (pSubmitRsp->aCreateTbRsp == NULL &&
-          (pSubmitRsp->aCreateTbRsp = taosArrayInit(TARRAY_SIZE(pSubmitReq->aSubmitTbData), sizeof(SVCreateTbRsp))) ==
-              NULL) {
-        code = TSDB_CODE_OUT_OF_MEMORY;
-        goto _exit;
-      }
+      SVCreateTbRsp *pCreateTbRsp = taosArrayGet(pSubmitRsp->aCreateTbRsp, iCreate++);
 
-      SVCreateTbRsp *pCreateTbRsp = taosArrayReserve(pSubmitRsp->aCreateTbRsp, 1);
-
-      // create table
-      if (metaCreateTable(pVnode->pMeta, ver, pSubmitTbData->pCreateTbReq, &pCreateTbRsp->pMeta) == 0) {
+      if (pCreateTbRsp->code == TSDB_CODE_SUCCESS) {
         // create table success
 
         if (newTbUids == NULL &&
@@ -1801,13 +1849,13 @@ static int32_t vnodeProcessSubmitReq(SVnode *pVnode, int64_t ver, void *pReq, in
           vnodeUpdateMetaRsp(pVnode, pCreateTbRsp->pMeta);
         }
       } else {  // create table failed
-        if (terrno != TSDB_CODE_TDB_TABLE_ALREADY_EXIST) {
-          code = terrno;
+        if (pCreateTbRsp->code != TSDB_CODE_TDB_TABLE_ALREADY_EXIST) {
+          code = pCreateTbRsp->code;
           vError("vgId:%d failed to create table:%s, code:%s", TD_VID(pVnode), pSubmitTbData->pCreateTbReq->name,
-                 tstrerror(terrno));
+                 tstrerror(code));
           goto _exit;
         }
-        terrno = 0;
+        pCreateTbRsp->code = TSDB_CODE_SUCCESS;
         pSubmitTbData->uid = pSubmitTbData->pCreateTbReq->uid;  // update uid if table exist for using below
       }
     }
@@ -1831,6 +1879,9 @@ static int32_t vnodeProcessSubmitReq(SVnode *pVnode, int64_t ver, void *pReq, in
   }
 
 _exit:
+  // rows inserted before a failure are in the mem table, keep the cache in step with them
+  (void)tsdbCacheUpdateBatchEnd(pVnode->pTsdb, pUpdBatch);
+
   // message
   pRsp->code = code;
   tEncodeSize(tEncodeSSubmitRsp2, pSubmitRsp, pRsp->contLen, ret);
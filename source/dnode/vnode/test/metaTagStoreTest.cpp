@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "meta.h"
+
+namespace {
+
+const char    *kPath = "meta_tag_store_test";
+const tb_uid_t kSuid = 1000;
+
+// tags of the super table: t_int int, t_str binary(16), t_big bigint, and t_new binary(8) once the stb is altered
+const col_id_t kCidInt = 3;
+const col_id_t kCidStr = 4;
+const col_id_t kCidBig = 5;
+const col_id_t kCidNew = 6;
+
+// one tag value as a test writes it, a var value may be empty
+struct TagVal {
+  bool        isNull;
+  int64_t     i64;
+  std::string str;
+};
+
+TagVal tagNull() { return TagVal{true, 0, ""}; }
+TagVal tagNum(int64_t v) { return TagVal{false, v, ""}; }
+TagVal tagStr(const std::string &s) { return TagVal{false, 0, s}; }
+
+class MetaTagStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    taosRemoveDir(kPath);
+
+    pVnode = (SVnode *)taosMemoryCalloc(1, sizeof(SVnode));
+    ASSERT_TRUE(pVnode != NULL);
+    pVnode->path = (char *)kPath;
+    pVnode->config.vgId = 2;
+    pVnode->config.szPage = 4096;
+    pVnode->config.szCache = 256;
+    pVnode->config.cacheLast = 0;
+
+    ASSERT_EQ(metaOpen(pVnode, &pVnode->pMeta, 0), 0);
+    pMeta = pVnode->pMeta;
+    ASSERT_EQ(metaBegin(pMeta, META_BEGIN_HEAP_OS), 0);
+
+    addTag(TSDB_DATA_TYPE_INT, kCidInt, "t_int", sizeof(int32_t));
+    addTag(TSDB_DATA_TYPE_BINARY, kCidStr, "t_str", 16 + VARSTR_HEADER_SIZE);
+    addTag(TSDB_DATA_TYPE_BIGINT, kCidBig, "t_big", sizeof(int64_t));
+    createStb();
+  }
+
+  void TearDown() override {
+    metaClose(&pVnode->pMeta);
+    taosMemoryFree(pVnode);
+    taosRemoveDir(kPath);
+  }
+
+  void addTag(int8_t type, col_id_t cid, const char *name, int32_t bytes) {
+    SSchema schema = {.type = type, .flags = 0, .colId = cid, .bytes = bytes};
+    tstrncpy(schema.name, name, TSDB_COL_NAME_LEN);
+    tags.push_back(schema);
+  }
+
+  void stbReq(SVCreateStbReq *pReq, SSchema *aCol) {
+    aCol[0] = (SSchema){.type = TSDB_DATA_TYPE_TIMESTAMP, .flags = 0, .colId = 1, .bytes = sizeof(int64_t)};
+    tstrncpy(aCol[0].name, "ts", TSDB_COL_NAME_LEN);
+    aCol[1] = (SSchema){.type = TSDB_DATA_TYPE_INT, .flags = 0, .colId = 2, .bytes = sizeof(int32_t)};
+    tstrncpy(aCol[1].name, "c1", TSDB_COL_NAME_LEN);
+
+    memset(pReq, 0, sizeof(*pReq));
+    pReq->name = (char *)"stb";
+    pReq->suid = kSuid;
+    pReq->schemaRow = (SSchemaWrapper){.nCols = 2, .version = 1, .pSchema = aCol};
+    pReq->schemaTag = (SSchemaWrapper){.nCols = (int32_t)tags.size(), .version = tagVer, .pSchema = tags.data()};
+  }
+
+  void createStb() {
+    SVCreateStbReq req;
+    SSchema        aCol[2];
+    stbReq(&req, aCol);
+    ASSERT_EQ(metaCreateSTable(pMeta, ++ver, &req), 0);
+  }
+
+  void alterStb() {
+    SVCreateStbReq req;
+    SSchema        aCol[2];
+    tagVer++;
+    stbReq(&req, aCol);
+    ASSERT_EQ(metaAlterSTable(pMeta, ++ver, &req), 0);
+  }
+
+  STag *buildTag(const std::vector<TagVal> &vals) {
+    SArray *pTagVals = taosArrayInit(vals.size(), sizeof(STagVal));
+    STag   *pTag = NULL;
+
+    for (size_t i = 0; i < vals.size(); i++) {
+      if (vals[i].isNull) continue;
+
+      STagVal tagVal = {.cid = tags[i].colId, .type = tags[i].type};
+      if (IS_VAR_DATA_TYPE(tags[i].type)) {
+        tagVal.pData = (uint8_t *)vals[i].str.data();
+        tagVal.nData = vals[i].str.size();
+      } else {
+        memcpy(&tagVal.i64, &vals[i].i64, tDataTypes[tags[i].type].bytes);
+      }
+      taosArrayPush(pTagVals, &tagVal);
+    }
+
+    EXPECT_EQ(tTagNew(pTagVals, tagVer, false, &pTag), 0);
+    taosArrayDestroy(pTagVals);
+    return pTag;
+  }
+
+  tb_uid_t createCtb(int32_t id, const std::vector<TagVal> &vals) {
+    char          name[TSDB_TABLE_NAME_LEN];
+    STag         *pTag = buildTag(vals);
+    SVCreateTbReq req = {0};
+
+    snprintf(name, sizeof(name), "ctb_%d", id);
+    req.name = name;
+    req.uid = kSuid + 1 + id;
+    req.type = TSDB_CHILD_TABLE;
+    req.btime = 1000;
+    req.ctb.stbName = (char *)"stb";
+    req.ctb.suid = kSuid;
+    req.ctb.pTag = (uint8_t *)pTag;
+    EXPECT_EQ(metaCreateTable(pMeta, ++ver, &req, NULL), 0);
+
+    tTagFree(pTag);
+    return req.uid;
+  }
+
+  void updateTag(int32_t id, col_id_t cid, const TagVal &val) {
+    char         name[TSDB_TABLE_NAME_LEN];
+    SVAlterTbReq req = {0};
+    int32_t      iTag = 0;
+
+    while (tags[iTag].colId != cid) iTag++;
+
+    snprintf(name, sizeof(name), "ctb_%d", id);
+    req.tbName = name;
+    req.action = TSDB_ALTER_TABLE_UPDATE_TAG_VAL;
+    req.tagName = tags[iTag].name;
+    req.tagType = tags[iTag].type;
+    req.isNull = val.isNull;
+    if (IS_VAR_DATA_TYPE(tags[iTag].type)) {
+      req.pTagVal = (uint8_t *)val.str.data();
+      req.nTagVal = val.str.size();
+    } else {
+      req.pTagVal = (uint8_t *)&val.i64;
+      req.nTagVal = tDataTypes[tags[iTag].type].bytes;
+    }
+    ASSERT_EQ(metaAlterTable(pMeta, ++ver, &req, NULL), 0);
+  }
+
+  void dropCtb(int32_t id) {
+    char        name[TSDB_TABLE_NAME_LEN];
+    SVDropTbReq req = {0};
+
+    snprintf(name, sizeof(name), "ctb_%d", id);
+    req.name = name;
+    req.suid = kSuid;
+    ASSERT_EQ(metaDropTable(pMeta, ++ver, &req, NULL, NULL), 0);
+  }
+
+  SArray *colList(const std::vector<col_id_t> &cids) {
+    SArray *pColList = taosArrayInit(cids.size(), sizeof(SColumnInfo));
+    for (col_id_t cid : cids) {
+      for (auto &tag : tags) {
+        if (tag.colId != cid) continue;
+        SColumnInfo info = {.colId = tag.colId, .bytes = tag.bytes, .type = tag.type};
+        taosArrayPush(pColList, &info);
+      }
+    }
+    return pColList;
+  }
+
+  // the tags of each child table as decoded from the blobs in the ctb index, in uid order
+  void blobTags(const std::vector<col_id_t> &cids, std::vector<tb_uid_t> *pUids,
+                std::vector<std::vector<TagVal>> *pVals) {
+    SMCtbCursor *pCur = metaOpenCtbCursor(pVnode, kSuid, 1);
+    ASSERT_TRUE(pCur != NULL);
+
+    while (true) {
+      tb_uid_t uid = metaCtbCursorNext(pCur);
+      if (uid == 0) break;
+
+      std::vector<TagVal> row;
+      for (col_id_t cid : cids) {
+        STagVal tagVal = {.cid = cid};
+        if (!tTagGet((STag *)pCur->pVal, &tagVal)) {
+          row.push_back(tagNull());
+        } else if (IS_VAR_DATA_TYPE(tagVal.type)) {
+          row.push_back(tagStr(std::string((char *)tagVal.pData, tagVal.nData)));
+        } else {
+          int64_t v = 0;
+          memcpy(&v, &tagVal.i64, tDataTypes[tagVal.type].bytes);
+          row.push_back(tagNum(v));
+        }
+      }
+      pUids->push_back(uid);
+      pVals->push_back(row);
+    }
+    metaCloseCtbCursor(pCur);
+  }
+
+  void checkCell(SColumnInfoData *pColInfo, int32_t row, const TagVal &expect, tb_uid_t uid) {
+    SCOPED_TRACE("uid " + std::to_string(uid) + " cid " + std::to_string(pColInfo->info.colId));
+
+    ASSERT_EQ(colDataIsNull_s(pColInfo, row), expect.isNull);
+    if (expect.isNull) return;
+
+    char *pData = colDataGetData(pColInfo, row);
+    if (IS_VAR_DATA_TYPE(pColInfo->info.type)) {
+      EXPECT_EQ(std::string(varDataVal(pData), varDataLen(pData)), expect.str);
+    } else {
+      int64_t v = 0;
+      memcpy(&v, pData, tDataTypes[pColInfo->info.type].bytes);
+      EXPECT_EQ(v, expect.i64);
+    }
+  }
+
+  // every child table through the tag store, compared against the blobs
+  void checkAll(const std::vector<col_id_t> &cids) {
+    std::vector<tb_uid_t>            uids;
+    std::vector<std::vector<TagVal>> vals;
+    blobTags(cids, &uids, &vals);
+
+    SArray      *pColList = colList(cids);
+    SArray      *pUidTagList = taosArrayInit(8, sizeof(STUidTagInfo));
+    SSDataBlock *pBlock = NULL;
+    ASSERT_EQ(metaGetTableTagCols(pVnode, kSuid, pColList, pUidTagList, &pBlock), 0);
+
+    ASSERT_EQ(taosArrayGetSize(pUidTagList), uids.size());
+    ASSERT_EQ(pBlock->info.rows, (int64_t)uids.size());
+    for (size_t i = 0; i < uids.size(); i++) {
+      ASSERT_EQ(((STUidTagInfo *)taosArrayGet(pUidTagList, i))->uid, uids[i]);
+      for (size_t j = 0; j < cids.size(); j++) {
+        checkCell((SColumnInfoData *)taosArrayGet(pBlock->pDataBlock, j), i, vals[i][j], uids[i]);
+      }
+    }
+
+    blockDataDestroy(pBlock);
+    taosArrayDestroy(pUidTagList);
+    taosArrayDestroy(pColList);
+  }
+
+  // the given uids through the tag store, a uid that is not a child table of the stb gets NULL tags
+  void checkUids(const std::vector<col_id_t> &cids, const std::vector<tb_uid_t> &query) {
+    std::vector<tb_uid_t>            uids;
+    std::vector<std::vector<TagVal>> vals;
+    blobTags(cids, &uids, &vals);
+
+    SArray      *pColList = colList(cids);
+    SArray      *pUidTagList = taosArrayInit(8, sizeof(STUidTagInfo));
+    SSDataBlock *pBlock = NULL;
+    for (tb_uid_t uid : query) {
+      STUidTagInfo info = {.uid = (uint64_t)uid};
+      taosArrayPush(pUidTagList, &info);
+    }
+    ASSERT_EQ(metaGetTableTagCols(pVnode, kSuid, pColList, pUidTagList, &pBlock), 0);
+
+    ASSERT_EQ(pBlock->info.rows, (int64_t)query.size());
+    for (size_t i = 0; i < query.size(); i++) {
+      size_t k = std::find(uids.begin(), uids.end(), query[i]) - uids.begin();
+      for (size_t j = 0; j < cids.size(); j++) {
+        checkCell((SColumnInfoData *)taosArrayGet(pBlock->pDataBlock, j), i,
+                  k < uids.size() ? vals[k][j] : tagNull(), query[i]);
+      }
+    }
+
+    blockDataDestroy(pBlock);
+    taosArrayDestroy(pUidTagList);
+    taosArrayDestroy(pColList);
+  }
+
+  // NULL, empty and repeated var tags, so the dictionary codes are shared and the empty code is used
+  std::vector<TagVal> genTags(int32_t id) {
+    return {id % 7 == 0 ? tagNull() : tagNum(id * 3),
+            id % 5 == 0 ? tagNull() : (id % 3 == 0 ? tagStr("") : tagStr("v" + std::to_string(id % 4))),
+            id % 2 == 0 ? tagNull() : tagNum((int64_t)id << 33)};
+  }
+
+  SVnode              *pVnode = NULL;
+  SMeta               *pMeta = NULL;
+  std::vector<SSchema> tags;
+  int32_t              tagVer = 1;
+  int64_t              ver = 0;
+};
+
+}  // namespace
+
+TEST_F(MetaTagStoreTest, CreateAlterDrop) {
+  std::vector<tb_uid_t> uids;
+  for (int32_t id = 0; id < 100; id++) {
+    uids.push_back(createCtb(id, genTags(id)));
+  }
+
+  // the first filter builds the store, the second one reads it
+  checkAll({kCidInt, kCidStr});
+  checkAll({kCidInt, kCidStr});
+
+  // kept up to date by creates, tag updates and drops, the order merges the new uids in
+  for (int32_t id = 100; id < 150; id++) {
+    uids.push_back(createCtb(id, genTags(id)));
+  }
+  updateTag(1, kCidStr, tagStr(""));
+  updateTag(2, kCidStr, tagNull());
+  updateTag(5, kCidStr, tagStr("new"));
+  updateTag(3, kCidInt, tagNull());
+  updateTag(7, kCidInt, tagNum(-7));
+  for (int32_t id = 10; id < 150; id += 9) {
+    dropCtb(id);
+  }
+  checkAll({kCidInt, kCidStr});
+  checkUids({kCidStr, kCidInt}, {uids[149], uids[10], uids[5], uids[1], uids[2], kSuid + 10000});
+
+  // a column the store has not seen yet is read from the blobs
+  checkAll({kCidBig, kCidStr});
+
+  // a create after the drops, with the columns of the store already built
+  createCtb(500, {tagNum(0), tagStr(""), tagNum(5)});
+  checkAll({kCidInt, kCidStr, kCidBig});
+}
+
+TEST_F(MetaTagStoreTest, StbAlter) {
+  for (int32_t id = 0; id < 40; id++) {
+    createCtb(id, genTags(id));
+  }
+  checkAll({kCidInt, kCidStr, kCidBig});
+
+  // the new tag is NULL for the tables created before it, and set for the ones created after
+  addTag(TSDB_DATA_TYPE_BINARY, kCidNew, "t_new", 8 + VARSTR_HEADER_SIZE);
+  alterStb();
+  checkAll({kCidInt, kCidNew});
+
+  std::vector<TagVal> vals = genTags(40);
+  vals.push_back(tagStr("n"));
+  createCtb(40, vals);
+  updateTag(0, kCidNew, tagStr(""));
+  checkAll({kCidNew, kCidStr});
+}
+
+TEST_F(MetaTagStoreTest, Abort) {
+  for (int32_t id = 0; id < 40; id++) {
+    createCtb(id, genTags(id));
+  }
+  ASSERT_EQ(metaCommit(pMeta, pMeta->txn), 0);
+  ASSERT_EQ(metaFinishCommit(pMeta, pMeta->txn), 0);
+  ASSERT_EQ(metaBegin(pMeta, META_BEGIN_HEAP_OS), 0);
+  checkAll({kCidInt, kCidStr});
+
+  // the store takes the changes of the txn, and forgets them when it is aborted
+  for (int32_t id = 40; id < 60; id++) {
+    createCtb(id, genTags(id));
+  }
+  updateTag(1, kCidStr, tagStr("aborted"));
+  dropCtb(2);
+  checkAll({kCidInt, kCidStr});
+
+  ASSERT_EQ(metaAbort(pMeta), 0);
+  ASSERT_EQ(metaBegin(pMeta, META_BEGIN_HEAP_OS), 0);
+  checkAll({kCidInt, kCidStr});
+  checkAll({kCidStr, kCidBig});
+}
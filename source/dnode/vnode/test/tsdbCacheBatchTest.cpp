@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include <tglobal.h>
+
+#include "tsdb.h"
+
+#define TEST_DIR "tsdbCacheBatchTest"
+
+namespace {
+
+const int32_t nThread = 8;
+const int32_t nRound = 200;
+const int32_t nOwnTable = 20;  // tables only one thread writes
+const int32_t nSharedTable = 10;
+const int16_t nCol = 4;
+
+tb_uid_t ownUid(int32_t thread, int32_t i) { return 1000 + thread * nOwnTable + i; }
+tb_uid_t sharedUid(int32_t i) { return 1 + i; }
+
+// the timestamp a thread writes in a round, never equal between threads
+TSKEY rowTs(int32_t thread, int32_t round) { return (TSKEY)round * nThread + thread + 1; }
+
+class TsdbCacheBatchTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    vnode.config.cacheLastSize = 64;
+    vnode.config.tsdbPageSize = 4096;
+    tsdb.pVnode = &vnode;
+    tsdb.path = (char *)TEST_DIR;
+
+    taosRemoveDir(TEST_DIR);
+    ASSERT_EQ(taosMkDir(TEST_DIR), 0);
+    ASSERT_EQ(tsdbOpenCache(&tsdb), 0);
+
+    for (int32_t i = 0; i < nSharedTable; i++) {
+      newTable(sharedUid(i));
+    }
+    for (int32_t t = 0; t < nThread; t++) {
+      for (int32_t i = 0; i < nOwnTable; i++) {
+        newTable(ownUid(t, i));
+      }
+    }
+  }
+
+  void TearDown() override {
+    tsdbCloseCache(&tsdb);
+    taosRemoveDir(TEST_DIR);
+  }
+
+  void newTable(tb_uid_t uid) {
+    for (int16_t cid = 1; cid <= nCol; cid++) {
+      ASSERT_EQ(tsdbCacheNewNTableColumn(&tsdb, uid, cid, TSDB_DATA_TYPE_BIGINT), 0);
+    }
+  }
+
+  void update(tb_uid_t uid, TSKEY ts) {
+    SArray *ctxArray = taosArrayInit(nCol * 2, sizeof(SLastUpdateCtx));
+    for (int16_t cid = 1; cid <= nCol; cid++) {
+      for (int8_t lflag = 0; lflag < 2; lflag++) {
+        SLastUpdateCtx ctx = {0};
+        ctx.lflag = lflag;
+        ctx.tsdbRowKey.key.ts = ts;
+        ctx.colVal.cid = cid;
+        ctx.colVal.flag = CV_FLAG_VALUE;
+        ctx.colVal.value.type = TSDB_DATA_TYPE_BIGINT;
+        ctx.colVal.value.val = ts * 10 + cid;
+        taosArrayPush(ctxArray, &ctx);
+      }
+    }
+    ASSERT_EQ(tsdbCacheUpdateOrBatch(&tsdb, 0, uid, ctxArray), 0);
+    taosArrayDestroy(ctxArray);
+  }
+
+  // an insert of one submit request: every table of the thread and all shared ones, in a batch or one by one
+  void insert(int32_t thread, int32_t round) {
+    SCacheUpdBatch *pBatch = NULL;
+    bool            batched = round % 4 != 3;
+    TSKEY           ts = rowTs(thread, round);
+
+    if (batched) {
+      ASSERT_EQ(tsdbCacheUpdateBatchBegin(&tsdb, &pBatch), 0);
+    }
+    for (int32_t i = 0; i < nOwnTable; i++) {
+      update(ownUid(thread, i), ts);
+      // a table updated twice in a request keeps the newer row
+      if (i % 5 == 0) update(ownUid(thread, i), ts - nThread);
+    }
+    for (int32_t i = 0; i < nSharedTable; i++) {
+      update(sharedUid(i), ts);
+    }
+    if (batched) {
+      ASSERT_EQ(tsdbCacheUpdateBatchEnd(&tsdb, pBatch), 0);
+    }
+  }
+
+  // ts TSKEY_MIN: never updated
+  void check(tb_uid_t uid, TSKEY ts) {
+    for (int16_t cid = 1; cid <= nCol; cid++) {
+      for (int8_t lflag = 0; lflag < 2; lflag++) {
+        // SLastKey: uid, cid, lflag
+        char key[sizeof(tb_uid_t) + sizeof(int16_t) + sizeof(int8_t)] = {0};
+        memcpy(key, &uid, sizeof(uid));
+        memcpy(key + sizeof(uid), &cid, sizeof(cid));
+        memcpy(key + sizeof(uid) + sizeof(cid), &lflag, sizeof(lflag));
+
+        LRUHandle *h = taosLRUCacheLookup(tsdb.lruCache, key, sizeof(key));
+        ASSERT_NE(h, nullptr) << "uid " << uid << " cid " << cid;
+        SLastCol *pLastCol = (SLastCol *)taosLRUCacheValue(tsdb.lruCache, h);
+        TSKEY     lastTs = pLastCol->rowKey.ts;
+        int64_t   lastVal = pLastCol->colVal.value.val;
+        taosLRUCacheRelease(tsdb.lruCache, h, false);
+
+        ASSERT_EQ(lastTs, ts) << "uid " << uid << " cid " << cid << " lflag " << (int)lflag;
+        if (ts != TSKEY_MIN) {
+          ASSERT_EQ(lastVal, ts * 10 + cid);
+        }
+      }
+    }
+  }
+
+  SVnode vnode = {0};
+  STsdb  tsdb = {0};
+};
+
+}  // namespace
+
+TEST_F(TsdbCacheBatchTest, ConcurrentInsert) {
+  std::vector<std::thread> threads;
+  for (int32_t t = 0; t < nThread; t++) {
+    threads.emplace_back([this, t]() {
+      for (int32_t r = 0; r < nRound; r++) {
+        insert(t, r);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (int32_t t = 0; t < nThread; t++) {
+    for (int32_t i = 0; i < nOwnTable; i++) {
+      check(ownUid(t, i), rowTs(t, nRound - 1));
+    }
+  }
+  for (int32_t i = 0; i < nSharedTable; i++) {
+    check(sharedUid(i), rowTs(nThread - 1, nRound - 1));
+  }
+}
+
+TEST_F(TsdbCacheBatchTest, NestedBatch) {
+  STsdb other = {0};
+  other.pVnode = &vnode;
+
+  SCacheUpdBatch *pOuter = NULL;
+  SCacheUpdBatch *pInner = NULL;
+
+  // a batch of another tsdb opened inside (rsma levels) does not take this tsdb's updates
+  ASSERT_EQ(tsdbCacheUpdateBatchBegin(&tsdb, &pOuter), 0);
+  update(sharedUid(0), 10);
+  ASSERT_EQ(tsdbCacheUpdateBatchBegin(&other, &pInner), 0);
+  update(sharedUid(1), 10);
+  ASSERT_EQ(tsdbCacheUpdateBatchEnd(&other, pInner), 0);
+  update(sharedUid(2), 10);
+
+  // nothing applied until the outer batch ends
+  check(sharedUid(0), TSKEY_MIN);
+  check(sharedUid(1), TSKEY_MIN);
+  ASSERT_EQ(tsdbCacheUpdateBatchEnd(&tsdb, pOuter), 0);
+  check(sharedUid(0), 10);
+  check(sharedUid(1), 10);
+  check(sharedUid(2), 10);
+
+  // once closed, updates go straight to the cache
+  update(sharedUid(3), 20);
+  check(sharedUid(3), 20);
+}
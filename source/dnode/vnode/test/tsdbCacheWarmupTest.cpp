@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <tglobal.h>
+
+#include "tsdb.h"
+#include "vnd.h"
+
+namespace {
+
+const char *kPath = "tsdb_cache_warmup_test";
+
+// stb with 600 child tables, 3 chunks of warm up, and stb2 with 10 child tables
+const tb_uid_t kSuid = 1000;
+const int32_t  kCtbs = 600;
+const tb_uid_t kSuid2 = 2000;
+const int32_t  kCtbs2 = 10;
+
+class TsdbCacheWarmupTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() { ASSERT_EQ(vnodeAsyncOpen(2), 0); }
+  static void TearDownTestCase() { vnodeAsyncClose(); }
+
+  void SetUp() override {
+    warmup = tsLastCacheWarmup;
+    rate = tsLastCacheWarmupRate;
+    tstrncpy(stbs, tsLastCacheWarmupStbs, sizeof(stbs));
+    tsLastCacheWarmup = true;
+    tsLastCacheWarmupRate = 0;
+    tsLastCacheWarmupStbs[0] = '\0';
+
+    taosRemoveDir(kPath);
+    pVnode = (SVnode *)taosMemoryCalloc(1, sizeof(SVnode));
+    ASSERT_TRUE(pVnode != NULL);
+    pVnode->path = (char *)kPath;
+    pVnode->config.vgId = 2;
+    pVnode->config.szPage = 4096;
+    pVnode->config.szCache = 256;
+    pVnode->config.cacheLast = 1;
+    pVnode->config.cacheLastSize = 1;
+
+    ASSERT_EQ(metaOpen(pVnode, &pVnode->pMeta, 0), 0);
+    ASSERT_EQ(metaBegin(pVnode->pMeta, META_BEGIN_HEAP_OS), 0);
+    ASSERT_EQ(tsdbOpen(pVnode, &pVnode->pTsdb, VNODE_TSDB_DIR, NULL, 0, false), 0);
+    pTsdb = pVnode->pTsdb;
+
+    createStb(kSuid, "stb", kCtbs);
+    createStb(kSuid2, "stb2", kCtbs2);
+  }
+
+  void TearDown() override {
+    tsdbClose(&pVnode->pTsdb);
+    metaClose(&pVnode->pMeta);
+    taosMemoryFree(pVnode);
+    taosRemoveDir(kPath);
+
+    tsLastCacheWarmup = warmup;
+    tsLastCacheWarmupRate = rate;
+    tstrncpy(tsLastCacheWarmupStbs, stbs, sizeof(stbs));
+  }
+
+  void createStb(tb_uid_t suid, const char *stbName, int32_t nCtbs) {
+    SSchema aCol[2];
+    aCol[0] = (SSchema){.type = TSDB_DATA_TYPE_TIMESTAMP, .flags = 0, .colId = 1, .bytes = sizeof(int64_t)};
+    tstrncpy(aCol[0].name, "ts", TSDB_COL_NAME_LEN);
+    aCol[1] = (SSchema){.type = TSDB_DATA_TYPE_INT, .flags = 0, .colId = 2, .bytes = sizeof(int32_t)};
+    tstrncpy(aCol[1].name, "c1", TSDB_COL_NAME_LEN);
+    SSchema tag = {.type = TSDB_DATA_TYPE_INT, .flags = 0, .colId = 3, .bytes = sizeof(int32_t)};
+    tstrncpy(tag.name, "t1", TSDB_COL_NAME_LEN);
+
+    SVCreateStbReq req = {0};
+    req.name = (char *)stbName;
+    req.suid = suid;
+    req.schemaRow = (SSchemaWrapper){.nCols = 2, .version = 1, .pSchema = aCol};
+    req.schemaTag = (SSchemaWrapper){.nCols = 1, .version = 1, .pSchema = &tag};
+    ASSERT_EQ(metaCreateSTable(pVnode->pMeta, ++ver, &req), 0);
+
+    for (int32_t i = 0; i < nCtbs; i++) {
+      SArray *pTagVals = taosArrayInit(1, sizeof(STagVal));
+      STagVal tagVal = {.cid = 3, .type = TSDB_DATA_TYPE_INT};
+      tagVal.i64 = i;
+      taosArrayPush(pTagVals, &tagVal);
+      STag *pTag = NULL;
+      ASSERT_EQ(tTagNew(pTagVals, 1, false, &pTag), 0);
+      taosArrayDestroy(pTagVals);
+
+      char          name[TSDB_TABLE_NAME_LEN];
+      SVCreateTbReq ctbReq = {0};
+      snprintf(name, sizeof(name), "%s_%d", stbName, i);
+      ctbReq.name = name;
+      ctbReq.uid = suid + 1 + i;
+      ctbReq.type = TSDB_CHILD_TABLE;
+      ctbReq.btime = 1000;
+      ctbReq.ctb.stbName = (char *)stbName;
+      ctbReq.ctb.suid = suid;
+      ctbReq.ctb.pTag = (uint8_t *)pTag;
+      EXPECT_EQ(metaCreateTable(pVnode->pMeta, ++ver, &ctbReq, NULL), 0);
+      tTagFree(pTag);
+    }
+  }
+
+  int64_t total() { return atomic_load_64(&pTsdb->warmupStat.total); }
+  int64_t loaded() { return atomic_load_64(&pTsdb->warmupStat.loaded); }
+
+  // waits for the warm up to load at least n tables, false on timeout
+  bool waitLoaded(int64_t n, int32_t timeoutMs = 5000) {
+    int64_t endMs = taosGetTimestampMs() + timeoutMs;
+    while (loaded() < n) {
+      if (taosGetTimestampMs() > endMs) return false;
+      taosMsleep(10);
+    }
+    return true;
+  }
+
+  SVnode *pVnode = NULL;
+  STsdb  *pTsdb = NULL;
+  int64_t ver = 0;
+
+  bool    warmup = false;
+  int32_t rate = 0;
+  char    stbs[1024] = {0};
+};
+
+}  // namespace
+
+TEST_F(TsdbCacheWarmupTest, Disabled) {
+  tsLastCacheWarmup = false;
+  EXPECT_EQ(tsdbCacheWarmupStart(pTsdb), 0);
+  EXPECT_TRUE(pTsdb->pWarmup == NULL);
+
+  tsLastCacheWarmup = true;
+  pVnode->config.cacheLast = 0;
+  EXPECT_EQ(tsdbCacheWarmupStart(pTsdb), 0);
+  EXPECT_TRUE(pTsdb->pWarmup == NULL);
+
+  EXPECT_EQ(tsdbCacheWarmupProgress(pTsdb), -1);
+  tsdbCacheWarmupStop(pTsdb);
+}
+
+TEST_F(TsdbCacheWarmupTest, ScheduleAll) {
+  EXPECT_EQ(tsdbCacheWarmupProgress(pTsdb), -1);
+
+  ASSERT_EQ(tsdbCacheWarmupStart(pTsdb), 0);
+  ASSERT_TRUE(pTsdb->pWarmup != NULL);
+  EXPECT_EQ(total(), kCtbs + kCtbs2);
+  EXPECT_EQ(atomic_load_8(&pTsdb->warmupStat.scheduled), 1);
+
+  // a running warm up is not scheduled again
+  EXPECT_EQ(tsdbCacheWarmupStart(pTsdb), 0);
+  EXPECT_EQ(total(), kCtbs + kCtbs2);
+
+  ASSERT_TRUE(waitLoaded(kCtbs + kCtbs2));
+  EXPECT_EQ(loaded(), kCtbs + kCtbs2);
+  EXPECT_EQ(tsdbCacheWarmupProgress(pTsdb), -1);
+}
+
+TEST_F(TsdbCacheWarmupTest, ScheduleSelected) {
+  tstrncpy(tsLastCacheWarmupStbs, " stb2 , not_exist", sizeof(stbs));
+
+  ASSERT_EQ(tsdbCacheWarmupStart(pTsdb), 0);
+  EXPECT_EQ(total(), kCtbs2);
+  ASSERT_TRUE(waitLoaded(kCtbs2));
+  EXPECT_EQ(tsdbCacheWarmupProgress(pTsdb), -1);
+}
+
+TEST_F(TsdbCacheWarmupTest, Progress) {
+  // the first chunk of 256 tables is due at once, the next one 4 seconds later
+  tsLastCacheWarmupRate = 64;
+  tstrncpy(tsLastCacheWarmupStbs, "stb", sizeof(stbs));
+
+  ASSERT_EQ(tsdbCacheWarmupStart(pTsdb), 0);
+  EXPECT_EQ(total(), kCtbs);
+  int32_t progress = tsdbCacheWarmupProgress(pTsdb);
+  EXPECT_TRUE(progress == 0 || progress == 42);
+
+  ASSERT_TRUE(waitLoaded(256, 3000));
+  EXPECT_EQ(loaded(), 256);
+  EXPECT_EQ(tsdbCacheWarmupProgress(pTsdb), 42);
+
+  // stop does not wait for the throttled chunks and resets the progress
+  int64_t startMs = taosGetTimestampMs();
+  tsdbCacheWarmupStop(pTsdb);
+  EXPECT_LT(taosGetTimestampMs() - startMs, 1000);
+  EXPECT_TRUE(pTsdb->pWarmup == NULL);
+  EXPECT_EQ(total(), 0);
+  EXPECT_EQ(loaded(), 0);
+  EXPECT_EQ(atomic_load_8(&pTsdb->warmupStat.scheduled), 0);
+  EXPECT_EQ(tsdbCacheWarmupProgress(pTsdb), -1);
+
+  // and it may be started again
+  tsLastCacheWarmupRate = 0;
+  ASSERT_EQ(tsdbCacheWarmupStart(pTsdb), 0);
+  EXPECT_EQ(total(), kCtbs);
+  ASSERT_TRUE(waitLoaded(kCtbs));
+}
+
+TEST_F(TsdbCacheWarmupTest, StopOnClose) {
+  tsLastCacheWarmupRate = 1;
+
+  ASSERT_EQ(tsdbCacheWarmupStart(pTsdb), 0);
+  ASSERT_TRUE(waitLoaded(256, 3000));
+
+  int64_t startMs = taosGetTimestampMs();
+  tsdbClose(&pVnode->pTsdb);
+  EXPECT_LT(taosGetTimestampMs() - startMs, 1000);
+  EXPECT_TRUE(pVnode->pTsdb == NULL);
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <tglobal.h>
+#include <vnodeInt.h>
+
+#include "tsdbDef.h"
+
+#define TEST_DIR "tsdbDirectWriteTest"
+
+// blocks of the sizes the data/stt/head writers produce: many small ones, some crossing pages
+static std::vector<std::vector<uint8_t>> genBlocks(uint32_t seed) {
+  std::mt19937                      rng(seed);
+  std::vector<std::vector<uint8_t>> blocks;
+
+  for (int32_t i = 0; i < 300; i++) {
+    std::vector<uint8_t> block(rng() % 16 == 0 ? 10000 + rng() % 30000 : 1 + rng() % 600);
+    for (auto &c : block) c = (uint8_t)rng();
+    blocks.push_back(block);
+  }
+  return blocks;
+}
+
+static void writeFile(STsdb *pTsdb, const char *path, const std::vector<std::vector<uint8_t>> &blocks,
+                      uint8_t *directIO) {
+  STsdbFD *pFD = NULL;
+  int64_t  offset = 0;
+
+  ASSERT_EQ(tsdbOpenFile(path, pTsdb, TD_FILE_READ | TD_FILE_WRITE | TD_FILE_CREATE | TD_FILE_TRUNC, &pFD, 0), 0);
+  for (auto &block : blocks) {
+    ASSERT_EQ(tsdbWriteFile(pFD, offset, block.data(), block.size(), 0, NULL), 0);
+    offset += block.size();
+  }
+  ASSERT_EQ(tsdbFsyncFile(pFD, 0, NULL), 0);
+  *directIO = pFD->directIO;
+  tsdbCloseFile(&pFD);
+}
+
+static void checkFile(STsdb *pTsdb, const char *path, const std::vector<std::vector<uint8_t>> &blocks) {
+  STsdbFD *pFD = NULL;
+  int64_t  offset = 0;
+
+  ASSERT_EQ(tsdbOpenFile(path, pTsdb, TD_FILE_READ, &pFD, 0), 0);
+  for (auto &block : blocks) {
+    std::vector<uint8_t> buf(block.size());
+    ASSERT_EQ(tsdbReadFile(pFD, offset, buf.data(), buf.size(), 0, 0, NULL), 0);
+    ASSERT_TRUE(buf == block);
+    offset += block.size();
+  }
+  ASSERT_EQ(pFD->directIO, 0);
+  tsdbCloseFile(&pFD);
+}
+
+static std::string readAll(const char *path) {
+  int64_t size = 0;
+  taosStatFile(path, &size, NULL, NULL);
+
+  std::string buf(size, '\0');
+  TdFilePtr   pFile = taosOpenFile(path, TD_FILE_READ);
+  EXPECT_EQ(taosReadFile(pFile, &buf[0], size), size);
+  taosCloseFile(&pFile);
+  return buf;
+}
+
+TEST(TsdbDirectWriteTest, RoundTrip) {
+  SVnode vnode = {0};
+  STsdb  tsdb = {0};
+
+  vnode.config.tsdbPageSize = 4096;
+  tsdb.pVnode = &vnode;
+
+  taosRemoveDir(TEST_DIR);
+  ASSERT_EQ(taosMkDir(TEST_DIR), 0);
+
+  bool    directWrite = tsTsdbDirectWrite;
+  int32_t syncPages = tsTsdbDirectWriteSyncPages;
+  tsTsdbDirectWriteSyncPages = 7;
+
+  const char *suffix[] = {"data", "stt", "head"};
+  for (int32_t i = 0; i < 3; i++) {
+    char directPath[128];
+    char bufferedPath[128];
+    snprintf(directPath, sizeof(directPath), TEST_DIR "/v1f1ver1.%s", suffix[i]);
+    snprintf(bufferedPath, sizeof(bufferedPath), TEST_DIR "/v1f1ver2.%s", suffix[i]);
+
+    auto    blocks = genBlocks(i + 1);
+    uint8_t directIO = 0;
+
+    tsTsdbDirectWrite = true;
+    writeFile(&tsdb, directPath, blocks, &directIO);
+    if (!directIO) {
+      printf("%s: O_DIRECT not supported here, written buffered\n", directPath);
+    }
+    checkFile(&tsdb, directPath, blocks);
+
+    // the pages on disk do not depend on how they were written
+    tsTsdbDirectWrite = false;
+    writeFile(&tsdb, bufferedPath, blocks, &directIO);
+    ASSERT_EQ(directIO, 0);
+    ASSERT_TRUE(readAll(directPath) == readAll(bufferedPath));
+  }
+
+  tsTsdbDirectWrite = directWrite;
+  tsTsdbDirectWriteSyncPages = syncPages;
+  taosRemoveDir(TEST_DIR);
+}
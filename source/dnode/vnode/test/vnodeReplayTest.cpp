@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <tglobal.h>
+
+#include "vnd.h"
+
+namespace {
+
+class VnodeReplayTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    decodeAhead = tsWalReplayDecodeAhead;
+    pVnode = (SVnode *)taosMemoryCalloc(1, sizeof(SVnode));
+    ASSERT_TRUE(pVnode != NULL);
+    ASSERT_EQ(vnodeReplayOpen(pVnode), 0);
+  }
+
+  void TearDown() override {
+    vnodeReplayClose(pVnode);
+    ASSERT_TRUE(pVnode->pReplayReqs == NULL);
+    taosMemoryFree(pVnode);
+    for (size_t i = 0; i < msgs.size(); i++) {
+      taosMemoryFree(msgs[i].pCont);
+    }
+    tsWalReplayDecodeAhead = decodeAhead;
+  }
+
+  // a submit of one table whose uid is the version, the decoded request points into the body kept in msgs
+  SRpcMsg submitMsg(int64_t ver) {
+    SSubmitTbData tbData = {0};
+    tbData.uid = ver;
+    tbData.aRowP = taosArrayInit(0, POINTER_BYTES);
+    SSubmitReq2 req = {0};
+    req.aSubmitTbData = taosArrayInit(1, sizeof(SSubmitTbData));
+    taosArrayPush(req.aSubmitTbData, &tbData);
+
+    int32_t len = 0;
+    int32_t ret = 0;
+    tEncodeSize(tEncodeSubmitReq, &req, len, ret);
+    EXPECT_EQ(ret, 0);
+
+    SSubmitReq2Msg *pSubmit = (SSubmitReq2Msg *)taosMemoryCalloc(1, sizeof(SSubmitReq2Msg) + len);
+    pSubmit->version = 1;
+    SEncoder encoder = {0};
+    tEncoderInit(&encoder, (uint8_t *)pSubmit->data, len);
+    EXPECT_EQ(tEncodeSubmitReq(&encoder, &req), 0);
+    tEncoderClear(&encoder);
+    taosArrayDestroy(tbData.aRowP);
+    taosArrayDestroy(req.aSubmitTbData);
+
+    SRpcMsg msg = {0};
+    msg.msgType = TDMT_VND_SUBMIT;
+    msg.pCont = pSubmit;
+    msg.contLen = sizeof(SSubmitReq2Msg) + len;
+    msgs.push_back(msg);
+    return msg;
+  }
+
+  void decodeAheadVer(int64_t ver) {
+    SRpcMsg msg = submitMsg(ver);
+    vnodeReplayDecodeAhead(pVnode, &msg, ver);
+  }
+
+  // takes the request decoded for ver, false if there is none
+  bool take(int64_t ver) {
+    SSubmitReq2 *pReq = vnodeReplayTake(pVnode, ver);
+    if (pReq == NULL) return false;
+
+    EXPECT_EQ(taosArrayGetSize(pReq->aSubmitTbData), 1);
+    EXPECT_EQ(((SSubmitTbData *)taosArrayGet(pReq->aSubmitTbData, 0))->uid, ver);
+    tDestroySubmitReq(pReq, TSDB_MSG_FLG_DECODE);
+    taosMemoryFree(pReq);
+    return true;
+  }
+
+  int32_t queued() { return taosHashGetSize(pVnode->pReplayReqs); }
+
+  SVnode              *pVnode = NULL;
+  std::vector<SRpcMsg> msgs;
+  int32_t              decodeAhead = 0;
+};
+
+}  // namespace
+
+TEST_F(VnodeReplayTest, TakeDecoded) {
+  tsWalReplayDecodeAhead = 16;
+  for (int64_t ver = 1; ver <= 3; ver++) {
+    decodeAheadVer(ver);
+  }
+  EXPECT_EQ(queued(), 3);
+
+  EXPECT_TRUE(take(2));
+  EXPECT_FALSE(take(2));
+  EXPECT_TRUE(take(1));
+  EXPECT_TRUE(take(3));
+  EXPECT_FALSE(take(4));
+  EXPECT_EQ(queued(), 0);
+}
+
+TEST_F(VnodeReplayTest, OnlyReplayedSubmits) {
+  tsWalReplayDecodeAhead = 16;
+
+  SRpcMsg msg = submitMsg(1);
+  msg.msgType = TDMT_VND_CREATE_TABLE;
+  vnodeReplayDecodeAhead(pVnode, &msg, 1);
+
+  msg = submitMsg(2);
+  msg.code = TSDB_CODE_FAILED;
+  vnodeReplayDecodeAhead(pVnode, &msg, 2);
+
+  // old format requests are left to the apply thread
+  msg = submitMsg(3);
+  ((SSubmitReq2Msg *)msg.pCont)->version = 0;
+  vnodeReplayDecodeAhead(pVnode, &msg, 3);
+
+  // bodies that do not decode are left to the apply thread, which reports the error
+  msg = submitMsg(4);
+  msg.contLen = sizeof(SSubmitReq2Msg) + 2;
+  vnodeReplayDecodeAhead(pVnode, &msg, 4);
+  EXPECT_EQ(queued(), 0);
+
+  // nothing is decoded ahead once the vnode is restored
+  pVnode->restored = true;
+  decodeAheadVer(5);
+  EXPECT_EQ(queued(), 0);
+  EXPECT_FALSE(take(5));
+}
+
+TEST_F(VnodeReplayTest, Drop) {
+  tsWalReplayDecodeAhead = 16;
+  decodeAheadVer(1);
+  decodeAheadVer(2);
+
+  // an entry that failed before reaching the submit handler frees its request after apply
+  vnodeReplayDrop(pVnode, 1);
+  vnodeReplayDrop(pVnode, 3);
+  EXPECT_EQ(queued(), 1);
+  EXPECT_FALSE(take(1));
+  EXPECT_TRUE(take(2));
+}
+
+TEST_F(VnodeReplayTest, Cap) {
+  tsWalReplayDecodeAhead = 2;
+  for (int64_t ver = 1; ver <= 4; ver++) {
+    decodeAheadVer(ver);
+  }
+  EXPECT_EQ(queued(), 2);
+  EXPECT_FALSE(take(3));
+
+  // taking one makes room for the next
+  EXPECT_TRUE(take(1));
+  decodeAheadVer(5);
+  EXPECT_EQ(queued(), 2);
+  EXPECT_TRUE(take(2));
+  EXPECT_TRUE(take(5));
+
+  tsWalReplayDecodeAhead = 0;
+  decodeAheadVer(6);
+  EXPECT_EQ(queued(), 0);
+}
+
+TEST_F(VnodeReplayTest, CloseFreesQueued) {
+  tsWalReplayDecodeAhead = 16;
+  for (int64_t ver = 1; ver <= 8; ver++) {
+    decodeAheadVer(ver);
+  }
+  EXPECT_EQ(queued(), 8);
+}
@@ -27,6 +27,7 @@
 #include "executorInt.h"
 #include "querytask.h"
 #include "storageapi.h"
+#include "tcompare.h"
 #include "tcompression.h"
 
 typedef struct tagFilterAssist {
@@ -44,6 +45,8 @@ typedef enum {
 static FilterCondType checkTagCond(SNode* cond);
 static int32_t optimizeTbnameInCond(void* metaHandle, int64_t suid, SArray* list, SNode* pTagCond, SStorageAPI* pAPI);
 static int32_t optimizeTbnameInCondImpl(void* metaHandle, SArray* list, SNode* pTagCond, SStorageAPI* pStoreAPI);
+static void    fillTagValBlockForFilter(SSDataBlock* pResBlock, int32_t numOfTables, SArray* pUidTagList, void* pVnode,
+                                        SStorageAPI* pStorageAPI, bool onlyTbname);
 
 static int32_t getTableList(void* pVnode, SScanPhysiNode* pScanNode, SNode* pTagCond, SNode* pTagIndexCond,
                             STableListInfo* pListInfo, uint8_t* digest, const char* idstr, SStorageAPI* pStorageAPI);
@@ -560,16 +563,22 @@ int32_t getColInfoResultForGroupby(void* pVnode, SNodeList* group, STableListInf
     taosArrayPush(pUidTagList, &info);
   }
 
-  code = pAPI->metaFn.getTableTags(pVnode, pTableListInfo->idInfo.suid, pUidTagList);
-  if (code != TSDB_CODE_SUCCESS) {
-    goto end;
-  }
-
   int32_t numOfTables = taosArrayGetSize(pUidTagList);
-  pResBlock = createTagValBlockForFilter(ctx.cInfoList, numOfTables, pUidTagList, pVnode, pAPI);
-  if (pResBlock == NULL) {
-    code = terrno;
-    goto end;
+  if (pTableListInfo->idInfo.tableType == TSDB_SUPER_TABLE &&
+      pAPI->metaFn.getTableTagCols(pVnode, pTableListInfo->idInfo.suid, ctx.cInfoList, pUidTagList, &pResBlock) ==
+          TSDB_CODE_SUCCESS) {
+    fillTagValBlockForFilter(pResBlock, numOfTables, pUidTagList, pVnode, pAPI, true);
+  } else {
+    code = pAPI->metaFn.getTableTags(pVnode, pTableListInfo->idInfo.suid, pUidTagList);
+    if (code != TSDB_CODE_SUCCESS) {
+      goto end;
+    }
+
+    pResBlock = createTagValBlockForFilter(ctx.cInfoList, numOfTables, pUidTagList, pVnode, pAPI);
+    if (pResBlock == NULL) {
+      code = terrno;
+      goto end;
+    }
   }
 
   //  int64_t st1 = taosGetTimestampUs();
@@ -925,7 +934,13 @@ SSDataBlock* createTagValBlockForFilter(SArray* pColList, int32_t numOfTables, S
   }
 
   pResBlock->info.rows = numOfTables;
+  fillTagValBlockForFilter(pResBlock, numOfTables, pUidTagList, pVnode, pStorageAPI, false);
+  return pResBlock;
+}
 
+// tag columns are left alone if onlyTbname is set, the columnar tag store has filled them already
+static void fillTagValBlockForFilter(SSDataBlock* pResBlock, int32_t numOfTables, SArray* pUidTagList, void* pVnode,
+                                     SStorageAPI* pStorageAPI, bool onlyTbname) {
   int32_t numOfCols = taosArrayGetSize(pResBlock->pDataBlock);
 
   for (int32_t i = 0; i < numOfTables; i++) {
@@ -946,7 +961,7 @@ SSDataBlock* createTagValBlockForFilter(SArray* pColList, int32_t numOfTables, S
 #if TAG_FILTER_DEBUG
         qDebug("tagfilter uid:%ld, tbname:%s", *uid, str + 2);
 #endif
-      } else {
+      } else if (!onlyTbname) {
         STagVal tagVal = {0};
         tagVal.cid = pColInfo->info.colId;
         if (p1->pTagVal == NULL) {
@@ -981,8 +996,6 @@ SSDataBlock* createTagValBlockForFilter(SArray* pColList, int32_t numOfTables, S
       }
     }
   }
-
-  return pResBlock;
 }
 
 static int32_t doSetQualifiedUid(STableListInfo* pListInfo, SArray* pUidList, const SArray* pUidTagList,
@@ -1073,6 +1086,11 @@ static int32_t doFilterByTagCond(STableListInfo* pListInfo, SArray* pUidList, SN
       taosArrayPush(pUidList, &pInfo->uid);
     }
     terrno = 0;
+  } else if (pListInfo->idInfo.tableType == TSDB_SUPER_TABLE &&
+             pAPI->metaFn.getTableTagCols(pVnode, pListInfo->idInfo.suid, ctx.cInfoList, pUidTagList, &pResBlock) ==
+                 TSDB_CODE_SUCCESS) {
+    // the tag columns come straight from the columnar tag store, no tag blob is decoded
+    qDebug("tagfilter get tag columns from tag store, numOfTables:%d", (int32_t)taosArrayGetSize(pUidTagList));
   } else {
     if ((condType == FILTER_NO_LOGIC || condType == FILTER_AND) && status != SFLT_NOT_INDEX) {
       code = pAPI->metaFn.getTableTagsByUid(pVnode, pListInfo->idInfo.suid, pUidTagList);
@@ -1091,10 +1109,14 @@ static int32_t doFilterByTagCond(STableListInfo* pListInfo, SArray* pUidList, SN
     goto end;
   }
 
-  pResBlock = createTagValBlockForFilter(ctx.cInfoList, numOfTables, pUidTagList, pVnode, pAPI);
-  if (pResBlock == NULL) {
-    code = terrno;
-    goto end;
+  if (pResBlock != NULL) {
+    fillTagValBlockForFilter(pResBlock, numOfTables, pUidTagList, pVnode, pAPI, true);
+  } else {
+    pResBlock = createTagValBlockForFilter(ctx.cInfoList, numOfTables, pUidTagList, pVnode, pAPI);
+    if (pResBlock == NULL) {
+      code = terrno;
+      goto end;
+    }
   }
 
   //  int64_t st1 = taosGetTimestampUs();
@@ -1134,6 +1156,63 @@ end:
   return code;
 }
 
+// the tag condition is evaluated again on the child tables created, altered or dropped since the uid list was cached
+static int32_t refreshCachedTableList(void* pVnode, STableListInfo* pListInfo, SArray* pUidList, SArray* pChanged,
+                                      SNode* pTagCond, SStorageAPI* pAPI) {
+  int32_t code = TSDB_CODE_SUCCESS;
+
+  taosArraySort(pChanged, compareUint64Val);
+  taosArrayRemoveDuplicate(pChanged, compareUint64Val, NULL);
+
+  // the changed tables are left out of the cached result, and put back below if they are still qualified
+  int32_t numOfTables = taosArrayGetSize(pUidList);
+  int32_t numOfKept = 0;
+  for (int32_t i = 0; i < numOfTables; ++i) {
+    uint64_t* uid = taosArrayGet(pUidList, i);
+    if (taosArraySearch(pChanged, uid, compareUint64Val, TD_EQ) == NULL) {
+      *(uint64_t*)taosArrayGet(pUidList, numOfKept++) = *uid;
+    }
+  }
+  taosArrayPopTailBatch(pUidList, numOfTables - numOfKept);
+
+  int32_t numOfChanged = 0;
+  for (int32_t i = 0; i < taosArrayGetSize(pChanged); ++i) {
+    uint64_t uid = *(uint64_t*)taosArrayGet(pChanged, i);
+    if (pAPI->metaFn.isTableExisted(pVnode, uid)) {
+      *(uint64_t*)taosArrayGet(pChanged, numOfChanged++) = uid;
+    }
+  }
+  taosArrayPopTailBatch(pChanged, taosArrayGetSize(pChanged) - numOfChanged);
+  if (numOfChanged == 0) {
+    return code;
+  }
+
+  if (pTagCond != NULL) {
+    bool           listAdded = false;
+    STableListInfo info = {.idInfo = pListInfo->idInfo};
+    info.pTableList = taosArrayInit(numOfChanged, sizeof(STableKeyInfo));
+    if (info.pTableList == NULL) {
+      return TSDB_CODE_OUT_OF_MEMORY;
+    }
+
+    // the tags are looked up by uid, there is no need to scan all child tables for a few of them
+    code = doFilterByTagCond(&info, pChanged, pTagCond, pVnode, SFLT_ACCURATE_INDEX, pAPI, true, &listAdded);
+    taosArrayDestroy(info.pTableList);
+    if (code != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+    if (!listAdded) {
+      taosArrayClear(pChanged);
+    }
+  }
+
+  // a tbname condition brings in the named tables as well, whether they are cached or not
+  taosArrayAddAll(pUidList, pChanged);
+  taosArraySort(pUidList, compareUint64Val);
+  taosArrayRemoveDuplicate(pUidList, compareUint64Val, NULL);
+  return code;
+}
+
 int32_t getTableList(void* pVnode, SScanPhysiNode* pScanNode, SNode* pTagCond, SNode* pTagIndexCond,
                      STableListInfo* pListInfo, uint8_t* digest, const char* idstr, SStorageAPI* pStorageAPI) {
   int32_t code = TSDB_CODE_SUCCESS;
@@ -1144,6 +1223,8 @@ int32_t getTableList(void* pVnode, SScanPhysiNode* pScanNode, SNode* pTagCond, S
   pListInfo->idInfo.tableType = pScanNode->tableType;
 
   SArray* pUidList = taosArrayInit(8, sizeof(uint64_t));
+  SArray* pChanged = NULL;
+  int64_t cacheVer = 0;
 
   SIdxFltStatus status = SFLT_NOT_INDEX;
   if (pScanNode->tableType != TSDB_SUPER_TABLE) {
@@ -1163,12 +1244,39 @@ int32_t getTableList(void* pVnode, SScanPhysiNode* pScanNode, SNode* pTagCond, S
       genTagFilterDigest(pTagCond, &context);
 
       bool acquired = false;
+      pChanged = taosArrayInit(4, sizeof(uint64_t));
+      if (pChanged == NULL) {
+        code = TSDB_CODE_OUT_OF_MEMORY;
+        goto _end;
+      }
+
       pStorageAPI->metaFn.getCachedTableList(pVnode, pScanNode->suid, context.digest, tListLen(context.digest),
-                                             pUidList, &acquired);
+                                             pUidList, &acquired, pChanged, &cacheVer);
       if (acquired) {
+        int32_t numOfChanged = taosArrayGetSize(pChanged);
+        if (numOfChanged > 0) {
+          code = refreshCachedTableList(pVnode, pListInfo, pUidList, pChanged, pTagCond, pStorageAPI);
+          if (code != TSDB_CODE_SUCCESS) {
+            goto _end;
+          }
+
+          numOfTables = taosArrayGetSize(pUidList);
+          size_t size = numOfTables * sizeof(uint64_t) + sizeof(int32_t);
+          char*  pPayload = taosMemoryMalloc(size);
+          if (pPayload != NULL) {
+            *(int32_t*)pPayload = numOfTables;
+            if (numOfTables > 0) {
+              memcpy(pPayload + sizeof(int32_t), taosArrayGet(pUidList, 0), numOfTables * sizeof(uint64_t));
+            }
+            pStorageAPI->metaFn.putCachedTableList(pVnode, pScanNode->suid, context.digest, tListLen(context.digest),
+                                                   pPayload, size, 1, cacheVer);
+          }
+        }
+
         digest[0] = 1;
         memcpy(digest + 1, context.digest, tListLen(context.digest));
-        qDebug("retrieve table uid list from cache, numOfTables:%d", (int32_t)taosArrayGetSize(pUidList));
+        qDebug("retrieve table uid list from cache, numOfTables:%d, changed:%d", (int32_t)taosArrayGetSize(pUidList),
+               numOfChanged);
         goto _end;
       }
     }
@@ -1213,7 +1321,7 @@ int32_t getTableList(void* pVnode, SScanPhysiNode* pScanNode, SNode* pTagCond, S
       }
 
       pStorageAPI->metaFn.putCachedTableList(pVnode, pScanNode->suid, context.digest, tListLen(context.digest),
-                                             pPayload, size, 1);
+                                             pPayload, size, 1, cacheVer);
       digest[0] = 1;
       memcpy(digest + 1, context.digest, tListLen(context.digest));
     }
@@ -1236,6 +1344,7 @@ _end:
   }
 
   taosArrayDestroy(pUidList);
+  taosArrayDestroy(pChanged);
   return code;
 }
 
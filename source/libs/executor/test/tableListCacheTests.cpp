@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "executorInt.h"
+#include "querytask.h"
+#include "tglobal.h"
+#include "tmd5.h"
+#include "vnodeInt.h"
+
+namespace {
+
+const char    *kPath = "table_list_cache_test";
+const tb_uid_t kSuid = 1000;
+const col_id_t kCidInt = 3;
+
+// the length of the change list of a super table before its cached uid lists are cleared instead
+const int32_t kMaxChanges = 4096;
+
+// child tables of stb(ts, c1) tags(t_int int), the tag filter is t_int > 50
+class TableListCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    tagFilterCache = tsTagFilterCache;
+    taosRemoveDir(kPath);
+
+    pVnode = (SVnode *)taosMemoryCalloc(1, sizeof(SVnode));
+    ASSERT_TRUE(pVnode != NULL);
+    pVnode->path = (char *)kPath;
+    pVnode->config.vgId = 2;
+    pVnode->config.szPage = 4096;
+    pVnode->config.szCache = 256;
+    pVnode->config.cacheLast = 0;
+
+    ASSERT_EQ(metaOpen(pVnode, &pVnode->pMeta, 0), 0);
+    ASSERT_EQ(metaBegin(pVnode->pMeta, META_BEGIN_HEAP_OS), 0);
+    initStorageAPI(&taskInfo.storageAPI);
+
+    createStb();
+    pTagCond = buildTagCond(50);
+    tagCondDigest(pTagCond, digest);
+  }
+
+  void TearDown() override {
+    nodesDestroyNode(pTagCond);
+    metaClose(&pVnode->pMeta);
+    taosMemoryFree(pVnode);
+    taosRemoveDir(kPath);
+    tsTagFilterCache = tagFilterCache;
+  }
+
+  void createStb() {
+    SSchema aCol[2] = {{.type = TSDB_DATA_TYPE_TIMESTAMP, .colId = 1, .bytes = sizeof(int64_t), .name = "ts"},
+                       {.type = TSDB_DATA_TYPE_INT, .colId = 2, .bytes = sizeof(int32_t), .name = "c1"}};
+    SSchema aTag[1] = {{.type = TSDB_DATA_TYPE_INT, .colId = kCidInt, .bytes = sizeof(int32_t), .name = "t_int"}};
+
+    SVCreateStbReq req = {0};
+    req.name = (char *)"stb";
+    req.suid = kSuid;
+    req.schemaRow = (SSchemaWrapper){.nCols = 2, .version = 1, .pSchema = aCol};
+    req.schemaTag = (SSchemaWrapper){.nCols = 1, .version = 1, .pSchema = aTag};
+    ASSERT_EQ(metaCreateSTable(pVnode->pMeta, ++ver, &req), 0);
+  }
+
+  SNode *buildTagCond(int32_t value) {
+    SColumnNode *pCol = (SColumnNode *)nodesMakeNode(QUERY_NODE_COLUMN);
+    pCol->colId = kCidInt;
+    pCol->colType = COLUMN_TYPE_TAG;
+    pCol->node.resType = (SDataType){.type = TSDB_DATA_TYPE_INT, .bytes = sizeof(int32_t)};
+
+    SValueNode *pVal = (SValueNode *)nodesMakeNode(QUERY_NODE_VALUE);
+    pVal->node.resType = (SDataType){.type = TSDB_DATA_TYPE_INT, .bytes = sizeof(int32_t)};
+    pVal->translate = true;
+    nodesSetValueNodeValue(pVal, &value);
+
+    SOperatorNode *pOp = (SOperatorNode *)nodesMakeNode(QUERY_NODE_OPERATOR);
+    pOp->opType = OP_TYPE_GREATER_THAN;
+    pOp->node.resType = (SDataType){.type = TSDB_DATA_TYPE_BOOL, .bytes = sizeof(bool)};
+    pOp->pLeft = (SNode *)pCol;
+    pOp->pRight = (SNode *)pVal;
+    return (SNode *)pOp;
+  }
+
+  // the key of the cached uid list, the same way the executor digests the tag condition
+  void tagCondDigest(SNode *pCond, uint8_t *pDigest) {
+    char     *payload = NULL;
+    int32_t   len = 0;
+    T_MD5_CTX context = {0};
+
+    ASSERT_EQ(nodesNodeToMsg(pCond, &payload, &len), 0);
+    tMD5Init(&context);
+    tMD5Update(&context, (uint8_t *)payload, (uint32_t)len);
+    tMD5Final(&context);
+    memcpy(pDigest, context.digest, tListLen(context.digest));
+    taosMemoryFree(payload);
+  }
+
+  tb_uid_t createCtb(int32_t id, int32_t tInt) {
+    char          name[TSDB_TABLE_NAME_LEN];
+    STag         *pTag = NULL;
+    SArray       *pTagVals = taosArrayInit(1, sizeof(STagVal));
+    STagVal       tagVal = {.cid = kCidInt, .type = TSDB_DATA_TYPE_INT, .i64 = tInt};
+    SVCreateTbReq req = {0};
+
+    taosArrayPush(pTagVals, &tagVal);
+    EXPECT_EQ(tTagNew(pTagVals, 1, false, &pTag), 0);
+    taosArrayDestroy(pTagVals);
+
+    snprintf(name, sizeof(name), "ctb_%d", id);
+    req.name = name;
+    req.uid = kSuid + 1 + id;
+    req.type = TSDB_CHILD_TABLE;
+    req.btime = 1000;
+    req.ctb.stbName = (char *)"stb";
+    req.ctb.suid = kSuid;
+    req.ctb.pTag = (uint8_t *)pTag;
+    EXPECT_EQ(metaCreateTable(pVnode->pMeta, ++ver, &req, NULL), 0);
+
+    tTagFree(pTag);
+    return req.uid;
+  }
+
+  void updateTag(int32_t id, int32_t tInt, bool isNull = false) {
+    char         name[TSDB_TABLE_NAME_LEN];
+    SVAlterTbReq req = {0};
+
+    snprintf(name, sizeof(name), "ctb_%d", id);
+    req.tbName = name;
+    req.action = TSDB_ALTER_TABLE_UPDATE_TAG_VAL;
+    req.tagName = (char *)"t_int";
+    req.tagType = TSDB_DATA_TYPE_INT;
+    req.isNull = isNull;
+    req.pTagVal = (uint8_t *)&tInt;
+    req.nTagVal = sizeof(tInt);
+    ASSERT_EQ(metaAlterTable(pVnode->pMeta, ++ver, &req, NULL), 0);
+  }
+
+  void dropCtb(int32_t id) {
+    char        name[TSDB_TABLE_NAME_LEN];
+    SVDropTbReq req = {0};
+
+    snprintf(name, sizeof(name), "ctb_%d", id);
+    req.name = name;
+    req.suid = kSuid;
+    ASSERT_EQ(metaDropTable(pVnode->pMeta, ++ver, &req, NULL, NULL), 0);
+  }
+
+  // the qualified child tables, through the uid list cache or evaluated on every child table
+  std::vector<uint64_t> query(bool useCache) {
+    SSubplan subplan = {0};
+    SArray  *pList = NULL;
+
+    tsTagFilterCache = useCache;
+    subplan.pTagCond = pTagCond;
+    EXPECT_EQ(qGetTableList(kSuid, pVnode, &subplan, &pList, &taskInfo), 0);
+
+    std::vector<uint64_t> uids;
+    for (int32_t i = 0; i < taosArrayGetSize(pList); i++) {
+      uids.push_back(((STableKeyInfo *)taosArrayGet(pList, i))->uid);
+    }
+    taosArrayDestroy(pList);
+    std::sort(uids.begin(), uids.end());
+    return uids;
+  }
+
+  void checkCached() {
+    std::vector<uint64_t> cold = query(false);
+    EXPECT_EQ(query(true), cold);
+  }
+
+  // whether a uid list is cached for the tag condition, and how many changes it has not seen
+  bool lookup(int32_t *pChanged = NULL, int64_t *pVer = NULL, std::vector<uint64_t> *pUids = NULL) {
+    SArray *pList = taosArrayInit(8, sizeof(uint64_t));
+    SArray *pChangedList = taosArrayInit(8, sizeof(uint64_t));
+    bool    acquired = false;
+    int64_t cacheVer = 0;
+
+    EXPECT_EQ(taskInfo.storageAPI.metaFn.getCachedTableList(pVnode, kSuid, digest, sizeof(digest), pList, &acquired,
+                                                            pChangedList, &cacheVer),
+              0);
+    if (pChanged) *pChanged = taosArrayGetSize(pChangedList);
+    if (pVer) *pVer = cacheVer;
+    if (pUids) {
+      pUids->assign((uint64_t *)pList->pData, (uint64_t *)pList->pData + taosArrayGetSize(pList));
+    }
+
+    taosArrayDestroy(pList);
+    taosArrayDestroy(pChangedList);
+    return acquired;
+  }
+
+  void put(const std::vector<uint64_t> &uids, int64_t cacheVer) {
+    int32_t size = sizeof(int32_t) + uids.size() * sizeof(uint64_t);
+    char   *pPayload = (char *)taosMemoryMalloc(size);
+
+    *(int32_t *)pPayload = uids.size();
+    if (!uids.empty()) {
+      memcpy(pPayload + sizeof(int32_t), uids.data(), uids.size() * sizeof(uint64_t));
+    }
+    ASSERT_EQ(taskInfo.storageAPI.metaFn.putCachedTableList(pVnode, kSuid, digest, sizeof(digest), pPayload, size, 1,
+                                                            cacheVer),
+              0);
+  }
+
+  SVnode        *pVnode = NULL;
+  SExecTaskInfo  taskInfo = {0};
+  SNode         *pTagCond = NULL;
+  uint8_t        digest[16] = {0};
+  int64_t        ver = 0;
+  char           tagFilterCache = 0;
+};
+
+}  // namespace
+
+TEST_F(TableListCacheTest, RefreshChangedTables) {
+  for (int32_t id = 0; id < 100; id++) {
+    createCtb(id, id);
+  }
+
+  EXPECT_EQ(query(false).size(), 49);
+  checkCached();
+  int32_t nChanged = -1;
+  ASSERT_TRUE(lookup(&nChanged));
+  EXPECT_EQ(nChanged, 0);
+
+  // qualified and unqualified tables are created, altered in and out of the filter, and dropped
+  createCtb(200, 200);
+  createCtb(201, 1);
+  updateTag(10, 90);
+  updateTag(60, 0);
+  updateTag(61, 0, true);
+  updateTag(62, 63);
+  dropCtb(70);
+  dropCtb(5);
+  ASSERT_TRUE(lookup(&nChanged));
+  EXPECT_EQ(nChanged, 8);
+
+  // the second query evaluates only the changed tables, and the refreshed list is cached again
+  checkCached();
+  ASSERT_TRUE(lookup(&nChanged));
+  EXPECT_EQ(nChanged, 0);
+  checkCached();
+
+  // a table dropped and created again under the same uid is evaluated with its new tags
+  dropCtb(80);
+  createCtb(80, 20);
+  updateTag(201, 300);
+  updateTag(201, 2);
+  ASSERT_TRUE(lookup(&nChanged));
+  EXPECT_EQ(nChanged, 4);
+  checkCached();
+}
+
+TEST_F(TableListCacheTest, TooManyChanges) {
+  for (int32_t id = 0; id < 100; id++) {
+    createCtb(id, id);
+  }
+  checkCached();
+
+  // up to the limit the changes are tracked
+  for (int32_t i = 0; i < kMaxChanges; i++) {
+    updateTag(i % 100, (i * 7) % 100);
+  }
+  int32_t nChanged = -1;
+  ASSERT_TRUE(lookup(&nChanged));
+  EXPECT_EQ(nChanged, kMaxChanges);
+
+  // one more clears the cached lists of the super table, the next query computes the list from scratch
+  updateTag(0, 99);
+  EXPECT_FALSE(lookup());
+  checkCached();
+  ASSERT_TRUE(lookup(&nChanged));
+  EXPECT_EQ(nChanged, 0);
+}
+
+TEST_F(TableListCacheTest, StalePut) {
+  for (int32_t id = 0; id < 100; id++) {
+    createCtb(id, id);
+  }
+
+  // a query misses and computes its list, a child table is created meanwhile. The list misses that table, so
+  // it is not cached
+  int64_t cacheVer = 0;
+  ASSERT_FALSE(lookup(NULL, &cacheVer));
+  std::vector<uint64_t> stale = query(false);
+  createCtb(100, 100);
+  put(stale, cacheVer);
+  EXPECT_FALSE(lookup());
+  checkCached();
+
+  // a list computed at an older version does not replace the cached one
+  std::vector<uint64_t> cached;
+  ASSERT_TRUE(lookup(NULL, &cacheVer, &cached));
+  put(std::vector<uint64_t>(), cacheVer - 1);
+  put(std::vector<uint64_t>(), cacheVer);
+  std::vector<uint64_t> uids;
+  int32_t               nChanged = -1;
+  ASSERT_TRUE(lookup(&nChanged, NULL, &uids));
+  EXPECT_EQ(uids, cached);
+  EXPECT_EQ(nChanged, 0);
+
+  // neither does one computed before changes the cached list has already seen
+  updateTag(1, 99);
+  checkCached();
+  ASSERT_TRUE(lookup(NULL, &cacheVer, &cached));
+  put(stale, cacheVer - 1);
+  ASSERT_TRUE(lookup(NULL, NULL, &uids));
+  EXPECT_EQ(uids, cached);
+  checkCached();
+}
@@ -22,8 +22,6 @@
 extern "C" {
 #endif
 
-//#define USE_MMAP 1
-
 #define DefaultMem 1024 * 1024
 
 static char tmpFile[] = "./index";
@@ -49,9 +47,7 @@ typedef struct IFileCtx {
       int32_t wBufOffset;
       int32_t wBufCap;
 
-#ifdef USE_MMAP
-      char* ptr;
-#endif
+      char* ptr;  // whole file mapped by readers, NULL if the map failed
     } file;
     struct {
       int32_t cap;
@@ -69,6 +65,8 @@ static int idxFileCtxDoFlush(IFileCtx* ctx);
 
 IFileCtx* idxFileCtxCreate(WriterType type, const char* path, bool readOnly, int32_t capacity);
 void      idxFileCtxDestroy(IFileCtx* w, bool remove);
+// return the mapped bytes [offset, offset + len) of a reader, NULL if not mapped or out of range
+char*     idxFileCtxMapped(IFileCtx* ctx, int32_t offset, int32_t len);
 
 typedef uint32_t CheckSummer;
 
@@ -77,6 +77,7 @@ typedef struct FstString {
   uint8_t* data;
   uint32_t len;
   int32_t  ref;
+  bool     borrowed;  // data is owned by the caller, e.g. a mapped file, and not freed
 } FstString;
 
 typedef struct FstSlice {
@@ -86,6 +87,7 @@ typedef struct FstSlice {
 } FstSlice;
 
 FstSlice fstSliceCreate(uint8_t* data, uint64_t len);
+FstSlice fstSliceCreateRef(uint8_t* data, uint64_t len);
 FstSlice fstSliceCopy(FstSlice* s, int32_t start, int32_t end);
 FstSlice fstSliceDeepCopy(FstSlice* s, int32_t start, int32_t end);
 bool     fstSliceIsEmpty(FstSlice* s);
@@ -68,11 +68,12 @@ struct SIndex {
   SLRUCache* lru;
   char*      path;
 
-  int8_t        status;
-  SIndexStat    stat;
-  TdThreadMutex mtx;
-  tsem_t        sem;
-  bool          quit;
+  int8_t          status;
+  SIndexStat      stat;
+  SIndexMergeStat mergeStat;
+  TdThreadMutex   mtx;
+  tsem_t          sem;
+  bool            quit;
 };
 
 struct SIndexMultiTermQuery {
@@ -167,13 +167,28 @@ void indexDestroy(void* handle) {
 void indexClose(SIndex* sIdx) {
   bool ref = 0;
   if (sIdx->colObj != NULL) {
-    void* iter = taosHashIterate(sIdx->colObj, NULL);
+    // schedule the merges of all columns first, so they run in parallel in the index pool
+    int32_t nMerge = 0;
+    void*   iter = taosHashIterate(sIdx->colObj, NULL);
     while (iter) {
       IndexCache** pCache = iter;
       idxCacheForceToMerge((void*)(*pCache));
-      indexInfo("%s wait to merge", (*pCache)->colName);
+      nMerge++;
+      iter = taosHashIterate(sIdx->colObj, iter);
+    }
+
+    indexInfo("wait %d column to merge", nMerge);
+    for (int32_t i = 0; i < nMerge; i++) {
       indexWait((void*)(sIdx));
-      indexInfo("%s finish to wait", (*pCache)->colName);
+    }
+    indexInfo("finish to wait %d column to merge, merged: %" PRId64 ", failed: %" PRId64 ", merge cost: %" PRId64
+              "us, write stalled: %" PRId64 ", stall cost: %" PRId64 "us",
+              nMerge, sIdx->mergeStat.nMerge, sIdx->mergeStat.nMergeFail, sIdx->mergeStat.mergeTimeUs,
+              sIdx->mergeStat.nStall, sIdx->mergeStat.stallTimeUs);
+
+    iter = taosHashIterate(sIdx->colObj, NULL);
+    while (iter) {
+      IndexCache** pCache = iter;
       iter = taosHashIterate(sIdx->colObj, iter);
       idxCacheUnRef(*pCache);
     }
@@ -184,6 +199,14 @@ void indexClose(SIndex* sIdx) {
   idxReleaseRef(sIdx->refId);
   idxRemoveRef(sIdx->refId);
 }
+void indexGetMergeStat(SIndex* sIdx, SIndexMergeStat* pStat) {
+  pStat->nMerge = atomic_load_64(&sIdx->mergeStat.nMerge);
+  pStat->nMergeFail = atomic_load_64(&sIdx->mergeStat.nMergeFail);
+  pStat->mergeTimeUs = atomic_load_64(&sIdx->mergeStat.mergeTimeUs);
+  pStat->nInFlight = atomic_load_64(&sIdx->mergeStat.nInFlight);
+  pStat->nStall = atomic_load_64(&sIdx->mergeStat.nStall);
+  pStat->stallTimeUs = atomic_load_64(&sIdx->mergeStat.stallTimeUs);
+}
 int64_t idxAddRef(void* p) {
   // impl
   return taosAddRef(indexRefMgt, p);
@@ -550,6 +573,7 @@ int idxFlushCacheToTFile(SIndex* sIdx, void* cache, bool quit) {
     idxCacheDestroyImm(pCache);
     tfileReaderUnRef(pReader);
     atomic_store_32(&pCache->merging, 0);
+    atomic_sub_fetch_64(&sIdx->mergeStat.nInFlight, 1);
     if (quit) {
       idxPost(sIdx);
     }
@@ -595,11 +619,15 @@ int idxFlushCacheToTFile(SIndex* sIdx, void* cache, bool quit) {
   idxMayMergeTempToFinalRslt(result, NULL, tr);
   idxTRsltDestroy(tr);
 
-  int ret = idxGenTFile(sIdx, pCache, result);
+  // the new tfile replaces the old one in the reader cache, searches keep using the old reader and imm until then
+  int     ret = idxGenTFile(sIdx, pCache, result);
+  int64_t cost = taosGetTimestampUs() - st;
   if (ret != 0) {
+    atomic_add_fetch_64(&sIdx->mergeStat.nMergeFail, 1);
     indexError("failed to merge");
   } else {
-    int64_t cost = taosGetTimestampUs() - st;
+    atomic_add_fetch_64(&sIdx->mergeStat.nMerge, 1);
+    atomic_add_fetch_64(&sIdx->mergeStat.mergeTimeUs, cost);
     indexInfo("success to merge , time cost: %" PRId64 "ms", cost / 1000);
   }
   idxDestroyFinalRslt(result);
@@ -613,6 +641,7 @@ int idxFlushCacheToTFile(SIndex* sIdx, void* cache, bool quit) {
   idxCacheUnRef(pCache);
 
   atomic_store_32(&pCache->merging, 0);
+  atomic_sub_fetch_64(&sIdx->mergeStat.nInFlight, 1);
   if (quit) {
     idxPost(sIdx);
   }
@@ -21,10 +21,11 @@
 
 #define MAX_INDEX_KEY_LEN 256  // test only, change later
 
-#define MEM_TERM_LIMIT     10 * 10000
-#define MEM_THRESHOLD      128 * 1024 * 1024  // 8M
-#define MEM_SIGNAL_QUIT    MEM_THRESHOLD * 5
-#define MEM_ESTIMATE_RADIO 1.5
+#define MEM_TERM_LIMIT      10 * 10000
+#define MEM_THRESHOLD       128 * 1024 * 1024  // 8M
+#define MEM_SIGNAL_QUIT     MEM_THRESHOLD * 5
+#define MEM_STALL_THRESHOLD MEM_THRESHOLD * 3  // writes block past it while imm is being merged
+#define MEM_ESTIMATE_RADIO  1.5
 
 static void idxMemRef(MemTable* tbl);
 static void idxMemUnRef(MemTable* tbl);
@@ -499,6 +500,7 @@ int idxCacheSchedToMerge(IndexCache* pCache, bool notify) {
   }
   schedMsg.msg = NULL;
   idxAcquireRef(pCache->index->refId);
+  atomic_add_fetch_64(&pCache->index->mergeStat.nInFlight, 1);
   taosScheduleTask(indexQhandle, &schedMsg);
   return 0;
 }
@@ -508,8 +510,17 @@ static void idxCacheMakeRoomForWrite(IndexCache* cache) {
     if (cache->occupiedMem * MEM_ESTIMATE_RADIO < MEM_THRESHOLD) {
       break;
     } else if (cache->imm != NULL) {
-      // TODO: wake up by condition variable
+      // the merge of imm runs in the background, let writes grow mem meanwhile and only
+      // block them when mem is far over the threshold or a forced merge has to queue up
+      if (cache->occupiedMem < MEM_SIGNAL_QUIT && cache->occupiedMem * MEM_ESTIMATE_RADIO < MEM_STALL_THRESHOLD) {
+        break;
+      }
+      int64_t st = taosGetTimestampUs();
       idxCacheWait(cache);
+      if (cache->index != NULL) {
+        atomic_add_fetch_64(&cache->index->mergeStat.nStall, 1);
+        atomic_add_fetch_64(&cache->index->mergeStat.stallTimeUs, taosGetTimestampUs() - st);
+      }
     } else {
       bool quit = cache->occupiedMem >= MEM_SIGNAL_QUIT ? true : false;
 
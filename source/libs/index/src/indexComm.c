@@ -288,7 +288,10 @@ char* idxPackJsonDataPrefixNoType(SIndexTerm* itm, int32_t* skip) {
 int idxUidCompare(const void* a, const void* b) {
   uint64_t l = *(uint64_t*)a;
   uint64_t r = *(uint64_t*)b;
-  return l - r;
+  if (l == r) {
+    return 0;
+  }
+  return l < r ? -1 : 1;
 }
 #ifdef BUILD_NO_CALL
 int32_t idxConvertData(void* src, int8_t type, void** dst) {
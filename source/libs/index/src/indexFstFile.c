@@ -81,12 +81,12 @@ static FORCE_INLINE int idxFileCtxDoWrite(IFileCtx* ctx, uint8_t* buf, int len)
 static FORCE_INLINE int idxFileCtxDoRead(IFileCtx* ctx, uint8_t* buf, int len) {
   int nRead = 0;
   if (ctx->type == TFILE) {
-#ifdef USE_MMAP
-    nRead = len < ctx->file.size ? len : ctx->file.size;
-    memcpy(buf, ctx->file.ptr, nRead);
-#else
-    nRead = taosReadFile(ctx->file.pFile, buf, len);
-#endif
+    if (ctx->file.ptr != NULL) {
+      nRead = TMAX(0, TMIN(len, ctx->file.size - ctx->offset));
+      memcpy(buf, ctx->file.ptr + ctx->offset, nRead);
+    } else {
+      nRead = taosReadFile(ctx->file.pFile, buf, len);
+    }
   } else {
     memcpy(buf, ctx->mem.buf + ctx->offset, len);
   }
@@ -102,6 +102,13 @@ static int idxFileCtxDoReadFrom(IFileCtx* ctx, uint8_t* buf, int len, int32_t of
 
   if (offset >= ctx->file.size) return 0;
 
+  if (ctx->file.ptr != NULL) {
+    // the mapped file is read in place, no block cache needed
+    total = TMIN(len, ctx->file.size - offset);
+    memcpy(buf, ctx->file.ptr + offset, total);
+    return total;
+  }
+
   do {
     char key[1024] = {0};
     ASSERT(strlen(ctx->file.buf) + 1 + 64 < sizeof(key));
@@ -160,6 +167,8 @@ static FORCE_INLINE int idxFileCtxGetSize(IFileCtx* ctx) {
   if (ctx->type == TFILE) {
     if (ctx->file.readOnly == false) {
       return ctx->offset;
+    } else if (ctx->file.ptr != NULL) {
+      return (int)ctx->file.size;
     } else {
       int64_t file_size = 0;
       taosStatFile(ctx->file.buf, &file_size, NULL, NULL);
@@ -212,9 +221,8 @@ IFileCtx* idxFileCtxCreate(WriterType type, const char* path, bool readOnly, int
 
       ctx->file.wBufOffset = 0;
 
-#ifdef USE_MMAP
-      ctx->file.ptr = (char*)tfMmapReadOnly(ctx->file.pFile, ctx->file.size);
-#endif
+      // index files are immutable once written, readers map them and walk fst nodes and posting lists in place
+      ctx->file.ptr = (char*)taosMmapReadOnlyFile(ctx->file.pFile, ctx->file.size);
     }
     if (ctx->file.pFile == NULL) {
       indexError("failed to open file, error %d", errno);
@@ -254,9 +262,7 @@ void idxFileCtxDestroy(IFileCtx* ctx, bool remove) {
     taosMemoryFreeClear(ctx->file.wBuf);
     taosCloseFile(&ctx->file.pFile);
     if (ctx->file.readOnly) {
-#ifdef USE_MMAP
-      munmap(ctx->file.ptr, ctx->file.size);
-#endif
+      taosMunmapFile(ctx->file.ptr, ctx->file.size);
     }
     if (remove) {
       unlink(ctx->file.buf);
@@ -265,6 +271,16 @@ void idxFileCtxDestroy(IFileCtx* ctx, bool remove) {
   taosMemoryFree(ctx);
 }
 
+char* idxFileCtxMapped(IFileCtx* ctx, int32_t offset, int32_t len) {
+  if (ctx->type != TFILE || ctx->file.ptr == NULL) {
+    return NULL;
+  }
+  if (offset < 0 || len < 0 || (int64_t)offset + len > ctx->file.size) {
+    return NULL;
+  }
+  return ctx->file.ptr + offset;
+}
+
 IdxFstFile* idxFileCreate(void* wrt) {
   IdxFstFile* cw = taosMemoryCalloc(1, sizeof(IdxFstFile));
   if (cw == NULL) {
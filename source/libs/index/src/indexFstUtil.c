@@ -79,6 +79,7 @@ FstSlice fstSliceCreate(uint8_t* data, uint64_t len) {
   FstString* str = (FstString*)taosMemoryMalloc(sizeof(FstString));
   str->ref = 1;
   str->len = len;
+  str->borrowed = false;
   str->data = taosMemoryMalloc(len * sizeof(uint8_t));
 
   if (data != NULL) {
@@ -88,6 +89,17 @@ FstSlice fstSliceCreate(uint8_t* data, uint64_t len) {
   FstSlice s = {.str = str, .start = 0, .end = len - 1};
   return s;
 }
+// wrap data without copy, data must outlive the slice and all its copies
+FstSlice fstSliceCreateRef(uint8_t* data, uint64_t len) {
+  FstString* str = (FstString*)taosMemoryMalloc(sizeof(FstString));
+  str->ref = 1;
+  str->len = len;
+  str->borrowed = true;
+  str->data = data;
+
+  FstSlice s = {.str = str, .start = 0, .end = len - 1};
+  return s;
+}
 // just shallow copy
 FstSlice fstSliceCopy(FstSlice* s, int32_t start, int32_t end) {
   FstString* str = s->str;
@@ -109,6 +121,7 @@ FstSlice fstSliceDeepCopy(FstSlice* s, int32_t start, int32_t end) {
   str->data = buf;
   str->len = tlen;
   str->ref = 1;
+  str->borrowed = false;
 
   FstSlice ans;
   ans.str = str;
@@ -130,7 +143,9 @@ void fstSliceDestroy(FstSlice* s) {
 
   int32_t ref = atomic_sub_fetch_32(&str->ref, 1);
   if (ref == 0) {
-    taosMemoryFree(str->data);
+    if (!str->borrowed) {
+      taosMemoryFree(str->data);
+    }
     taosMemoryFree(str);
     s->str = NULL;
   }
@@ -32,11 +32,16 @@ typedef struct TFileFstIter {
   TFileReader* rdr;
 } TFileFstIter;
 
-#define TF_TABLE_TATOAL_SIZE(sz) (sizeof(sz) + sz * sizeof(uint64_t))
+// posting list of a term
+// |<--- -count --->|<--- nbytes --->|<------ delta of sorted uids, varint ------>|
+// |<--- int32_t -->|<--- int32_t -->|<----------------- nbytes ----------------->|
+// a non-negative count marks the older layout, count uint64_t uids in plain
+#define TF_TABLE_HEAD_SIZE (sizeof(int32_t) * 2)
 
 static int  tfileStrCompare(const void* a, const void* b);
 static int  tfileValueCompare(const void* a, const void* b, const void* param);
-static void tfileSerialTableIdsToBuf(char* buf, SArray* tableIds);
+static int32_t tfileTableIdsSize(SArray* tableIds);
+static void    tfileSerialTableIdsToBuf(char* buf, SArray* tableIds);
 
 static int tfileWriteHeader(TFileWriter* writer);
 static int tfileWriteFstOffset(TFileWriter* tw, int32_t offset);
@@ -564,7 +569,7 @@ int tfileWriterPut(TFileWriter* tw, void* data, bool order) {
     taosArrayRemoveDuplicate(v->tableId, idxUidCompare, NULL);
     int32_t tbsz = taosArrayGetSize(v->tableId);
     if (tbsz == 0) continue;
-    fstOffset += TF_TABLE_TATOAL_SIZE(tbsz);
+    fstOffset += tfileTableIdsSize(v->tableId);
   }
   tfileWriteFstOffset(tw, fstOffset);
 
@@ -577,7 +582,7 @@ int tfileWriterPut(TFileWriter* tw, void* data, bool order) {
     int32_t tbsz = taosArrayGetSize(v->tableId);
     if (tbsz == 0) continue;
     // check buf has enough space or not
-    int32_t ttsz = TF_TABLE_TATOAL_SIZE(tbsz);
+    int32_t ttsz = tfileTableIdsSize(v->tableId);
 
     if (cap < ttsz) {
       cap = ttsz;
@@ -796,8 +801,8 @@ static int tfileStrCompare(const void* a, const void* b) {
 static int tfileValueCompare(const void* a, const void* b, const void* param) {
   __compar_fn_t fn = *(__compar_fn_t*)param;
 
-  TFileValue* av = (TFileValue*)a;
-  TFileValue* bv = (TFileValue*)b;
+  TFileValue* av = *(TFileValue**)a;
+  TFileValue* bv = *(TFileValue**)b;
 
   return fn(av->colVal, bv->colVal);
 }
@@ -823,12 +828,27 @@ void tfileValueDestroy(TFileValue* tf) {
   taosMemoryFree(tf->colVal);
   taosMemoryFree(tf);
 }
+static int32_t tfileTableIdsSize(SArray* ids) {
+  int32_t  len = TF_TABLE_HEAD_SIZE;
+  uint64_t prev = 0;
+  for (size_t i = 0; i < taosArrayGetSize(ids); i++) {
+    uint64_t v = *(uint64_t*)taosArrayGet(ids, i);
+    len += taosEncodeVariantU64(NULL, v - prev);
+    prev = v;
+  }
+  return len;
+}
 static void tfileSerialTableIdsToBuf(char* buf, SArray* ids) {
-  int sz = taosArrayGetSize(ids);
-  SERIALIZE_VAR_TO_BUF(buf, sz, int32_t);
+  // ids are sorted and unique, so the deltas are small for uids allocated close together
+  int32_t  sz = taosArrayGetSize(ids);
+  int32_t  nbytes = tfileTableIdsSize(ids) - TF_TABLE_HEAD_SIZE;
+  uint64_t prev = 0;
+  SERIALIZE_VAR_TO_BUF(buf, -sz, int32_t);
+  SERIALIZE_VAR_TO_BUF(buf, nbytes, int32_t);
   for (size_t i = 0; i < sz; i++) {
-    uint64_t* v = taosArrayGet(ids, i);
-    SERIALIZE_VAR_TO_BUF(buf, *v, uint64_t);
+    uint64_t v = *(uint64_t*)taosArrayGet(ids, i);
+    taosEncodeVariantU64((void**)&buf, v - prev);
+    prev = v;
   }
 }
 
@@ -901,8 +921,19 @@ static int tfileReaderLoadFst(TFileReader* reader) {
   IFileCtx* ctx = reader->ctx;
   int       size = ctx->size(ctx);
 
-  // current load fst into memory, refactor it later
   int   fstSize = size - reader->header.fstOffset - sizeof(FILE_MAGIC_NUMBER);
+  char* mapped = idxFileCtxMapped(ctx, reader->header.fstOffset, fstSize);
+  if (mapped != NULL) {
+    // walk fst nodes in the mapped file, the ctx is destroyed after the fst
+    FstSlice st = fstSliceCreateRef((uint8_t*)mapped, fstSize);
+    reader->fst = fstCreate(&st);
+    fstSliceDestroy(&st);
+    indexInfo("map fst, offset=%d, fst size: %d, filename: %s, file size: %d", reader->header.fstOffset, fstSize,
+              ctx->file.buf, size);
+    return reader->fst != NULL ? 0 : -1;
+  }
+
+  // load fst into memory when the file can not be mapped
   char* buf = taosMemoryCalloc(1, fstSize);
   if (buf == NULL) {
     return -1;
@@ -916,6 +947,7 @@ static int tfileReaderLoadFst(TFileReader* reader) {
   // we assuse fst size less than FST_MAX_SIZE
   ASSERTS(nread > 0 && nread <= fstSize, "index read incomplete fst");
   if (nread <= 0 || nread > fstSize) {
+    taosMemoryFree(buf);
     return -1;
   }
 
@@ -926,17 +958,14 @@ static int tfileReaderLoadFst(TFileReader* reader) {
 
   return reader->fst != NULL ? 0 : -1;
 }
-static int tfileReaderLoadTableIds(TFileReader* reader, int32_t offset, SArray* result) {
-  // TODO(yihao): opt later
+static int tfileReaderLoadPlainTableIds(TFileReader* reader, int32_t offset, int32_t nid, SArray* result) {
   IFileCtx* ctx = reader->ctx;
   // add block cache
   char    block[4096] = {0};
   int32_t nread = ctx->readFrom(ctx, block, sizeof(block), offset);
   ASSERT(nread >= sizeof(uint32_t));
 
-  char*   p = block;
-  int32_t nid = *(int32_t*)p;
-  p += sizeof(nid);
+  char* p = block + sizeof(nid);
 
   while (nid > 0) {
     int32_t left = block + sizeof(block) - p;
@@ -959,6 +988,66 @@ static int tfileReaderLoadTableIds(TFileReader* reader, int32_t offset, SArray*
   }
   return 0;
 }
+static int tfileReaderLoadTableIds(TFileReader* reader, int32_t offset, SArray* result) {
+  IFileCtx* ctx = reader->ctx;
+  char      head[TF_TABLE_HEAD_SIZE] = {0};
+  int32_t   nread = ctx->readFrom(ctx, head, sizeof(head), offset);
+  if (nread < (int32_t)sizeof(int32_t)) {
+    return -1;
+  }
+
+  int32_t nid = *(int32_t*)head;
+  if (nid >= 0) {
+    return tfileReaderLoadPlainTableIds(reader, offset, nid, result);
+  }
+  if (nread != sizeof(head)) {
+    return -1;
+  }
+  nid = -nid;
+
+  int32_t nbytes = *(int32_t*)(head + sizeof(int32_t));
+  char    block[4096];
+  char*   alloc = NULL;
+  int     code = 0;
+
+  // decode straight from the mapped file, or read the list into a buffer first
+  const char* buf = idxFileCtxMapped(ctx, offset + sizeof(head), nbytes);
+  if (buf == NULL) {
+    char* rbuf = block;
+    if (nbytes > sizeof(block)) {
+      rbuf = alloc = taosMemoryMalloc(nbytes);
+      if (alloc == NULL) {
+        return -1;
+      }
+    }
+    if (ctx->readFrom(ctx, rbuf, nbytes, offset + sizeof(head)) != nbytes) {
+      taosMemoryFree(alloc);
+      return -1;
+    }
+    buf = rbuf;
+  }
+
+  if (taosArrayEnsureCap(result, taosArrayGetSize(result) + nid) != 0) {
+    taosMemoryFree(alloc);
+    return -1;
+  }
+
+  const char* p = buf;
+  const char* end = buf + nbytes;
+  uint64_t    v = 0;
+  for (int32_t i = 0; i < nid; i++) {
+    uint64_t delta = 0;
+    if (p >= end || (p = taosDecodeVariantU64(p, &delta)) == NULL || p > end) {
+      code = -1;
+      break;
+    }
+    v += delta;
+    taosArrayPush(result, &v);
+  }
+
+  taosMemoryFree(alloc);
+  return code;
+}
 static int tfileReaderVerify(TFileReader* reader) {
   // just validate header and Footer, file corrupted also shuild be verified later
   IFileCtx* ctx = reader->ctx;
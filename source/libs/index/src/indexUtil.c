@@ -14,6 +14,7 @@
  */
 #include "indexUtil.h"
 #include "index.h"
+#include "talgo.h"
 #include "tcompare.h"
 
 typedef struct MergeIndex {
@@ -21,46 +22,78 @@ typedef struct MergeIndex {
   int len;
 } MergeIndex;
 
-static FORCE_INLINE int iBinarySearch(SArray *arr, int s, int e, uint64_t k) {
-  uint64_t v;
-  int32_t  m;
-  while (s <= e) {
-    m = s + (e - s) / 2;
-    v = *(uint64_t *)taosArrayGet(arr, m);
-    if (v >= k) {
-      e = m - 1;
-    } else {
+/*
+ * find the first position in [s, len) whose value is not less than k, probing
+ * 1, 2, 4 ... elements ahead of s before the binary search, so walking a long
+ * list with the keys of a short one costs O(short * log(long / short))
+ */
+static FORCE_INLINE int iGallopSearch(const uint64_t *arr, int s, int len, uint64_t k) {
+  int step = 1;
+  int e = s;
+  while (e < len && arr[e] < k) {
+    s = e + 1;
+    e += step;
+    step <<= 1;
+  }
+  if (e >= len) {
+    e = len;
+  }
+  while (s < e) {
+    int m = s + (e - s) / 2;
+    if (arr[m] < k) {
       s = m + 1;
+    } else {
+      e = m;
     }
   }
   return s;
 }
 
+static int iArraySizeCompare(const void *a, const void *b) {
+  int32_t la = (int32_t)taosArrayGetSize(*(SArray **)a);
+  int32_t lb = (int32_t)taosArrayGetSize(*(SArray **)b);
+  return la == lb ? 0 : (la < lb ? -1 : 1);
+}
+
 void iIntersection(SArray *in, SArray *out) {
   int32_t sz = (int32_t)taosArrayGetSize(in);
   if (sz <= 0) {
     return;
   }
+
+  // drive the intersection with the shortest list
+  SArray **arrs = taosMemoryCalloc(sz, sizeof(SArray *));
   MergeIndex *mi = taosMemoryCalloc(sz, sizeof(MergeIndex));
+  if (arrs == NULL || mi == NULL) {
+    taosMemoryFree(arrs);
+    taosMemoryFree(mi);
+    return;
+  }
   for (int i = 0; i < sz; i++) {
-    SArray *t = taosArrayGetP(in, i);
-    mi[i].len = (int32_t)taosArrayGetSize(t);
+    arrs[i] = taosArrayGetP(in, i);
+  }
+  taosMergeSort(arrs, sz, sizeof(SArray *), iArraySizeCompare);
+  for (int i = 0; i < sz; i++) {
+    mi[i].len = (int32_t)taosArrayGetSize(arrs[i]);
     mi[i].idx = 0;
   }
 
-  SArray *base = taosArrayGetP(in, 0);
-  for (int i = 0; i < taosArrayGetSize(base); i++) {
-    uint64_t tgt = *(uint64_t *)taosArrayGet(base, i);
+  const uint64_t *base = (const uint64_t *)TARRAY_DATA(arrs[0]);
+  for (int i = 0; i < mi[0].len; i++) {
+    uint64_t tgt = base[i];
     bool     has = true;
-    for (int j = 1; j < taosArrayGetSize(in); j++) {
-      SArray *oth = taosArrayGetP(in, j);
-      int     mid = iBinarySearch(oth, mi[j].idx, mi[j].len - 1, tgt);
-      if (mid >= 0 && mid < mi[j].len) {
-        uint64_t val = *(uint64_t *)taosArrayGet(oth, mid);
-        has = (val == tgt ? true : false);
-        mi[j].idx = mid;
-      } else {
+    for (int j = 1; j < sz; j++) {
+      const uint64_t *oth = (const uint64_t *)TARRAY_DATA(arrs[j]);
+      mi[j].idx = iGallopSearch(oth, mi[j].idx, mi[j].len, tgt);
+      if (mi[j].idx >= mi[j].len) {
+        // nothing left in this list can match any later value of the base
+        i = mi[0].len;
         has = false;
+        break;
+      }
+      if (oth[mi[j].idx] != tgt) {
+        has = false;
+        break;
       }
     }
     if (has == true) {
@@ -68,7 +101,34 @@ void iIntersection(SArray *in, SArray *out) {
     }
   }
   taosMemoryFreeClear(mi);
+  taosMemoryFreeClear(arrs);
+}
+
+static void iUnionTwo(SArray *a, SArray *b, SArray *out) {
+  const uint64_t *pa = (const uint64_t *)TARRAY_DATA(a);
+  const uint64_t *pb = (const uint64_t *)TARRAY_DATA(b);
+  int32_t         la = (int32_t)taosArrayGetSize(a);
+  int32_t         lb = (int32_t)taosArrayGetSize(b);
+  int32_t         i = 0, j = 0;
+
+  taosArrayEnsureCap(out, taosArrayGetSize(out) + la + lb);
+  while (i < la || j < lb) {
+    uint64_t v;
+    if (j >= lb || (i < la && pa[i] < pb[j])) {
+      v = pa[i++];
+    } else if (i >= la || pb[j] < pa[i]) {
+      v = pb[j++];
+    } else {
+      v = pa[i++];
+      j++;
+    }
+    if (taosArrayGetSize(out) > 0 && *(uint64_t *)taosArrayGetLast(out) == v) {
+      continue;
+    }
+    taosArrayPush(out, &v);
+  }
 }
+
 void iUnion(SArray *in, SArray *out) {
   int32_t sz = (int32_t)taosArrayGetSize(in);
   if (sz <= 0) {
@@ -78,6 +138,10 @@ void iUnion(SArray *in, SArray *out) {
     taosArrayAddAll(out, taosArrayGetP(in, 0));
     return;
   }
+  if (sz == 2) {
+    iUnionTwo(taosArrayGetP(in, 0), taosArrayGetP(in, 1), out);
+    return;
+  }
 
   MergeIndex *mi = taosMemoryCalloc(sz, sizeof(MergeIndex));
   for (int i = 0; i < sz; i++) {
@@ -95,7 +159,7 @@ void iUnion(SArray *in, SArray *out) {
         continue;
       }
       uint64_t cVal = *(uint64_t *)taosArrayGet(t, mi[j].idx);
-      if (cVal < mVal) {
+      if (cVal < mVal || mIdx == -1) {
         mVal = cVal;
         mIdx = j;
       }
@@ -123,15 +187,20 @@ void iExcept(SArray *total, SArray *except) {
     return;
   }
 
+  uint64_t       *pt = (uint64_t *)TARRAY_DATA(total);
+  const uint64_t *pe = (const uint64_t *)TARRAY_DATA(except);
+
   int vIdx = 0;
+  int eIdx = 0;
   for (int i = 0; i < tsz; i++) {
-    uint64_t val = *(uint64_t *)taosArrayGet(total, i);
-    int      idx = iBinarySearch(except, 0, esz - 1, val);
-    if (idx >= 0 && idx < esz && *(uint64_t *)taosArrayGet(except, idx) == val) {
-      continue;
+    uint64_t val = pt[i];
+    if (eIdx < esz) {
+      eIdx = iGallopSearch(pe, eIdx, esz, val);
+      if (eIdx < esz && pe[eIdx] == val) {
+        continue;
+      }
     }
-    taosArraySet(total, vIdx, &val);
-    vIdx += 1;
+    pt[vIdx++] = val;
   }
 
   taosArrayPopTailBatch(total, tsz - vIdx);
@@ -15,6 +15,9 @@
 #include <gtest/gtest.h>
 #include <algorithm>
 #include <iostream>
+#include <map>
+#include <random>
+#include <set>
 #include <string>
 #include <thread>
 #include "index.h"
@@ -516,6 +519,52 @@ TEST_F(IndexTFileEnv, test_tfile_write) {
 
   // tfileWriterDestroy(twrite);
 }
+TEST_F(IndexTFileEnv, test_tfile_write_sparse_uid) {
+  // uids spread over the whole uint64 range, with posting lists longer than one read block
+  std::mt19937_64                           rng(1);
+  std::map<std::string, std::set<uint64_t>> expect;
+
+  SArray* data = (SArray*)taosArrayInit(4, sizeof(void*));
+  for (int i = 0; i < 8; i++) {
+    std::string val = "v" + std::to_string(i);
+    TFileValue* tv = genTFileValue(val.c_str());
+    taosArrayClear(tv->tableId);
+
+    std::set<uint64_t>& uids = expect[val];
+    int                 n = i == 0 ? 1 : 3000 * i;
+    for (int j = 0; j < n; j++) {
+      uint64_t uid = (i % 2 == 0) ? rng() : (uint64_t)0x7f00000000000000 + rng() % 100000;
+      taosArrayPush(tv->tableId, &uid);
+      uids.insert(uid);
+    }
+    taosArrayPush(data, &tv);
+  }
+  fObj->Put(data);
+  for (size_t i = 0; i < taosArrayGetSize(data); i++) {
+    destroyTFileValue(taosArrayGetP(data, i));
+  }
+  taosArrayDestroy(data);
+
+  for (auto& kv : expect) {
+    char    buf[256] = {0};
+    int16_t sz = kv.first.size();
+    memcpy(buf, (uint16_t*)&sz, 2);
+    memcpy(buf + 2, kv.first.c_str(), kv.first.size());
+    SIndexTerm* term =
+        indexTermCreate(1, ADD_VALUE, TSDB_DATA_TYPE_BINARY, colName.c_str(), colName.size(), buf, sizeof(buf));
+    SIndexTermQuery query = {term, QUERY_TERM};
+
+    SArray* result = (SArray*)taosArrayInit(1, sizeof(uint64_t));
+    fObj->Get(&query, result);
+    ASSERT_EQ(taosArrayGetSize(result), kv.second.size());
+    size_t j = 0;
+    for (uint64_t uid : kv.second) {
+      ASSERT_EQ(*(uint64_t*)taosArrayGet(result, j++), uid);
+    }
+    indexTermDestroy(term);
+    taosArrayDestroy(result);
+  }
+}
 class CacheObj {
  public:
   CacheObj() {
@@ -1026,6 +1075,27 @@ TEST_F(IndexEnv2, testIndex_restart) {
   index->SearchOneTarget("tag1", "Hello", 10);
   index->SearchOneTarget("tag2", "Test", 10);
 }
+TEST_F(IndexEnv2, testIndex_close_multi_col) {
+  // close merges every column into its tfile, the columns are merged side by side
+  std::string path = TD_TMP_DIR_PATH "close_multi_col";
+  if (index->Init(path) != 0) {
+  }
+  for (int c = 0; c < 4; c++) {
+    std::string colName = "tag" + std::to_string(c);
+    for (int i = 0; i < 100 * (c + 1); i++) {
+      index->PutOneTarge(colName, "Hello", i);
+    }
+  }
+  delete index;
+
+  index = new IndexObj();
+  if (index->Init(path, false) != 0) {
+  }
+  for (int c = 0; c < 4; c++) {
+    std::string colName = "tag" + std::to_string(c);
+    EXPECT_EQ(100 * (c + 1), index->SearchOne(colName, "Hello"));
+  }
+}
 // TEST_F(IndexEnv2, testIndex_restart1) {
 //  std::string path = TD_TMP_DIR_PATH "cache_and_tfile";
 //  if (index->Init(path, false) != 0) {
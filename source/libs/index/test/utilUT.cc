@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <algorithm>
 #include <iostream>
+#include <iterator>
+#include <random>
 #include <string>
 #include <thread>
 #include <vector>
@@ -323,6 +325,53 @@ TEST_F(UtilEnv, 01Except) {
   ASSERT_EQ(*(uint64_t *)taosArrayGet(total, 0), 1);
   ASSERT_EQ(*(uint64_t *)taosArrayGet(total, 1), 100);
 }
+TEST_F(UtilEnv, randomMerge) {
+  std::mt19937_64 rng(7);
+  for (int round = 0; round < 50; round++) {
+    clearSourceArray(src);
+    clearFinalArray(rslt);
+
+    std::vector<std::vector<uint64_t>> lists(3);
+    for (int i = 0; i < 3; i++) {
+      int      n = rng() % (i == 0 ? 50 : 5000);
+      uint64_t range = round % 2 == 0 ? 10000 : UINT64_MAX;
+      for (int j = 0; j < n; j++) lists[i].push_back(rng() % range);
+      std::sort(lists[i].begin(), lists[i].end());
+      lists[i].erase(std::unique(lists[i].begin(), lists[i].end()), lists[i].end());
+
+      SArray *m = (SArray *)taosArrayGetP(src, (i + round) % 3);
+      for (uint64_t v : lists[i]) taosArrayPush(m, &v);
+    }
+
+    std::vector<uint64_t> expect, tmp;
+    std::set_intersection(lists[0].begin(), lists[0].end(), lists[1].begin(), lists[1].end(), std::back_inserter(tmp));
+    std::set_intersection(tmp.begin(), tmp.end(), lists[2].begin(), lists[2].end(), std::back_inserter(expect));
+    iIntersection(src, rslt);
+    ASSERT_EQ(taosArrayGetSize(rslt), expect.size());
+    for (size_t i = 0; i < expect.size(); i++) {
+      ASSERT_EQ(*(uint64_t *)taosArrayGet(rslt, i), expect[i]);
+    }
+
+    clearFinalArray(rslt);
+    expect.clear();
+    tmp.clear();
+    std::set_union(lists[0].begin(), lists[0].end(), lists[1].begin(), lists[1].end(), std::back_inserter(tmp));
+    std::set_union(tmp.begin(), tmp.end(), lists[2].begin(), lists[2].end(), std::back_inserter(expect));
+    iUnion(src, rslt);
+    ASSERT_EQ(taosArrayGetSize(rslt), expect.size());
+    for (size_t i = 0; i < expect.size(); i++) {
+      ASSERT_EQ(*(uint64_t *)taosArrayGet(rslt, i), expect[i]);
+    }
+
+    tmp.clear();
+    std::set_difference(expect.begin(), expect.end(), lists[1].begin(), lists[1].end(), std::back_inserter(tmp));
+    iExcept(rslt, (SArray *)taosArrayGetP(src, (1 + round) % 3));
+    ASSERT_EQ(taosArrayGetSize(rslt), tmp.size());
+    for (size_t i = 0; i < tmp.size(); i++) {
+      ASSERT_EQ(*(uint64_t *)taosArrayGet(rslt, i), tmp[i]);
+    }
+  }
+}
 TEST_F(UtilEnv, testFill) {
   for (int i = 0; i < 1000000; i++) {
     int64_t val = i;
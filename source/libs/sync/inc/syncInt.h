@@ -53,6 +53,9 @@ typedef struct SSyncLogReplMgr        SSyncLogReplMgr;
 
 #define MAX_CONFIG_INDEX_COUNT 256
 
+// clock drift the leader lease leaves to the shortest election timeout
+#define SYNC_LEASE_DRIFT_MS 500
+
 typedef struct SRaftCfg {
   SSyncCfg          cfg;
   int32_t           batchSize;
@@ -104,6 +107,7 @@ typedef struct SElectTimerParam {
 typedef struct SPeerState {
   SyncIndex lastSendIndex;
   int64_t   lastSendTime;
+  int64_t   hbAckTime;
 } SPeerState;
 
 typedef struct SSyncNode {
@@ -223,6 +227,8 @@ typedef struct SSyncNode {
   int64_t startTime;
   int64_t roleTimeMs;
   int64_t lastReplicateTime;
+  int64_t leaderHbTimeMs;  // last heartbeat of the current leader, voters stay with it for the lease
+  int64_t noVoteUntilMs;   // no votes until it, a lease acked before a restart may still be in use
 
   int32_t electNum;
   int32_t becomeLeaderNum;
@@ -282,6 +288,10 @@ bool      syncNodeHeartbeatReplyTimeout(SSyncNode* pSyncNode);
 bool      syncNodeSnapshotSending(SSyncNode* pSyncNode);
 bool      syncNodeSnapshotRecving(SSyncNode* pSyncNode);
 bool      syncNodeIsReadyForRead(SSyncNode* pSyncNode);
+bool      syncNodeLeaseValid(SSyncNode* pSyncNode);
+bool      syncNodeLeaderLeaseHeld(SSyncNode* pSyncNode);
+bool      syncNodeVoteBlocked(SSyncNode* pSyncNode);
+int32_t   syncNodeLeaseMs(SSyncNode* pSyncNode);
 
 // raft state change --------------
 void syncNodeUpdateTerm(SSyncNode* pSyncNode, SyncTerm term);
@@ -148,6 +148,7 @@ typedef struct SyncHeartbeatReply {
   int64_t  startTime;
   int64_t  timeStamp;
   int16_t  reserved;
+  int64_t  hbTimeStamp;  // send time of the acked heartbeat, renews the leader lease
 } SyncHeartbeatReply;
 
 typedef struct SyncPreSnapshot {
@@ -262,6 +263,8 @@ int32_t syncBuildAppendEntries(SRpcMsg* pMsg, int32_t dataLen, int32_t vgId);
 int32_t syncBuildAppendEntriesReply(SRpcMsg* pMsg, int32_t vgId);
 int32_t syncBuildAppendEntriesFromRaftEntry(SSyncNode* pNode, SSyncRaftEntry* pEntry, SyncTerm prevLogTerm,
                                             SRpcMsg* pRpcMsg);
+int32_t syncBuildAppendEntriesFromRaftEntries(SSyncNode* pNode, SSyncRaftEntry** ppEntries, int32_t count,
+                                              SyncTerm prevLogTerm, SRpcMsg* pRpcMsg);
 int32_t syncBuildHeartbeat(SRpcMsg* pMsg, int32_t vgId);
 int32_t syncBuildHeartbeatReply(SRpcMsg* pMsg, int32_t vgId);
 int32_t syncBuildPreSnapshot(SRpcMsg* pMsg, int32_t vgId);
@@ -47,6 +47,8 @@ typedef struct SSyncLogBufEntry {
   SyncTerm        prevLogTerm;
 } SSyncLogBufEntry;
 
+// Entries and indexes are modified under mutex by the sync thread and the proposing write thread. Indexes are
+// published with atomic stores, so readers of the buffer state use the accessors below without taking the lock.
 typedef struct SSyncLogBuffer {
   SSyncLogBufEntry entries[TSDB_SYNC_LOG_BUFFER_SIZE];
   int64_t          startIndex;
@@ -85,6 +87,8 @@ int32_t syncLogReplProbe(SSyncLogReplMgr* pMgr, SSyncNode* pNode, SyncIndex inde
 int32_t syncLogReplRetryOnNeed(SSyncLogReplMgr* pMgr, SSyncNode* pNode);
 int32_t syncLogReplSendTo(SSyncLogReplMgr* pMgr, SSyncNode* pNode, SyncIndex index, SyncTerm* pTerm, SRaftId* pDestId,
                           bool* pBarrier);
+int32_t syncLogReplSendBatchTo(SSyncLogReplMgr* pMgr, SSyncNode* pNode, SyncIndex index, SyncIndex lastIndex,
+                               SRaftId* pDestId, int64_t nowMs, int32_t* pCount);
 
 int32_t syncLogReplProcessReply(SSyncLogReplMgr* pMgr, SSyncNode* pNode, SyncAppendEntriesReply* pMsg);
 int32_t syncLogReplRecover(SSyncLogReplMgr* pMgr, SSyncNode* pNode, SyncAppendEntriesReply* pMsg);
@@ -100,11 +104,15 @@ int32_t         syncLogBufferReInit(SSyncLogBuffer* pBuf, SSyncNode* pNode);
 
 // access
 int64_t syncLogBufferGetEndIndex(SSyncLogBuffer* pBuf);
+int64_t syncLogBufferGetCommitIndex(SSyncLogBuffer* pBuf);
+int64_t syncLogBufferGetMatchIndex(SSyncLogBuffer* pBuf);
 SyncTerm syncLogBufferGetLastMatchTerm(SSyncLogBuffer* pBuf);
 bool     syncLogBufferIsEmpty(SSyncLogBuffer* pBuf);
 
 int32_t syncLogBufferAppend(SSyncLogBuffer* pBuf, SSyncNode* pNode, SSyncRaftEntry* pEntry);
 int32_t syncLogBufferAccept(SSyncLogBuffer* pBuf, SSyncNode* pNode, SSyncRaftEntry* pEntry, SyncTerm prevTerm);
+int32_t syncLogBufferAcceptBatch(SSyncLogBuffer* pBuf, SSyncNode* pNode, SSyncRaftEntry** ppEntries, int32_t count,
+                                 SyncTerm prevTerm);
 int64_t syncLogBufferProceed(SSyncLogBuffer* pBuf, SSyncNode* pNode, SyncTerm* pMatchTerm, char *str);
 int32_t syncLogBufferCommit(SSyncLogBuffer* pBuf, SSyncNode* pNode, int64_t commitIndex);
 int32_t syncLogBufferReset(SSyncLogBuffer* pBuf, SSyncNode* pNode);
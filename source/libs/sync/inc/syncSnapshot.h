@@ -30,6 +30,10 @@ extern "C" {
 
 #define SYNC_SNAPSHOT_RETRY_MS 5000
 
+// payload type of data blocks. A receiver sets it in its begin rsp to announce that it accepts compressed blocks.
+#define SYNC_SNAP_CODEC_NONE 0
+#define SYNC_SNAP_CODEC_LZ4  1  // [raw length][lz4 output]
+
 typedef struct SSyncSnapBuffer {
   void         *entries[TSDB_SYNC_SNAP_BUFFER_SIZE];
   int64_t       start;
@@ -65,6 +69,7 @@ typedef struct SSyncSnapshotSender {
   int64_t        startTime;
   int64_t        lastSendTime;
   bool           finish;
+  int16_t        codec;  // negotiated with the receiver on begin
 
   // ring buffer for ack
   SSyncSnapBuffer *pSndBuf;
@@ -97,6 +102,14 @@ typedef struct SSyncSnapshotReceiver {
   // buffer
   SSyncSnapBuffer *pRcvBuf;
 
+  // blocks are written by a background thread, so fsm writes overlap with receiving the next blocks
+  TdThread      writeThread;
+  TdThreadMutex writeMutex;
+  TdThreadCond  writeCond;
+  SArray       *pWriteQ;
+  int32_t       writeCode;
+  bool          writeStop;
+
   // init when create
   SSyncNode *pSyncNode;
 } SSyncSnapshotReceiver;
@@ -107,6 +120,11 @@ void                   snapshotReceiverStart(SSyncSnapshotReceiver *pReceiver, S
 void                   snapshotReceiverStop(SSyncSnapshotReceiver *pReceiver);
 bool                   snapshotReceiverIsStart(SSyncSnapshotReceiver *pReceiver);
 
+// write thread of the received blocks
+int32_t snapshotReceiverStartWriteThread(SSyncSnapshotReceiver *pReceiver);
+int32_t snapshotReceiverQueueWrite(SSyncSnapshotReceiver *pReceiver, SyncSnapshotSend *pMsg);
+int32_t snapshotReceiverStopWriteThread(SSyncSnapshotReceiver *pReceiver, bool discard);
+
 // on message
 // int32_t syncNodeOnSnapshot(SSyncNode *ths, const SRpcMsg *pMsg);
 // int32_t syncNodeOnSnapshotRsp(SSyncNode *ths, const SRpcMsg *pMsg);
@@ -94,6 +94,7 @@ int32_t syncNodeOnAppendEntries(SSyncNode* ths, const SRpcMsg* pRpcMsg) {
   SRpcMsg            rpcRsp = {0};
   bool               accepted = false;
   SSyncRaftEntry*    pEntry = NULL;
+  SArray*            pEntries = NULL;
   bool               resetElect = false;
 
   // if already drop replica, do not process
@@ -137,39 +138,60 @@ int32_t syncNodeOnAppendEntries(SSyncNode* ths, const SRpcMsg* pRpcMsg) {
     goto _IGNORE;
   }
 
-  pEntry = syncEntryBuildFromAppendEntries(pMsg);
-  if (pEntry == NULL) {
-    sError("vgId:%d, failed to get raft entry from append entries since %s", ths->vgId, terrstr());
+  // a msg carries one or more consecutive entries packed back to back
+  pEntries = taosArrayInit(4, POINTER_BYTES);
+  if (pEntries == NULL) {
     goto _IGNORE;
   }
 
-  if (pMsg->prevLogIndex + 1 != pEntry->index || pEntry->term < 0) {
-    sError("vgId:%d, invalid previous log index in msg. index:%" PRId64 ",  term:%" PRId64 ", prevLogIndex:%" PRId64
-           ", prevLogTerm:%" PRId64,
-           ths->vgId, pEntry->index, pEntry->term, pMsg->prevLogIndex, pMsg->prevLogTerm);
-    goto _IGNORE;
+  for (uint32_t offset = 0; offset < pMsg->dataLen; offset += pEntry->bytes) {
+    pEntry = syncEntryBuildFromAppendEntriesData(pMsg->data + offset, pMsg->dataLen - offset);
+    if (pEntry == NULL) {
+      sError("vgId:%d, failed to get raft entry from append entries since %s", ths->vgId, terrstr());
+      goto _IGNORE;
+    }
+
+    SyncIndex index = pMsg->prevLogIndex + 1 + taosArrayGetSize(pEntries);
+    if (index != pEntry->index || pEntry->term < 0) {
+      sError("vgId:%d, invalid previous log index in msg. index:%" PRId64 ",  term:%" PRId64 ", prevLogIndex:%" PRId64
+             ", prevLogTerm:%" PRId64,
+             ths->vgId, pEntry->index, pEntry->term, pMsg->prevLogIndex, pMsg->prevLogTerm);
+      goto _IGNORE;
+    }
+
+    if (taosArrayPush(pEntries, &pEntry) == NULL) {
+      goto _IGNORE;
+    }
   }
+  pEntry = NULL;
+
+  int32_t count = taosArrayGetSize(pEntries);
+  pReply->lastSendIndex = pMsg->prevLogIndex + count;
 
-  sTrace("vgId:%d, recv append entries msg. index:%" PRId64 ", term:%" PRId64 ", preLogIndex:%" PRId64
+  sTrace("vgId:%d, recv append entries msg. index:%" PRId64 ", count:%d, term:%" PRId64 ", preLogIndex:%" PRId64
          ", prevLogTerm:%" PRId64 " commitIndex:%" PRId64 " entryterm:%" PRId64,
-         pMsg->vgId, pMsg->prevLogIndex + 1, pMsg->term, pMsg->prevLogIndex, pMsg->prevLogTerm, pMsg->commitIndex,
-         pEntry->term);
+         pMsg->vgId, pMsg->prevLogIndex + 1, count, pMsg->term, pMsg->prevLogIndex, pMsg->prevLogTerm,
+         pMsg->commitIndex, (*(SSyncRaftEntry**)taosArrayGet(pEntries, 0))->term);
 
   if (ths->fsmState == SYNC_FSM_STATE_INCOMPLETE) {
     pReply->fsmState = ths->fsmState;
-    sWarn("vgId:%d, unable to accept, due to incomplete fsm state. index:%" PRId64, ths->vgId, pEntry->index);
-    syncEntryDestroy(pEntry);
+    sWarn("vgId:%d, unable to accept, due to incomplete fsm state. index:%" PRId64, ths->vgId,
+          pMsg->prevLogIndex + 1);
+    taosArrayDestroyP(pEntries, (FDelete)syncEntryDestroy);
+    pEntries = NULL;
     goto _SEND_RESPONSE;
   }
 
   // accept
-  if (syncLogBufferAccept(ths->pLogBuf, ths, pEntry, pMsg->prevLogTerm) < 0) {
+  if (syncLogBufferAcceptBatch(ths->pLogBuf, ths, (SSyncRaftEntry**)TARRAY_DATA(pEntries), count,
+                               pMsg->prevLogTerm) < 0) {
     goto _SEND_RESPONSE;
   }
   accepted = true;
 
 _SEND_RESPONSE:
   pEntry = NULL;
+  taosArrayDestroy(pEntries);
   pReply->matchIndex = syncLogBufferProceed(ths->pLogBuf, ths, &pReply->lastMatchTerm, "OnAppn");
   bool matched = (pReply->matchIndex >= pReply->lastSendIndex);
   if (accepted && matched) {
@@ -192,5 +214,6 @@ _SEND_RESPONSE:
 _IGNORE:
   rpcFreeCont(rpcRsp.pCont);
   syncEntryDestroy(pEntry);
+  taosArrayDestroyP(pEntries, (FDelete)syncEntryDestroy);
   return 0;
 }
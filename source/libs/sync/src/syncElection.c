@@ -76,6 +76,12 @@ int32_t syncNodeElect(SSyncNode* pSyncNode) {
     return -1;
   }
 
+  if (syncNodeVoteBlocked(pSyncNode)) {
+    sNInfo(pSyncNode, "skip leader election, the lease of the last leader may be in use");
+    syncNodeResetElectTimer(pSyncNode);
+    return 0;
+  }
+
   sNInfo(pSyncNode, "begin election");
   pSyncNode->electNum++;
 
@@ -79,6 +79,10 @@ int64_t syncOpen(SSyncInfo* pSyncInfo, int32_t vnodeVersion) {
   pSyncNode->hbBaseLine = pSyncInfo->heartbeatMs;
   pSyncNode->heartbeatTimerMS = pSyncInfo->heartbeatMs;
   pSyncNode->msgcb = pSyncInfo->msgcb;
+  if (tsSyncLeaderLeaseMs > 0 && syncNodeLeaseMs(pSyncNode) <= 0) {
+    sError("vgId:%d, leader lease of %d ms disabled, it must end %d ms before the elect timeout of %d ms",
+           pSyncNode->vgId, tsSyncLeaderLeaseMs, SYNC_LEASE_DRIFT_MS, pSyncNode->electBaseLine);
+  }
   return pSyncNode->rid;
 }
 
@@ -520,9 +524,99 @@ bool syncNodeIsReadyForRead(SSyncNode* pSyncNode) {
     return false;
   }
 
+  if (pSyncNode->state == TAOS_SYNC_STATE_LEADER && !syncNodeLeaseValid(pSyncNode)) {
+    terrno = TSDB_CODE_SYN_NOT_LEADER;
+    return false;
+  }
+
   return true;
 }
 
+// The lease is only used while it runs out a drift margin before the shortest election timeout, longer ones are
+// rejected at open.
+int32_t syncNodeLeaseMs(SSyncNode* pSyncNode) {
+  if (tsSyncLeaderLeaseMs <= 0) return 0;
+  if (tsSyncLeaderLeaseMs + SYNC_LEASE_DRIFT_MS >= pSyncNode->electBaseLine) return 0;
+  return tsSyncLeaderLeaseMs;
+}
+
+// The leader holds a lease while a quorum of voters, itself included, acked heartbeats sent within the last
+// lease ms. Each of those voters neither votes for anyone else nor starts an election for the lease after it
+// received the heartbeat, so no other leader can be elected before the lease runs out.
+bool syncNodeLeaseValid(SSyncNode* pSyncNode) {
+  int32_t leaseMs = syncNodeLeaseMs(pSyncNode);
+  if (leaseMs <= 0) return true;
+  if (pSyncNode->state != TAOS_SYNC_STATE_LEADER) return false;
+
+  int64_t acks[TSDB_MAX_REPLICA + TSDB_MAX_LEARNER_REPLICA] = {0};
+  int32_t num = 0;
+  for (int32_t i = 0; i < pSyncNode->peersNum; ++i) {
+    if (pSyncNode->peersNodeInfo[i].nodeRole == TAOS_SYNC_ROLE_LEARNER) continue;
+    SPeerState* pState = syncNodeGetPeerState(pSyncNode, &pSyncNode->peersId[i]);
+    if (pState != NULL) acks[num++] = atomic_load_64(&pState->hbAckTime);
+  }
+
+  // the (quorum - 1)-th most recent peer ack, together with the leader itself, makes a quorum
+  int32_t need = pSyncNode->quorum - 1;
+  if (need <= 0) return true;
+  if (need > num) return false;
+
+  for (int32_t i = 0; i < need; ++i) {
+    for (int32_t j = i + 1; j < num; ++j) {
+      if (acks[j] > acks[i]) TSWAP(acks[i], acks[j]);
+    }
+  }
+
+  return acks[need - 1] > 0 && taosGetTimestampMs() < acks[need - 1] + leaseMs;
+}
+
+// the follower side of the lease: a leader of the current term was heard from recently
+bool syncNodeLeaderLeaseHeld(SSyncNode* pSyncNode) {
+  int32_t leaseMs = syncNodeLeaseMs(pSyncNode);
+  if (leaseMs <= 0) return false;
+  if (pSyncNode->state != TAOS_SYNC_STATE_FOLLOWER && pSyncNode->state != TAOS_SYNC_STATE_LEARNER) return false;
+
+  int64_t hbTimeMs = atomic_load_64(&pSyncNode->leaderHbTimeMs);
+  return hbTimeMs > 0 && taosGetTimestampMs() < hbTimeMs + leaseMs;
+}
+
+// the voter side of the lease, in any state but leader: no vote for another candidate and no election of its own
+// while a lease it acked may still be in use, nor within a lease after start
+bool syncNodeVoteBlocked(SSyncNode* pSyncNode) {
+  int32_t leaseMs = syncNodeLeaseMs(pSyncNode);
+  if (leaseMs <= 0) return false;
+  if (pSyncNode->state == TAOS_SYNC_STATE_LEADER || pSyncNode->state == TAOS_SYNC_STATE_ASSIGNED_LEADER) return false;
+
+  int64_t now = taosGetTimestampMs();
+  int64_t hbTimeMs = atomic_load_64(&pSyncNode->leaderHbTimeMs);
+  return (hbTimeMs > 0 && now < hbTimeMs + leaseMs) || now < atomic_load_64(&pSyncNode->noVoteUntilMs);
+}
+
+bool syncIsReadyForStaleRead(int64_t rid, SyncIndex commitIndex) {
+  SSyncNode* pSyncNode = syncNodeAcquire(rid);
+  if (pSyncNode == NULL) {
+    sError("sync ready for stale read error");
+    return false;
+  }
+
+  bool ready = false;
+  if (pSyncNode->state == TAOS_SYNC_STATE_LEADER || pSyncNode->state == TAOS_SYNC_STATE_ASSIGNED_LEADER) {
+    ready = syncNodeIsReadyForRead(pSyncNode);
+  } else if (!syncNodeLeaderLeaseHeld(pSyncNode)) {
+    // without a recent heartbeat the staleness of this replica is not bounded
+    terrno = TSDB_CODE_SYN_NOT_LEADER;
+  } else {
+    SyncIndex appliedIndex = pSyncNode->pFsm->FpAppliedIndexCb != NULL
+                                 ? pSyncNode->pFsm->FpAppliedIndexCb(pSyncNode->pFsm)
+                                 : SYNC_INDEX_INVALID;
+    ready = appliedIndex >= commitIndex;
+    if (!ready) terrno = TSDB_CODE_SYN_RESTORING;
+  }
+
+  syncNodeRelease(pSyncNode);
+  return ready;
+}
+
 bool syncIsReadyForRead(int64_t rid) {
   SSyncNode* pSyncNode = syncNodeAcquire(rid);
   if (pSyncNode == NULL) {
@@ -763,16 +857,16 @@ int32_t syncIsCatchUp(int64_t rid) {
   }
 
   int32_t isCatchUp = 0;
-  if (pSyncNode->pLogBuf->totalIndex < 0 || pSyncNode->pLogBuf->commitIndex < 0 ||
-      pSyncNode->pLogBuf->totalIndex < pSyncNode->pLogBuf->commitIndex ||
-      pSyncNode->pLogBuf->totalIndex - pSyncNode->pLogBuf->commitIndex > SYNC_LEARNER_CATCHUP) {
+  int64_t totalIndex = atomic_load_64(&pSyncNode->pLogBuf->totalIndex);
+  int64_t commitIndex = syncLogBufferGetCommitIndex(pSyncNode->pLogBuf);
+  int64_t matchIndex = syncLogBufferGetMatchIndex(pSyncNode->pLogBuf);
+  if (totalIndex < 0 || commitIndex < 0 || totalIndex < commitIndex || totalIndex - commitIndex > SYNC_LEARNER_CATCHUP) {
     sInfo("vgId:%d, Not catch up, wait one second, totalIndex:%" PRId64 " commitIndex:%" PRId64 " matchIndex:%" PRId64,
-          pSyncNode->vgId, pSyncNode->pLogBuf->totalIndex, pSyncNode->pLogBuf->commitIndex,
-          pSyncNode->pLogBuf->matchIndex);
+          pSyncNode->vgId, totalIndex, commitIndex, matchIndex);
     isCatchUp = 0;
   } else {
     sInfo("vgId:%d, Catch up, totalIndex:%" PRId64 " commitIndex:%" PRId64 " matchIndex:%" PRId64, pSyncNode->vgId,
-          pSyncNode->pLogBuf->totalIndex, pSyncNode->pLogBuf->commitIndex, pSyncNode->pLogBuf->matchIndex);
+          totalIndex, commitIndex, matchIndex);
     isCatchUp = 1;
   }
 
@@ -1342,6 +1436,9 @@ int32_t syncNodeRestore(SSyncNode* pSyncNode) {
 }
 
 int32_t syncNodeStart(SSyncNode* pSyncNode) {
+  // a lease acked before a restart may still be in use
+  atomic_store_64(&pSyncNode->noVoteUntilMs, taosGetTimestampMs() + syncNodeLeaseMs(pSyncNode));
+
   // start raft
   if (pSyncNode->raftCfg.cfg.nodeInfo[pSyncNode->raftCfg.cfg.myIndex].nodeRole == TAOS_SYNC_ROLE_LEARNER) {
     syncNodeBecomeLearner(pSyncNode, "first start");
@@ -2119,6 +2216,7 @@ int32_t syncNodePeerStateInit(SSyncNode* pSyncNode) {
   for (int32_t i = 0; i < TSDB_MAX_REPLICA + TSDB_MAX_LEARNER_REPLICA; ++i) {
     pSyncNode->peerStates[i].lastSendIndex = SYNC_INDEX_INVALID;
     pSyncNode->peerStates[i].lastSendTime = 0;
+    atomic_store_64(&pSyncNode->peerStates[i].hbAckTime, 0);
   }
 
   return 0;
@@ -3213,7 +3311,7 @@ static int32_t syncNodeAppendNoopOld(SSyncNode* ths) {
   LRUHandle* h = NULL;
 
   if (ths->state == TAOS_SYNC_STATE_LEADER) {
-    int32_t code = ths->pLogStore->syncLogAppendEntry(ths->pLogStore, pEntry, false);
+    int32_t code = ths->pLogStore->syncLogAppendEntry(ths->pLogStore, pEntry);
     if (code != 0) {
       sError("append noop error");
       return -1;
@@ -3272,9 +3370,12 @@ int32_t syncNodeOnHeartbeat(SSyncNode* ths, const SRpcMsg* pRpcMsg) {
     currentTerm = pMsg->term;
   }
 
+  pMsgReply->hbTimeStamp = pMsg->timeStamp;
+
   if (pMsg->term == currentTerm &&
       (ths->state != TAOS_SYNC_STATE_LEADER && ths->state != TAOS_SYNC_STATE_ASSIGNED_LEADER)) {
     syncIndexMgrSetRecvTime(ths->pNextIndex, &(pMsg->srcId), tsMs);
+    atomic_store_64(&ths->leaderHbTimeMs, tsMs);
     resetElect = true;
 
     ths->minMatchIndex = pMsg->minMatchIndex;
@@ -3347,6 +3448,15 @@ int32_t syncNodeOnHeartbeatReply(SSyncNode* ths, const SRpcMsg* pRpcMsg) {
 
   syncIndexMgrSetRecvTime(ths->pMatchIndex, &pMsg->srcId, tsMs);
 
+  // replies of older versions carry no heartbeat time and do not renew the lease
+  if (pRpcMsg->contLen >= sizeof(SyncHeartbeatReply) && pMsg->term == raftStoreGetTerm(ths) &&
+      ths->state == TAOS_SYNC_STATE_LEADER) {
+    SPeerState* pState = syncNodeGetPeerState(ths, &pMsg->srcId);
+    if (pState != NULL && pMsg->hbTimeStamp > atomic_load_64(&pState->hbAckTime)) {
+      atomic_store_64(&pState->hbAckTime, pMsg->hbTimeStamp);
+    }
+  }
+
   return syncLogReplProcessHeartbeatReply(pMgr, ths, pMsg);
 }
 
@@ -182,6 +182,43 @@ int32_t syncBuildAppendEntriesFromRaftEntry(SSyncNode* pNode, SSyncRaftEntry* pE
   return 0;
 }
 
+// consecutive entries are packed back to back in data, each one is delimited by its own bytes field
+int32_t syncBuildAppendEntriesFromRaftEntries(SSyncNode* pNode, SSyncRaftEntry** ppEntries, int32_t count,
+                                              SyncTerm prevLogTerm, SRpcMsg* pRpcMsg) {
+  uint32_t dataLen = 0;
+  for (int32_t i = 0; i < count; i++) {
+    dataLen += ppEntries[i]->bytes;
+  }
+
+  uint32_t bytes = sizeof(SyncAppendEntries) + dataLen;
+  pRpcMsg->contLen = bytes;
+  pRpcMsg->pCont = rpcMallocCont(pRpcMsg->contLen);
+  if (pRpcMsg->pCont == NULL) {
+    terrno = TSDB_CODE_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  SyncAppendEntries* pMsg = pRpcMsg->pCont;
+  pMsg->bytes = pRpcMsg->contLen;
+  pMsg->msgType = pRpcMsg->msgType = TDMT_SYNC_APPEND_ENTRIES;
+  pMsg->dataLen = dataLen;
+
+  char* pData = pMsg->data;
+  for (int32_t i = 0; i < count; i++) {
+    (void)memcpy(pData, ppEntries[i], ppEntries[i]->bytes);
+    pData += ppEntries[i]->bytes;
+  }
+
+  pMsg->prevLogIndex = ppEntries[0]->index - 1;
+  pMsg->prevLogTerm = prevLogTerm;
+  pMsg->vgId = pNode->vgId;
+  pMsg->srcId = pNode->myRaftId;
+  pMsg->term = raftStoreGetTerm(pNode);
+  pMsg->commitIndex = pNode->commitIndex;
+  pMsg->privateTerm = 0;
+  return 0;
+}
+
 int32_t syncBuildHeartbeat(SRpcMsg* pMsg, int32_t vgId) {
   int32_t bytes = sizeof(SyncHeartbeat);
   pMsg->pCont = rpcMallocCont(bytes);
@@ -27,6 +27,7 @@
 #include "syncUtil.h"
 #include "syncRaftCfg.h"
 #include "syncVoteMgr.h"
+#include "tglobal.h"
 
 static bool syncIsMsgBlock(tmsg_t type) {
   return (type == TDMT_VND_CREATE_TABLE) || (type == TDMT_VND_ALTER_TABLE) || (type == TDMT_VND_DROP_TABLE) ||
@@ -37,13 +38,19 @@ FORCE_INLINE static int64_t syncGetRetryMaxWaitMs() {
   return SYNC_LOG_REPL_RETRY_WAIT_MS * (1 << SYNC_MAX_RETRY_BACKOFF);
 }
 
-int64_t syncLogBufferGetEndIndex(SSyncLogBuffer* pBuf) {
-  taosThreadMutexLock(&pBuf->mutex);
-  int64_t index = pBuf->endIndex;
-  taosThreadMutexUnlock(&pBuf->mutex);
-  return index;
+static void syncLogBufferResetIndexes(SSyncLogBuffer* pBuf) {
+  atomic_store_64(&pBuf->startIndex, 0);
+  atomic_store_64(&pBuf->commitIndex, 0);
+  atomic_store_64(&pBuf->matchIndex, 0);
+  atomic_store_64(&pBuf->endIndex, 0);
 }
 
+int64_t syncLogBufferGetEndIndex(SSyncLogBuffer* pBuf) { return atomic_load_64(&pBuf->endIndex); }
+
+int64_t syncLogBufferGetCommitIndex(SSyncLogBuffer* pBuf) { return atomic_load_64(&pBuf->commitIndex); }
+
+int64_t syncLogBufferGetMatchIndex(SSyncLogBuffer* pBuf) { return atomic_load_64(&pBuf->matchIndex); }
+
 int32_t syncLogBufferAppend(SSyncLogBuffer* pBuf, SSyncNode* pNode, SSyncRaftEntry* pEntry) {
   taosThreadMutexLock(&pBuf->mutex);
   syncLogBufferValidate(pBuf);
@@ -83,7 +90,7 @@ int32_t syncLogBufferAppend(SSyncLogBuffer* pBuf, SSyncNode* pNode, SSyncRaftEnt
 
   SSyncLogBufEntry tmp = {.pItem = pEntry, .prevLogIndex = pMatch->index, .prevLogTerm = pMatch->term};
   pBuf->entries[index % pBuf->size] = tmp;
-  pBuf->endIndex = index + 1;
+  atomic_store_64(&pBuf->endIndex, index + 1);
 
   syncLogBufferValidate(pBuf);
   taosThreadMutexUnlock(&pBuf->mutex);
@@ -188,9 +195,9 @@ int32_t syncLogBufferInitWithoutLock(SSyncLogBuffer* pBuf, SSyncNode* pNode) {
   ASSERT(lastVer >= commitIndex);
   SyncIndex toIndex = lastVer;
   // update match index
-  pBuf->commitIndex = commitIndex;
-  pBuf->matchIndex = toIndex;
-  pBuf->endIndex = toIndex + 1;
+  atomic_store_64(&pBuf->commitIndex, commitIndex);
+  atomic_store_64(&pBuf->matchIndex, toIndex);
+  atomic_store_64(&pBuf->endIndex, toIndex + 1);
 
   // load log entries in reverse order
   SSyncLogStore*  pLogStore = pNode->pLogStore;
@@ -250,7 +257,7 @@ int32_t syncLogBufferInitWithoutLock(SSyncLogBuffer* pBuf, SSyncNode* pNode) {
   }
 
   // update startIndex
-  pBuf->startIndex = takeDummy ? index : index + 1;
+  atomic_store_64(&pBuf->startIndex, takeDummy ? index : index + 1);
 
   pBuf->isCatchup = false;
 
@@ -282,7 +289,7 @@ int32_t syncLogBufferReInit(SSyncLogBuffer* pBuf, SSyncNode* pNode) {
     pEntry = NULL;
     memset(&pBuf->entries[(index + pBuf->size) % pBuf->size], 0, sizeof(pBuf->entries[0]));
   }
-  pBuf->startIndex = pBuf->commitIndex = pBuf->matchIndex = pBuf->endIndex = 0;
+  syncLogBufferResetIndexes(pBuf);
   int32_t ret = syncLogBufferInitWithoutLock(pBuf, pNode);
   if (ret < 0) {
     sError("vgId:%d, failed to re-initialize sync log buffer since %s.", pNode->vgId, terrstr());
@@ -307,15 +314,13 @@ SyncTerm syncLogBufferGetLastMatchTerm(SSyncLogBuffer* pBuf) {
 }
 
 bool syncLogBufferIsEmpty(SSyncLogBuffer* pBuf) {
-  taosThreadMutexLock(&pBuf->mutex);
-  bool empty = (pBuf->endIndex <= pBuf->startIndex);
-  taosThreadMutexUnlock(&pBuf->mutex);
-  return empty;
+  int64_t startIndex = atomic_load_64(&pBuf->startIndex);
+  int64_t endIndex = atomic_load_64(&pBuf->endIndex);
+  return endIndex <= startIndex;
 }
 
-int32_t syncLogBufferAccept(SSyncLogBuffer* pBuf, SSyncNode* pNode, SSyncRaftEntry* pEntry, SyncTerm prevTerm) {
-  taosThreadMutexLock(&pBuf->mutex);
-  syncLogBufferValidate(pBuf);
+static int32_t syncLogBufferAcceptWithoutLock(SSyncLogBuffer* pBuf, SSyncNode* pNode, SSyncRaftEntry* pEntry,
+                                              SyncTerm prevTerm) {
   int32_t         ret = -1;
   SyncIndex       index = pEntry->index;
   SyncIndex       prevIndex = pEntry->index - 1;
@@ -338,7 +343,7 @@ int32_t syncLogBufferAccept(SSyncLogBuffer* pBuf, SSyncNode* pNode, SSyncRaftEnt
 
   if(pNode->raftCfg.cfg.nodeInfo[pNode->raftCfg.cfg.myIndex].nodeRole == TAOS_SYNC_ROLE_LEARNER &&
       index > 0 && index > pBuf->totalIndex){
-    pBuf->totalIndex = index;
+    atomic_store_64(&pBuf->totalIndex, index);
     sTrace("vgId:%d, update learner progress. index:%" PRId64 ", term:%" PRId64 ": prevterm:%" PRId64
           " != lastmatch:%" PRId64 ". log buffer: [%" PRId64 " %" PRId64 " %" PRId64 ", %" PRId64 ")",
           pNode->vgId, pEntry->index, pEntry->term, prevTerm, lastMatchTerm, pBuf->startIndex, pBuf->commitIndex,
@@ -388,7 +393,7 @@ int32_t syncLogBufferAccept(SSyncLogBuffer* pBuf, SSyncNode* pNode, SSyncRaftEnt
   pBuf->entries[index % pBuf->size] = tmp;
 
   // update end index
-  pBuf->endIndex = TMAX(index + 1, pBuf->endIndex);
+  atomic_store_64(&pBuf->endIndex, TMAX(index + 1, pBuf->endIndex));
 
   // success
   ret = 0;
@@ -399,8 +404,44 @@ _out:
     syncEntryDestroy(pExist);
     pExist = NULL;
   }
+  return ret;
+}
+
+int32_t syncLogBufferAccept(SSyncLogBuffer* pBuf, SSyncNode* pNode, SSyncRaftEntry* pEntry, SyncTerm prevTerm) {
+  taosThreadMutexLock(&pBuf->mutex);
+  syncLogBufferValidate(pBuf);
+  int32_t ret = syncLogBufferAcceptWithoutLock(pBuf, pNode, pEntry, prevTerm);
+  syncLogBufferValidate(pBuf);
+  taosThreadMutexUnlock(&pBuf->mutex);
+  return ret;
+}
+
+// accept consecutive entries under one lock, the prev term of each entry is the term of the one before it.
+// entries are owned by the buffer afterwards, the ones behind a rejected entry are dropped.
+int32_t syncLogBufferAcceptBatch(SSyncLogBuffer* pBuf, SSyncNode* pNode, SSyncRaftEntry** ppEntries, int32_t count,
+                                 SyncTerm prevTerm) {
+  int32_t ret = 0;
+  int32_t i = 0;
+
+  taosThreadMutexLock(&pBuf->mutex);
+  syncLogBufferValidate(pBuf);
+  for (; i < count; i++) {
+    SyncTerm term = ppEntries[i]->term;
+    ret = syncLogBufferAcceptWithoutLock(pBuf, pNode, ppEntries[i], prevTerm);
+    ppEntries[i] = NULL;
+    if (ret < 0) {
+      i++;
+      break;
+    }
+    prevTerm = term;
+  }
   syncLogBufferValidate(pBuf);
   taosThreadMutexUnlock(&pBuf->mutex);
+
+  for (; i < count; i++) {
+    syncEntryDestroy(ppEntries[i]);
+    ppEntries[i] = NULL;
+  }
   return ret;
 }
 
@@ -418,8 +459,7 @@ int32_t syncLogStorePersist(SSyncLogStore* pLogStore, SSyncNode* pNode, SSyncRaf
   lastVer = pLogStore->syncLogLastIndex(pLogStore);
   ASSERT(pEntry->index == lastVer + 1);
 
-  bool doFsync = syncLogStoreNeedFlush(pEntry, pNode->replicaNum);
-  if (pLogStore->syncLogAppendEntry(pLogStore, pEntry, doFsync) < 0) {
+  if (pLogStore->syncLogAppendEntry(pLogStore, pEntry) < 0) {
     sError("failed to append sync log entry since %s. index:%" PRId64 ", term:%" PRId64 "", terrstr(), pEntry->index,
            pEntry->term);
     return -1;
@@ -435,7 +475,9 @@ int64_t syncLogBufferProceed(SSyncLogBuffer* pBuf, SSyncNode* pNode, SyncTerm* p
   syncLogBufferValidate(pBuf);
 
   SSyncLogStore* pLogStore = pNode->pLogStore;
+  int64_t        syncedIndex = pBuf->matchIndex;
   int64_t        matchIndex = pBuf->matchIndex;
+  bool           forceFsync = false;
 
   while (pBuf->matchIndex + 1 < pBuf->endIndex) {
     int64_t index = pBuf->matchIndex + 1;
@@ -472,7 +514,7 @@ int64_t syncLogBufferProceed(SSyncLogBuffer* pBuf, SSyncNode* pNode, SyncTerm* p
     }
 
     // increase match index
-    pBuf->matchIndex = index;
+    atomic_store_64(&pBuf->matchIndex, index);
 
     sTrace("vgId:%d, log buffer proceed. start index:%" PRId64 ", match index:%" PRId64 ", end index:%" PRId64,
            pNode->vgId, pBuf->startIndex, pBuf->matchIndex, pBuf->endIndex);
@@ -484,6 +526,7 @@ int64_t syncLogBufferProceed(SSyncLogBuffer* pBuf, SSyncNode* pNode, SyncTerm* p
       taosMsleep(1);
       goto _out;
     }
+    forceFsync = forceFsync || syncLogStoreNeedFlush(pEntry, pNode->replicaNum);
 
     if(pEntry->originalRpcType == TDMT_SYNC_CONFIG_CHANGE){
       if(pNode->pLogBuf->commitIndex == pEntry->index -1){
@@ -519,13 +562,23 @@ int64_t syncLogBufferProceed(SSyncLogBuffer* pBuf, SSyncNode* pNode, SyncTerm* p
 
     ASSERT(pEntry->index == pBuf->matchIndex);
 
-    // update my match index
     matchIndex = pBuf->matchIndex;
-    syncIndexMgrSetIndex(pNode->pMatchIndex, &pNode->myRaftId, pBuf->matchIndex);
   }  // end of while
 
 _out:
-  pBuf->matchIndex = matchIndex;
+  // the entries persisted above are synced at once, before the match index acks them or counts them to commit. If it
+  // fails, they are persisted again by the next proceed.
+  if (matchIndex > syncedIndex) {
+    if (pLogStore->syncLogFsync(pLogStore, forceFsync) < 0) {
+      sError("vgId:%d, failed to sync log entries since %s. index:[%" PRId64 ", %" PRId64 "]", pNode->vgId, terrstr(),
+             syncedIndex + 1, matchIndex);
+      matchIndex = syncedIndex;
+    } else {
+      // update my match index
+      syncIndexMgrSetIndex(pNode->pMatchIndex, &pNode->myRaftId, matchIndex);
+    }
+  }
+  atomic_store_64(&pBuf->matchIndex, matchIndex);
   if (pMatchTerm) {
     *pMatchTerm = pBuf->entries[(matchIndex + pBuf->size) % pBuf->size].pItem->term;
   }
@@ -641,7 +694,7 @@ int32_t syncLogBufferCommit(SSyncLogBuffer* pBuf, SSyncNode* pNode, int64_t comm
              vgId, pEntry->index, pEntry->term, role, currentTerm);
       goto _out;
     }
-    pBuf->commitIndex = index;
+    atomic_store_64(&pBuf->commitIndex, index);
 
     sTrace("vgId:%d, committed index:%" PRId64 ", term:%" PRId64 ", role:%d, current term:%" PRId64 "", pNode->vgId,
            pEntry->index, pEntry->term, role, currentTerm);
@@ -675,7 +728,7 @@ int32_t syncLogBufferCommit(SSyncLogBuffer* pBuf, SSyncNode* pNode, int64_t comm
           }
 
           index++;
-          pBuf->commitIndex = index;
+          atomic_store_64(&pBuf->commitIndex, index);
 
           sTrace("vgId:%d, committed index:%" PRId64 ", term:%" PRId64 ", role:%d, current term:%" PRId64 "", pNode->vgId,
                 pNextEntry->index, pNextEntry->term, role, currentTerm);
@@ -700,7 +753,7 @@ int32_t syncLogBufferCommit(SSyncLogBuffer* pBuf, SSyncNode* pNode, int64_t comm
     ASSERT(pEntry != NULL);
     syncEntryDestroy(pEntry);
     memset(&pBuf->entries[(index + pBuf->size) % pBuf->size], 0, sizeof(pBuf->entries[0]));
-    pBuf->startIndex = index + 1;
+    atomic_store_64(&pBuf->startIndex, index + 1);
   }
 
   ret = 0;
@@ -763,7 +816,7 @@ int32_t syncLogReplRetryOnNeed(SSyncLogReplMgr* pMgr, SSyncNode* pNode) {
   SyncTerm term = -1;
   int64_t  batchSize = TMAX(1, pMgr->size >> (4 + pMgr->retryBackoff));
 
-  for (SyncIndex index = pMgr->startIndex; index < pMgr->endIndex; index++) {
+  for (SyncIndex index = pMgr->startIndex; index < pMgr->endIndex;) {
     int64_t pos = index % pMgr->size;
     ASSERT(!pMgr->states[pos].barrier || (index == pMgr->startIndex || index + 1 == pMgr->endIndex));
 
@@ -778,24 +831,32 @@ int32_t syncLogReplRetryOnNeed(SSyncLogReplMgr* pMgr, SSyncNode* pNode) {
               pDestId->addr);
         goto _out;
       }
+      index++;
       continue;
     }
 
-    bool barrier = false;
-    if (syncLogReplSendTo(pMgr, pNode, index, &term, pDestId, &barrier) < 0) {
+    // resend the run of expired entries that are not acked in one msg
+    SyncIndex lastIndex = index;
+    while (lastIndex + 1 < pMgr->endIndex) {
+      SSyncReplInfo* pState = &pMgr->states[(lastIndex + 1) % pMgr->size];
+      if (pState->acked || nowMs < pState->timeMs + retryWaitMs) break;
+      lastIndex++;
+    }
+
+    int32_t sent = 0;
+    if (syncLogReplSendBatchTo(pMgr, pNode, index, lastIndex, pDestId, nowMs, &sent) < 0) {
       sError("vgId:%d, failed to replicate sync log entry since %s. index:%" PRId64 ", dest:%" PRIx64 "", pNode->vgId,
              terrstr(), index, pDestId->addr);
       goto _out;
     }
-    ASSERT(barrier == pMgr->states[pos].barrier);
-    pMgr->states[pos].timeMs = nowMs;
-    pMgr->states[pos].term = term;
-    pMgr->states[pos].acked = false;
+    term = pMgr->states[(index + sent - 1) % pMgr->size].term;
 
     retried = true;
     if (firstIndex == -1) firstIndex = index;
 
-    if (batchSize <= count++) {
+    index += sent;
+    count += sent;
+    if (batchSize < count) {
       break;
     }
   }
@@ -1001,37 +1062,35 @@ int32_t syncLogReplAttempt(SSyncLogReplMgr* pMgr, SSyncNode* pNode) {
   SyncTerm  term = -1;
   SyncIndex firstIndex = -1;
 
-  for (SyncIndex index = pMgr->endIndex; index <= pNode->pLogBuf->matchIndex; index++) {
+  for (SyncIndex index = pMgr->endIndex; index <= pNode->pLogBuf->matchIndex;) {
     if (batchSize < count || limit <= index - pMgr->startIndex) {
       break;
     }
     if (pMgr->startIndex + 1 < index && pMgr->states[(index - 1) % pMgr->size].barrier) {
       break;
     }
-    int64_t  pos = index % pMgr->size;
-    SRaftId* pDestId = &pNode->replicasId[pMgr->peerId];
-    bool     barrier = false;
-    SyncTerm term = -1;
-    if (syncLogReplSendTo(pMgr, pNode, index, &term, pDestId, &barrier) < 0) {
+
+    SyncIndex lastIndex = TMIN(pNode->pLogBuf->matchIndex, pMgr->startIndex + limit - 1);
+    int32_t   sent = 0;
+    if (syncLogReplSendBatchTo(pMgr, pNode, index, lastIndex, pDestId, nowMs, &sent) < 0) {
       sError("vgId:%d, failed to replicate log entry since %s. index:%" PRId64 ", dest: 0x%016" PRIx64 "", pNode->vgId,
              terrstr(), index, pDestId->addr);
       return -1;
     }
-    pMgr->states[pos].barrier = barrier;
-    pMgr->states[pos].timeMs = nowMs;
-    pMgr->states[pos].term = term;
-    pMgr->states[pos].acked = false;
 
+    SyncIndex sentIndex = index + sent - 1;
+    term = pMgr->states[sentIndex % pMgr->size].term;
     if (firstIndex == -1) firstIndex = index;
-    count++;
+    count += sent;
 
-    pMgr->endIndex = index + 1;
-    if (barrier) {
+    pMgr->endIndex = sentIndex + 1;
+    if (pMgr->states[sentIndex % pMgr->size].barrier) {
       sInfo("vgId:%d, replicated sync barrier to dnode:%d. index:%" PRId64 ", term:%" PRId64 ", repl-mgr:[%" PRId64
             " %" PRId64 ", %" PRId64 ")",
-            pNode->vgId, DID(pDestId), index, term, pMgr->startIndex, pMgr->matchIndex, pMgr->endIndex);
+            pNode->vgId, DID(pDestId), sentIndex, term, pMgr->startIndex, pMgr->matchIndex, pMgr->endIndex);
       break;
     }
+    index = sentIndex + 1;
   }
 
   syncLogReplRetryOnNeed(pMgr, pNode);
@@ -1154,7 +1213,7 @@ void syncLogBufferClear(SSyncLogBuffer* pBuf) {
     pEntry = NULL;
     memset(&pBuf->entries[(index + pBuf->size) % pBuf->size], 0, sizeof(pBuf->entries[0]));
   }
-  pBuf->startIndex = pBuf->commitIndex = pBuf->matchIndex = pBuf->endIndex = 0;
+  syncLogBufferResetIndexes(pBuf);
   taosThreadMutexUnlock(&pBuf->mutex);
 }
 
@@ -1191,8 +1250,8 @@ int32_t syncLogBufferRollback(SSyncLogBuffer* pBuf, SSyncNode* pNode, SyncIndex
     }
     index--;
   }
-  pBuf->endIndex = toIndex;
-  pBuf->matchIndex = TMIN(pBuf->matchIndex, index);
+  atomic_store_64(&pBuf->endIndex, toIndex);
+  atomic_store_64(&pBuf->matchIndex, TMIN(pBuf->matchIndex, index));
   ASSERT(index + 1 == toIndex);
 
   // trunc wal
@@ -1230,7 +1289,7 @@ int32_t syncLogBufferReset(SSyncLogBuffer* pBuf, SSyncNode* pNode) {
   sInfo("vgId:%d, reset sync log buffer. buffer: [%" PRId64 " %" PRId64 " %" PRId64 ", %" PRId64 ")", pNode->vgId,
         pBuf->startIndex, pBuf->commitIndex, pBuf->matchIndex, pBuf->endIndex);
 
-  pBuf->endIndex = pBuf->matchIndex + 1;
+  atomic_store_64(&pBuf->endIndex, pBuf->matchIndex + 1);
 
   // reset repl mgr
   for (int i = 0; i < pNode->totalReplicaNum; i++) {
@@ -1315,3 +1374,83 @@ _err:
   }
   return -1;
 }
+
+// send consecutive entries from index up to lastIndex in one msg, within the count and size limits of a batch.
+// a batch stays within one term and a barrier entry always closes it. replication states of the sent entries are
+// updated.
+int32_t syncLogReplSendBatchTo(SSyncLogReplMgr* pMgr, SSyncNode* pNode, SyncIndex index, SyncIndex lastIndex,
+                               SRaftId* pDestId, int64_t nowMs, int32_t* pCount) {
+  SSyncRaftEntry* entries[TSDB_SYNC_LOG_BUFFER_SIZE >> 4] = {0};
+  bool            inBufs[TSDB_SYNC_LOG_BUFFER_SIZE >> 4] = {0};
+  int32_t         maxCount = TMAX(1, TMIN(tsSyncBatchEntries, (int32_t)(TSDB_SYNC_LOG_BUFFER_SIZE >> 4)));
+  int32_t         count = 0;
+  int64_t         bytes = 0;
+  SRpcMsg         msgOut = {0};
+  SSyncLogBuffer* pBuf = pNode->pLogBuf;
+  int32_t         ret = -1;
+
+  *pCount = 0;
+  for (SyncIndex i = index; i <= lastIndex && count < maxCount; i++) {
+    bool            inBuf = false;
+    SSyncRaftEntry* pEntry = syncLogBufferGetOneEntry(pBuf, pNode, i, &inBuf);
+    if (pEntry == NULL) {
+      break;
+    }
+    if (count > 0 && (pEntry->term != entries[0]->term || bytes + pEntry->bytes > tsSyncBatchBytes)) {
+      if (!inBuf) syncEntryDestroy(pEntry);
+      break;
+    }
+
+    entries[count] = pEntry;
+    inBufs[count] = inBuf;
+    count++;
+    bytes += pEntry->bytes;
+    if (syncLogReplBarrier(pEntry)) {
+      break;
+    }
+  }
+
+  if (count == 0) {
+    sWarn("vgId:%d, failed to get raft entry for index:%" PRId64 "", pNode->vgId, index);
+    if (terrno == TSDB_CODE_WAL_LOG_NOT_EXIST) {
+      sInfo("vgId:%d, reset sync log repl of peer:%" PRIx64 " since %s. index:%" PRId64, pNode->vgId, pDestId->addr,
+            terrstr(), index);
+      (void)syncLogReplReset(pMgr);
+    }
+    return -1;
+  }
+
+  SyncTerm prevLogTerm = syncLogReplGetPrevLogTerm(pMgr, pNode, index);
+  if (prevLogTerm < 0) {
+    sError("vgId:%d, failed to get prev log term since %s. index:%" PRId64 "", pNode->vgId, terrstr(), index);
+    goto _out;
+  }
+
+  if (syncBuildAppendEntriesFromRaftEntries(pNode, entries, count, prevLogTerm, &msgOut) < 0) {
+    sError("vgId:%d, failed to get append entries for index:%" PRId64 "", pNode->vgId, index);
+    goto _out;
+  }
+
+  (void)syncNodeSendAppendEntries(pNode, pDestId, &msgOut);
+
+  for (int32_t i = 0; i < count; i++) {
+    SSyncReplInfo* pState = &pMgr->states[(index + i) % pMgr->size];
+    pState->barrier = syncLogReplBarrier(entries[i]);
+    pState->timeMs = nowMs;
+    pState->term = entries[i]->term;
+    pState->acked = false;
+  }
+
+  sTrace("vgId:%d, replicate %d msgs in one batch, index:%" PRId64 " term:%" PRId64 " prevterm:%" PRId64
+         " to dest: 0x%016" PRIx64,
+         pNode->vgId, count, index, entries[0]->term, prevLogTerm, pDestId->addr);
+
+  *pCount = count;
+  ret = 0;
+
+_out:
+  for (int32_t i = 0; i < count; i++) {
+    if (!inBufs[i]) syncEntryDestroy(entries[i]);
+  }
+  return ret;
+}
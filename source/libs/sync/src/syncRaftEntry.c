@@ -74,6 +74,23 @@ SSyncRaftEntry* syncEntryBuildFromAppendEntries(const SyncAppendEntries* pMsg) {
   return pEntry;
 }
 
+// build the entry packed at the front of data, used for append entries msgs carrying several entries
+SSyncRaftEntry* syncEntryBuildFromAppendEntriesData(const char* pData, uint32_t dataLen) {
+  const SSyncRaftEntry* pHead = (const SSyncRaftEntry*)pData;
+  if (dataLen < sizeof(SSyncRaftEntry) || pHead->bytes < sizeof(SSyncRaftEntry) || pHead->bytes > dataLen) {
+    terrno = TSDB_CODE_SYN_INTERNAL_ERROR;
+    return NULL;
+  }
+
+  SSyncRaftEntry* pEntry = taosMemoryMalloc(pHead->bytes);
+  if (pEntry == NULL) {
+    terrno = TSDB_CODE_OUT_OF_MEMORY;
+    return NULL;
+  }
+  memcpy(pEntry, pData, pHead->bytes);
+  return pEntry;
+}
+
 SSyncRaftEntry* syncEntryBuildNoop(SyncTerm term, SyncIndex index, int32_t vgId) {
   SSyncRaftEntry* pEntry = syncEntryBuild(sizeof(SMsgHead));
   if (pEntry == NULL) return NULL;
@@ -99,12 +99,16 @@ int32_t syncNodeOnRequestVote(SSyncNode* ths, const SRpcMsg* pRpcMsg) {
   }
 
   bool logOK = syncNodeOnRequestVoteLogOK(ths, pMsg);
+
+  // the current leader may still serve reads under its lease, neither adopt the new term nor vote
+  bool leaseHeld = pMsg->term > raftStoreGetTerm(ths) && syncNodeVoteBlocked(ths);
+
   // maybe update term
-  if (pMsg->term > raftStoreGetTerm(ths)) {
+  if (!leaseHeld && pMsg->term > raftStoreGetTerm(ths)) {
     syncNodeStepDown(ths, pMsg->term);
   }
   SyncTerm currentTerm = raftStoreGetTerm(ths);
-  ASSERT(pMsg->term <= currentTerm);
+  ASSERT(leaseHeld || pMsg->term <= currentTerm);
 
   bool grant = (pMsg->term == currentTerm) && logOK &&
                ((!raftStoreHasVoted(ths)) || (syncUtilSameId(&ths->raftStore.voteFor, &pMsg->srcId)));
@@ -133,7 +137,7 @@ int32_t syncNodeOnRequestVote(SSyncNode* ths, const SRpcMsg* pRpcMsg) {
   ASSERT(!grant || pMsg->term == pReply->term);
 
   // trace log
-  syncLogRecvRequestVote(ths, pMsg, pReply->voteGranted, "");
+  syncLogRecvRequestVote(ths, pMsg, pReply->voteGranted, leaseHeld ? "leader lease held" : "");
   syncLogSendRequestVoteReply(ths, pReply, "");
   syncNodeSendMsgById(&pReply->destId, ths, &rpcMsg);
 
@@ -22,6 +22,7 @@
 #include "syncRaftStore.h"
 #include "syncReplication.h"
 #include "syncUtil.h"
+#include "tcompression.h"
 #include "tglobal.h"
 
 static SyncIndex syncNodeGetSnapBeginIndex(SSyncNode *ths);
@@ -166,6 +167,7 @@ int32_t snapshotSenderStart(SSyncSnapshotSender *pSender) {
   pSender->startTime = taosGetMonoTimestampMs();
   pSender->lastSendTime = taosGetTimestampMs();
   pSender->finish = false;
+  pSender->codec = SYNC_SNAP_CODEC_NONE;
 
   // Get snapshot info
   SSyncNode *pSyncNode = pSender->pSyncNode;
@@ -266,6 +268,30 @@ _OUT:
   return code;
 }
 
+// replace the block by [raw length][lz4 output] if the receiver accepts it and the block shrinks, it is kept raw
+// otherwise
+static void snapshotSenderCompressBlock(SSyncSnapshotSender *pSender, SyncSnapBlock *pBlk) {
+  if (pSender->codec != SYNC_SNAP_CODEC_LZ4) return;
+
+  // the codec falls back to a raw copy of at most blockLen + 1 bytes when it cannot shrink the data
+  char *pCmpr = taosMemoryMalloc(sizeof(int32_t) + pBlk->blockLen + 1);
+  if (pCmpr == NULL) return;
+
+  *(int32_t *)pCmpr = pBlk->blockLen;
+  int8_t  lvl = tsGetCompressL2Level(L2_LZ4, L2_LVL_LOW);
+  int32_t len = compressL2Dict[L2_LZ4].comprFn(pBlk->pBlock, pBlk->blockLen, pCmpr + sizeof(int32_t),
+                                               pBlk->blockLen + 1, TSDB_DATA_TYPE_BINARY, lvl);
+  if (len <= 0 || pCmpr[sizeof(int32_t)] != 1 || sizeof(int32_t) + len >= pBlk->blockLen) {
+    taosMemoryFree(pCmpr);
+    return;
+  }
+
+  taosMemoryFree(pBlk->pBlock);
+  pBlk->pBlock = pCmpr;
+  pBlk->blockLen = sizeof(int32_t) + len;
+  pBlk->blockType = SYNC_SNAP_CODEC_LZ4;
+}
+
 // when sender receive ack, call this function to send msg from seq
 // seq = ack + 1, already updated
 static int32_t snapshotSend(SSyncSnapshotSender *pSender) {
@@ -296,6 +322,7 @@ static int32_t snapshotSend(SSyncSnapshotSender *pSender) {
       if (pBlk->blockLen > 0) {
         // has read data
         sSDebug(pSender, "snapshot sender continue to read, blockLen:%d seq:%d", pBlk->blockLen, pBlk->seq);
+        snapshotSenderCompressBlock(pSender, pBlk);
       } else {
         // read finish, update seq to end
         pSender->seq = SYNC_SNAPSHOT_SEQ_END;
@@ -311,7 +338,8 @@ static int32_t snapshotSend(SSyncSnapshotSender *pSender) {
   // send msg
   int32_t blockLen = (pBlk) ? pBlk->blockLen : 0;
   void   *pBlock = (pBlk) ? pBlk->pBlock : NULL;
-  if (syncSnapSendMsg(pSender, pSender->seq, pBlock, blockLen, 0) != 0) {
+  int16_t blockType = (pBlk) ? pBlk->blockType : SYNC_SNAP_CODEC_NONE;
+  if (syncSnapSendMsg(pSender, pSender->seq, pBlock, blockLen, blockType) != 0) {
     goto _OUT;
   }
 
@@ -351,7 +379,7 @@ int32_t snapshotReSend(SSyncSnapshotSender *pSender) {
     if (pBlk->acked || nowMs < pBlk->sendTimeMs + SYNC_SNAP_RESEND_MS) {
       continue;
     }
-    if (syncSnapSendMsg(pSender, pBlk->seq, pBlk->pBlock, pBlk->blockLen, 0) != 0) {
+    if (syncSnapSendMsg(pSender, pBlk->seq, pBlk->pBlock, pBlk->blockLen, pBlk->blockType) != 0) {
       goto _out;
     }
     pBlk->sendTimeMs = nowMs;
@@ -430,10 +458,151 @@ SSyncSnapshotReceiver *snapshotReceiverCreate(SSyncNode *pSyncNode, SRaftId from
   pRcvBuf->entryDeleteCb = rpcFreeCont;
   pReceiver->pRcvBuf = pRcvBuf;
 
+  pReceiver->pWriteQ = taosArrayInit(tsSnapReplMaxWaitN, POINTER_BYTES);
+  if (pReceiver->pWriteQ == NULL) {
+    terrno = TSDB_CODE_OUT_OF_MEMORY;
+    syncSnapBufferDestroy(&pReceiver->pRcvBuf);
+    taosMemoryFree(pReceiver);
+    return NULL;
+  }
+  taosThreadMutexInit(&pReceiver->writeMutex, NULL);
+  taosThreadCondInit(&pReceiver->writeCond, NULL);
+
   syncSnapBufferReset(pReceiver->pRcvBuf);
   return pReceiver;
 }
 
+// apply a data block, decompress it first if needed
+static int32_t snapshotReceiverDoWrite(SSyncSnapshotReceiver *pReceiver, SyncSnapshotSend *pMsg) {
+  SSyncFSM *pFsm = pReceiver->pSyncNode->pFsm;
+  if (pMsg->dataLen == 0) return 0;
+
+  if (pMsg->payloadType != SYNC_SNAP_CODEC_LZ4) {
+    return pFsm->FpSnapshotDoWrite(pFsm, pReceiver->pWriter, pMsg->data, pMsg->dataLen);
+  }
+
+  int32_t rawLen = (pMsg->dataLen > sizeof(int32_t)) ? *(int32_t *)pMsg->data : -1;
+  if (rawLen <= 0) {
+    terrno = TSDB_CODE_SYN_INVALID_SNAPSHOT_MSG;
+    return -1;
+  }
+
+  char *pRaw = taosMemoryMalloc(rawLen + 1);
+  if (pRaw == NULL) {
+    terrno = TSDB_CODE_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  int32_t code = 0;
+  int32_t len = compressL2Dict[L2_LZ4].decomprFn(pMsg->data + sizeof(int32_t), pMsg->dataLen - sizeof(int32_t), pRaw,
+                                                 rawLen, TSDB_DATA_TYPE_BINARY);
+  if (len != rawLen) {
+    terrno = TSDB_CODE_SYN_INVALID_SNAPSHOT_MSG;
+    code = -1;
+  } else {
+    code = pFsm->FpSnapshotDoWrite(pFsm, pReceiver->pWriter, pRaw, rawLen);
+  }
+
+  taosMemoryFree(pRaw);
+  return code;
+}
+
+static void *snapshotReceiverWriteThread(void *param) {
+  SSyncSnapshotReceiver *pReceiver = param;
+  setThreadName("sync-snap-write");
+
+  taosThreadMutexLock(&pReceiver->writeMutex);
+  while (true) {
+    while (taosArrayGetSize(pReceiver->pWriteQ) == 0 && !pReceiver->writeStop) {
+      taosThreadCondWait(&pReceiver->writeCond, &pReceiver->writeMutex);
+    }
+    if (taosArrayGetSize(pReceiver->pWriteQ) == 0) break;
+
+    SyncSnapshotSend *pMsg = *(SyncSnapshotSend **)taosArrayGet(pReceiver->pWriteQ, 0);
+    bool              skip = (pReceiver->writeCode != 0);
+    taosThreadMutexUnlock(&pReceiver->writeMutex);
+
+    int32_t code = 0;
+    if (!skip && snapshotReceiverDoWrite(pReceiver, pMsg) != 0) {
+      code = (terrno != 0) ? terrno : TSDB_CODE_SYN_INTERNAL_ERROR;
+      sRError(pReceiver, "snapshot receiver write failed since %s, seq:%d", tstrerror(code), pMsg->seq);
+    }
+
+    // dequeue only after the write, so a drained queue means all blocks are applied
+    taosThreadMutexLock(&pReceiver->writeMutex);
+    taosArrayRemove(pReceiver->pWriteQ, 0);
+    rpcFreeCont(pMsg);
+    if (code != 0 && pReceiver->writeCode == 0) {
+      pReceiver->writeCode = code;
+    }
+    taosThreadCondBroadcast(&pReceiver->writeCond);
+  }
+  taosThreadMutexUnlock(&pReceiver->writeMutex);
+
+  return NULL;
+}
+
+int32_t snapshotReceiverStartWriteThread(SSyncSnapshotReceiver *pReceiver) {
+  pReceiver->writeCode = 0;
+  pReceiver->writeStop = false;
+
+  TdThreadAttr thAttr;
+  taosThreadAttrInit(&thAttr);
+  taosThreadAttrSetDetachState(&thAttr, PTHREAD_CREATE_JOINABLE);
+  if (taosThreadCreate(&pReceiver->writeThread, &thAttr, snapshotReceiverWriteThread, pReceiver) != 0) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    taosThreadAttrDestroy(&thAttr);
+    taosThreadClear(&pReceiver->writeThread);
+    return -1;
+  }
+  taosThreadAttrDestroy(&thAttr);
+  return 0;
+}
+
+// wait for the write thread to exit, after writing the queued blocks or dropping them if discard. Return the first
+// write error.
+int32_t snapshotReceiverStopWriteThread(SSyncSnapshotReceiver *pReceiver, bool discard) {
+  if (!taosCheckPthreadValid(pReceiver->writeThread)) return pReceiver->writeCode;
+
+  taosThreadMutexLock(&pReceiver->writeMutex);
+  if (discard && pReceiver->writeCode == 0) {
+    pReceiver->writeCode = TSDB_CODE_SYN_INTERNAL_ERROR;
+  }
+  pReceiver->writeStop = true;
+  taosThreadCondBroadcast(&pReceiver->writeCond);
+  taosThreadMutexUnlock(&pReceiver->writeMutex);
+
+  taosThreadJoin(pReceiver->writeThread, NULL);
+  taosThreadClear(&pReceiver->writeThread);
+  return pReceiver->writeCode;
+}
+
+// hand a block over to the write thread, wait while tsSnapReplMaxWaitN blocks are pending
+int32_t snapshotReceiverQueueWrite(SSyncSnapshotReceiver *pReceiver, SyncSnapshotSend *pMsg) {
+  int32_t code = 0;
+
+  taosThreadMutexLock(&pReceiver->writeMutex);
+  while (taosArrayGetSize(pReceiver->pWriteQ) >= tsSnapReplMaxWaitN && pReceiver->writeCode == 0) {
+    taosThreadCondWait(&pReceiver->writeCond, &pReceiver->writeMutex);
+  }
+
+  if (pReceiver->writeCode != 0) {
+    code = pReceiver->writeCode;
+  } else if (taosArrayPush(pReceiver->pWriteQ, &pMsg) == NULL) {
+    code = TSDB_CODE_OUT_OF_MEMORY;
+  } else {
+    taosThreadCondBroadcast(&pReceiver->writeCond);
+  }
+  taosThreadMutexUnlock(&pReceiver->writeMutex);
+
+  if (code != 0) {
+    rpcFreeCont(pMsg);
+    terrno = code;
+    return -1;
+  }
+  return 0;
+}
+
 static int32_t snapshotReceiverClearInfoData(SSyncSnapshotReceiver *pReceiver) {
   if (pReceiver->snapshotParam.data) {
     taosMemoryFree(pReceiver->snapshotParam.data);
@@ -450,6 +619,8 @@ static int32_t snapshotReceiverClearInfoData(SSyncSnapshotReceiver *pReceiver) {
 void snapshotReceiverDestroy(SSyncSnapshotReceiver *pReceiver) {
   if (pReceiver == NULL) return;
 
+  (void)snapshotReceiverStopWriteThread(pReceiver, true);
+
   // close writer
   if (pReceiver->pWriter != NULL) {
     int32_t ret = pReceiver->pSyncNode->pFsm->FpSnapshotStopWrite(pReceiver->pSyncNode->pFsm, pReceiver->pWriter, false,
@@ -467,6 +638,10 @@ void snapshotReceiverDestroy(SSyncSnapshotReceiver *pReceiver) {
 
   snapshotReceiverClearInfoData(pReceiver);
 
+  taosArrayDestroy(pReceiver->pWriteQ);
+  taosThreadCondDestroy(&pReceiver->writeCond);
+  taosThreadMutexDestroy(&pReceiver->writeMutex);
+
   // free receiver
   taosMemoryFree(pReceiver);
 }
@@ -508,6 +683,14 @@ static int32_t snapshotReceiverStartWriter(SSyncSnapshotReceiver *pReceiver, Syn
     return -1;
   }
 
+  if (snapshotReceiverStartWriteThread(pReceiver) != 0) {
+    sRError(pReceiver, "snapshot receiver start write thread failed since %s", terrstr());
+    (void)pReceiver->pSyncNode->pFsm->FpSnapshotStopWrite(pReceiver->pSyncNode->pFsm, pReceiver->pWriter, false,
+                                                          &pReceiver->snapshot);
+    pReceiver->pWriter = NULL;
+    return -1;
+  }
+
   // event log
   sRInfo(pReceiver, "snapshot receiver start write");
   return 0;
@@ -540,6 +723,8 @@ void snapshotReceiverStop(SSyncSnapshotReceiver *pReceiver) {
   if (stopped) return;
   taosThreadMutexLock(&pReceiver->pRcvBuf->mutex);
   {
+    (void)snapshotReceiverStopWriteThread(pReceiver, true);
+
     if (pReceiver->pWriter != NULL) {
       int32_t ret = pReceiver->pSyncNode->pFsm->FpSnapshotStopWrite(pReceiver->pSyncNode->pFsm, pReceiver->pWriter,
                                                                     false, &pReceiver->snapshot);
@@ -561,11 +746,18 @@ void snapshotReceiverStop(SSyncSnapshotReceiver *pReceiver) {
 static int32_t snapshotReceiverFinish(SSyncSnapshotReceiver *pReceiver, SyncSnapshotSend *pMsg) {
   int32_t code = 0;
   if (pReceiver->pWriter != NULL) {
+    // wait for the queued blocks
+    code = snapshotReceiverStopWriteThread(pReceiver, false);
+    if (code != 0) {
+      terrno = code;
+      sRError(pReceiver, "failed to finish snapshot receiver write since %s", terrstr());
+      return -1;
+    }
+
     // write data
     sRInfo(pReceiver, "snapshot receiver write about to finish, blockLen:%d seq:%d", pMsg->dataLen, pMsg->seq);
     if (pMsg->dataLen > 0) {
-      code = pReceiver->pSyncNode->pFsm->FpSnapshotDoWrite(pReceiver->pSyncNode->pFsm, pReceiver->pWriter, pMsg->data,
-                                                           pMsg->dataLen);
+      code = snapshotReceiverDoWrite(pReceiver, pMsg);
       if (code != 0) {
         sRError(pReceiver, "failed to finish snapshot receiver write since %s", terrstr());
         return -1;
@@ -631,21 +823,18 @@ static int32_t snapshotReceiverGotData(SSyncSnapshotReceiver *pReceiver, SyncSna
 
   sRDebug(pReceiver, "snapshot receiver continue to write, blockLen:%d seq:%d", pMsg->dataLen, pMsg->seq);
 
-  if (pMsg->dataLen > 0) {
-    // apply data block
-    int32_t code = pReceiver->pSyncNode->pFsm->FpSnapshotDoWrite(pReceiver->pSyncNode->pFsm, pReceiver->pWriter,
-                                                                 pMsg->data, pMsg->dataLen);
-    if (code != 0) {
-      sRError(pReceiver, "snapshot receiver continue write failed since %s", terrstr());
-      return -1;
-    }
+  // a failed write of an earlier block aborts the transfer
+  taosThreadMutexLock(&pReceiver->writeMutex);
+  int32_t code = pReceiver->writeCode;
+  taosThreadMutexUnlock(&pReceiver->writeMutex);
+  if (code != 0) {
+    sRError(pReceiver, "snapshot receiver continue write failed since %s", tstrerror(code));
+    terrno = code;
+    return -1;
   }
 
-  // update progress
+  // update progress, the block is applied by the write thread
   pReceiver->ack = pMsg->seq;
-
-  // event log
-  sRDebug(pReceiver, "snapshot receiver continue to write finish");
   return 0;
 }
 
@@ -821,8 +1010,9 @@ _SEND_REPLY:
     code = terrno;
   }
 
-  // send response
-  if (syncSnapSendRsp(pReceiver, pMsg, NULL, 0, 0, code) != 0) {
+  // send response, announce that compressed blocks are accepted
+  int32_t type = (code == 0) ? SYNC_SNAP_CODEC_LZ4 : SYNC_SNAP_CODEC_NONE;
+  if (syncSnapSendRsp(pReceiver, pMsg, NULL, 0, type, code) != 0) {
     return -1;
   }
 
@@ -900,17 +1090,24 @@ static int32_t syncSnapBufferRecv(SSyncSnapshotReceiver *pReceiver, SyncSnapshot
   }
 
   for (int64_t seq = pRcvBuf->start; seq <= pRcvBuf->cursor; ++seq) {
-    if (snapshotReceiverGotData(pReceiver, pRcvBuf->entries[seq % pRcvBuf->size]) != 0) {
+    SyncSnapshotSend *pData = pRcvBuf->entries[seq % pRcvBuf->size];
+    if (snapshotReceiverGotData(pReceiver, pData) != 0) {
       code = terrno;
       if (code >= SYNC_SNAPSHOT_SEQ_INVALID) {
         code = TSDB_CODE_SYN_INTERNAL_ERROR;
       }
     }
     pRcvBuf->start = seq + 1;
-    syncSnapSendRsp(pReceiver, pRcvBuf->entries[seq % pRcvBuf->size], NULL, 0, 0, code);
-    pRcvBuf->entryDeleteCb(pRcvBuf->entries[seq % pRcvBuf->size]);
     pRcvBuf->entries[seq % pRcvBuf->size] = NULL;
-    if (code) goto _out;
+    syncSnapSendRsp(pReceiver, pData, NULL, 0, 0, code);
+    if (code) {
+      pRcvBuf->entryDeleteCb(pData);
+      goto _out;
+    }
+    if (snapshotReceiverQueueWrite(pReceiver, pData) != 0) {
+      code = terrno;
+      goto _out;
+    }
   }
 
 _out:
@@ -1175,6 +1372,11 @@ static int32_t syncSnapBufferSend(SSyncSnapshotSender *pSender, SyncSnapshotRsp
 
   ASSERT(pSndBuf->start <= pSndBuf->cursor + 1 && pSndBuf->cursor < pSndBuf->end);
 
+  if (pMsg->ack == SYNC_SNAPSHOT_SEQ_BEGIN) {
+    pSender->codec = (tsSyncSnapCompress && pMsg->payloadType == SYNC_SNAP_CODEC_LZ4) ? SYNC_SNAP_CODEC_LZ4
+                                                                                       : SYNC_SNAP_CODEC_NONE;
+  }
+
   if (pMsg->ack > pSndBuf->cursor && pMsg->ack < pSndBuf->end) {
     SyncSnapBlock *pBlk = pSndBuf->entries[pMsg->ack % pSndBuf->size];
     ASSERT(pBlk);
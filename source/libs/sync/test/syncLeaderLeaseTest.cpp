@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+
+#include "syncElection.h"
+#include "syncPipeline.h"
+#include "syncRaftStore.h"
+#include "syncRaftEntry.h"
+#include "tglobal.h"
+
+static SyncIndex lastIndex(SSyncLogStore *pLogStore) { return 0; }
+static SyncIndex beginIndex(SSyncLogStore *pLogStore) { return 0; }
+static SyncIndex appliedIndex(const SSyncFSM *pFsm) { return 0; }
+
+// a leader of five voters, peers 0..3 of it ack heartbeats. The lease needs two of them.
+class SyncLeaderLeaseTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    leaseMs = tsSyncLeaderLeaseMs;
+    tsSyncLeaderLeaseMs = 2000;
+
+    pNode = (SSyncNode *)taosMemoryCalloc(1, sizeof(SSyncNode));
+    ASSERT_TRUE(pNode != NULL);
+    pNode->vgId = 2;
+    pNode->state = TAOS_SYNC_STATE_LEADER;
+    pNode->electBaseLine = 4000;
+    pNode->peersNum = 4;
+    pNode->totalReplicaNum = 5;
+    pNode->quorum = 3;
+    pNode->myRaftId.addr = 0x1;
+    pNode->myRaftId.vgId = 2;
+    pNode->replicasId[0] = pNode->myRaftId;
+    for (int32_t i = 0; i < pNode->peersNum; i++) {
+      pNode->peersId[i].addr = 0x2 + i;
+      pNode->peersId[i].vgId = 2;
+      pNode->peersNodeInfo[i].nodeRole = TAOS_SYNC_ROLE_VOTER;
+      pNode->replicasId[i + 1] = pNode->peersId[i];
+    }
+    for (int32_t i = 0; i < pNode->totalReplicaNum; i++) {
+      pNode->peerHeartbeatTimerArr[i].hbDataRid = -1;
+      pNode->logReplMgrs[i] = syncLogReplCreate();
+      ASSERT_TRUE(pNode->logReplMgrs[i] != NULL);
+    }
+    ASSERT_EQ(syncNodePeerStateInit(pNode), 0);
+
+    pNode->pLogBuf = syncLogBufferCreate();
+    ASSERT_TRUE(pNode->pLogBuf != NULL);
+    pNode->pLogBuf->entries[0].pItem = syncEntryBuildNoop(0, 0, pNode->vgId);
+    pNode->pLogBuf->endIndex = 1;
+    logStore.syncLogLastIndex = lastIndex;
+    logStore.syncLogBeginIndex = beginIndex;
+    pNode->pLogStore = &logStore;
+    fsm.FpAppliedIndexCb = appliedIndex;
+    pNode->pFsm = &fsm;
+  }
+
+  void TearDown() override {
+    syncLogBufferDestroy(pNode->pLogBuf);
+    for (int32_t i = 0; i < pNode->totalReplicaNum; i++) {
+      syncLogReplDestroy(pNode->logReplMgrs[i]);
+    }
+    taosMemoryFree(pNode);
+    tsSyncLeaderLeaseMs = leaseMs;
+  }
+
+  void ack(int32_t peer, int64_t timeMs) {
+    SPeerState *pState = syncNodeGetPeerState(pNode, &pNode->peersId[peer]);
+    ASSERT_TRUE(pState != NULL);
+    pState->hbAckTime = timeMs;
+  }
+
+  SSyncNode    *pNode = NULL;
+  SSyncLogStore logStore = {0};
+  SSyncFSM      fsm = {0};
+  int32_t       leaseMs = 0;
+};
+
+TEST_F(SyncLeaderLeaseTest, QuorumOfRecentAcks) {
+  int64_t now = taosGetTimestampMs();
+
+  // no heartbeat acked yet
+  EXPECT_FALSE(syncNodeLeaseValid(pNode));
+
+  ack(0, now - 100);
+  EXPECT_FALSE(syncNodeLeaseValid(pNode));
+
+  ack(1, now - 200);
+  EXPECT_TRUE(syncNodeLeaseValid(pNode));
+
+  // acks of learners do not count towards the quorum
+  pNode->peersNodeInfo[1].nodeRole = TAOS_SYNC_ROLE_LEARNER;
+  EXPECT_FALSE(syncNodeLeaseValid(pNode));
+  pNode->peersNodeInfo[1].nodeRole = TAOS_SYNC_ROLE_VOTER;
+  EXPECT_TRUE(syncNodeLeaseValid(pNode));
+}
+
+TEST_F(SyncLeaderLeaseTest, Expires) {
+  int64_t now = taosGetTimestampMs();
+
+  ack(0, now - 100);
+  ack(1, now - tsSyncLeaderLeaseMs - 1);
+  ack(2, now - tsSyncLeaderLeaseMs - 500);
+  EXPECT_FALSE(syncNodeLeaseValid(pNode));
+
+  // the second most recent ack decides, here it is about to run out
+  ack(3, now - tsSyncLeaderLeaseMs + 300);
+  EXPECT_TRUE(syncNodeLeaseValid(pNode));
+  taosMsleep(400);
+  EXPECT_FALSE(syncNodeLeaseValid(pNode));
+
+  // a new round of heartbeats renews it
+  now = taosGetTimestampMs();
+  ack(2, now);
+  EXPECT_TRUE(syncNodeLeaseValid(pNode));
+}
+
+TEST_F(SyncLeaderLeaseTest, RevokedOnStepDown) {
+  int64_t now = taosGetTimestampMs();
+
+  ack(0, now);
+  ack(1, now);
+  ack(2, now);
+  ASSERT_TRUE(syncNodeLeaseValid(pNode));
+
+  syncNodeBecomeFollower(pNode, "step down");
+  EXPECT_EQ(pNode->state, TAOS_SYNC_STATE_FOLLOWER);
+  EXPECT_FALSE(syncNodeLeaseValid(pNode));
+
+  // the peer states are reset when it becomes leader again, the old acks do not carry over
+  ASSERT_EQ(syncNodePeerStateInit(pNode), 0);
+  pNode->state = TAOS_SYNC_STATE_LEADER;
+  EXPECT_FALSE(syncNodeLeaseValid(pNode));
+}
+
+TEST_F(SyncLeaderLeaseTest, FollowerSide) {
+  syncNodeBecomeFollower(pNode, "step down");
+
+  // a follower that never heard from a leader does not hold its lease
+  EXPECT_FALSE(syncNodeLeaderLeaseHeld(pNode));
+
+  pNode->leaderHbTimeMs = taosGetTimestampMs();
+  EXPECT_TRUE(syncNodeLeaderLeaseHeld(pNode));
+
+  pNode->leaderHbTimeMs = taosGetTimestampMs() - tsSyncLeaderLeaseMs - 1;
+  EXPECT_FALSE(syncNodeLeaderLeaseHeld(pNode));
+
+  // a candidate does not stay with the old leader
+  pNode->leaderHbTimeMs = taosGetTimestampMs();
+  pNode->state = TAOS_SYNC_STATE_CANDIDATE;
+  EXPECT_FALSE(syncNodeLeaderLeaseHeld(pNode));
+}
+
+TEST_F(SyncLeaderLeaseTest, Disabled) {
+  tsSyncLeaderLeaseMs = 0;
+
+  EXPECT_TRUE(syncNodeLeaseValid(pNode));
+  syncNodeBecomeFollower(pNode, "step down");
+  pNode->leaderHbTimeMs = taosGetTimestampMs();
+  EXPECT_FALSE(syncNodeLeaderLeaseHeld(pNode));
+}
+
+TEST_F(SyncLeaderLeaseTest, LongerThanElectTimeout) {
+  // the lease must run out a drift margin before a voter may start an election
+  pNode->electBaseLine = tsSyncLeaderLeaseMs + SYNC_LEASE_DRIFT_MS;
+  EXPECT_EQ(syncNodeLeaseMs(pNode), 0);
+  EXPECT_TRUE(syncNodeLeaseValid(pNode));
+
+  syncNodeBecomeFollower(pNode, "step down");
+  pNode->leaderHbTimeMs = taosGetTimestampMs();
+  EXPECT_FALSE(syncNodeLeaderLeaseHeld(pNode));
+  EXPECT_FALSE(syncNodeVoteBlocked(pNode));
+
+  pNode->electBaseLine++;
+  EXPECT_EQ(syncNodeLeaseMs(pNode), tsSyncLeaderLeaseMs);
+  EXPECT_TRUE(syncNodeVoteBlocked(pNode));
+}
+
+TEST_F(SyncLeaderLeaseTest, VoteBlocked) {
+  EXPECT_FALSE(syncNodeVoteBlocked(pNode));
+
+  syncNodeBecomeFollower(pNode, "step down");
+  EXPECT_FALSE(syncNodeVoteBlocked(pNode));
+
+  pNode->leaderHbTimeMs = taosGetTimestampMs();
+  EXPECT_TRUE(syncNodeVoteBlocked(pNode));
+
+  // unlike stale reads, a candidate still stays with the lease it acked
+  pNode->state = TAOS_SYNC_STATE_CANDIDATE;
+  EXPECT_TRUE(syncNodeVoteBlocked(pNode));
+
+  pNode->leaderHbTimeMs = taosGetTimestampMs() - tsSyncLeaderLeaseMs - 1;
+  EXPECT_FALSE(syncNodeVoteBlocked(pNode));
+
+  // nor does it vote within a lease after start, whatever it acked before a restart
+  pNode->noVoteUntilMs = taosGetTimestampMs() + 300;
+  EXPECT_TRUE(syncNodeVoteBlocked(pNode));
+  taosMsleep(400);
+  EXPECT_FALSE(syncNodeVoteBlocked(pNode));
+}
+
+TEST_F(SyncLeaderLeaseTest, ElectionSkipped) {
+  syncNodeBecomeFollower(pNode, "step down");
+  pNode->raftStore.currentTerm = 3;
+  pNode->leaderHbTimeMs = taosGetTimestampMs();
+
+  // the election timer fired within the lease, the follower neither becomes candidate nor votes for itself
+  EXPECT_EQ(syncNodeElect(pNode), 0);
+  EXPECT_EQ(pNode->state, TAOS_SYNC_STATE_FOLLOWER);
+  EXPECT_EQ(pNode->raftStore.currentTerm, 3);
+  EXPECT_FALSE(raftStoreHasVoted(pNode));
+  EXPECT_EQ(pNode->electNum, 0);
+}
@@ -0,0 +1,85 @@
+#include <atomic>
+#include <cassert>
+#include <thread>
+#include <vector>
+
+#include "syncPipeline.h"
+
+// Readers poll the commit state of the log buffer while one producer appends under the buffer mutex, as the sync
+// thread does. Compares the lock free accessors with reading the same state under the mutex.
+
+static const int32_t kBenchMs = 2000;
+static const int32_t kHoldSpin = 200;
+
+static std::atomic<bool> gStop(false);
+
+static void producer(SSyncLogBuffer *pBuf) {
+  int64_t index = 0;
+  while (!gStop.load()) {
+    taosThreadMutexLock(&pBuf->mutex);
+    index++;
+    atomic_store_64(&pBuf->endIndex, index + 1);
+    atomic_store_64(&pBuf->matchIndex, index);
+    // stand in for the work done while appending and committing an entry
+    for (volatile int32_t i = 0; i < kHoldSpin; i++) {
+    }
+    atomic_store_64(&pBuf->commitIndex, index);
+    taosThreadMutexUnlock(&pBuf->mutex);
+  }
+}
+
+static void lockedReader(SSyncLogBuffer *pBuf, int64_t *pOps) {
+  int64_t ops = 0;
+  int64_t sum = 0;
+  while (!gStop.load()) {
+    taosThreadMutexLock(&pBuf->mutex);
+    sum += pBuf->commitIndex + pBuf->endIndex;
+    taosThreadMutexUnlock(&pBuf->mutex);
+    ops++;
+  }
+  *pOps = ops + (sum < 0 ? 1 : 0);
+}
+
+static void lockFreeReader(SSyncLogBuffer *pBuf, int64_t *pOps) {
+  int64_t ops = 0;
+  int64_t sum = 0;
+  while (!gStop.load()) {
+    sum += syncLogBufferGetCommitIndex(pBuf) + syncLogBufferGetEndIndex(pBuf);
+    ops++;
+  }
+  *pOps = ops + (sum < 0 ? 1 : 0);
+}
+
+static void run(const char *name, void (*reader)(SSyncLogBuffer *, int64_t *), int32_t nReaders) {
+  SSyncLogBuffer *pBuf = syncLogBufferCreate();
+  assert(pBuf != NULL);
+
+  gStop.store(false);
+  std::vector<int64_t>     ops(nReaders, 0);
+  std::vector<std::thread> readers;
+  std::thread              writer(producer, pBuf);
+  for (int32_t i = 0; i < nReaders; i++) {
+    readers.emplace_back(reader, pBuf, &ops[i]);
+  }
+
+  taosMsleep(kBenchMs);
+  gStop.store(true);
+  writer.join();
+  for (auto &t : readers) t.join();
+
+  int64_t total = 0;
+  for (int64_t n : ops) total += n;
+  printf("%-10s readers:%d reads:%" PRId64 " reads/ms:%" PRId64 " appended:%" PRId64 "\n", name, nReaders, total,
+         total / kBenchMs, pBuf->endIndex);
+
+  syncLogBufferDestroy(pBuf);
+}
+
+int main(int argc, char **argv) {
+  int32_t maxReaders = (argc > 1) ? atoi(argv[1]) : 4;
+  for (int32_t n = 1; n <= maxReaders; n *= 2) {
+    run("locked", lockedReader, n);
+    run("lock-free", lockFreeReader, n);
+  }
+  return 0;
+}
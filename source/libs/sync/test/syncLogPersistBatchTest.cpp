@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "syncIndexMgr.h"
+#include "syncPipeline.h"
+#include "syncRaftEntry.h"
+#include "syncRaftLog.h"
+#include "wal.h"
+
+// fsyncs of the log store, each with the force flag it was called with
+static std::vector<bool> gFsyncs;
+static int32_t           gFsyncFail = 0;
+static int32_t (*gRealFsync)(SSyncLogStore *pLogStore, bool forceSync) = NULL;
+
+static int32_t countFsync(SSyncLogStore *pLogStore, bool forceSync) {
+  gFsyncs.push_back(forceSync);
+  if (gFsyncFail > 0) {
+    gFsyncFail--;
+    terrno = TSDB_CODE_FAILED;
+    return -1;
+  }
+  return gRealFsync(pLogStore, forceSync);
+}
+
+// a follower of three replicas on a wal, the entries it accepts are persisted by syncLogBufferProceed
+class SyncLogPersistBatchTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() { ASSERT_EQ(walInit(), 0); }
+  static void TearDownTestCase() { walCleanUp(); }
+
+  void SetUp() override {
+    gFsyncs.clear();
+    gFsyncFail = 0;
+
+    taosRemoveDir(pathName);
+    SWalCfg cfg = {0};
+    cfg.vgId = 2;
+    cfg.rollPeriod = -1;
+    cfg.segSize = -1;
+    cfg.level = TAOS_WAL_FSYNC;
+    pWal = walOpen(pathName, &cfg);
+    ASSERT_TRUE(pWal != NULL);
+
+    pNode = (SSyncNode *)taosMemoryCalloc(1, sizeof(SSyncNode));
+    ASSERT_TRUE(pNode != NULL);
+    pNode->vgId = 2;
+    pNode->state = TAOS_SYNC_STATE_FOLLOWER;
+    pNode->replicaNum = 3;
+    pNode->totalReplicaNum = 3;
+    pNode->myRaftId.addr = 0x1;
+    pNode->myRaftId.vgId = 2;
+    for (int32_t i = 0; i < pNode->totalReplicaNum; i++) {
+      pNode->replicasId[i].addr = 0x1 + i;
+      pNode->replicasId[i].vgId = 2;
+    }
+    pNode->pWal = pWal;
+    pNode->pMatchIndex = syncIndexMgrCreate(pNode);
+    ASSERT_TRUE(pNode->pMatchIndex != NULL);
+    pNode->pLogStore = logStoreCreate(pNode);
+    ASSERT_TRUE(pNode->pLogStore != NULL);
+    gRealFsync = pNode->pLogStore->syncLogFsync;
+    pNode->pLogStore->syncLogFsync = countFsync;
+
+    // index 0 is the dummy entry at startIndex, already in the wal. All entries are of term 1.
+    pNode->pLogBuf = syncLogBufferCreate();
+    ASSERT_TRUE(pNode->pLogBuf != NULL);
+    SSyncRaftEntry *pDummy = syncEntryBuildNoop(1, 0, pNode->vgId);
+    ASSERT_EQ(pNode->pLogStore->syncLogAppendEntry(pNode->pLogStore, pDummy), 0);
+    pNode->pLogBuf->entries[0].pItem = pDummy;
+    pNode->pLogBuf->endIndex = 1;
+  }
+
+  void TearDown() override {
+    syncLogBufferDestroy(pNode->pLogBuf);
+    logStoreDestory(pNode->pLogStore);
+    syncIndexMgrDestroy(pNode->pMatchIndex);
+    taosMemoryFree(pNode);
+    walClose(pWal);
+    taosRemoveDir(pathName);
+  }
+
+  // the entries of one append entries msg
+  void accept(SyncIndex from, SyncIndex to, tmsg_t lastType = TDMT_VND_SUBMIT) {
+    std::vector<SSyncRaftEntry *> entries;
+    for (SyncIndex index = from; index <= to; index++) {
+      SSyncRaftEntry *pEntry = syncEntryBuild(64);
+      ASSERT_TRUE(pEntry != NULL);
+      pEntry->index = index;
+      pEntry->term = 1;
+      pEntry->originalRpcType = index == to ? lastType : TDMT_VND_SUBMIT;
+      memset(pEntry->data, (int)index, pEntry->dataLen);
+      entries.push_back(pEntry);
+    }
+    ASSERT_EQ(syncLogBufferAcceptBatch(pNode->pLogBuf, pNode, entries.data(), entries.size(), 1), 0);
+  }
+
+  SyncIndex proceed() { return syncLogBufferProceed(pNode->pLogBuf, pNode, NULL, "test"); }
+  SyncIndex myMatchIndex() { return syncIndexMgrGetIndex(pNode->pMatchIndex, &pNode->myRaftId); }
+
+  SWal       *pWal = NULL;
+  SSyncNode  *pNode = NULL;
+  const char *pathName = TD_TMP_DIR_PATH "sync_persist_batch";
+};
+
+TEST_F(SyncLogPersistBatchTest, OneFsyncPerBatch) {
+  accept(1, 8);
+  EXPECT_EQ(proceed(), 8);
+  EXPECT_EQ(gFsyncs, std::vector<bool>({false}));
+  EXPECT_EQ(walGetLastVer(pWal), 8);
+  EXPECT_EQ(myMatchIndex(), 8);
+
+  accept(9, 9);
+  EXPECT_EQ(proceed(), 9);
+  EXPECT_EQ(gFsyncs, std::vector<bool>({false, false}));
+
+  // nothing new to persist, nothing to sync
+  EXPECT_EQ(proceed(), 9);
+  EXPECT_EQ(gFsyncs.size(), 2);
+}
+
+TEST_F(SyncLogPersistBatchTest, CommitForcesFsync) {
+  accept(1, 4, TDMT_VND_COMMIT);
+  EXPECT_EQ(proceed(), 4);
+  accept(5, 6);
+  EXPECT_EQ(proceed(), 6);
+  EXPECT_EQ(gFsyncs, std::vector<bool>({true, false}));
+}
+
+TEST_F(SyncLogPersistBatchTest, NotAckedUntilSynced) {
+  accept(1, 8);
+
+  // the batch is written but not synced, it is neither acked nor counted as matched
+  gFsyncFail = 1;
+  EXPECT_EQ(proceed(), 0);
+  EXPECT_EQ(pNode->pLogBuf->matchIndex, 0);
+  EXPECT_EQ(myMatchIndex(), 0);
+
+  // the next proceed persists it again
+  EXPECT_EQ(proceed(), 8);
+  EXPECT_EQ(gFsyncs.size(), 2);
+  EXPECT_EQ(walGetLastVer(pWal), 8);
+  EXPECT_EQ(myMatchIndex(), 8);
+
+  SSyncRaftEntry *pEntry = NULL;
+  ASSERT_EQ(pNode->pLogStore->syncLogGetEntry(pNode->pLogStore, 8, &pEntry), 0);
+  EXPECT_EQ(pEntry->term, 1);
+  EXPECT_EQ(pEntry->data[0], 8);
+  syncEntryDestroy(pEntry);
+}
@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "syncMessage.h"
+#include "syncPipeline.h"
+#include "syncRaftEntry.h"
+#include "tglobal.h"
+
+// entries of each append entries msg the leader sent, decoded the way the follower splits them
+struct SSentBatch {
+  SyncIndex              prevLogIndex;
+  std::vector<SyncIndex> indexes;
+  std::vector<SyncTerm>  terms;
+};
+
+static std::vector<SSentBatch> gSent;
+
+static int32_t captureSend(const SEpSet *pEpSet, SRpcMsg *pMsg) {
+  SyncAppendEntries *pAppend = (SyncAppendEntries *)pMsg->pCont;
+  SSentBatch         batch;
+
+  batch.prevLogIndex = pAppend->prevLogIndex;
+  for (uint32_t offset = 0; offset < pAppend->dataLen;) {
+    SSyncRaftEntry *pEntry = syncEntryBuildFromAppendEntriesData(pAppend->data + offset, pAppend->dataLen - offset);
+    EXPECT_TRUE(pEntry != NULL);
+    if (pEntry == NULL) break;
+    batch.indexes.push_back(pEntry->index);
+    batch.terms.push_back(pEntry->term);
+    offset += pEntry->bytes;
+    syncEntryDestroy(pEntry);
+  }
+
+  gSent.push_back(batch);
+  rpcFreeCont(pMsg->pCont);
+  return 0;
+}
+
+class SyncLogReplBatchTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    batchEntries = tsSyncBatchEntries;
+    batchBytes = tsSyncBatchBytes;
+    gSent.clear();
+
+    pNode = (SSyncNode *)taosMemoryCalloc(1, sizeof(SSyncNode));
+    ASSERT_TRUE(pNode != NULL);
+    pNode->vgId = 2;
+    pNode->peersNum = 1;
+    pNode->peersId[0].addr = 0x2;
+    pNode->peersId[0].vgId = 2;
+    pNode->syncSendMSg = captureSend;
+    pNode->raftStore.currentTerm = 3;
+    taosThreadMutexInit(&pNode->raftStore.mutex, NULL);
+
+    pNode->pLogBuf = syncLogBufferCreate();
+    ASSERT_TRUE(pNode->pLogBuf != NULL);
+    pMgr = syncLogReplCreate();
+    ASSERT_TRUE(pMgr != NULL);
+
+    // index 0 is the dummy entry at startIndex
+    putEntry(0, 0, 0, TDMT_SYNC_NOOP);
+  }
+
+  void TearDown() override {
+    syncLogBufferDestroy(pNode->pLogBuf);
+    syncLogReplDestroy(pMgr);
+    taosThreadMutexDestroy(&pNode->raftStore.mutex);
+    taosMemoryFree(pNode);
+
+    tsSyncBatchEntries = batchEntries;
+    tsSyncBatchBytes = batchBytes;
+  }
+
+  void putEntry(SyncIndex index, SyncTerm term, int32_t dataLen, tmsg_t type = TDMT_VND_SUBMIT) {
+    SSyncLogBuffer *pBuf = pNode->pLogBuf;
+    SSyncRaftEntry *pEntry = syncEntryBuild(dataLen);
+    ASSERT_TRUE(pEntry != NULL);
+    pEntry->index = index;
+    pEntry->term = term;
+    pEntry->originalRpcType = type;
+    memset(pEntry->data, (int)index, dataLen);
+
+    pBuf->entries[index % pBuf->size].pItem = pEntry;
+    pBuf->matchIndex = index;
+    pBuf->endIndex = index + 1;
+  }
+
+  // replicate [index, lastIndex] the way syncLogReplAttempt does, one batch after the other
+  void sendAll(SyncIndex index, SyncIndex lastIndex) {
+    while (index <= lastIndex) {
+      int32_t sent = 0;
+      ASSERT_EQ(syncLogReplSendBatchTo(pMgr, pNode, index, lastIndex, &pNode->peersId[0], 1000, &sent), 0);
+      ASSERT_GT(sent, 0);
+      index += sent;
+    }
+  }
+
+  void checkBatches(const std::vector<std::vector<SyncIndex>> &expected) {
+    ASSERT_EQ(gSent.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+      EXPECT_EQ(gSent[i].indexes, expected[i]);
+      EXPECT_EQ(gSent[i].prevLogIndex, expected[i][0] - 1);
+    }
+  }
+
+  SSyncNode       *pNode = NULL;
+  SSyncLogReplMgr *pMgr = NULL;
+  int32_t          batchEntries = 0;
+  int32_t          batchBytes = 0;
+};
+
+TEST_F(SyncLogReplBatchTest, OffByDefault) {
+  // batchEntries holds the default, older followers take one entry per msg only
+  tsSyncBatchEntries = batchEntries;
+  tsSyncBatchBytes = 1024 * 1024;
+
+  for (int32_t i = 1; i <= 4; i++) {
+    putEntry(i, 2, 16);
+  }
+
+  sendAll(1, 4);
+  checkBatches({{1}, {2}, {3}, {4}});
+}
+
+TEST_F(SyncLogReplBatchTest, SplitOnTerm) {
+  tsSyncBatchEntries = 16;
+  tsSyncBatchBytes = 1024 * 1024;
+
+  SyncTerm terms[] = {1, 1, 1, 2, 2, 3, 3, 3};
+  for (int32_t i = 0; i < 8; i++) {
+    putEntry(i + 1, terms[i], 64);
+  }
+
+  sendAll(1, 8);
+  checkBatches({{1, 2, 3}, {4, 5}, {6, 7, 8}});
+  for (auto &batch : gSent) {
+    for (auto term : batch.terms) EXPECT_EQ(term, batch.terms[0]);
+  }
+  for (int32_t i = 0; i < 8; i++) {
+    EXPECT_EQ(pMgr->states[(i + 1) % pMgr->size].term, terms[i]);
+    EXPECT_FALSE(pMgr->states[(i + 1) % pMgr->size].acked);
+  }
+}
+
+TEST_F(SyncLogReplBatchTest, SplitOnSize) {
+  int32_t entryBytes = sizeof(SSyncRaftEntry) + 100;
+  tsSyncBatchEntries = 16;
+  tsSyncBatchBytes = 3 * entryBytes;
+
+  for (int32_t i = 1; i <= 10; i++) {
+    putEntry(i, 2, 100);
+  }
+
+  sendAll(1, 10);
+  checkBatches({{1, 2, 3}, {4, 5, 6}, {7, 8, 9}, {10}});
+}
+
+TEST_F(SyncLogReplBatchTest, OversizedEntrySentAlone) {
+  tsSyncBatchEntries = 16;
+  tsSyncBatchBytes = 1024;
+
+  putEntry(1, 2, 100);
+  putEntry(2, 2, 4096);
+  putEntry(3, 2, 100);
+  putEntry(4, 2, 100);
+
+  sendAll(1, 4);
+  checkBatches({{1}, {2}, {3, 4}});
+}
+
+TEST_F(SyncLogReplBatchTest, SplitOnCountAndBarrier) {
+  tsSyncBatchEntries = 4;
+  tsSyncBatchBytes = 1024 * 1024;
+
+  for (int32_t i = 1; i <= 10; i++) {
+    putEntry(i, 2, 16, i == 6 ? TDMT_SYNC_CONFIG_CHANGE : TDMT_VND_SUBMIT);
+  }
+
+  sendAll(1, 10);
+  checkBatches({{1, 2, 3, 4}, {5, 6}, {7, 8, 9, 10}});
+  EXPECT_TRUE(pMgr->states[6 % pMgr->size].barrier);
+}
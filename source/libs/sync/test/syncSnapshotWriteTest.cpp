@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "syncMessage.h"
+#include "syncSnapshot.h"
+#include "tglobal.h"
+
+#define TEST_WRITE_ERROR TSDB_CODE_OUT_OF_MEMORY
+
+// fsm writer that records the blocks it applied, waits while the gate is closed and fails at failSeq
+static struct {
+  std::vector<int32_t> seqs;
+  std::atomic<bool>    gateOpen;
+  std::atomic<int32_t> entered;
+  int32_t              failSeq;
+  int32_t              stopWrites;
+} gFsm;
+
+static int32_t testStartWrite(const SSyncFSM *pFsm, void *pParam, void **ppWriter) {
+  *ppWriter = (void *)&gFsm;
+  return 0;
+}
+
+static int32_t testStopWrite(const SSyncFSM *pFsm, void *pWriter, bool isApply, SSnapshot *pSnapshot) {
+  gFsm.stopWrites++;
+  return 0;
+}
+
+static int32_t testDoWrite(const SSyncFSM *pFsm, void *pWriter, void *pBuf, int32_t len) {
+  int32_t seq = *(int32_t *)pBuf;
+  gFsm.entered++;
+  while (!gFsm.gateOpen.load()) {
+    taosMsleep(1);
+  }
+  gFsm.seqs.push_back(seq);
+  if (seq == gFsm.failSeq) {
+    terrno = TEST_WRITE_ERROR;
+    return -1;
+  }
+  return 0;
+}
+
+static SyncSnapshotSend *buildBlock(int32_t seq) {
+  int32_t           dataLen = 64;
+  SyncSnapshotSend *pMsg = (SyncSnapshotSend *)rpcMallocCont(sizeof(SyncSnapshotSend) + dataLen);
+  memset(pMsg, 0, sizeof(SyncSnapshotSend) + dataLen);
+  pMsg->bytes = sizeof(SyncSnapshotSend) + dataLen;
+  pMsg->seq = seq;
+  pMsg->dataLen = dataLen;
+  *(int32_t *)pMsg->data = seq;
+  return pMsg;
+}
+
+class SyncSnapshotWriteTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    maxWaitN = tsSnapReplMaxWaitN;
+    gFsm.seqs.clear();
+    gFsm.gateOpen = true;
+    gFsm.entered = 0;
+    gFsm.failSeq = -1;
+    gFsm.stopWrites = 0;
+
+    fsm.FpSnapshotStartWrite = testStartWrite;
+    fsm.FpSnapshotStopWrite = testStopWrite;
+    fsm.FpSnapshotDoWrite = testDoWrite;
+
+    pNode = (SSyncNode *)taosMemoryCalloc(1, sizeof(SSyncNode));
+    ASSERT_TRUE(pNode != NULL);
+    pNode->vgId = 2;
+    pNode->pFsm = &fsm;
+    taosThreadMutexInit(&pNode->raftStore.mutex, NULL);
+
+    SRaftId fromId = {.addr = 0x2, .vgId = 2};
+    pReceiver = snapshotReceiverCreate(pNode, fromId);
+    ASSERT_TRUE(pReceiver != NULL);
+    ASSERT_EQ(testStartWrite(&fsm, NULL, &pReceiver->pWriter), 0);
+    ASSERT_EQ(snapshotReceiverStartWriteThread(pReceiver), 0);
+  }
+
+  void TearDown() override {
+    gFsm.gateOpen = true;
+    snapshotReceiverDestroy(pReceiver);
+    taosThreadMutexDestroy(&pNode->raftStore.mutex);
+    taosMemoryFree(pNode);
+    tsSnapReplMaxWaitN = maxWaitN;
+  }
+
+  void waitEntered(int32_t n) {
+    while (gFsm.entered.load() < n) {
+      taosMsleep(1);
+    }
+  }
+
+  SSyncFSM               fsm = {0};
+  SSyncNode             *pNode = NULL;
+  SSyncSnapshotReceiver *pReceiver = NULL;
+  int32_t                maxWaitN = 0;
+};
+
+TEST_F(SyncSnapshotWriteTest, WritesInOrderWithBackPressure) {
+  tsSnapReplMaxWaitN = 4;
+
+  for (int32_t seq = 1; seq <= 50; seq++) {
+    ASSERT_EQ(snapshotReceiverQueueWrite(pReceiver, buildBlock(seq)), 0);
+  }
+
+  ASSERT_EQ(snapshotReceiverStopWriteThread(pReceiver, false), 0);
+  ASSERT_EQ(gFsm.seqs.size(), 50);
+  for (int32_t i = 0; i < 50; i++) {
+    EXPECT_EQ(gFsm.seqs[i], i + 1);
+  }
+  EXPECT_EQ(taosArrayGetSize(pReceiver->pWriteQ), 0);
+}
+
+TEST_F(SyncSnapshotWriteTest, WriteErrorIsSticky) {
+  tsSnapReplMaxWaitN = 16;
+  gFsm.failSeq = 3;
+  gFsm.gateOpen = false;
+
+  for (int32_t seq = 1; seq <= 6; seq++) {
+    ASSERT_EQ(snapshotReceiverQueueWrite(pReceiver, buildBlock(seq)), 0);
+  }
+  gFsm.gateOpen = true;
+
+  // the blocks behind the failed one are dropped without being written
+  while (true) {
+    taosThreadMutexLock(&pReceiver->writeMutex);
+    bool drained = taosArrayGetSize(pReceiver->pWriteQ) == 0;
+    taosThreadMutexUnlock(&pReceiver->writeMutex);
+    if (drained) break;
+    taosMsleep(1);
+  }
+  EXPECT_EQ(gFsm.seqs, std::vector<int32_t>({1, 2, 3}));
+
+  // later blocks and the end of the transfer fail with the first error
+  terrno = 0;
+  EXPECT_EQ(snapshotReceiverQueueWrite(pReceiver, buildBlock(7)), -1);
+  EXPECT_EQ(terrno, TEST_WRITE_ERROR);
+  EXPECT_EQ(snapshotReceiverStopWriteThread(pReceiver, false), TEST_WRITE_ERROR);
+  EXPECT_EQ(gFsm.seqs.size(), 3);
+}
+
+TEST_F(SyncSnapshotWriteTest, AbortDiscardsQueuedBlocks) {
+  tsSnapReplMaxWaitN = 16;
+  gFsm.gateOpen = false;
+
+  for (int32_t seq = 1; seq <= 8; seq++) {
+    ASSERT_EQ(snapshotReceiverQueueWrite(pReceiver, buildBlock(seq)), 0);
+  }
+  waitEntered(1);
+
+  // stop waits for the block being written, the rest of the queue is freed unwritten
+  std::thread opener([]() {
+    taosMsleep(50);
+    gFsm.gateOpen = true;
+  });
+  EXPECT_EQ(snapshotReceiverStopWriteThread(pReceiver, true), TSDB_CODE_SYN_INTERNAL_ERROR);
+  opener.join();
+
+  EXPECT_EQ(gFsm.seqs, std::vector<int32_t>({1}));
+  EXPECT_EQ(taosArrayGetSize(pReceiver->pWriteQ), 0);
+  EXPECT_FALSE(taosCheckPthreadValid(pReceiver->writeThread));
+}
+
+TEST_F(SyncSnapshotWriteTest, QueueFullUnblocksOnError) {
+  tsSnapReplMaxWaitN = 2;
+  gFsm.failSeq = 1;
+  gFsm.gateOpen = false;
+
+  ASSERT_EQ(snapshotReceiverQueueWrite(pReceiver, buildBlock(1)), 0);
+  ASSERT_EQ(snapshotReceiverQueueWrite(pReceiver, buildBlock(2)), 0);
+  waitEntered(1);
+
+  // the sync thread waits on the full queue until the failed write releases it
+  std::thread opener([]() {
+    taosMsleep(50);
+    gFsm.gateOpen = true;
+  });
+  terrno = 0;
+  EXPECT_EQ(snapshotReceiverQueueWrite(pReceiver, buildBlock(3)), -1);
+  EXPECT_EQ(terrno, TEST_WRITE_ERROR);
+  opener.join();
+}
+
+TEST_F(SyncSnapshotWriteTest, DestroyStopsThread) {
+  tsSnapReplMaxWaitN = 16;
+  gFsm.gateOpen = false;
+
+  for (int32_t seq = 1; seq <= 8; seq++) {
+    ASSERT_EQ(snapshotReceiverQueueWrite(pReceiver, buildBlock(seq)), 0);
+  }
+  waitEntered(1);
+
+  std::thread opener([]() {
+    taosMsleep(50);
+    gFsm.gateOpen = true;
+  });
+  snapshotReceiverDestroy(pReceiver);
+  pReceiver = NULL;
+  opener.join();
+
+  EXPECT_EQ(gFsm.seqs, std::vector<int32_t>({1}));
+  EXPECT_EQ(gFsm.stopWrites, 1);
+}
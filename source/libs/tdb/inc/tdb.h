@@ -26,10 +26,18 @@ extern "C" {
 typedef int (*tdb_cmpr_fn_t)(const void *pKey1, int32_t kLen1, const void *pKey2, int32_t kLen2);
 
 // exposed types
-typedef struct STDB TDB;
-typedef struct STTB TTB;
-typedef struct STBC TBC;
-typedef struct STxn TXN;
+typedef struct STDB    TDB;
+typedef struct STTB    TTB;
+typedef struct STBC    TBC;
+typedef struct STxn    TXN;
+typedef struct SBtBulk TBB;
+
+typedef struct {
+  const void *pKey;
+  int         kLen;
+  const void *pVal;
+  int         vLen;
+} TKV;
 
 // TDB
 int32_t tdbOpen(const char *dbname, int szPage, int pages, TDB **ppDb, int8_t rollback, int32_t encryptAlgorithm,
@@ -43,9 +51,20 @@ int32_t tdbPrepareAsyncCommit(TDB *pDb, TXN *pTxn);
 int32_t tdbAbort(TDB *pDb, TXN *pTxn);
 int32_t tdbAlter(TDB *pDb, int pages);
 
+// read snapshot, a snapshot txn reads every page as it was when the version it pins was published, while the writer
+// goes on changing and committing pages
+int32_t tdbSnapshotEnable(TDB *pDb);
+int32_t tdbSnapshotPublish(TDB *pDb);
+int32_t tdbSnapshotBegin(TDB *pDb, TXN **ppTxn);
+int32_t tdbSnapshotEnd(TDB *pDb, TXN *pTxn);
+
 // TTB
+#define TDB_TB_PREFIX_KEY 0x1  // a new table compresses the key prefix shared in a leaf page, variable length keys only
+
 int32_t tdbTbOpen(const char *tbname, int keyLen, int valLen, tdb_cmpr_fn_t keyCmprFn, TDB *pEnv, TTB **ppTb,
                   int8_t rollback);
+int32_t tdbTbOpenWithFlags(const char *tbname, int keyLen, int valLen, tdb_cmpr_fn_t keyCmprFn, TDB *pEnv, TTB **ppTb,
+                           int8_t rollback, int32_t flags);
 int32_t tdbTbClose(TTB *pTb);
 bool    tdbTbExist(const char *tbname, TDB *pEnv);
 int     tdbTbDropByName(const char *tbname, TDB *pEnv, TXN* pTxn);
@@ -55,8 +74,17 @@ int32_t tdbTbDelete(TTB *pTb, const void *pKey, int kLen, TXN *pTxn);
 int32_t tdbTbUpsert(TTB *pTb, const void *pKey, int kLen, const void *pVal, int vLen, TXN *pTxn);
 int32_t tdbTbGet(TTB *pTb, const void *pKey, int kLen, void **ppVal, int *vLen);
 int32_t tdbTbPGet(TTB *pTb, const void *pKey, int kLen, void **ppKey, int *pkLen, void **ppVal, int *vLen);
+int32_t tdbTbGetWithTxn(TTB *pTb, const void *pKey, int kLen, void **ppVal, int *vLen, TXN *pTxn);
 int32_t tdbTbTraversal(TTB *pTb, void *data,
                        int32_t (*func)(const void *pKey, int keyLen, const void *pVal, int valLen, void *data));
+// aKV is sorted in place in the key order of the table and put through one cursor, a key already in the table gets
+// the new value, the keys in aKV should be distinct
+int32_t tdbTbPutBatch(TTB *pTb, TKV *aKV, int32_t nKV, TXN *pTxn);
+
+// TBB, bulk load keys in ascending order into an empty table, the pages stay dirty in pTxn until it is committed
+int32_t tdbTbBulkOpen(TTB *pTb, int fillPct, TXN *pTxn, TBB **ppBulk);
+int32_t tdbTbBulkAppend(TBB *pBulk, const void *pKey, int kLen, const void *pVal, int vLen);
+int32_t tdbTbBulkClose(TBB *pBulk, int8_t finish);
 
 // TBC
 int32_t tdbTbcOpen(TTB *pTb, TBC **ppTbc, TXN *pTxn);
@@ -76,6 +104,7 @@ int32_t tdbTbcUpsert(TBC *pTbc, const void *pKey, int nKey, const void *pData, i
 // TXN
 #define TDB_TXN_WRITE            0x1
 #define TDB_TXN_READ_UNCOMMITTED 0x2
+#define TDB_TXN_SNAPSHOT         0x4
 
 int32_t tdbTxnOpen(TXN *pTxn, int64_t txnid, void *(*xMalloc)(void *, size_t), void (*xFree)(void *, void *),
                    void *xArg, int flags);
@@ -101,6 +130,11 @@ struct STxn {
   void     *xArg;
   tdb_fd_t  jfd;
   hashset_t jPageSet;
+  // snapshot txn
+  int64_t snapVer;
+  int8_t  snapAborted;  // the pages it reads were reverted by an aborted txn
+  TXN    *pSnapPrev;
+  TXN    *pSnapNext;
 };
 
 // error code
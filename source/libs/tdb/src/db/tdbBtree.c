@@ -13,11 +13,19 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "talgo.h"
 #include "tdbInt.h"
 
 #define TDB_BTREE_ROOT 0x1
 #define TDB_BTREE_LEAF 0x2
 #define TDB_BTREE_OVFL 0x4
+#define TDB_BTREE_PFX  0x8  // leaf page with prefix compressed keys
+
+// A prefix compressed leaf keeps a key prefix in its header. The kLen field of each cell is (kLen << 1) | isSuffix, a
+// suffix cell stores only the key bytes after the page prefix and is always local. Balance picks the prefix of each
+// new page from the prefixes of the old pages and the prefix its own keys share, and sizes the pages with it.
+#define TDB_BTREE_PFX_MIN 4
+#define TDB_BTREE_PFX_MAX 64
 
 struct SBTree {
   SPgno         root;
@@ -30,6 +38,7 @@ struct SBTree {
   int           minLocal;
   int           maxLeaf;
   int           minLeaf;
+  int           maxPfxLeaf;
   SBtInfo       info;
   char         *tbname;
   void         *pBuf;
@@ -42,10 +51,12 @@ struct SBTree {
 #define TDB_BTREE_PAGE_IS_ROOT(PAGE)          (TDB_BTREE_PAGE_GET_FLAGS(PAGE) & TDB_BTREE_ROOT)
 #define TDB_BTREE_PAGE_IS_LEAF(PAGE)          (TDB_BTREE_PAGE_GET_FLAGS(PAGE) & TDB_BTREE_LEAF)
 #define TDB_BTREE_PAGE_IS_OVFL(PAGE)          (TDB_BTREE_PAGE_GET_FLAGS(PAGE) & TDB_BTREE_OVFL)
-#define TDB_BTREE_ASSERT_FLAG(flags)                                                     \
-  ASSERT(TDB_FLAG_IS(flags, TDB_BTREE_ROOT) || TDB_FLAG_IS(flags, TDB_BTREE_LEAF) ||     \
-         TDB_FLAG_IS(flags, TDB_BTREE_ROOT | TDB_BTREE_LEAF) || TDB_FLAG_IS(flags, 0) || \
-         TDB_FLAG_IS(flags, TDB_BTREE_OVFL))
+#define TDB_BTREE_PAGE_IS_PFX(PAGE)           (TDB_BTREE_PAGE_GET_FLAGS(PAGE) & TDB_BTREE_PFX)
+#define TDB_BTREE_ASSERT_FLAG(flags)                                                                             \
+  ASSERT(TDB_FLAG_IS(flags, TDB_BTREE_ROOT) || TDB_FLAG_IS(flags, TDB_BTREE_LEAF) ||                             \
+         TDB_FLAG_IS(flags, TDB_BTREE_ROOT | TDB_BTREE_LEAF) || TDB_FLAG_IS(flags, 0) ||                         \
+         TDB_FLAG_IS(flags, TDB_BTREE_OVFL) || TDB_FLAG_IS(flags, TDB_BTREE_LEAF | TDB_BTREE_PFX) ||             \
+         TDB_FLAG_IS(flags, TDB_BTREE_ROOT | TDB_BTREE_LEAF | TDB_BTREE_PFX))
 
 #pragma pack(push, 1)
 typedef struct {
@@ -56,8 +67,16 @@ typedef struct {
   TDB_BTREE_PAGE_COMMON_HDR
   SPgno pgno;  // right-most child
 } SIntHdr;
+
+typedef struct {
+  TDB_BTREE_PAGE_COMMON_HDR
+  u8 nPfx;  // followed by nPfx bytes of key prefix
+} SPfxLeafHdr;
 #pragma pack(pop)
 
+#define TDB_BTREE_PFX_LEN(PAGE) (TDB_BTREE_PAGE_IS_PFX(PAGE) ? ((SPfxLeafHdr *)(PAGE)->pData)->nPfx : 0)
+#define TDB_BTREE_PFX_PTR(PAGE) ((PAGE)->pData + sizeof(SPfxLeafHdr))
+
 static int tdbDefaultKeyCmprFn(const void *pKey1, int keyLen1, const void *pKey2, int keyLen2);
 static int tdbBtreeOpenImpl(SBTree *pBt);
 // static int tdbBtreeInitPage(SPage *pPage, void *arg, int init);
@@ -68,9 +87,15 @@ static int tdbBtreeBalance(SBTC *pBtc);
 static int tdbBtreeCellSize(const SPage *pPage, SCell *pCell, int dropOfp, TXN *pTxn, SBTree *pBt);
 static int tdbBtcMoveDownward(SBTC *pBtc);
 static int tdbBtcMoveUpward(SBTC *pBtc);
-
-int tdbBtreeOpen(int keyLen, int valLen, SPager *pPager, char const *tbname, SPgno pgno, tdb_cmpr_fn_t kcmpr, TDB *pEnv,
-                 SBTree **ppBt) {
+static void tdbBtcReset(SBTC *pBtc);
+static int tdbBtcPut(SBTC *pBtc, const void *pKey, int kLen, const void *pVal, int vLen);
+static int tdbBtreeZeroPfxPage(SPage *pPage, SBTree *pBt, u8 flags, const u8 *pPfx, int nPfx);
+static int tdbBtreeCellFullSize(const SPage *pPage, SCell *pCell);
+static int tdbBtreeCellIsLocal(const SPage *pPage, const SCell *pCell);
+static int tdbBtreeCompactPage(SBTree *pBt, SPage *pPage, TXN *pTxn);
+
+int tdbBtreeOpen(int keyLen, int valLen, SPager *pPager, char const *tbname, SPgno pgno, tdb_cmpr_fn_t kcmpr, int flags,
+                 TDB *pEnv, SBTree **ppBt) {
   SBTree *pBt;
   int     ret;
 
@@ -104,6 +129,8 @@ int tdbBtreeOpen(int keyLen, int valLen, SPager *pPager, char const *tbname, SPg
   pBt->maxLeaf = tdbPageCapacity(pBt->pageSize, sizeof(SLeafHdr));
   // pBt->minLeaf
   pBt->minLeaf = pBt->minLocal;
+  // pBt->maxPfxLeaf: a cell of a prefix compressed leaf must fit beside the largest prefix
+  pBt->maxPfxLeaf = tdbPageCapacity(pBt->pageSize, sizeof(SPfxLeafHdr) + TDB_BTREE_PFX_MAX);
 
   // if pgno == 0 fetch new btree root leaf page
   if (pgno == 0) {
@@ -119,6 +146,9 @@ int tdbBtreeOpen(int keyLen, int valLen, SPager *pPager, char const *tbname, SPg
 
     SBtreeInitPageArg zArg;
     zArg.flags = 0x1 | 0x2;  // root leaf node;
+    if ((flags & TDB_BTREE_PREFIX_KEY) && pBt->keyLen == TDB_VARIANT_LEN) {
+      zArg.flags |= TDB_BTREE_PFX;
+    }
     zArg.pBt = pBt;
     ret = tdbPagerFetchPage(pPager, &pgno, &pPage, tdbBtreeInitPage, &zArg, txn);
     if (ret < 0) {
@@ -274,6 +304,35 @@ int tdbBtreeDelete(SBTree *pBt, const void *pKey, int kLen, TXN *pTxn) {
   return 0;
 }
 
+static int tdbBtreeKVCmpr(const void *p1, const void *p2, const void *param) {
+  const TKV *pKV1 = (const TKV *)p1;
+  const TKV *pKV2 = (const TKV *)p2;
+
+  return ((const SBTree *)param)->kcmpr(pKV1->pKey, pKV1->kLen, pKV2->pKey, pKV2->kLen);
+}
+
+int tdbBtreePutBatch(SBTree *pBt, TKV *aKV, int nKV, TXN *pTxn) {
+  SBTC btc;
+  int  ret = 0;
+
+  if (nKV <= 0) return 0;
+
+  // in key order the next key is mostly on the same leaf, or on a neighbour under the same parent
+  taosqsort(aKV, nKV, sizeof(TKV), pBt, tdbBtreeKVCmpr);
+
+  tdbBtcOpen(&btc, pBt, pTxn);
+  for (int i = 0; i < nKV; i++) {
+    ret = tdbBtcPut(&btc, aKV[i].pKey, aKV[i].kLen, aKV[i].pVal, aKV[i].vLen);
+    if (ret < 0) {
+      tdbError("tdb/btree-put-batch: put failed at %d of %d.", i, nKV);
+      break;
+    }
+  }
+  tdbBtcClose(&btc);
+
+  return ret;
+}
+
 #if 0
 int tdbBtreeUpsert(SBTree *pBt, const void *pKey, int nKey, const void *pData, int nData, TXN *pTxn) {
   SBTC btc = {0};
@@ -321,10 +380,11 @@ int tdbBtreeUpsert(SBTree *pBt, const void *pKey, int nKey, const void *pData, i
 #endif
 
 int tdbBtreeGet(SBTree *pBt, const void *pKey, int kLen, void **ppVal, int *vLen) {
-  return tdbBtreePGet(pBt, pKey, kLen, NULL, NULL, ppVal, vLen);
+  return tdbBtreePGet(pBt, pKey, kLen, NULL, NULL, ppVal, vLen, NULL);
 }
 
-int tdbBtreePGet(SBTree *pBt, const void *pKey, int kLen, void **ppKey, int *pkLen, void **ppVal, int *vLen) {
+int tdbBtreePGet(SBTree *pBt, const void *pKey, int kLen, void **ppKey, int *pkLen, void **ppVal, int *vLen,
+                 TXN *pTxn) {
   SBTC         btc;
   SCell       *pCell;
   int          cret;
@@ -333,7 +393,7 @@ int tdbBtreePGet(SBTree *pBt, const void *pKey, int kLen, void **ppKey, int *pkL
   void        *pTVal = NULL;
   SCellDecoder cd = {0};
 
-  tdbBtcOpen(&btc, pBt, NULL);
+  tdbBtcOpen(&btc, pBt, pTxn);
 
   tdbTrace("tdb pget, btc: %p", &btc);
 
@@ -434,20 +494,32 @@ int tdbBtreeInitPage(SPage *pPage, void *arg, int init) {
     leaf = TDB_BTREE_PAGE_IS_LEAF(pPage);
     TDB_BTREE_ASSERT_FLAG(flags);
 
-    tdbPageInit(pPage, leaf ? sizeof(SLeafHdr) : sizeof(SIntHdr), tdbBtreeCellSize);
+    if (flags & TDB_BTREE_PFX) {
+      tdbPageInit(pPage, sizeof(SPfxLeafHdr) + TDB_BTREE_PFX_LEN(pPage), tdbBtreeCellSize);
+    } else {
+      tdbPageInit(pPage, leaf ? sizeof(SLeafHdr) : sizeof(SIntHdr), tdbBtreeCellSize);
+    }
   } else {
     // zero page
     flags = ((SBtreeInitPageArg *)arg)->flags;
     leaf = flags & TDB_BTREE_LEAF;
     TDB_BTREE_ASSERT_FLAG(flags);
 
-    tdbPageZero(pPage, leaf ? sizeof(SLeafHdr) : sizeof(SIntHdr), tdbBtreeCellSize);
+    if (flags & TDB_BTREE_PFX) {
+      tdbPageZero(pPage, sizeof(SPfxLeafHdr), tdbBtreeCellSize);
+
+      SPfxLeafHdr *pPfxHdr = (SPfxLeafHdr *)(pPage->pData);
+      pPfxHdr->flags = flags;
+      pPfxHdr->nPfx = 0;
+    } else if (leaf) {
+      tdbPageZero(pPage, sizeof(SLeafHdr), tdbBtreeCellSize);
 
-    if (leaf) {
       SLeafHdr *pLeafHdr = (SLeafHdr *)(pPage->pData);
       pLeafHdr->flags = flags;
 
     } else {
+      tdbPageZero(pPage, sizeof(SIntHdr), tdbBtreeCellSize);
+
       SIntHdr *pIntHdr = (SIntHdr *)(pPage->pData);
       pIntHdr->flags = flags;
       pIntHdr->pgno = 0;
@@ -457,7 +529,7 @@ int tdbBtreeInitPage(SPage *pPage, void *arg, int init) {
   if (leaf) {
     pPage->kLen = pBt->keyLen;
     pPage->vLen = pBt->valLen;
-    pPage->maxLocal = pBt->maxLeaf;
+    pPage->maxLocal = (flags & TDB_BTREE_PFX) ? pBt->maxPfxLeaf : pBt->maxLeaf;
     pPage->minLocal = pBt->minLeaf;
   } else if (TDB_BTREE_PAGE_IS_OVFL(pPage)) {
     pPage->kLen = pBt->keyLen;
@@ -508,6 +580,11 @@ static int tdbBtreeBalanceDeeper(SBTree *pBt, SPage *pRoot, SPage **ppChild, TXN
     return -1;
   }
 
+  // the suffix cells of the root need its key prefix in the child
+  if (TDB_BTREE_PFX_LEN(pRoot) > 0) {
+    tdbBtreeZeroPfxPage(pChild, pBt, zArg.flags, TDB_BTREE_PFX_PTR(pRoot), TDB_BTREE_PFX_LEN(pRoot));
+  }
+
   // Copy the root page content to the child page
   tdbPageCopy(pRoot, pChild, 0);
 
@@ -526,6 +603,281 @@ static int tdbBtreeBalanceDeeper(SBTree *pBt, SPage *pRoot, SPage **ppChild, TXN
   return 0;
 }
 
+typedef struct {
+  int szFull;    // size of the cell in full, with its offset
+  int aSize[3];  // size of the cell with the prefix of each old page, with its offset
+  int kLen;      // -1 for cells with overflow pages, they stay in full
+  int kOff;
+} SBtPfxCell;
+
+typedef struct {
+  int         nOlds;
+  int         nCells;
+  SBtPfxCell *aCell;
+  u8         *pKeys;
+  SCell      *pCellBuf;
+  int         anPfx[3];
+  u8          aPfx[3][TDB_BTREE_PFX_MAX];
+} SBtPfxBalance;
+
+typedef struct {
+  int start;
+  int cnt;
+  int szFull;
+  int aSize[3];
+  int nLocal;
+  int ref;   // a local cell of the range, -1 if none
+  int nLcp;  // prefix shared by the local keys, short of it after cells are dropped
+} SBtPfxRange;
+
+#define TDB_BTREE_PFX_KEY(PB, IDX) ((PB)->pKeys + (PB)->aCell[IDX].kOff)
+
+static void tdbBtreePfxBalanceClose(SBtPfxBalance *pPb) {
+  if (pPb) {
+    tdbOsFree(pPb->aCell);
+    tdbFree(pPb->pKeys);
+    tdbOsFree(pPb->pCellBuf);
+    tdbOsFree(pPb);
+  }
+}
+
+static int tdbBtreePfxBalanceOpen(SBTree *pBt, SPage **pOlds, int nOlds, SBtPfxBalance **ppPb, TXN *pTxn) {
+  SBtPfxBalance *pPb;
+  SCellDecoder   cd = {0};
+  int            nKeys = 0;
+  int            iCell = 0;
+  u8             buf[8];
+
+  pPb = tdbOsCalloc(1, sizeof(*pPb));
+  if (pPb == NULL) {
+    return -1;
+  }
+
+  pPb->nOlds = nOlds;
+  for (int i = 0; i < nOlds; i++) {
+    pPb->nCells += TDB_PAGE_TOTAL_CELLS(pOlds[i]);
+    pPb->anPfx[i] = TDB_BTREE_PFX_LEN(pOlds[i]);
+    memcpy(pPb->aPfx[i], TDB_BTREE_PFX_PTR(pOlds[i]), pPb->anPfx[i]);
+  }
+
+  pPb->aCell = tdbOsMalloc(sizeof(SBtPfxCell) * pPb->nCells);
+  pPb->pCellBuf = tdbOsMalloc(pBt->pageSize);
+  if (pPb->aCell == NULL || pPb->pCellBuf == NULL) {
+    tdbBtreePfxBalanceClose(pPb);
+    return -1;
+  }
+
+  for (int i = 0; i < nOlds; i++) {
+    SPage *pPage = pOlds[i];
+
+    for (int oIdx = 0; oIdx < TDB_PAGE_TOTAL_CELLS(pPage); oIdx++, iCell++) {
+      SCell      *pCell = tdbPageGetCell(pPage, oIdx);
+      SBtPfxCell *pInfo = &pPb->aCell[iCell];
+
+      pInfo->szFull = tdbBtreeCellFullSize(pPage, pCell) + TDB_PAGE_OFFSET_SIZE(pPage);
+      pInfo->kLen = -1;
+      for (int c = 0; c < nOlds; c++) {
+        pInfo->aSize[c] = pInfo->szFull;
+      }
+
+      if (!tdbBtreeCellIsLocal(pPage, pCell)) {
+        continue;
+      }
+
+      if (tdbBtreeDecodeCell(pPage, pCell, &cd, pTxn, pBt) < 0) {
+        goto _err;
+      }
+
+      u8 *pKeys = tdbRealloc(pPb->pKeys, nKeys + cd.kLen);
+      if (pKeys == NULL) {
+        goto _err;
+      }
+      pPb->pKeys = pKeys;
+      memcpy(pKeys + nKeys, cd.pKey, cd.kLen);
+      pInfo->kLen = cd.kLen;
+      pInfo->kOff = nKeys;
+      nKeys += cd.kLen;
+
+      // exact size of the suffix cell, the kLen field may take a byte less
+      for (int c = 0; c < nOlds; c++) {
+        int nPfx = pPb->anPfx[c];
+        if (nPfx > 0 && cd.kLen >= nPfx && memcmp(cd.pKey, pPb->aPfx[c], nPfx) == 0) {
+          pInfo->aSize[c] = pInfo->szFull - nPfx - tdbPutVarInt(buf, cd.kLen << 1) +
+                            tdbPutVarInt(buf, ((cd.kLen - nPfx) << 1) | 1);
+        }
+      }
+    }
+  }
+
+  if (TDB_CELLDECODER_FREE_KEY(&cd)) {
+    tdbFree(cd.pKey);
+  }
+  if (TDB_CELLDECODER_FREE_VAL(&cd)) {
+    tdbFree(cd.pVal);
+  }
+
+  *ppPb = pPb;
+  return 0;
+
+_err:
+  if (TDB_CELLDECODER_FREE_KEY(&cd)) {
+    tdbFree(cd.pKey);
+  }
+  if (TDB_CELLDECODER_FREE_VAL(&cd)) {
+    tdbFree(cd.pVal);
+  }
+  tdbBtreePfxBalanceClose(pPb);
+  return -1;
+}
+
+// add a cell at either end of the range
+static void tdbBtreePfxRangeAdd(SBtPfxBalance *pPb, SBtPfxRange *pRange, int iCell) {
+  SBtPfxCell *pInfo = &pPb->aCell[iCell];
+
+  if (pRange->cnt == 0 || iCell < pRange->start) {
+    pRange->start = iCell;
+  }
+  pRange->cnt++;
+  pRange->szFull += pInfo->szFull;
+  for (int c = 0; c < pPb->nOlds; c++) {
+    pRange->aSize[c] += pInfo->aSize[c];
+  }
+
+  if (pInfo->kLen < 0) {
+    return;
+  }
+
+  pRange->nLocal++;
+  if (pRange->ref < 0) {
+    pRange->ref = iCell;
+    pRange->nLcp = TMIN(pInfo->kLen, TDB_BTREE_PFX_MAX);
+  } else {
+    u8 *pRef = TDB_BTREE_PFX_KEY(pPb, pRange->ref);
+    u8 *pKey = TDB_BTREE_PFX_KEY(pPb, iCell);
+    int n = 0;
+
+    while (n < pRange->nLcp && n < pInfo->kLen && pRef[n] == pKey[n]) n++;
+    pRange->nLcp = n;
+  }
+}
+
+static void tdbBtreePfxRangeReset(SBtPfxBalance *pPb, SBtPfxRange *pRange, int start, int cnt) {
+  memset(pRange, 0, sizeof(*pRange));
+  pRange->ref = -1;
+  for (int i = start; i < start + cnt; i++) {
+    tdbBtreePfxRangeAdd(pPb, pRange, i);
+  }
+}
+
+// drop the last cell of the range, the shared prefix only grows by that so it is kept as it is
+static void tdbBtreePfxRangeDrop(SBtPfxBalance *pPb, SBtPfxRange *pRange) {
+  int         iCell = pRange->start + pRange->cnt - 1;
+  SBtPfxCell *pInfo = &pPb->aCell[iCell];
+
+  if (iCell == pRange->ref) {
+    tdbBtreePfxRangeReset(pPb, pRange, pRange->start, pRange->cnt - 1);
+    return;
+  }
+
+  pRange->cnt--;
+  pRange->szFull -= pInfo->szFull;
+  for (int c = 0; c < pPb->nOlds; c++) {
+    pRange->aSize[c] -= pInfo->aSize[c];
+  }
+  if (pInfo->kLen >= 0) {
+    pRange->nLocal--;
+  }
+}
+
+// bytes the range takes in a page with the best prefix for it, the prefix itself included. *pChoice is the old page
+// whose prefix is taken, nOlds for the prefix shared by the keys of the range and -1 for no prefix.
+static int tdbBtreePfxRangeSize(SBtPfxBalance *pPb, SBtPfxRange *pRange, int *pChoice) {
+  int size = pRange->szFull;
+  int choice = -1;
+
+  for (int c = 0; c < pPb->nOlds; c++) {
+    if (pPb->anPfx[c] > 0 && pRange->aSize[c] + pPb->anPfx[c] < size) {
+      size = pRange->aSize[c] + pPb->anPfx[c];
+      choice = c;
+    }
+  }
+
+  if (pRange->nLcp >= TDB_BTREE_PFX_MIN) {
+    int sz = pRange->szFull - pRange->nLocal * pRange->nLcp + pRange->nLcp;
+    if (sz < size) {
+      size = sz;
+      choice = pPb->nOlds;
+    }
+  }
+
+  if (pChoice) {
+    *pChoice = choice;
+  }
+  return size;
+}
+
+// Same as the distribution of plain pages: fill the pages from the left, then move cells right to even them out. A
+// range that fits a page still fits after losing cells, so filling from the left takes the fewest pages.
+static int tdbBtreePfxBalanceSize(SBtPfxBalance *pPb, int usable, SBtPfxRange *aRange, int *pnNews) {
+  int nNews = 0;
+
+  tdbBtreePfxRangeReset(pPb, &aRange[0], 0, 0);
+  for (int iCell = 0; iCell < pPb->nCells; iCell++) {
+    SBtPfxRange range = aRange[nNews];
+
+    tdbBtreePfxRangeAdd(pPb, &range, iCell);
+    if (range.cnt > 1 && tdbBtreePfxRangeSize(pPb, &range, NULL) > usable) {
+      // page is full, use a new page
+      nNews++;
+      if (ASSERT(nNews < 5)) {
+        return -1;
+      }
+      tdbBtreePfxRangeReset(pPb, &aRange[nNews], iCell, 1);
+    } else {
+      aRange[nNews] = range;
+    }
+  }
+  nNews++;
+
+  // back loop to make the distribution even
+  for (int iNew = nNews - 1; iNew > 0; iNew--) {
+    while (aRange[iNew - 1].cnt > 1) {
+      SBtPfxRange left = aRange[iNew - 1];
+      SBtPfxRange right = aRange[iNew];
+
+      tdbBtreePfxRangeAdd(pPb, &right, left.start + left.cnt - 1);
+      tdbBtreePfxRangeDrop(pPb, &left);
+      if (tdbBtreePfxRangeSize(pPb, &right, NULL) >= tdbBtreePfxRangeSize(pPb, &left, NULL)) {
+        break;
+      }
+
+      aRange[iNew - 1] = left;
+      aRange[iNew] = right;
+    }
+  }
+
+  *pnNews = nNews;
+  return 0;
+}
+
+// zero a new page with the prefix that suits the cells it is going to take
+static int tdbBtreePfxBalanceZero(SBTree *pBt, SBtPfxBalance *pPb, SBtPfxRange *pRange, SPage *pPage, u8 flags) {
+  SBtreeInitPageArg iarg = {.flags = flags, .pBt = pBt};
+  int               choice;
+
+  // the shared prefix is worked out again, dropping cells may have left it short
+  tdbBtreePfxRangeReset(pPb, pRange, pRange->start, pRange->cnt);
+  tdbBtreePfxRangeSize(pPb, pRange, &choice);
+
+  if (choice < 0) {
+    return tdbBtreeInitPage(pPage, &iarg, 0);
+  } else if (choice < pPb->nOlds) {
+    return tdbBtreeZeroPfxPage(pPage, pBt, flags, pPb->aPfx[choice], pPb->anPfx[choice]);
+  } else {
+    return tdbBtreeZeroPfxPage(pPage, pBt, flags, TDB_BTREE_PFX_KEY(pPb, pRange->ref), pRange->nLcp);
+  }
+}
+
 static int tdbBtreeBalanceNonRoot(SBTree *pBt, SPage *pParent, int idx, TXN *pTxn) {
   int ret;
 
@@ -653,7 +1005,23 @@ static int tdbBtreeBalanceNonRoot(SBTree *pBt, SPage *pParent, int idx, TXN *pTx
     int oIdx;
   } infoNews[5] = {0};
 
-  {  // Get how many new pages are needed and the new distribution
+  SBtPfxBalance *pPb = NULL;
+  SBtPfxRange    aRange[5];
+  if (TDB_BTREE_PAGE_IS_PFX(pOlds[0])) {
+    // the cells of prefix compressed leaves change size with the page they go to
+    if (tdbBtreePfxBalanceOpen(pBt, pOlds, nOlds, &pPb, pTxn) < 0) {
+      return -1;
+    }
+
+    if (tdbBtreePfxBalanceSize(pPb, TDB_PAGE_USABLE_SIZE(pOlds[0]) + TDB_BTREE_PFX_LEN(pOlds[0]), aRange, &nNews) < 0) {
+      tdbBtreePfxBalanceClose(pPb);
+      return -1;
+    }
+
+    for (int iNew = 0; iNew < nNews; iNew++) {
+      infoNews[iNew].cnt = aRange[iNew].cnt;
+    }
+  } else {  // Get how many new pages are needed and the new distribution
 
     // first loop to find minimum number of pages needed
     for (int oPage = 0; oPage < nOlds; oPage++) {
@@ -784,19 +1152,27 @@ static int tdbBtreeBalanceNonRoot(SBTree *pBt, SPage *pParent, int idx, TXN *pTx
     SBtreeInitPageArg iarg;
     int               iNew, nNewCells;
     SCellDecoder      cd = {0};
+    int               iCell = 0;
 
     iarg.pBt = pBt;
     iarg.flags = TDB_BTREE_PAGE_GET_FLAGS(pOlds[0]);
     for (int i = 0; i < nOlds; i++) {
       tdbPageCreate(pOlds[0]->pageSize, &pOldsCopy[i], tdbDefaultMalloc, NULL);
       tdbBtreeInitPage(pOldsCopy[i], &iarg, 0);
+      if (TDB_BTREE_PFX_LEN(pOlds[i]) > 0) {
+        tdbBtreeZeroPfxPage(pOldsCopy[i], pBt, iarg.flags, TDB_BTREE_PFX_PTR(pOlds[i]), TDB_BTREE_PFX_LEN(pOlds[i]));
+      }
       tdbPageCopy(pOlds[i], pOldsCopy[i], 0);
       pOlds[i]->nOverflow = 0;
     }
 
     iNew = 0;
     nNewCells = 0;
-    tdbBtreeInitPage(pNews[iNew], &iarg, 0);
+    if (pPb) {
+      tdbBtreePfxBalanceZero(pBt, pPb, &aRange[iNew], pNews[iNew], iarg.flags);
+    } else {
+      tdbBtreeInitPage(pNews[iNew], &iarg, 0);
+    }
 
     for (int iOld = 0; iOld < nOlds; iOld++) {
       SPage *pPage;
@@ -815,8 +1191,17 @@ static int tdbBtreeBalanceNonRoot(SBTree *pBt, SPage *pParent, int idx, TXN *pTx
         }
 
         if (nNewCells < infoNews[iNew].cnt) {
-          tdbPageInsertCell(pNews[iNew], nNewCells, pCell, szCell, 0);
+          if (pPb && pPb->aCell[iCell].kLen >= 0) {
+            // local cells are written again against the prefix of the new page
+            int szNewCell;
+            tdbBtreeDecodeCell(pPage, pCell, &cd, pTxn, pBt);
+            tdbBtreeEncodeCell(pNews[iNew], cd.pKey, cd.kLen, cd.pVal, cd.vLen, pPb->pCellBuf, &szNewCell, pTxn, pBt);
+            tdbPageInsertCell(pNews[iNew], nNewCells, pPb->pCellBuf, szNewCell, 0);
+          } else {
+            tdbPageInsertCell(pNews[iNew], nNewCells, pCell, szCell, 0);
+          }
           nNewCells++;
+          iCell++;
 
           // insert parent page
           if (!childNotLeaf && nNewCells == infoNews[iNew].cnt) {
@@ -847,7 +1232,11 @@ static int tdbBtreeBalanceNonRoot(SBTree *pBt, SPage *pParent, int idx, TXN *pTx
             iNew++;
             nNewCells = 0;
             if (iNew < nNews) {
-              tdbBtreeInitPage(pNews[iNew], &iarg, 0);
+              if (pPb) {
+                tdbBtreePfxBalanceZero(pBt, pPb, &aRange[iNew], pNews[iNew], iarg.flags);
+              } else {
+                tdbBtreeInitPage(pNews[iNew], &iarg, 0);
+              }
             }
           }
         } else {
@@ -896,12 +1285,23 @@ static int tdbBtreeBalanceNonRoot(SBTree *pBt, SPage *pParent, int idx, TXN *pTx
     for (int i = 0; i < nOlds; i++) {
       tdbPageDestroy(pOldsCopy[i], tdbDefaultFree, NULL);
     }
+    if (TDB_CELLDECODER_FREE_KEY(&cd)) {
+      tdbFree(cd.pKey);
+    }
+    if (TDB_CELLDECODER_FREE_VAL(&cd)) {
+      tdbFree(cd.pVal);
+    }
+    tdbBtreePfxBalanceClose(pPb);
   }
 
   if (TDB_BTREE_PAGE_IS_ROOT(pParent) && TDB_PAGE_TOTAL_CELLS(pParent) == 0) {
-    i8 flags = TDB_BTREE_ROOT | TDB_BTREE_PAGE_IS_LEAF(pNews[0]);
+    i8 flags = TDB_BTREE_ROOT | TDB_BTREE_PAGE_IS_LEAF(pNews[0]) | TDB_BTREE_PAGE_IS_PFX(pNews[0]);
     // copy content to the parent page
-    tdbBtreeInitPage(pParent, &(SBtreeInitPageArg){.flags = flags, .pBt = pBt}, 0);
+    if (TDB_BTREE_PFX_LEN(pNews[0]) > 0) {
+      tdbBtreeZeroPfxPage(pParent, pBt, flags, TDB_BTREE_PFX_PTR(pNews[0]), TDB_BTREE_PFX_LEN(pNews[0]));
+    } else {
+      tdbBtreeInitPage(pParent, &(SBtreeInitPageArg){.flags = flags, .pBt = pBt}, 0);
+    }
     tdbPageCopy(pNews[0], pParent, 1);
 
     if (!TDB_BTREE_PAGE_IS_LEAF(pNews[0])) {
@@ -1237,6 +1637,24 @@ static int tdbBtreeEncodePayload(SPage *pPage, SCell *pCell, int nHeader, const
   return 0;
 }
 
+// a key goes into a suffix cell when it has the page prefix and its full cell would still be local
+static int tdbBtreeUseSuffix(SPage *pPage, const void *pKey, int kLen, int vLen) {
+  int nPfx = TDB_BTREE_PFX_LEN(pPage);
+  u8  buf[16];
+  int nHeader;
+
+  if (nPfx == 0 || kLen < nPfx || memcmp(pKey, TDB_BTREE_PFX_PTR(pPage), nPfx) != 0) {
+    return 0;
+  }
+
+  nHeader = tdbPutVarInt(buf, kLen << 1);
+  if (pPage->vLen == TDB_VARIANT_LEN) {
+    nHeader += tdbPutVarInt(buf + nHeader, vLen);
+  }
+
+  return nHeader + kLen + vLen <= pPage->maxLocal;
+}
+
 static int tdbBtreeEncodeCell(SPage *pPage, const void *pKey, int kLen, const void *pVal, int vLen, SCell *pCell,
                               int *szCell, TXN *pTxn, SBTree *pBt) {
   u8  leaf;
@@ -1270,8 +1688,32 @@ static int tdbBtreeEncodeCell(SPage *pPage, const void *pKey, int kLen, const vo
     nHeader = nHeader + sizeof(SPgno);
   }
 
-  /* Encode kLen if need */
-  if (pPage->kLen == TDB_VARIANT_LEN) {
+  if (TDB_BTREE_PAGE_IS_PFX(pPage)) {
+    if (pPage->vLen == 0) {
+      pVal = NULL;
+      vLen = 0;
+    }
+
+    if (tdbBtreeUseSuffix(pPage, pKey, kLen, vLen)) {
+      int nPfx = TDB_BTREE_PFX_LEN(pPage);
+
+      nHeader += tdbPutVarInt(pCell + nHeader, ((kLen - nPfx) << 1) | 1);
+      if (pPage->vLen == TDB_VARIANT_LEN) {
+        nHeader += tdbPutVarInt(pCell + nHeader, vLen);
+      }
+
+      memcpy(pCell + nHeader, (u8 *)pKey + nPfx, kLen - nPfx);
+      if (vLen > 0) {
+        memcpy(pCell + nHeader + kLen - nPfx, pVal, vLen);
+      }
+
+      *szCell = nHeader + kLen - nPfx + vLen;
+      return 0;
+    }
+
+    nHeader += tdbPutVarInt(pCell + nHeader, kLen << 1);
+  } else if (pPage->kLen == TDB_VARIANT_LEN) {
+    /* Encode kLen if need */
     nHeader += tdbPutVarInt(pCell + nHeader, kLen);
   }
 
@@ -1297,6 +1739,52 @@ static int tdbBtreeEncodeCell(SPage *pPage, const void *pKey, int kLen, const vo
   return 0;
 }
 
+// the size tdbBtreeEncodeCell gives the cell on pPage, without building its overflow pages
+static int tdbBtreeEncodedCellSize(SPage *pPage, const void *pKey, int kLen, int vLen) {
+  u8  buf[16];
+  u8  leaf = TDB_BTREE_PAGE_IS_LEAF(pPage);
+  int nHeader = leaf ? 0 : sizeof(SPgno);
+  int nPayload;
+
+  if (TDB_BTREE_PAGE_IS_PFX(pPage)) {
+    if (pPage->vLen == 0) {
+      vLen = 0;
+    }
+
+    if (tdbBtreeUseSuffix(pPage, pKey, kLen, vLen)) {
+      int nPfx = TDB_BTREE_PFX_LEN(pPage);
+
+      nHeader += tdbPutVarInt(buf, ((kLen - nPfx) << 1) | 1);
+      if (pPage->vLen == TDB_VARIANT_LEN) {
+        nHeader += tdbPutVarInt(buf, vLen);
+      }
+      return nHeader + kLen - nPfx + vLen;
+    }
+
+    nHeader += tdbPutVarInt(buf, kLen << 1);
+  } else if (pPage->kLen == TDB_VARIANT_LEN) {
+    nHeader += tdbPutVarInt(buf, kLen);
+  }
+
+  if (pPage->vLen == TDB_VARIANT_LEN) {
+    nHeader += tdbPutVarInt(buf, vLen);
+  }
+
+  if ((!leaf) || pPage->vLen == 0) {
+    vLen = 0;
+  }
+
+  // same local size as tdbBtreeEncodePayload
+  nPayload = kLen + vLen;
+  if (nPayload + nHeader <= pPage->maxLocal) {
+    return nHeader + nPayload;
+  } else {
+    int minLocal = pPage->minLocal;
+    int surplus = minLocal + (nPayload + nHeader - minLocal) % (pPage->maxLocal - sizeof(SPgno));
+    return surplus <= pPage->maxLocal ? surplus : minLocal;
+  }
+}
+
 static int tdbBtreeDecodePayload(SPage *pPage, const SCell *pCell, int nHeader, SCellDecoder *pDecoder, TXN *pTxn,
                                  SBTree *pBt) {
   int ret = 0;
@@ -1504,6 +1992,8 @@ static int tdbBtreeDecodeCell(SPage *pPage, const SCell *pCell, SCellDecoder *pD
   u8  leaf;
   int nHeader;
   int ret;
+  int isSuffix = 0;
+  u8 *pKeyBuf = NULL;
 
   nHeader = 0;
   leaf = TDB_BTREE_PAGE_IS_LEAF(pPage);
@@ -1515,7 +2005,8 @@ static int tdbBtreeDecodeCell(SPage *pPage, const SCell *pCell, SCellDecoder *pD
     // tdbTrace("tdb btc decoder val set nil: %p/0x%x ", pDecoder, pDecoder->freeKV);
   }
   if (TDB_CELLDECODER_FREE_KEY(pDecoder)) {
-    tdbFree(pDecoder->pKey);
+    // kept for the key of a suffix cell, iterating a prefix compressed page decodes one per cell
+    pKeyBuf = pDecoder->pKey;
     TDB_CELLDECODER_CLZ_FREE_KEY(pDecoder);
     // tdbTrace("tdb btc decoder key set nil: %p/0x%x ", pDecoder, pDecoder->freeKV);
   }
@@ -1539,12 +2030,17 @@ static int tdbBtreeDecodeCell(SPage *pPage, const SCell *pCell, SCellDecoder *pD
 
   if (pPage->kLen == TDB_VARIANT_LEN) {
     nHeader += tdbGetVarInt(pCell + nHeader, &(pDecoder->kLen));
+    if (TDB_BTREE_PAGE_IS_PFX(pPage)) {
+      isSuffix = pDecoder->kLen & 1;
+      pDecoder->kLen >>= 1;
+    }
   } else {
     pDecoder->kLen = pPage->kLen;
   }
 
   if (pPage->vLen == TDB_VARIANT_LEN) {
     if (!leaf) {
+      tdbFree(pKeyBuf);
       tdbError("tdb/btree-decode-cell: not a leaf page.");
       return -1;
     }
@@ -1553,6 +2049,28 @@ static int tdbBtreeDecodeCell(SPage *pPage, const SCell *pCell, SCellDecoder *pD
     pDecoder->vLen = pPage->vLen;
   }
 
+  if (isSuffix) {
+    // suffix cells are local, only the key is put together with the page prefix
+    int nPfx = TDB_BTREE_PFX_LEN(pPage);
+    int sLen = pDecoder->kLen;
+
+    pDecoder->kLen = nPfx + sLen;
+    pDecoder->pKey = tdbRealloc(pKeyBuf, pDecoder->kLen);
+    if (pDecoder->pKey == NULL) {
+      tdbFree(pKeyBuf);
+      return -1;
+    }
+    TDB_CELLDECODER_SET_FREE_KEY(pDecoder);
+
+    memcpy(pDecoder->pKey, TDB_BTREE_PFX_PTR(pPage), nPfx);
+    memcpy(pDecoder->pKey + nPfx, pCell + nHeader, sLen);
+    if (pDecoder->vLen > 0) {
+      pDecoder->pVal = (SCell *)pCell + nHeader + sLen;
+    }
+    return 0;
+  }
+  tdbFree(pKeyBuf);
+
   // 2. Decode payload part
   ret = tdbBtreeDecodePayload(pPage, pCell, nHeader, pDecoder, pTxn, pBt);
   if (ret < 0) {
@@ -1574,6 +2092,10 @@ static int tdbBtreeCellSize(const SPage *pPage, SCell *pCell, int dropOfp, TXN *
 
   if (pPage->kLen == TDB_VARIANT_LEN) {
     nHeader += tdbGetVarInt(pCell + nHeader, &kLen);
+    if (TDB_BTREE_PAGE_IS_PFX(pPage)) {
+      // the low bit flags a suffix cell
+      kLen >>= 1;
+    }
   } else {
     kLen = pPage->kLen;
   }
@@ -1651,6 +2173,146 @@ static int tdbBtreeCellSize(const SPage *pPage, SCell *pCell, int dropOfp, TXN *
     return nLocal;
   }
 }
+
+static int tdbBtreeZeroPfxPage(SPage *pPage, SBTree *pBt, u8 flags, const u8 *pPfx, int nPfx) {
+  SBtreeInitPageArg zArg = {.flags = flags, .pBt = pBt};
+
+  tdbBtreeInitPage(pPage, &zArg, 0);
+  tdbPageZero(pPage, sizeof(SPfxLeafHdr) + nPfx, tdbBtreeCellSize);
+  ((SPfxLeafHdr *)pPage->pData)->nPfx = nPfx;
+  memcpy(TDB_BTREE_PFX_PTR(pPage), pPfx, nPfx);
+
+  return 0;
+}
+
+// size of the cell once a suffix cell is written back in full
+static int tdbBtreeCellFullSize(const SPage *pPage, SCell *pCell) {
+  int szCell = tdbBtreeCellSize(pPage, pCell, 0, NULL, NULL);
+  int nPfx = TDB_BTREE_PFX_LEN(pPage);
+  int field, nField;
+  u8  buf[8];
+
+  if (nPfx == 0) {
+    return szCell;
+  }
+
+  nField = tdbGetVarInt(pCell, &field);
+  if ((field & 1) == 0) {
+    return szCell;
+  }
+
+  return szCell + nPfx + tdbPutVarInt(buf, ((field >> 1) + nPfx) << 1) - nField;
+}
+
+static int tdbBtreeCellIsLocal(const SPage *pPage, const SCell *pCell) {
+  int kLen, vLen, nHeader;
+
+  nHeader = tdbGetVarInt(pCell, &kLen);
+  if (kLen & 1) {
+    return 1;
+  }
+  kLen >>= 1;
+
+  if (pPage->vLen == TDB_VARIANT_LEN) {
+    nHeader += tdbGetVarInt(pCell + nHeader, &vLen);
+  } else {
+    vLen = pPage->vLen;
+  }
+
+  return nHeader + kLen + vLen <= pPage->maxLocal;
+}
+
+// Give a prefix compressed leaf the longest prefix its local keys share and rewrite its cells against it. Only done
+// when the prefix grows, the page must be writable and without overflow cells.
+static int tdbBtreeCompactPage(SBTree *pBt, SPage *pPage, TXN *pTxn) {
+  int          nCells = TDB_PAGE_TOTAL_CELLS(pPage);
+  u8           flags = TDB_BTREE_PAGE_GET_FLAGS(pPage);
+  SCellDecoder cd = {0};
+  u8          *pPfx = NULL;
+  int          nPfx = -1;
+  SPage       *pTmp = NULL;
+  SCell       *pBuf = NULL;
+  int          ret = -1;
+
+  if (!TDB_BTREE_PAGE_IS_PFX(pPage) || pPage->nOverflow > 0 || nCells < 2) {
+    return 0;
+  }
+
+  // the keys are ordered by the table comparator, not bytewise, so every local key is looked at
+  for (int i = 0; i < nCells && nPfx != 0; i++) {
+    SCell *pCell = tdbPageGetCell(pPage, i);
+    if (!tdbBtreeCellIsLocal(pPage, pCell)) continue;
+
+    if (tdbBtreeDecodeCell(pPage, pCell, &cd, pTxn, pBt) < 0) {
+      goto _exit;
+    }
+
+    if (nPfx < 0) {
+      nPfx = TMIN(TDB_BTREE_PFX_MAX, cd.kLen);
+      pPfx = tdbRealloc(NULL, nPfx);
+      if (pPfx == NULL) {
+        goto _exit;
+      }
+      memcpy(pPfx, cd.pKey, nPfx);
+    } else {
+      int n = 0;
+      while (n < nPfx && n < cd.kLen && pPfx[n] == cd.pKey[n]) n++;
+      nPfx = n;
+    }
+  }
+
+  if (nPfx < TDB_BTREE_PFX_MIN || nPfx <= TDB_BTREE_PFX_LEN(pPage)) {
+    ret = 0;
+    goto _exit;
+  }
+
+  pBuf = tdbOsMalloc(pPage->pageSize);
+  if (pBuf == NULL || tdbPageCreate(pPage->pageSize, &pTmp, tdbDefaultMalloc, NULL) < 0) {
+    goto _exit;
+  }
+  tdbBtreeZeroPfxPage(pTmp, pBt, flags, pPfx, nPfx);
+
+  for (int i = 0; i < nCells; i++) {
+    SCell *pCell = tdbPageGetCell(pPage, i);
+    int    szCell;
+
+    if (tdbBtreeCellIsLocal(pPage, pCell)) {
+      if (tdbBtreeDecodeCell(pPage, pCell, &cd, pTxn, pBt) < 0 ||
+          tdbBtreeEncodeCell(pTmp, cd.pKey, cd.kLen, cd.pVal, cd.vLen, pBuf, &szCell, pTxn, pBt) < 0) {
+        goto _exit;
+      }
+      pCell = pBuf;
+    } else {
+      // full cells with overflow pages are laid out the same way in every prefix compressed page
+      szCell = tdbBtreeCellSize(pPage, pCell, 0, NULL, NULL);
+    }
+
+    if (tdbPageInsertCell(pTmp, i, pCell, szCell, 0) < 0 || pTmp->nOverflow > 0) {
+      goto _exit;
+    }
+  }
+
+  tdbBtreeZeroPfxPage(pPage, pBt, flags, pPfx, nPfx);
+  tdbPageCopy(pTmp, pPage, 0);
+  ret = 0;
+
+_exit:
+  if (TDB_CELLDECODER_FREE_KEY(&cd)) {
+    tdbFree(cd.pKey);
+  }
+  if (TDB_CELLDECODER_FREE_VAL(&cd)) {
+    tdbFree(cd.pVal);
+  }
+  if (pTmp) {
+    for (int i = 0; i < pTmp->nOverflow; i++) {
+      tdbOsFree(pTmp->apOvfl[i]);
+    }
+    tdbPageDestroy(pTmp, tdbDefaultFree, NULL);
+  }
+  tdbOsFree(pBuf);
+  tdbFree(pPfx);
+  return ret;
+}
 // TDB_BTREE_CELL
 
 // TDB_BTREE_CURSOR =====================
@@ -1873,12 +2535,19 @@ int tdbBtreeNext(SBTC *pBtc, void **ppKey, int *kLen, void **ppVal, int *vLen) {
 
   pKey = tdbRealloc(*ppKey, cd.kLen);
   if (pKey == NULL) {
+    if (TDB_CELLDECODER_FREE_KEY(&cd)) {
+      tdbFree(cd.pKey);
+    }
     return -1;
   }
 
   *ppKey = pKey;
   *kLen = cd.kLen;
   memcpy(pKey, cd.pKey, (size_t)cd.kLen);
+  // the key of a suffix cell is put together in a buffer of the decoder
+  if (TDB_CELLDECODER_FREE_KEY(&cd)) {
+    tdbFree(cd.pKey);
+  }
 
   if (ppVal) {
     if (cd.vLen > 0) {
@@ -1936,12 +2605,18 @@ int tdbBtreePrev(SBTC *pBtc, void **ppKey, int *kLen, void **ppVal, int *vLen) {
 
   pKey = tdbRealloc(*ppKey, cd.kLen);
   if (pKey == NULL) {
+    if (TDB_CELLDECODER_FREE_KEY(&cd)) {
+      tdbFree(cd.pKey);
+    }
     return -1;
   }
 
   *ppKey = pKey;
   *kLen = cd.kLen;
   memcpy(pKey, cd.pKey, (size_t)cd.kLen);
+  if (TDB_CELLDECODER_FREE_KEY(&cd)) {
+    tdbFree(cd.pKey);
+  }
 
   if (ppVal) {
     // TODO: vLen may be zero
@@ -2114,6 +2789,58 @@ static int tdbBtcMoveUpward(SBTC *pBtc) {
   return 0;
 }
 
+// give back the pages on the path, the cursor moves from the root again next time
+static void tdbBtcReset(SBTC *pBtc) {
+  for (; pBtc->iPage >= 0; pBtc->iPage--) {
+    if (pBtc->pPage) {
+      tdbPagerReturnPage(pBtc->pBt->pPager, pBtc->pPage, pBtc->pTxn);
+    }
+    pBtc->pPage = pBtc->iPage > 0 ? pBtc->pgStack[pBtc->iPage - 1] : NULL;
+  }
+
+  pBtc->pPage = NULL;
+  pBtc->idx = -1;
+
+  // a clear cursor is closed without looking at the decoder
+  if (TDB_CELLDECODER_FREE_KEY(&pBtc->coder)) {
+    tdbFree(pBtc->coder.pKey);
+  }
+  if (TDB_CELLDECODER_FREE_VAL(&pBtc->coder)) {
+    tdbFree(pBtc->coder.pVal);
+  }
+  memset(&pBtc->coder, 0, sizeof(SCellDecoder));
+}
+
+// insert the key, or give it the new value, keeping the cursor on its path for the next key
+static int tdbBtcPut(SBTC *pBtc, const void *pKey, int kLen, const void *pVal, int vLen) {
+  SBTree *pBt = pBtc->pBt;
+  int     c = 0;
+
+  if (tdbBtcMoveTo(pBtc, pKey, kLen, &c) < 0) {
+    tdbBtcReset(pBtc);
+    return -1;
+  }
+
+  if (pBtc->idx == -1) {
+    pBtc->idx = 0;
+  } else if (c == 0) {
+    // replaced as tdbTbUpsert does, the delete may merge pages on the path
+    tdbBtcReset(pBtc);
+    tdbBtreeDelete(pBt, pKey, kLen, pBtc->pTxn);
+    return tdbBtreeInsert(pBt, pKey, kLen, pVal, vLen, pBtc->pTxn);
+  } else if (c > 0) {
+    pBtc->idx++;
+  }
+
+  // a balance leaves the cursor on the lowest page it did not split, with the path above it unchanged
+  if (tdbBtcUpsert(pBtc, pKey, kLen, pVal, vLen, 1) < 0) {
+    tdbBtcReset(pBtc);
+    return -1;
+  }
+
+  return 0;
+}
+
 int tdbBtcGet(SBTC *pBtc, const void **ppKey, int *kLen, const void **ppVal, int *vLen) {
   SCell *pCell;
 
@@ -2373,48 +3100,35 @@ int tdbBtcMoveTo(SBTC *pBtc, const void *pKey, int kLen, int *pCRst) {
     // for empty tree, just return with an invalid position
     if (TDB_PAGE_TOTAL_CELLS(pBtc->pPage) == 0) return 0;
   } else {
-    // TODO
-    tdbError("tdb/btc-move-to: move from a dirty cursor.");
-    return -1;
-#if 0
-    SPage *pPage;
-    int    idx;
-    int    iPage = 0;
-
-    // downward search
-    for (; iPage < pBtc->iPage; iPage++) {
-      pPage = pBtc->pgStack[iPage];
-      idx = pBtc->idxStack[iPage];
-      nCells = TDB_PAGE_TOTAL_CELLS(pPage);
+    // move from a dirty cursor. Child idx of an interior page covers the keys in (key[idx - 1], key[idx]], so the
+    // path is kept down to the first page whose child on the path does not cover the key, the search goes on there
+    int iPage;
 
-      if (TDB_BTREE_PAGE_IS_LEAF(pPage)) {
-        tdbError("tdb/btc-move-to: leaf page in cursor stack.");
-        return -1;
-      }
+    for (iPage = 0; iPage < pBtc->iPage; iPage++) {
+      SPage *pPage = pBtc->pgStack[iPage];
+      int    idx = pBtc->idxStack[iPage];
 
-      // check if key <= current position
+      nCells = TDB_PAGE_TOTAL_CELLS(pPage);
       if (idx < nCells) {
-        pCell = tdbPageGetCell(pPage, idx);
-        tdbBtreeDecodeCell(pPage, pCell, &cd);
-        c = pBt->kcmpr(pKey, kLen, cd.pKey, cd.kLen);
+        tdbBtreeDecodeCell(pPage, tdbPageGetCell(pPage, idx), &pBtc->coder, pBtc->pTxn, pBt);
+        c = pBt->kcmpr(pKey, kLen, pBtc->coder.pKey, pBtc->coder.kLen);
         if (c > 0) break;
       }
 
-      // check if key > current - 1 position
       if (idx > 0) {
-        pCell = tdbPageGetCell(pPage, idx - 1);
-        tdbBtreeDecodeCell(pPage, pCell, &cd);
-        c = pBt->kcmpr(pKey, kLen, cd.pKey, cd.kLen, pBtc->pTxn, pBtc->pBt);
+        tdbBtreeDecodeCell(pPage, tdbPageGetCell(pPage, idx - 1), &pBtc->coder, pBtc->pTxn, pBt);
+        c = pBt->kcmpr(pKey, kLen, pBtc->coder.pKey, pBtc->coder.kLen);
         if (c <= 0) break;
       }
     }
 
-    // move upward
-    for (;;) {
-      if (pBtc->iPage == iPage) break;
+    while (pBtc->iPage > iPage) {
       tdbBtcMoveUpward(pBtc);
     }
-#endif
+
+    pBtc->idx = -1;
+    // only the root leaf of an empty tree has no cells
+    if (TDB_PAGE_TOTAL_CELLS(pBtc->pPage) == 0) return 0;
   }
 
   // search downward to the leaf
@@ -2537,6 +3251,327 @@ int tdbBtcIsValid(SBTC *pBtc) {
 }
 // TDB_BTREE_CURSOR
 
+// TDB_BTREE_BULK =====================
+// Bulk load of keys in strictly ascending order into an empty btree. Leaves are filled left to right up to fillPct of
+// the usable page size, and each finished page hands its page number and last key to the level above. An interior
+// level keeps its newest child pending as the right-most child, and turns it into a divider cell when the next child
+// arrives. At the end the single page of the top level is copied into the root page, so the root page number kept in
+// the main db does not change.
+
+#define TDB_BTREE_BULK_FILL 90
+
+typedef struct {
+  SPage *pPage;
+  int    nPage;
+  SPgno  pgno;  // interior level: the pending right-most child
+  void  *pKey;  // leaf level: the last key, interior level: the last key under the pending child
+  int    kLen;
+  int    kCap;
+} SBtBulkLevel;
+
+struct SBtBulk {
+  SBTree      *pBt;
+  TXN         *pTxn;
+  int          fillPct;
+  u8           leafFlags;
+  int          nLevel;
+  i64          nData;
+  void        *pBuf;      // divider cells of the interior levels
+  void        *pLeafBuf;  // cells of the leaf level
+  SBtBulkLevel aLevel[BTREE_MAX_DEPTH];
+};
+
+static int tdbBtBulkSetKey(SBtBulkLevel *pLevel, const void *pKey, int kLen) {
+  if (kLen > pLevel->kCap) {
+    void *pNew = tdbRealloc(pLevel->pKey, kLen);
+    if (pNew == NULL) {
+      return -1;
+    }
+    pLevel->pKey = pNew;
+    pLevel->kCap = kLen;
+  }
+
+  memcpy(pLevel->pKey, pKey, kLen);
+  pLevel->kLen = kLen;
+  return 0;
+}
+
+static int tdbBtBulkNewPage(SBtBulk *pBulk, int iLevel) {
+  SBTree           *pBt = pBulk->pBt;
+  SPgno             pgno = 0;
+  SBtreeInitPageArg zArg = {.flags = iLevel == 0 ? pBulk->leafFlags : 0, .pBt = pBt};
+  SPage            *pPage;
+
+  if (tdbPagerFetchPage(pBt->pPager, &pgno, &pPage, tdbBtreeInitPage, &zArg, pBulk->pTxn) < 0) {
+    tdbError("tdb/btree-bulk: fetch page failed at level %d.", iLevel);
+    return -1;
+  }
+
+  if (tdbPagerWrite(pBt->pPager, pPage) < 0) {
+    tdbError("failed to write page since %s", terrstr());
+    tdbPagerReturnPage(pBt->pPager, pPage, pBulk->pTxn);
+    return -1;
+  }
+
+  pBulk->aLevel[iLevel].pPage = pPage;
+  pBulk->aLevel[iLevel].nPage++;
+  if (pBulk->nLevel <= iLevel) {
+    pBulk->nLevel = iLevel + 1;
+  }
+  return 0;
+}
+
+// encode a cell once its page is settled, the overflow pages it needs are built here and only here
+static int tdbBtBulkEncode(SBtBulk *pBulk, void **ppBuf, SPage *pPage, const void *pKey, int kLen, const void *pVal,
+                           int vLen, int szCell, SCell **ppCell) {
+  int   nEncoded = 0;
+  void *pBuf = tdbRealloc(*ppBuf, szCell);
+  if (pBuf == NULL) {
+    return -1;
+  }
+  *ppBuf = pBuf;
+  *ppCell = (SCell *)pBuf;
+
+  if (tdbBtreeEncodeCell(pPage, pKey, kLen, pVal, vLen, *ppCell, &nEncoded, pBulk->pTxn, pBulk->pBt) < 0) {
+    return -1;
+  }
+  if (nEncoded != szCell) {
+    tdbError("tdb/btree-bulk: cell size %d differs from the expected %d.", nEncoded, szCell);
+    return -1;
+  }
+  return 0;
+}
+
+static bool tdbBtBulkFits(SBtBulk *pBulk, SPage *pPage, int szCell) {
+  int need = szCell + TDB_PAGE_OFFSET_SIZE(pPage);
+  int usable = TDB_PAGE_USABLE_SIZE(pPage);
+  int nFree = TDB_PAGE_FREE_SIZE(pPage);
+
+  if (nFree < need) return false;
+  if (TDB_PAGE_TOTAL_CELLS(pPage) == 0) return true;
+  return (int64_t)(usable - nFree + need) * 100 <= (int64_t)usable * pBulk->fillPct;
+}
+
+static int tdbBtBulkPushChild(SBtBulk *pBulk, int iLevel, SPgno pgno, const void *pKey, int kLen);
+
+// hand the open page of a level to the level above, the page keeps a ref from the pager as it is dirty
+static int tdbBtBulkFinishPage(SBtBulk *pBulk, int iLevel) {
+  SBtBulkLevel *pLevel = &pBulk->aLevel[iLevel];
+  SPage        *pPage = pLevel->pPage;
+
+  pLevel->pPage = NULL;
+  if (iLevel == 0) {
+    tdbBtreeCompactPage(pBulk->pBt, pPage, pBulk->pTxn);
+  }
+  int ret = tdbBtBulkPushChild(pBulk, iLevel + 1, TDB_PAGE_PGNO(pPage), pLevel->pKey, pLevel->kLen);
+  tdbPagerReturnPage(pBulk->pBt->pPager, pPage, pBulk->pTxn);
+  return ret;
+}
+
+static int tdbBtBulkPushChild(SBtBulk *pBulk, int iLevel, SPgno pgno, const void *pKey, int kLen) {
+  SBtBulkLevel *pLevel;
+  SCell        *pCell;
+  int           szCell;
+
+  if (iLevel >= BTREE_MAX_DEPTH) {
+    tdbError("tdb/btree-bulk: btree deeper than %d.", BTREE_MAX_DEPTH);
+    return -1;
+  }
+  pLevel = &pBulk->aLevel[iLevel];
+
+  if (pLevel->pPage == NULL) {
+    if (tdbBtBulkNewPage(pBulk, iLevel) < 0) {
+      return -1;
+    }
+  } else {
+    // the pending child gets its divider cell, or stays the right-most child of a full page
+    szCell = tdbBtreeEncodedCellSize(pLevel->pPage, pLevel->pKey, pLevel->kLen, sizeof(SPgno));
+    if (tdbBtBulkFits(pBulk, pLevel->pPage, szCell)) {
+      if (tdbBtBulkEncode(pBulk, &pBulk->pBuf, pLevel->pPage, pLevel->pKey, pLevel->kLen, &pLevel->pgno, sizeof(SPgno),
+                          szCell, &pCell) < 0) {
+        tdbError("tdb/btree-bulk: encode divider cell failed at level %d.", iLevel);
+        return -1;
+      }
+      if (tdbPageInsertCell(pLevel->pPage, TDB_PAGE_TOTAL_CELLS(pLevel->pPage), pCell, szCell, 0) < 0) {
+        return -1;
+      }
+    } else {
+      if (tdbBtBulkFinishPage(pBulk, iLevel) < 0 || tdbBtBulkNewPage(pBulk, iLevel) < 0) {
+        return -1;
+      }
+    }
+  }
+
+  pLevel->pgno = pgno;
+  ((SIntHdr *)pLevel->pPage->pData)->pgno = pgno;
+  return tdbBtBulkSetKey(pLevel, pKey, kLen);
+}
+
+static int tdbBtBulkSetRoot(SBtBulk *pBulk, SPage *pTop) {
+  SBTree *pBt = pBulk->pBt;
+  SPgno   pgno = pBt->root;
+  SPage  *pRoot;
+  u8      leaf = TDB_BTREE_PAGE_IS_LEAF(pTop);
+  u8      flags = TDB_BTREE_ROOT | leaf | TDB_BTREE_PAGE_IS_PFX(pTop);
+
+  if (tdbPagerFetchPage(pBt->pPager, &pgno, &pRoot, tdbBtreeInitPage, &((SBtreeInitPageArg){.pBt = pBt, .flags = 0}),
+                        pBulk->pTxn) < 0) {
+    tdbError("tdb/btree-bulk: fetch root page failed.");
+    return -1;
+  }
+
+  if (tdbPagerWrite(pBt->pPager, pRoot) < 0) {
+    tdbError("failed to write page since %s", terrstr());
+    tdbPagerReturnPage(pBt->pPager, pRoot, pBulk->pTxn);
+    return -1;
+  }
+
+  if (leaf) {
+    tdbBtreeCompactPage(pBt, pTop, pBulk->pTxn);
+  }
+  if (TDB_BTREE_PFX_LEN(pTop) > 0) {
+    tdbBtreeZeroPfxPage(pRoot, pBt, flags, TDB_BTREE_PFX_PTR(pTop), TDB_BTREE_PFX_LEN(pTop));
+  } else {
+    tdbBtreeInitPage(pRoot, &((SBtreeInitPageArg){.flags = flags, .pBt = pBt}), 0);
+  }
+  tdbPageCopy(pTop, pRoot, 1);
+  if (!leaf) {
+    ((SIntHdr *)pRoot->pData)->pgno = ((SIntHdr *)pTop->pData)->pgno;
+  }
+
+  tdbPagerInsertFreePage(pBt->pPager, pTop, pBulk->pTxn);
+  tdbPagerReturnPage(pBt->pPager, pRoot, pBulk->pTxn);
+  return 0;
+}
+
+int tdbBtreeBulkOpen(SBTree *pBt, int fillPct, TXN *pTxn, SBtBulk **ppBulk) {
+  SBtBulk *pBulk;
+  SPage   *pRoot;
+  SPgno    pgno = pBt->root;
+  int      empty;
+  u8       leafFlags;
+
+  *ppBulk = NULL;
+
+  if (!pTxn || !TDB_TXN_IS_WRITE(pTxn)) {
+    tdbError("tdb/btree-bulk: bulk load needs a write txn.");
+    return -1;
+  }
+
+  if (tdbPagerFetchPage(pBt->pPager, &pgno, &pRoot, tdbBtreeInitPage, &((SBtreeInitPageArg){.pBt = pBt, .flags = 0}),
+                        pTxn) < 0) {
+    tdbError("tdb/btree-bulk: fetch root page failed.");
+    return -1;
+  }
+  empty = TDB_BTREE_PAGE_IS_LEAF(pRoot) && TDB_PAGE_TOTAL_CELLS(pRoot) == 0;
+  leafFlags = TDB_BTREE_LEAF | TDB_BTREE_PAGE_IS_PFX(pRoot);
+  tdbPagerReturnPage(pBt->pPager, pRoot, pTxn);
+
+  if (!empty) {
+    tdbError("tdb/btree-bulk: table %s is not empty.", pBt->tbname ? pBt->tbname : "");
+    return -1;
+  }
+
+  pBulk = (SBtBulk *)tdbOsCalloc(1, sizeof(*pBulk));
+  if (pBulk == NULL) {
+    return -1;
+  }
+
+  pBulk->pBt = pBt;
+  pBulk->pTxn = pTxn;
+  pBulk->fillPct = (fillPct <= 0 || fillPct > 100) ? TDB_BTREE_BULK_FILL : fillPct;
+  pBulk->leafFlags = leafFlags;
+
+  *ppBulk = pBulk;
+  return 0;
+}
+
+int tdbBtreeBulkAppend(SBtBulk *pBulk, const void *pKey, int kLen, const void *pVal, int vLen) {
+  SBtBulkLevel *pLeaf = &pBulk->aLevel[0];
+  SCell        *pCell;
+  int           szCell;
+
+  if (pBulk->nData > 0 && pBulk->pBt->kcmpr(pLeaf->pKey, pLeaf->kLen, pKey, kLen) >= 0) {
+    tdbError("tdb/btree-bulk: keys not in ascending order.");
+    return -1;
+  }
+
+  if (pLeaf->pPage == NULL && tdbBtBulkNewPage(pBulk, 0) < 0) {
+    return -1;
+  }
+
+  // the cell size depends on the page prefix, so the page is settled before the cell is encoded
+  szCell = tdbBtreeEncodedCellSize(pLeaf->pPage, pKey, kLen, vLen);
+  if (!tdbBtBulkFits(pBulk, pLeaf->pPage, szCell) && TDB_BTREE_PAGE_IS_PFX(pLeaf->pPage)) {
+    // a full prefix compressed leaf may make room by taking the prefix its keys share
+    tdbBtreeCompactPage(pBulk->pBt, pLeaf->pPage, pBulk->pTxn);
+    szCell = tdbBtreeEncodedCellSize(pLeaf->pPage, pKey, kLen, vLen);
+  }
+
+  if (!tdbBtBulkFits(pBulk, pLeaf->pPage, szCell)) {
+    // a new prefix compressed leaf starts without a prefix
+    if (tdbBtBulkFinishPage(pBulk, 0) < 0 || tdbBtBulkNewPage(pBulk, 0) < 0) {
+      return -1;
+    }
+    szCell = tdbBtreeEncodedCellSize(pLeaf->pPage, pKey, kLen, vLen);
+  }
+
+  if (tdbBtBulkEncode(pBulk, &pBulk->pLeafBuf, pLeaf->pPage, pKey, kLen, pVal, vLen, szCell, &pCell) < 0) {
+    tdbError("tdb/btree-bulk: encode cell failed.");
+    return -1;
+  }
+
+  if (tdbPageInsertCell(pLeaf->pPage, TDB_PAGE_TOTAL_CELLS(pLeaf->pPage), pCell, szCell, 0) < 0) {
+    return -1;
+  }
+
+  pBulk->nData++;
+  return tdbBtBulkSetKey(pLeaf, pKey, kLen);
+}
+
+int tdbBtreeBulkClose(SBtBulk *pBulk, int finish) {
+  int ret = 0;
+
+  if (pBulk == NULL) return 0;
+
+  // close the levels bottom up, until a level that ends with its only page, which becomes the root
+  for (int iLevel = 0; finish && pBulk->nData > 0 && iLevel < pBulk->nLevel; iLevel++) {
+    SBtBulkLevel *pLevel = &pBulk->aLevel[iLevel];
+
+    if (iLevel == pBulk->nLevel - 1 && pLevel->nPage == 1) {
+      SPage *pTop = pLevel->pPage;
+      pLevel->pPage = NULL;
+      ret = tdbBtBulkSetRoot(pBulk, pTop);
+      tdbPagerReturnPage(pBulk->pBt->pPager, pTop, pBulk->pTxn);
+      break;
+    }
+
+    if (tdbBtBulkFinishPage(pBulk, iLevel) < 0) {
+      ret = -1;
+      break;
+    }
+  }
+
+  if (ret == 0 && finish) {
+    tdbDebug("tdb/btree-bulk: table %s loaded, nData:%" PRId64 " nLevel:%d",
+             pBulk->pBt->tbname ? pBulk->pBt->tbname : "", pBulk->nData, pBulk->nLevel);
+  }
+
+  for (int iLevel = 0; iLevel < BTREE_MAX_DEPTH; iLevel++) {
+    SBtBulkLevel *pLevel = &pBulk->aLevel[iLevel];
+    if (pLevel->pPage) {
+      tdbPagerReturnPage(pBulk->pBt->pPager, pLevel->pPage, pBulk->pTxn);
+    }
+    tdbFree(pLevel->pKey);
+  }
+  tdbFree(pBulk->pBuf);
+  tdbFree(pBulk->pLeafBuf);
+  tdbOsFree(pBulk);
+
+  return ret;
+}
+// TDB_BTREE_BULK
+
 // TDB_BTREE_DEBUG =====================
 #ifndef NODEBUG
 typedef struct {
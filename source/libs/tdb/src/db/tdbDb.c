@@ -68,6 +68,8 @@ int32_t tdbOpen(const char *dbname, int32_t szPage, int32_t pages, TDB **ppDb, i
   }
   memset(pDb->pgrHash, 0, tsize);
 
+  tdbRwlockInit(&pDb->snapLock, NULL);
+
   ret = taosMulModeMkDir(dbname, 0755, false);
   if (ret < 0) {
     return -1;
@@ -105,6 +107,7 @@ int tdbClose(TDB *pDb) {
     }
 
     tdbPCacheClose(pDb->pCache);
+    tdbRwlockDestroy(&pDb->snapLock);
     tdbOsFree(pDb->pgrHash);
     tdbOsFree(pDb);
   }
@@ -114,6 +117,133 @@ int tdbClose(TDB *pDb) {
 
 int32_t tdbAlter(TDB *pDb, int pages) { return tdbPCacheAlter(pDb->pCache, pages); }
 
+int32_t tdbSnapshotEnable(TDB *pDb) {
+  pDb->snapEnabled = 1;
+  return 0;
+}
+
+// drop the images that neither an open snapshot nor one opened from now on can read, called with snapLock write locked
+static void tdbSnapshotDropImages(TDB *pDb) {
+  i64 ver = pDb->pSnapHead ? pDb->pSnapHead->snapVer : pDb->snapVer;
+
+  if (ver <= pDb->snapGcVer) return;
+  pDb->snapGcVer = ver;
+
+  for (SPager *pPager = pDb->pgrList; pPager; pPager = pPager->pNext) {
+    tdbPagerDropImages(pPager, ver);
+  }
+}
+
+// called with snapLock write locked
+static void tdbSnapshotUnlink(TDB *pDb, TXN *pTxn) {
+  if (pTxn->pSnapPrev) {
+    pTxn->pSnapPrev->pSnapNext = pTxn->pSnapNext;
+  } else {
+    atomic_store_ptr(&pDb->pSnapHead, pTxn->pSnapNext);
+  }
+  if (pTxn->pSnapNext) {
+    pTxn->pSnapNext->pSnapPrev = pTxn->pSnapPrev;
+  } else {
+    pDb->pSnapTail = pTxn->pSnapPrev;
+  }
+}
+
+// An aborted txn reverts its pages to the last commit, while the published versions hold its changes. The open
+// snapshots are ended for their further reads, and the next version is the reverted one. Called with snapLock write
+// locked.
+static void tdbSnapshotAbort(TDB *pDb) {
+  TXN *pTxn;
+
+  if (!pDb->snapEnabled) return;
+
+  while ((pTxn = pDb->pSnapHead) != NULL) {
+    tdbSnapshotUnlink(pDb, pTxn);
+    pTxn->pSnapPrev = NULL;
+    pTxn->pSnapNext = NULL;
+    pTxn->snapAborted = 1;
+  }
+
+  atomic_store_8(&pDb->snapChanged, 0);
+  atomic_store_8(&pDb->snapUnkept, 0);
+  atomic_store_64(&pDb->snapVer, pDb->snapVer + 1);
+  tdbSnapshotDropImages(pDb);
+}
+
+int32_t tdbSnapshotPublish(TDB *pDb) {
+  if (!pDb->snapEnabled || !atomic_load_8(&pDb->snapChanged)) {
+    return 0;
+  }
+
+  tdbRwlockWrlock(&pDb->snapLock);
+  if (pDb->snapChanged) {
+    atomic_store_8(&pDb->snapChanged, 0);
+    atomic_store_8(&pDb->snapUnkept, 0);
+    atomic_store_64(&pDb->snapVer, pDb->snapVer + 1);
+    tdbSnapshotDropImages(pDb);
+  }
+  tdbRwlockUnlock(&pDb->snapLock);
+
+  return 0;
+}
+
+int32_t tdbSnapshotBegin(TDB *pDb, TXN **ppTxn) {
+  TXN *pTxn;
+
+  *ppTxn = NULL;
+  if (!pDb->snapEnabled) {
+    tdbDebug("tdb/snapshot: read snapshot not enabled, dbName:%s", pDb->dbName);
+    return -1;
+  }
+
+  pTxn = tdbOsCalloc(1, sizeof(*pTxn));
+  if (pTxn == NULL) {
+    terrno = TSDB_CODE_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  if (tdbTxnOpen(pTxn, 0, tdbDefaultMalloc, tdbDefaultFree, NULL, TDB_TXN_SNAPSHOT) < 0) {
+    tdbOsFree(pTxn);
+    return -1;
+  }
+
+  tdbRwlockWrlock(&pDb->snapLock);
+  pTxn->snapVer = pDb->snapVer;
+  pTxn->pSnapPrev = pDb->pSnapTail;
+  if (pDb->pSnapTail) {
+    pDb->pSnapTail->pSnapNext = pTxn;
+  } else {
+    atomic_store_ptr(&pDb->pSnapHead, pTxn);
+  }
+  pDb->pSnapTail = pTxn;
+
+  // the writer changed pages of the published version without keeping their images, see tdbPagerKeepImage
+  if (atomic_load_8(&pDb->snapUnkept)) {
+    tdbSnapshotUnlink(pDb, pTxn);
+    tdbRwlockUnlock(&pDb->snapLock);
+    tdbTxnClose(pTxn);
+    tdbDebug("tdb/snapshot: version %" PRId64 " not complete, dbName:%s", pDb->snapVer, pDb->dbName);
+    return -1;
+  }
+  tdbRwlockUnlock(&pDb->snapLock);
+
+  *ppTxn = pTxn;
+  return 0;
+}
+
+int32_t tdbSnapshotEnd(TDB *pDb, TXN *pTxn) {
+  if (pTxn == NULL) return 0;
+
+  tdbRwlockWrlock(&pDb->snapLock);
+  if (!pTxn->snapAborted) {
+    tdbSnapshotUnlink(pDb, pTxn);
+    tdbSnapshotDropImages(pDb);
+  }
+  tdbRwlockUnlock(&pDb->snapLock);
+
+  tdbTxnClose(pTxn);
+  return 0;
+}
+
 int32_t tdbBegin(TDB *pDb, TXN **ppTxn, void *(*xMalloc)(void *, size_t), void (*xFree)(void *, void *), void *xArg,
                  int flags) {
   SPager *pPager;
@@ -202,14 +332,20 @@ int32_t tdbAbort(TDB *pDb, TXN *pTxn) {
   SPager *pPager;
   int     ret;
 
+  // snapshots read live pages under the read lock, they must not see them reverted
+  tdbRwlockWrlock(&pDb->snapLock);
   for (pPager = pDb->pgrList; pPager; pPager = pPager->pNext) {
     ret = tdbPagerAbort(pPager, pTxn);
     if (ret < 0) {
+      tdbSnapshotAbort(pDb);
+      tdbRwlockUnlock(&pDb->snapLock);
       tdbError("failed to abort pager since %s. dbName:%s, txnId:%" PRId64, tstrerror(terrno), pDb->dbName,
                pTxn->txnId);
       return -1;
     }
   }
+  tdbSnapshotAbort(pDb);
+  tdbRwlockUnlock(&pDb->snapLock);
 
   tdbTxnClose(pTxn);
 
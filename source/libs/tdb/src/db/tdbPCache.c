@@ -17,18 +17,31 @@
 // #include <sys/types.h>
 // #include <unistd.h>
 
-struct SPCache {
-  int         szPage;
-  int         nPages;
-  SPage     **aPage;
+// The cache is split into shards by page id hash, each with its own lock, hash table and free list, so readers of
+// different pages do not serialize on one mutex. Local pages in a shard's hash sit on a ring swept by a CLOCK hand,
+// fetching or releasing a page only touches its reference bit and pin count, the ring changes only when a page enters
+// or leaves the hash.
+
+#define TDB_PCACHE_MAX_SHARDS      16
+#define TDB_PCACHE_MIN_SHARD_PAGES 64
+
+typedef struct {
   tdb_mutex_t mutex;
   int         nFree;
   SPage      *pFree;
   int         nPage;
   int         nHash;
   SPage     **pgHash;
-  int         nRecyclable;
-  SPage       lru;
+  SPage       clock;
+  SPage      *pHand;
+} SPCacheShard;
+
+struct SPCache {
+  int           szPage;
+  int           nPages;
+  SPage       **aPage;
+  int           nShard;
+  SPCacheShard *aShard;
 };
 
 static inline uint32_t tdbPCachePageHash(const SPgid *pPgid) {
@@ -36,18 +49,45 @@ static inline uint32_t tdbPCachePageHash(const SPgid *pPgid) {
   return (uint32_t)(t[0] + t[1] + t[2] + t[3] + t[4] + t[5] + (pPgid)->pgno);
 }
 
+static inline SPCacheShard *tdbPCacheGetShard(SPCache *pCache, const SPgid *pPgid) {
+  return &pCache->aShard[tdbPCachePageHash(pPgid) & (pCache->nShard - 1)];
+}
+
+static inline uint32_t tdbPCacheBucket(SPCache *pCache, SPCacheShard *pShard, const SPgid *pPgid) {
+  return (tdbPCachePageHash(pPgid) / pCache->nShard) % pShard->nHash;
+}
+
 static int    tdbPCacheOpenImpl(SPCache *pCache);
-static SPage *tdbPCacheFetchImpl(SPCache *pCache, const SPgid *pPgid, TXN *pTxn);
-static void   tdbPCachePinPage(SPCache *pCache, SPage *pPage);
-static void   tdbPCacheRemovePageFromHash(SPCache *pCache, SPage *pPage);
-static void   tdbPCacheAddPageToHash(SPCache *pCache, SPage *pPage);
-static void   tdbPCacheUnpinPage(SPCache *pCache, SPage *pPage);
+static SPage *tdbPCacheFetchImpl(SPCache *pCache, SPCacheShard *pShard, const SPgid *pPgid, TXN *pTxn);
+static void   tdbPCacheRemovePageFromHash(SPCache *pCache, SPCacheShard *pShard, SPage *pPage);
+static void   tdbPCacheAddPageToHash(SPCache *pCache, SPCacheShard *pShard, SPage *pPage);
+static void   tdbPCacheUnpinPage(SPCache *pCache, SPCacheShard *pShard, SPage *pPage);
 static int    tdbPCacheCloseImpl(SPCache *pCache);
 
-static void tdbPCacheInitLock(SPCache *pCache) { tdbMutexInit(&(pCache->mutex), NULL); }
-static void tdbPCacheDestroyLock(SPCache *pCache) { tdbMutexDestroy(&(pCache->mutex)); }
-static void tdbPCacheLock(SPCache *pCache) { tdbMutexLock(&(pCache->mutex)); }
-static void tdbPCacheUnlock(SPCache *pCache) { tdbMutexUnlock(&(pCache->mutex)); }
+static void tdbPCacheInitLock(SPCacheShard *pShard) { tdbMutexInit(&(pShard->mutex), NULL); }
+static void tdbPCacheDestroyLock(SPCacheShard *pShard) { tdbMutexDestroy(&(pShard->mutex)); }
+static void tdbPCacheLock(SPCacheShard *pShard) { tdbMutexLock(&(pShard->mutex)); }
+static void tdbPCacheUnlock(SPCacheShard *pShard) { tdbMutexUnlock(&(pShard->mutex)); }
+
+static void tdbPCacheLockAll(SPCache *pCache) {
+  for (int i = 0; i < pCache->nShard; i++) {
+    tdbPCacheLock(&pCache->aShard[i]);
+  }
+}
+
+static void tdbPCacheUnlockAll(SPCache *pCache) {
+  for (int i = pCache->nShard - 1; i >= 0; i--) {
+    tdbPCacheUnlock(&pCache->aShard[i]);
+  }
+}
+
+static int tdbPCacheShardNum(int cacheSize) {
+  int nShard = 1;
+  while (nShard < TDB_PCACHE_MAX_SHARDS && cacheSize / (nShard * 2) >= TDB_PCACHE_MIN_SHARD_PAGES) {
+    nShard *= 2;
+  }
+  return nShard;
+}
 
 int tdbPCacheOpen(int pageSize, int cacheSize, SPCache **ppCache) {
   SPCache *pCache;
@@ -67,7 +107,17 @@ int tdbPCacheOpen(int pageSize, int cacheSize, SPCache **ppCache) {
     return -1;
   }
 
+  pCache->nShard = tdbPCacheShardNum(cacheSize);
+  pCache->aShard = (SPCacheShard *)tdbOsCalloc(pCache->nShard, sizeof(SPCacheShard));
+  if (pCache->aShard == NULL) {
+    tdbOsFree(pCache->aPage);
+    tdbOsFree(pCache);
+    return -1;
+  }
+
   if (tdbPCacheOpenImpl(pCache) < 0) {
+    tdbOsFree(pCache->aShard);
+    tdbOsFree(pCache->aPage);
     tdbOsFree(pCache);
     return -1;
   }
@@ -79,19 +129,86 @@ int tdbPCacheOpen(int pageSize, int cacheSize, SPCache **ppCache) {
 int tdbPCacheClose(SPCache *pCache) {
   if (pCache) {
     tdbPCacheCloseImpl(pCache);
+    tdbOsFree(pCache->aShard);
     tdbOsFree(pCache->aPage);
     tdbOsFree(pCache);
   }
   return 0;
 }
 
-// TODO:
-// if (pPage->id >= pCache->nPages) {
-//   free(pPage);
-//   pCache->aPage[pPage->id] = NULL;
-// } else {
-//   add to free list
-// }
+static void tdbPCacheClockAdd(SPCacheShard *pShard, SPage *pPage) {
+  // enter just behind the hand, so a new page gets a full sweep before it can be recycled
+  SPage *pHand = pShard->pHand;
+
+  pPage->pLruNext = pHand;
+  pPage->pLruPrev = pHand->pLruPrev;
+  pHand->pLruPrev->pLruNext = pPage;
+  pHand->pLruPrev = pPage;
+  pPage->isRecent = 0;
+}
+
+static void tdbPCacheClockRemove(SPCacheShard *pShard, SPage *pPage) {
+  if (pPage->pLruNext == NULL) return;
+
+  if (pShard->pHand == pPage) {
+    pShard->pHand = pPage->pLruNext;
+  }
+  pPage->pLruPrev->pLruNext = pPage->pLruNext;
+  pPage->pLruNext->pLruPrev = pPage->pLruPrev;
+  pPage->pLruNext = NULL;
+  pPage->pLruPrev = NULL;
+}
+
+// sweep the ring from the hand, clearing reference bits, and take the first unpinned page not referenced since the
+// last sweep. Two rounds are enough to visit every page with its bit cleared.
+static SPage *tdbPCacheClockEvict(SPCache *pCache, SPCacheShard *pShard) {
+  for (int nStep = 2 * (pShard->nPage + 1); nStep > 0; nStep--) {
+    SPage *pPage = pShard->pHand;
+    pShard->pHand = pPage->pLruNext;
+
+    if (pPage->isAnchor || pPage->isDirty || tdbGetPageRef(pPage) != 0 || pPage->id >= pCache->nPages) continue;
+    if (pPage->isRecent) {
+      pPage->isRecent = 0;
+      continue;
+    }
+
+    tdbPCacheRemovePageFromHash(pCache, pShard, pPage);
+    tdbTrace("pcache/recycle page %p/%d, pgno:%d, ", pPage, pPage->id, TDB_PAGE_PGNO(pPage));
+    return pPage;
+  }
+
+  return NULL;
+}
+
+static SPage *tdbPCacheGetFree(SPCacheShard *pShard) {
+  SPage *pPage = pShard->pFree;
+  if (pPage) {
+    pShard->pFree = pPage->pFreeNext;
+    pShard->nFree--;
+    pPage->pLruNext = NULL;
+  }
+  return pPage;
+}
+
+// the shard of the page is exhausted, take a free or recyclable page from a shard nobody else holds right now
+static SPage *tdbPCacheStealPage(SPCache *pCache, SPCacheShard *pShard, bool recycle) {
+  int iShard = pShard - pCache->aShard;
+
+  for (int i = 1; i < pCache->nShard; i++) {
+    SPCacheShard *pOther = &pCache->aShard[(iShard + i) & (pCache->nShard - 1)];
+    if (tdbMutexTryLock(&pOther->mutex) != 0) continue;
+
+    SPage *pPage = tdbPCacheGetFree(pOther);
+    if (pPage == NULL && recycle) {
+      pPage = tdbPCacheClockEvict(pCache, pOther);
+    }
+    tdbPCacheUnlock(pOther);
+
+    if (pPage) return pPage;
+  }
+
+  return NULL;
+}
 
 static int tdbPCacheAlterImpl(SPCache *pCache, int32_t nPage) {
   if (pCache->nPages == nPage) {
@@ -124,9 +241,10 @@ static int tdbPCacheAlterImpl(SPCache *pCache, int32_t nPage) {
 
     // add page to free list
     for (int32_t iPage = pCache->nPages; iPage < nPage; iPage++) {
-      aPage[iPage]->pFreeNext = pCache->pFree;
-      pCache->pFree = aPage[iPage];
-      pCache->nFree++;
+      SPCacheShard *pShard = &pCache->aShard[iPage & (pCache->nShard - 1)];
+      aPage[iPage]->pFreeNext = pShard->pFree;
+      pShard->pFree = aPage[iPage];
+      pShard->nFree++;
     }
 
     for (int32_t iPage = 0; iPage < pCache->nPages; iPage++) {
@@ -136,17 +254,32 @@ static int tdbPCacheAlterImpl(SPCache *pCache, int32_t nPage) {
     tdbOsFree(pCache->aPage);
     pCache->aPage = aPage;
   } else {
-    for (SPage **ppPage = &pCache->pFree; *ppPage;) {
-      int32_t iPage = (*ppPage)->id;
+    for (int iShard = 0; iShard < pCache->nShard; iShard++) {
+      SPCacheShard *pShard = &pCache->aShard[iShard];
+
+      for (SPage **ppPage = &pShard->pFree; *ppPage;) {
+        int32_t iPage = (*ppPage)->id;
+
+        if (iPage >= nPage) {
+          SPage *pPage = *ppPage;
+          *ppPage = pPage->pFreeNext;
+          pCache->aPage[pPage->id] = NULL;
+          tdbPageDestroy(pPage, tdbDefaultFree, NULL);
+          pShard->nFree--;
+        } else {
+          ppPage = &(*ppPage)->pFreeNext;
+        }
+      }
 
-      if (iPage >= nPage) {
-        SPage *pPage = *ppPage;
-        *ppPage = pPage->pFreeNext;
-        pCache->aPage[pPage->id] = NULL;
-        tdbPageDestroy(pPage, tdbDefaultFree, NULL);
-        pCache->nFree--;
-      } else {
-        ppPage = &(*ppPage)->pFreeNext;
+      // unpinned pages beyond the new size are dropped now, pinned ones when they are released
+      for (SPage *pPage = pShard->clock.pLruNext; !pPage->isAnchor;) {
+        SPage *pNext = pPage->pLruNext;
+        if (pPage->id >= nPage && tdbGetPageRef(pPage) == 0) {
+          tdbPCacheRemovePageFromHash(pCache, pShard, pPage);
+          pCache->aPage[pPage->id] = NULL;
+          tdbPageDestroy(pPage, tdbDefaultFree, NULL);
+        }
+        pPage = pNext;
       }
     }
   }
@@ -158,27 +291,28 @@ static int tdbPCacheAlterImpl(SPCache *pCache, int32_t nPage) {
 int tdbPCacheAlter(SPCache *pCache, int32_t nPage) {
   int ret = 0;
 
-  tdbPCacheLock(pCache);
+  tdbPCacheLockAll(pCache);
 
   ret = tdbPCacheAlterImpl(pCache, nPage);
 
-  tdbPCacheUnlock(pCache);
+  tdbPCacheUnlockAll(pCache);
 
   return ret;
 }
 
 SPage *tdbPCacheFetch(SPCache *pCache, const SPgid *pPgid, TXN *pTxn) {
-  SPage *pPage;
-  i32    nRef = 0;
+  SPCacheShard *pShard = tdbPCacheGetShard(pCache, pPgid);
+  SPage        *pPage;
+  i32           nRef = 0;
 
-  tdbPCacheLock(pCache);
+  tdbPCacheLock(pShard);
 
-  pPage = tdbPCacheFetchImpl(pCache, pPgid, pTxn);
+  pPage = tdbPCacheFetchImpl(pCache, pShard, pPgid, pTxn);
   if (pPage) {
     nRef = tdbRefPage(pPage);
   }
 
-  tdbPCacheUnlock(pCache);
+  tdbPCacheUnlock(pShard);
 
   // printf("thread %" PRId64 " fetch page %d pgno %d pPage %p nRef %d\n", taosGetSelfPthreadId(), pPage->id,
   //        TDB_PAGE_PGNO(pPage), pPage, nRef);
@@ -193,63 +327,69 @@ SPage *tdbPCacheFetch(SPCache *pCache, const SPgid *pPgid, TXN *pTxn) {
 }
 
 void tdbPCacheMarkFree(SPCache *pCache, SPage *pPage) {
-  tdbPCacheLock(pCache);
-  tdbPCacheRemovePageFromHash(pCache, pPage);
+  SPCacheShard *pShard = tdbPCacheGetShard(pCache, &pPage->pgid);
+
+  tdbPCacheLock(pShard);
+  tdbPCacheRemovePageFromHash(pCache, pShard, pPage);
   pPage->isFree = 1;
-  tdbPCacheUnlock(pCache);
+  tdbPCacheUnlock(pShard);
 }
 
-static void tdbPCacheFreePage(SPCache *pCache, SPage *pPage) {
+static void tdbPCacheFreePage(SPCache *pCache, SPCacheShard *pShard, SPage *pPage) {
   if (pPage->id < pCache->nPages) {
-    pPage->pFreeNext = pCache->pFree;
-    pCache->pFree = pPage;
+    pPage->pFreeNext = pShard->pFree;
+    pShard->pFree = pPage;
     pPage->isFree = 0;
-    ++pCache->nFree;
+    ++pShard->nFree;
     tdbTrace("pcache/free page %p/%d, pgno:%d, ", pPage, pPage->id, TDB_PAGE_PGNO(pPage));
   } else {
     tdbTrace("pcache/free2 page: %p/%d, pgno:%d, ", pPage, pPage->id, TDB_PAGE_PGNO(pPage));
 
-    tdbPCacheRemovePageFromHash(pCache, pPage);
+    tdbPCacheRemovePageFromHash(pCache, pShard, pPage);
     tdbPageDestroy(pPage, tdbDefaultFree, NULL);
   }
 }
 
 void tdbPCacheInvalidatePage(SPCache *pCache, SPager *pPager, SPgno pgno) {
-  SPgid        pgid;
-  const SPgid *pPgid = &pgid;
-  SPage       *pPage = NULL;
+  SPgid         pgid;
+  const SPgid  *pPgid = &pgid;
+  SPage        *pPage = NULL;
+  SPCacheShard *pShard;
 
   memcpy(&pgid, pPager->fid, TDB_FILE_ID_LEN);
   pgid.pgno = pgno;
 
-  pPage = pCache->pgHash[tdbPCachePageHash(pPgid) % pCache->nHash];
+  pShard = tdbPCacheGetShard(pCache, pPgid);
+  tdbPCacheLock(pShard);
+
+  pPage = pShard->pgHash[tdbPCacheBucket(pCache, pShard, pPgid)];
   while (pPage) {
     if (pPage->pgid.pgno == pPgid->pgno && memcmp(pPage->pgid.fileid, pPgid->fileid, TDB_FILE_ID_LEN) == 0) break;
     pPage = pPage->pHashNext;
   }
 
   if (pPage) {
-    bool moveToFreeList = false;
-    if (pPage->pLruNext) {
-      tdbPCachePinPage(pCache, pPage);
-      moveToFreeList = true;
-    }
-    tdbPCacheRemovePageFromHash(pCache, pPage);
+    bool moveToFreeList = pPage->isLocal && tdbGetPageRef(pPage) == 0;
+    tdbPCacheRemovePageFromHash(pCache, pShard, pPage);
     if (moveToFreeList) {
-      tdbPCacheFreePage(pCache, pPage);
+      tdbPCacheFreePage(pCache, pShard, pPage);
     }
   }
+
+  tdbPCacheUnlock(pShard);
 }
 
 void tdbPCacheRelease(SPCache *pCache, SPage *pPage, TXN *pTxn) {
-  i32 nRef;
+  SPCacheShard *pShard;
+  i32           nRef;
 
   if (!pTxn) {
     tdbError("tdb/pcache: null ptr pTxn, release failed.");
     return;
   }
 
-  tdbPCacheLock(pCache);
+  pShard = tdbPCacheGetShard(pCache, &pPage->pgid);
+  tdbPCacheLock(pShard);
   nRef = tdbUnrefPage(pPage);
   tdbTrace("pcache/release page %p/%d/%d/%d", pPage, TDB_PAGE_PGNO(pPage), pPage->id, nRef);
   if (nRef == 0) {
@@ -259,26 +399,26 @@ void tdbPCacheRelease(SPCache *pCache, SPage *pPage, TXN *pTxn) {
     // if (nRef == 0) {
     if (pPage->isLocal) {
       if (!pPage->isFree) {
-        tdbPCacheUnpinPage(pCache, pPage);
+        tdbPCacheUnpinPage(pCache, pShard, pPage);
       } else {
-        tdbPCacheFreePage(pCache, pPage);
+        tdbPCacheFreePage(pCache, pShard, pPage);
       }
     } else {
       if (TDB_TXN_IS_WRITE(pTxn)) {
         // remove from hash
-        tdbPCacheRemovePageFromHash(pCache, pPage);
+        tdbPCacheRemovePageFromHash(pCache, pShard, pPage);
       }
 
       tdbPageDestroy(pPage, pTxn->xFree, pTxn->xArg);
     }
     // }
   }
-  tdbPCacheUnlock(pCache);
+  tdbPCacheUnlock(pShard);
 }
 
 int tdbPCacheGetPageSize(SPCache *pCache) { return pCache->szPage; }
 
-static SPage *tdbPCacheFetchImpl(SPCache *pCache, const SPgid *pPgid, TXN *pTxn) {
+static SPage *tdbPCacheFetchImpl(SPCache *pCache, SPCacheShard *pShard, const SPgid *pPgid, TXN *pTxn) {
   int    ret = 0;
   SPage *pPage = NULL;
   SPage *pPageH = NULL;
@@ -289,7 +429,7 @@ static SPage *tdbPCacheFetchImpl(SPCache *pCache, const SPgid *pPgid, TXN *pTxn)
   }
 
   // 1. Search the hash table
-  pPage = pCache->pgHash[tdbPCachePageHash(pPgid) % pCache->nHash];
+  pPage = pShard->pgHash[tdbPCacheBucket(pCache, pShard, pPgid)];
   while (pPage) {
     if (pPage->pgid.pgno == pPgid->pgno && memcmp(pPage->pgid.fileid, pPgid->fileid, TDB_FILE_ID_LEN) == 0) break;
     pPage = pPage->pHashNext;
@@ -297,7 +437,7 @@ static SPage *tdbPCacheFetchImpl(SPCache *pCache, const SPgid *pPgid, TXN *pTxn)
 
   if (pPage) {
     if (pPage->isLocal || TDB_TXN_IS_WRITE(pTxn)) {
-      tdbPCachePinPage(pCache, pPage);
+      pPage->isRecent = 1;
       return pPage;
     }
   }
@@ -308,18 +448,16 @@ static SPage *tdbPCacheFetchImpl(SPCache *pCache, const SPgid *pPgid, TXN *pTxn)
   pPage = NULL;
 
   // 2. Try to allocate a new page from the free list
-  if (pCache->pFree) {
-    pPage = pCache->pFree;
-    pCache->pFree = pPage->pFreeNext;
-    pCache->nFree--;
-    pPage->pLruNext = NULL;
-  }
+  pPage = tdbPCacheGetFree(pShard);
 
   // 3. Try to Recycle a page
-  if (!pPageH && !pPage && !pCache->lru.pLruPrev->isAnchor) {
-    pPage = pCache->lru.pLruPrev;
-    tdbPCacheRemovePageFromHash(pCache, pPage);
-    tdbPCachePinPage(pCache, pPage);
+  if (!pPageH && !pPage) {
+    pPage = tdbPCacheClockEvict(pCache, pShard);
+  }
+
+  // 3.1 Try to take a page from other shards
+  if (!pPage && pCache->nShard > 1) {
+    pPage = tdbPCacheStealPage(pCache, pShard, !pPageH);
   }
 
   // 4. Try a create new page
@@ -371,7 +509,7 @@ static SPage *tdbPCacheFetchImpl(SPCache *pCache, const SPgid *pPgid, TXN *pTxn)
       pPage->pPager = NULL;
 
       if (pPage->isLocal || TDB_TXN_IS_WRITE(pTxn)) {
-        tdbPCacheAddPageToHash(pCache, pPage);
+        tdbPCacheAddPageToHash(pCache, pShard, pPage);
       }
     }
   }
@@ -379,25 +517,7 @@ static SPage *tdbPCacheFetchImpl(SPCache *pCache, const SPgid *pPgid, TXN *pTxn)
   return pPage;
 }
 
-static void tdbPCachePinPage(SPCache *pCache, SPage *pPage) {
-  if (pPage->pLruNext != NULL) {
-    int32_t nRef = tdbGetPageRef(pPage);
-    if (nRef != 0) {
-      tdbError("tdb/pcache: pin page's ref not zero: %" PRId32, nRef);
-      return;
-    }
-
-    pPage->pLruPrev->pLruNext = pPage->pLruNext;
-    pPage->pLruNext->pLruPrev = pPage->pLruPrev;
-    pPage->pLruNext = NULL;
-
-    pCache->nRecyclable--;
-
-    tdbTrace("pcache/pin page %p/%d, pgno:%d, ", pPage, pPage->id, TDB_PAGE_PGNO(pPage));
-  }
-}
-
-static void tdbPCacheUnpinPage(SPCache *pCache, SPage *pPage) {
+static void tdbPCacheUnpinPage(SPCache *pCache, SPCacheShard *pShard, SPage *pPage) {
   i32 nRef = tdbGetPageRef(pPage);
   if (nRef != 0) {
     tdbError("tdb/pcache: unpin page's ref not zero: %" PRId32, nRef);
@@ -411,54 +531,54 @@ static void tdbPCacheUnpinPage(SPCache *pCache, SPage *pPage) {
     tdbError("tdb/pcache: unpin page's dirty: %" PRIu8, pPage->isDirty);
     return;
   }
-  if (NULL != pPage->pLruNext) {
-    tdbError("tdb/pcache: unpin page's pLruNext not null.");
-    return;
-  }
 
   tdbTrace("pCache:%p unpin page %p/%d, nPages:%d, pgno:%d, ", pCache, pPage, pPage->id, pCache->nPages,
            TDB_PAGE_PGNO(pPage));
-  if (pPage->id < pCache->nPages) {
-    pPage->pLruPrev = &(pCache->lru);
-    pPage->pLruNext = pCache->lru.pLruNext;
-    pCache->lru.pLruNext->pLruPrev = pPage;
-    pCache->lru.pLruNext = pPage;
-
-    pCache->nRecyclable++;
-
-    // printf("unpin page %d pgno %d pPage %p\n", pPage->id, TDB_PAGE_PGNO(pPage), pPage);
-    tdbTrace("pcache/unpin page %p/%d/%d", pPage, TDB_PAGE_PGNO(pPage), pPage->id);
-  } else {
+  if (pPage->id >= pCache->nPages) {
     tdbTrace("pcache destroy page: %p/%d/%d", pPage, TDB_PAGE_PGNO(pPage), pPage->id);
 
-    tdbPCacheRemovePageFromHash(pCache, pPage);
+    tdbPCacheRemovePageFromHash(pCache, pShard, pPage);
     tdbPageDestroy(pPage, tdbDefaultFree, NULL);
+  } else if (pPage->pLruNext == NULL) {
+    // dropped from the hash while pinned, nothing can find it any more
+    tdbPCacheFreePage(pCache, pShard, pPage);
+  } else {
+    // stays on the clock ring, the hand decides when it is recycled
+    tdbTrace("pcache/unpin page %p/%d/%d", pPage, TDB_PAGE_PGNO(pPage), pPage->id);
   }
 }
 
-static void tdbPCacheRemovePageFromHash(SPCache *pCache, SPage *pPage) {
-  uint32_t h = tdbPCachePageHash(&(pPage->pgid)) % pCache->nHash;
+static void tdbPCacheRemovePageFromHash(SPCache *pCache, SPCacheShard *pShard, SPage *pPage) {
+  uint32_t h = tdbPCacheBucket(pCache, pShard, &(pPage->pgid));
 
-  SPage **ppPage = &(pCache->pgHash[h]);
+  SPage **ppPage = &(pShard->pgHash[h]);
   for (; (*ppPage) && *ppPage != pPage; ppPage = &((*ppPage)->pHashNext))
     ;
 
   if (*ppPage) {
     *ppPage = pPage->pHashNext;
-    pCache->nPage--;
+    pShard->nPage--;
     // printf("rmv page %d to hash, pgno %d, pPage %p\n", pPage->id, TDB_PAGE_PGNO(pPage), pPage);
   }
 
+  if (pPage->isLocal) {
+    tdbPCacheClockRemove(pShard, pPage);
+  }
+
   tdbTrace("pcache/remove page %p/%d from hash %" PRIu32 " pgno:%d, ", pPage, pPage->id, h, TDB_PAGE_PGNO(pPage));
 }
 
-static void tdbPCacheAddPageToHash(SPCache *pCache, SPage *pPage) {
-  uint32_t h = tdbPCachePageHash(&(pPage->pgid)) % pCache->nHash;
+static void tdbPCacheAddPageToHash(SPCache *pCache, SPCacheShard *pShard, SPage *pPage) {
+  uint32_t h = tdbPCacheBucket(pCache, pShard, &(pPage->pgid));
+
+  pPage->pHashNext = pShard->pgHash[h];
+  pShard->pgHash[h] = pPage;
 
-  pPage->pHashNext = pCache->pgHash[h];
-  pCache->pgHash[h] = pPage;
+  pShard->nPage++;
 
-  pCache->nPage++;
+  if (pPage->isLocal) {
+    tdbPCacheClockAdd(pShard, pPage);
+  }
 
   tdbTrace("pcache/add page %p/%d to hash %" PRIu32 " pgno:%d, ", pPage, pPage->id, h, TDB_PAGE_PGNO(pPage));
 }
@@ -469,12 +589,31 @@ static int tdbPCacheOpenImpl(SPCache *pCache) {
   int    tsize;
   int    ret;
 
-  tdbPCacheInitLock(pCache);
+  for (int iShard = 0; iShard < pCache->nShard; iShard++) {
+    SPCacheShard *pShard = &pCache->aShard[iShard];
+
+    tdbPCacheInitLock(pShard);
+
+    // Open the hash table
+    pShard->nPage = 0;
+    pShard->nHash = pCache->nPages / pCache->nShard < 8 ? 8 : pCache->nPages / pCache->nShard;
+    pShard->pgHash = (SPage **)tdbOsCalloc(pShard->nHash, sizeof(SPage *));
+    if (pShard->pgHash == NULL) {
+      // TODO
+      return -1;
+    }
+
+    // Open the clock ring
+    pShard->clock.isAnchor = 1;
+    pShard->clock.pLruNext = &(pShard->clock);
+    pShard->clock.pLruPrev = &(pShard->clock);
+    pShard->pHand = &(pShard->clock);
+  }
 
-  // Open the free list
-  pCache->nFree = 0;
-  pCache->pFree = NULL;
+  // Open the free lists, local pages are spread over the shards
   for (int i = 0; i < pCache->nPages; i++) {
+    SPCacheShard *pShard = &pCache->aShard[i & (pCache->nShard - 1)];
+
     if (tdbPageCreate(pCache->szPage, &pPage, tdbDefaultMalloc, NULL) < 0) {
       // TODO: handle error
       return -1;
@@ -490,50 +629,39 @@ static int tdbPCacheOpenImpl(SPCache *pCache) {
     pPage->pDirtyNext = NULL;
 
     // add page to free list
-    pPage->pFreeNext = pCache->pFree;
-    pCache->pFree = pPage;
-    pCache->nFree++;
+    pPage->pFreeNext = pShard->pFree;
+    pShard->pFree = pPage;
+    pShard->nFree++;
 
     // add to local list
     pPage->id = i;
     pCache->aPage[i] = pPage;
   }
 
-  // Open the hash table
-  pCache->nPage = 0;
-  pCache->nHash = pCache->nPages < 8 ? 8 : pCache->nPages;
-  pCache->pgHash = (SPage **)tdbOsCalloc(pCache->nHash, sizeof(SPage *));
-  if (pCache->pgHash == NULL) {
-    // TODO
-    return -1;
-  }
-
-  // Open LRU list
-  pCache->nRecyclable = 0;
-  pCache->lru.isAnchor = 1;
-  pCache->lru.pLruNext = &(pCache->lru);
-  pCache->lru.pLruPrev = &(pCache->lru);
-
   return 0;
 }
 
 static int tdbPCacheCloseImpl(SPCache *pCache) {
-  // free free page
-  for (SPage *pPage = pCache->pFree; pPage;) {
-    SPage *pPageT = pPage->pFreeNext;
-    tdbPageDestroy(pPage, tdbDefaultFree, NULL);
-    pPage = pPageT;
-  }
+  for (int iShard = 0; iShard < pCache->nShard; iShard++) {
+    SPCacheShard *pShard = &pCache->aShard[iShard];
 
-  for (int32_t iBucket = 0; iBucket < pCache->nHash; iBucket++) {
-    for (SPage *pPage = pCache->pgHash[iBucket]; pPage;) {
-      SPage *pPageT = pPage->pHashNext;
+    // free free page
+    for (SPage *pPage = pShard->pFree; pPage;) {
+      SPage *pPageT = pPage->pFreeNext;
       tdbPageDestroy(pPage, tdbDefaultFree, NULL);
       pPage = pPageT;
     }
-  }
 
-  tdbOsFree(pCache->pgHash);
-  tdbPCacheDestroyLock(pCache);
+    for (int32_t iBucket = 0; iBucket < pShard->nHash; iBucket++) {
+      for (SPage *pPage = pShard->pgHash[iBucket]; pPage;) {
+        SPage *pPageT = pPage->pHashNext;
+        tdbPageDestroy(pPage, tdbDefaultFree, NULL);
+        pPage = pPageT;
+      }
+    }
+
+    tdbOsFree(pShard->pgHash);
+    tdbPCacheDestroyLock(pShard);
+  }
   return 0;
 }
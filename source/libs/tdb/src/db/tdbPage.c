@@ -468,10 +468,9 @@ static int tdbPageFree(SPage *pPage, int idx, SCell *pCell, int szCell) {
       cellFree = TDB_PAGE_FCELL(pPage);
       pPage->pPageMethods->setFreeCellInfo(pCell, szCell, cellFree);
       TDB_PAGE_FCELL_SET(pPage, pCell - pPage->pData);
-    } else {
-      tdbError("tdb/page-free: invalid cell size: %d", szCell);
-      return -1;
     }
+    // a cell too small for the free list, such as a suffix cell of a prefix compressed leaf, is left as a fragment
+    // like the remainder of an allocation, defragment takes it back
   }
 
   dest = pPage->pCellIdx + TDB_PAGE_OFFSET_SIZE(pPage) * idx;
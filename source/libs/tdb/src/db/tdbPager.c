@@ -145,6 +145,10 @@ static int tdbPagerInitPage(SPager *pPager, SPage *pPage, int (*initPage)(SPage
                             u8 loadPage);
 static int tdbPagerWritePageToJournal(SPager *pPager, SPage *pPage);
 static int tdbPagerPWritePageToDB(SPager *pPager, SPage *pPage);
+static int tdbPagerKeepImage(SPager *pPager, SPage *pPage);
+static int tdbPagerFetchSnapPage(SPager *pPager, SPgno pgno, SPage **ppPage, int (*initPage)(SPage *, void *, int),
+                                 void *arg, TXN *pTxn);
+static void tdbPagerFreeImages(SPager *pPager);
 
 static FORCE_INLINE int32_t pageCmpFn(const SRBTreeNode *lhs, const SRBTreeNode *rhs) {
   SPage *pPageL = (SPage *)(((uint8_t *)lhs) - offsetof(SPage, node));
@@ -227,6 +231,7 @@ int tdbPagerClose(SPager *pPager) {
     }
     */
     tdbOsClose(pPager->fd);
+    tdbPagerFreeImages(pPager);
     tdbOsFree(pPager);
   }
   return 0;
@@ -236,6 +241,11 @@ int tdbPagerWrite(SPager *pPager, SPage *pPage) {
   int     ret;
   SPage **ppPage;
 
+  // snapshots opened before the page changes still read its image
+  if (tdbPagerKeepImage(pPager, pPage) < 0) {
+    return -1;
+  }
+
   if (pPage->isDirty) return 0;
 
   // ref page one more time so the page will not be release
@@ -711,6 +721,10 @@ int tdbPagerFetchPage(SPager *pPager, SPgno *ppgno, SPage **ppPage, int (*initPa
   pgno = *ppgno;
   loadPage = 1;
 
+  if (TDB_TXN_IS_SNAPSHOT(pTxn)) {
+    return tdbPagerFetchSnapPage(pPager, pgno, ppPage, initPage, arg, pTxn);
+  }
+
   // alloc new page
   if (pgno == 0) {
     loadPage = 0;
@@ -741,6 +755,11 @@ int tdbPagerFetchPage(SPager *pPager, SPgno *ppgno, SPage **ppPage, int (*initPa
       tdbError("tdb/pager: %p, pPage: %p, init page failed.", pPager, pPage);
       return -1;
     }
+
+    // no snapshot reaches a page allocated now, a recycled one had its image kept when it was freed
+    if (!loadPage) {
+      pPage->snapVer = atomic_load_64(&pPager->pEnv->snapVer) + 1;
+    }
   }
 
   // printf("thread %" PRId64 " pager fetch page %d pgno %d ppage %p\n", taosGetSelfPthreadId(), pPage->id,
@@ -770,6 +789,11 @@ int tdbPagerInsertFreePage(SPager *pPager, SPage *pPage, TXN *pTxn) {
   int   code = 0;
   SPgno pgno = TDB_PAGE_PGNO(pPage);
 
+  // the page is overwritten once it is allocated again, snapshots may still reach it from older parents
+  if (tdbPagerKeepImage(pPager, pPage) < 0) {
+    return -1;
+  }
+
   if (pPager->frps) {
     taosArrayPush(pPager->frps, &pgno);
     pPage->pPager = NULL;
@@ -910,6 +934,7 @@ static int tdbPagerInitPage(SPager *pPager, SPage *pPage, int (*initPage)(SPage
     }
 
     pgno = TDB_PAGE_PGNO(pPage);
+    pPage->snapVer = 0;
 
     tdbTrace("tdb/pager:%p, pgno:%d, loadPage:%d, size:%d", pPager, pgno, loadPage, pPager->dbOrigSize);
     if (loadPage && pgno <= pPager->dbOrigSize) {
@@ -1231,3 +1256,243 @@ int tdbPagerRollback(SPager *pPager) {
 
   return 0;
 }
+
+// ---------------------------- Read snapshot
+#define TDB_PAGER_IMG_FREE_MAX 64
+
+static FORCE_INLINE SPgImg **tdbPagerImgBucket(SPager *pPager, SPgno pgno) {
+  return &pPager->imgHash[pgno & (pPager->nImgHash - 1)];
+}
+
+static int tdbPagerGrowImgHash(SPager *pPager) {
+  int      nImgHash = pPager->nImgHash ? pPager->nImgHash * 2 : 1024;
+  SPgImg **imgHash = tdbOsCalloc(nImgHash, sizeof(SPgImg *));
+  if (imgHash == NULL) {
+    terrno = TSDB_CODE_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  for (int i = 0; i < pPager->nImgHash; i++) {
+    SPgImg *pNext = NULL;
+    for (SPgImg *pImg = pPager->imgHash[i]; pImg; pImg = pNext) {
+      pNext = pImg->pHashNext;
+      pImg->pHashNext = imgHash[pImg->pgno & (nImgHash - 1)];
+      imgHash[pImg->pgno & (nImgHash - 1)] = pImg;
+    }
+  }
+
+  tdbOsFree(pPager->imgHash);
+  pPager->imgHash = imgHash;
+  pPager->nImgHash = nImgHash;
+  return 0;
+}
+
+// keep the page as it was at the last published version, before the writer changes it for the first time since
+static int tdbPagerKeepImage(SPager *pPager, SPage *pPage) {
+  TDB    *pEnv = pPager->pEnv;
+  SPgno   pgno = TDB_PAGE_PGNO(pPage);
+  SPgImg *pImg = NULL;
+  i64     ver;
+
+  if (!pEnv->snapEnabled) {
+    return 0;
+  }
+
+  // the next publish makes a new version even if the page already has its image
+  if (!pEnv->snapChanged) {
+    atomic_store_8(&pEnv->snapChanged, 1);
+  }
+
+  if (pPage->snapVer > atomic_load_64(&pEnv->snapVer)) {
+    return 0;
+  }
+
+  // no snapshot can read an image if none is open. Snapshots stop beginning before the page is changed, a snapshot
+  // that began in between is seen on the second look.
+  if (atomic_load_ptr(&pEnv->pSnapHead) == NULL) {
+    if (!pEnv->snapUnkept) {
+      atomic_store_8(&pEnv->snapUnkept, 1);
+    }
+    if (atomic_load_ptr(&pEnv->pSnapHead) == NULL) {
+      return 0;
+    }
+  }
+
+  tdbRwlockWrlock(&pEnv->snapLock);
+  ver = pEnv->snapVer;
+
+  if (pPager->nImg >= pPager->nImgHash && tdbPagerGrowImgHash(pPager) < 0) {
+    goto _err;
+  }
+
+  for (pImg = *tdbPagerImgBucket(pPager, pgno); pImg; pImg = pImg->pHashNext) {
+    if (pImg->pgno == pgno && pImg->ver == ver) break;
+  }
+
+  if (pImg == NULL) {
+    if (pPager->pImgFree) {
+      pImg = pPager->pImgFree;
+      pPager->pImgFree = pImg->pNext;
+      pPager->nImgFree--;
+    } else {
+      pImg = tdbOsMalloc(sizeof(*pImg) + pPager->pageSize);
+      if (pImg == NULL) {
+        terrno = TSDB_CODE_OUT_OF_MEMORY;
+        goto _err;
+      }
+      pImg->pData = (u8 *)(pImg + 1);
+    }
+
+    pImg->pgno = pgno;
+    pImg->ver = ver;
+    memcpy(pImg->pData, pPage->pData, pPager->pageSize);
+
+    SPgImg **ppBucket = tdbPagerImgBucket(pPager, pgno);
+    pImg->pHashNext = *ppBucket;
+    *ppBucket = pImg;
+
+    pImg->pNext = NULL;
+    if (pPager->pImgTail) {
+      pPager->pImgTail->pNext = pImg;
+    } else {
+      pPager->pImgHead = pImg;
+    }
+    pPager->pImgTail = pImg;
+    pPager->nImg++;
+  }
+
+  tdbRwlockUnlock(&pEnv->snapLock);
+
+  pPage->snapVer = ver + 1;
+  return 0;
+
+_err:
+  tdbRwlockUnlock(&pEnv->snapLock);
+  tdbError("tdb/pager: %p, pgno: %" PRIu32 ", keep page image failed since %s.", pPager, pgno, tstrerror(terrno));
+  return -1;
+}
+
+// the oldest image still holding the page at version ver, NULL if the page has not changed since
+static SPgImg *tdbPagerFindImage(SPager *pPager, SPgno pgno, i64 ver) {
+  SPgImg *pFound = NULL;
+
+  if (pPager->nImgHash == 0) {
+    return NULL;
+  }
+
+  for (SPgImg *pImg = *tdbPagerImgBucket(pPager, pgno); pImg; pImg = pImg->pHashNext) {
+    if (pImg->pgno == pgno && pImg->ver >= ver && (pFound == NULL || pImg->ver < pFound->ver)) {
+      pFound = pImg;
+    }
+  }
+
+  return pFound;
+}
+
+void tdbPagerDropImages(SPager *pPager, i64 ver) {
+  SPgImg  *pImg;
+  SPgImg **ppImg;
+
+  // images are taken in version order
+  while ((pImg = pPager->pImgHead) != NULL && pImg->ver < ver) {
+    pPager->pImgHead = pImg->pNext;
+    if (pPager->pImgHead == NULL) {
+      pPager->pImgTail = NULL;
+    }
+
+    for (ppImg = tdbPagerImgBucket(pPager, pImg->pgno); *ppImg != pImg; ppImg = &((*ppImg)->pHashNext)) {
+    }
+    *ppImg = pImg->pHashNext;
+    pPager->nImg--;
+
+    if (pPager->nImgFree < TDB_PAGER_IMG_FREE_MAX) {
+      pImg->pNext = pPager->pImgFree;
+      pPager->pImgFree = pImg;
+      pPager->nImgFree++;
+    } else {
+      tdbOsFree(pImg);
+    }
+  }
+}
+
+static void tdbPagerFreeImages(SPager *pPager) {
+  SPgImg *pImg;
+
+  while ((pImg = pPager->pImgHead) != NULL) {
+    pPager->pImgHead = pImg->pNext;
+    tdbOsFree(pImg);
+  }
+  while ((pImg = pPager->pImgFree) != NULL) {
+    pPager->pImgFree = pImg->pNext;
+    tdbOsFree(pImg);
+  }
+
+  tdbOsFree(pPager->imgHash);
+  pPager->imgHash = NULL;
+  pPager->nImgHash = 0;
+  pPager->nImg = 0;
+  pPager->nImgFree = 0;
+  pPager->pImgTail = NULL;
+}
+
+// a snapshot txn reads a private copy of the page, taken from its image if the writer changed the page since
+static int tdbPagerFetchSnapPage(SPager *pPager, SPgno pgno, SPage **ppPage, int (*initPage)(SPage *, void *, int),
+                                 void *arg, TXN *pTxn) {
+  TDB    *pEnv = pPager->pEnv;
+  SPage  *pLive = NULL;
+  SPage  *pPage;
+  SPgImg *pImg;
+  SPgid   pgid;
+
+  if (pgno == 0) {
+    tdbError("tdb/pager: %p, snapshot txn can not alloc page.", pPager);
+    return -1;
+  }
+
+  if (tdbPageCreate(pPager->pageSize, &pPage, pTxn->xMalloc, pTxn->xArg) < 0) {
+    return -1;
+  }
+  pPage->isLocal = 0;
+  pPage->id = -1;
+  memcpy(&pgid, pPager->fid, TDB_FILE_ID_LEN);
+  pgid.pgno = pgno;
+  memcpy(&(pPage->pgid), &pgid, sizeof(pgid));
+
+  // the writer keeps the image before it changes or frees a page, and it can not do so while the lock is read
+  // locked, so the live page is only touched when it is the same as at the snapshot version
+  tdbRwlockRdlock(&pEnv->snapLock);
+  if (pTxn->snapAborted) {
+    tdbRwlockUnlock(&pEnv->snapLock);
+    tdbPageDestroy(pPage, pTxn->xFree, pTxn->xArg);
+    terrno = TSDB_CODE_TDB_SNAPSHOT_ABORTED;
+    return -1;
+  }
+  pImg = tdbPagerFindImage(pPager, pgno, pTxn->snapVer);
+  if (pImg == NULL) {
+    pLive = tdbPCacheFetch(pPager->pCache, &pgid, pTxn);
+    if (pLive == NULL || (!TDB_PAGE_INITIALIZED(pLive) && tdbPagerInitPage(pPager, pLive, initPage, arg, 1) < 0)) {
+      tdbRwlockUnlock(&pEnv->snapLock);
+      tdbError("tdb/pager: %p, pgno: %" PRIu32 ", fetch snapshot page failed.", pPager, pgno);
+      if (pLive) tdbPagerReturnPage(pPager, pLive, pTxn);
+      tdbPageDestroy(pPage, pTxn->xFree, pTxn->xArg);
+      return -1;
+    }
+  }
+  memcpy(pPage->pData, pImg ? pImg->pData : pLive->pData, pPager->pageSize);
+  tdbRwlockUnlock(&pEnv->snapLock);
+
+  if (pLive) {
+    tdbPagerReturnPage(pPager, pLive, pTxn);
+  }
+
+  if ((*initPage)(pPage, arg, 1) < 0) {
+    tdbError("tdb/pager: %p, pgno: %" PRIu32 ", init snapshot page failed.", pPager, pgno);
+    tdbPageDestroy(pPage, pTxn->xFree, pTxn->xArg);
+    return -1;
+  }
+  pPage->pPager = pPager;
+  tdbRefPage(pPage);
+
+  *ppPage = pPage;
+  return 0;
+}
@@ -26,6 +26,12 @@ struct STBC {
 
 int tdbTbOpen(const char *tbname, int keyLen, int valLen, tdb_cmpr_fn_t keyCmprFn, TDB *pEnv, TTB **ppTb,
               int8_t rollback) {
+  return tdbTbOpenWithFlags(tbname, keyLen, valLen, keyCmprFn, pEnv, ppTb, rollback, 0);
+}
+
+// flags only take effect when the table is created, an existing table keeps the page format it was created with
+int tdbTbOpenWithFlags(const char *tbname, int keyLen, int valLen, tdb_cmpr_fn_t keyCmprFn, TDB *pEnv, TTB **ppTb,
+                       int8_t rollback, int32_t flags) {
   TTB    *pTb;
   SPager *pPager;
   int     ret;
@@ -116,7 +122,8 @@ int tdbTbOpen(const char *tbname, int keyLen, int valLen, tdb_cmpr_fn_t keyCmprF
   }
 
   // pTb->pBt
-  ret = tdbBtreeOpen(keyLen, valLen, pPager, tbname, pgno, keyCmprFn, pEnv, &(pTb->pBt));
+  ret = tdbBtreeOpen(keyLen, valLen, pPager, tbname, pgno, keyCmprFn,
+                     (flags & TDB_TB_PREFIX_KEY) ? TDB_BTREE_PREFIX_KEY : 0, pEnv, &(pTb->pBt));
   if (ret < 0) {
     tdbOsFree(pTb);
     return -1;
@@ -206,14 +213,30 @@ int tdbTbUpsert(TTB *pTb, const void *pKey, int kLen, const void *pVal, int vLen
   return tdbTbInsert(pTb, pKey, kLen, pVal, vLen, pTxn);
 }
 
+int tdbTbPutBatch(TTB *pTb, TKV *aKV, int32_t nKV, TXN *pTxn) { return tdbBtreePutBatch(pTb->pBt, aKV, nKV, pTxn); }
+
 int tdbTbGet(TTB *pTb, const void *pKey, int kLen, void **ppVal, int *vLen) {
   return tdbBtreeGet(pTb->pBt, pKey, kLen, ppVal, vLen);
 }
 
 int tdbTbPGet(TTB *pTb, const void *pKey, int kLen, void **ppKey, int *pkLen, void **ppVal, int *vLen) {
-  return tdbBtreePGet(pTb->pBt, pKey, kLen, ppKey, pkLen, ppVal, vLen);
+  return tdbBtreePGet(pTb->pBt, pKey, kLen, ppKey, pkLen, ppVal, vLen, NULL);
+}
+
+int tdbTbGetWithTxn(TTB *pTb, const void *pKey, int kLen, void **ppVal, int *vLen, TXN *pTxn) {
+  return tdbBtreePGet(pTb->pBt, pKey, kLen, NULL, NULL, ppVal, vLen, pTxn);
 }
 
+int tdbTbBulkOpen(TTB *pTb, int fillPct, TXN *pTxn, TBB **ppBulk) {
+  return tdbBtreeBulkOpen(pTb->pBt, fillPct, pTxn, ppBulk);
+}
+
+int tdbTbBulkAppend(TBB *pBulk, const void *pKey, int kLen, const void *pVal, int vLen) {
+  return tdbBtreeBulkAppend(pBulk, pKey, kLen, pVal, vLen);
+}
+
+int tdbTbBulkClose(TBB *pBulk, int8_t finish) { return tdbBtreeBulkClose(pBulk, finish); }
+
 int tdbTbcOpen(TTB *pTb, TBC **ppTbc, TXN *pTxn) {
   int  ret;
   TBC *pTbc = NULL;
@@ -103,6 +103,7 @@ typedef struct SPage   SPage;
 #define TDB_TXN_IS_WRITE(PTXN)            ((PTXN)->flags & TDB_TXN_WRITE)
 #define TDB_TXN_IS_READ(PTXN)             (!TDB_TXN_IS_WRITE(PTXN))
 #define TDB_TXN_IS_READ_UNCOMMITTED(PTXN) ((PTXN)->flags & TDB_TXN_READ_UNCOMMITTED)
+#define TDB_TXN_IS_SNAPSHOT(PTXN)         ((PTXN)->flags & TDB_TXN_SNAPSHOT)
 
 // tdbEnv.c ====================================
 void    tdbEnvAddPager(TDB *pEnv, SPager *pPager);
@@ -110,8 +111,9 @@ void    tdbEnvRemovePager(TDB *pEnv, SPager *pPager);
 SPager *tdbEnvGetPager(TDB *pEnv, const char *fname);
 
 // tdbBtree.c ====================================
-typedef struct SBTree SBTree;
-typedef struct SBTC   SBTC;
+typedef struct SBTree  SBTree;
+typedef struct SBTC    SBTC;
+typedef struct SBtBulk SBtBulk;
 typedef struct SBtInfo {
   SPgno root;
   int   nLevel;
@@ -155,14 +157,21 @@ struct SBTC {
 };
 
 // SBTree
-int tdbBtreeOpen(int keyLen, int valLen, SPager *pFile, char const *tbname, SPgno pgno, tdb_cmpr_fn_t kcmpr, TDB *pEnv,
-                 SBTree **ppBt);
+#define TDB_BTREE_PREFIX_KEY 0x1  // new btree keeps prefix compressed keys in its leaves, variable length keys only
+
+int tdbBtreeOpen(int keyLen, int valLen, SPager *pFile, char const *tbname, SPgno pgno, tdb_cmpr_fn_t kcmpr, int flags,
+                 TDB *pEnv, SBTree **ppBt);
 int tdbBtreeClose(SBTree *pBt);
 int tdbBtreeInsert(SBTree *pBt, const void *pKey, int kLen, const void *pVal, int vLen, TXN *pTxn);
 int tdbBtreeDelete(SBTree *pBt, const void *pKey, int kLen, TXN *pTxn);
 // int tdbBtreeUpsert(SBTree *pBt, const void *pKey, int nKey, const void *pData, int nData, TXN *pTxn);
+int tdbBtreePutBatch(SBTree *pBt, TKV *aKV, int nKV, TXN *pTxn);
 int tdbBtreeGet(SBTree *pBt, const void *pKey, int kLen, void **ppVal, int *vLen);
-int tdbBtreePGet(SBTree *pBt, const void *pKey, int kLen, void **ppKey, int *pkLen, void **ppVal, int *vLen);
+int tdbBtreePGet(SBTree *pBt, const void *pKey, int kLen, void **ppKey, int *pkLen, void **ppVal, int *vLen,
+                 TXN *pTxn);
+int tdbBtreeBulkOpen(SBTree *pBt, int fillPct, TXN *pTxn, SBtBulk **ppBulk);
+int tdbBtreeBulkAppend(SBtBulk *pBulk, const void *pKey, int kLen, const void *pVal, int vLen);
+int tdbBtreeBulkClose(SBtBulk *pBulk, int finish);
 
 typedef struct {
   u8      flags;
@@ -204,6 +213,8 @@ int  tdbPagerInsertFreePage(SPager *pPager, SPage *pPage, TXN *pTxn);
 // int  tdbPagerAllocPage(SPager *pPager, SPgno *ppgno);
 int tdbPagerRestoreJournals(SPager *pPager);
 int tdbPagerRollback(SPager *pPager);
+// read snapshot, called with pEnv->snapLock write locked
+void tdbPagerDropImages(SPager *pPager, i64 ver);
 
 // tdbPCache.c ====================================
 #define TDB_PCACHE_PAGE    \
@@ -211,6 +222,7 @@ int tdbPagerRollback(SPager *pPager);
   u8           isLocal;    \
   u8           isDirty;    \
   u8           isFree;     \
+  u8           isRecent;   \
   volatile i32 nRef;       \
   i32          id;         \
   SPage       *pFreeNext;  \
@@ -288,6 +300,7 @@ struct SPage {
   int       maxLocal;
   int       minLocal;
   int (*xCellSize)(const SPage *, SCell *, int, TXN *pTxn, SBTree *pBt);
+  i64 snapVer;  // the page has its image kept for the versions before this one
   // Fields used by SPCache
   TDB_PCACHE_PAGE
 };
@@ -395,6 +408,26 @@ struct STDB {
   int64_t txnId;
   int32_t encryptAlgorithm;
   char    encryptKey[ENCRYPT_KEY_LEN + 1];
+  // read snapshot
+  tdb_rwlock_t snapLock;  // write locked to change the versions and the images, read locked to read a page
+  int8_t       snapEnabled;
+  int8_t       snapChanged;  // pages were changed since the last published version
+  int8_t       snapUnkept;   // pages were changed without images while no snapshot was open, none can begin until the
+                             // next published version
+  int64_t      snapVer;      // the last published version
+  int64_t      snapGcVer;    // images older than this are dropped
+  TXN         *pSnapHead;    // open snapshots, the oldest first
+  TXN         *pSnapTail;
+};
+
+// the content of a page at versions (ver of the previous image of the page, ver], kept for read snapshots
+typedef struct SPgImg SPgImg;
+struct SPgImg {
+  SPgno   pgno;
+  i64     ver;
+  SPgImg *pHashNext;
+  SPgImg *pNext;
+  u8     *pData;
 };
 
 struct SPager {
@@ -417,6 +450,14 @@ struct SPager {
 #ifdef USE_MAINDB
   TDB *pEnv;
 #endif
+  // images kept for read snapshots, hashed by pgno and listed in the order they are taken
+  SPgImg **imgHash;
+  int      nImgHash;
+  int      nImg;
+  SPgImg  *pImgHead;
+  SPgImg  *pImgTail;
+  SPgImg  *pImgFree;
+  int      nImgFree;
 };
 
 #ifdef __cplusplus
@@ -84,6 +84,16 @@ typedef TdThreadMutex tdb_mutex_t;
 #define tdbMutexDestroy taosThreadMutexDestroy
 #define tdbMutexLock    taosThreadMutexLock
 #define tdbMutexUnlock  taosThreadMutexUnlock
+#define tdbMutexTryLock taosThreadMutexTryLock
+
+/* rwlock */
+typedef TdThreadRwlock tdb_rwlock_t;
+
+#define tdbRwlockInit    taosThreadRwlockInit
+#define tdbRwlockDestroy taosThreadRwlockDestroy
+#define tdbRwlockRdlock  taosThreadRwlockRdlock
+#define tdbRwlockWrlock  taosThreadRwlockWrlock
+#define tdbRwlockUnlock  taosThreadRwlockUnlock
 
 #else
 
@@ -142,6 +152,16 @@ typedef pthread_mutex_t tdb_mutex_t;
 #define tdbMutexDestroy pthread_mutex_destroy
 #define tdbMutexLock    pthread_mutex_lock
 #define tdbMutexUnlock  pthread_mutex_unlock
+#define tdbMutexTryLock pthread_mutex_trylock
+
+/* rwlock */
+typedef pthread_rwlock_t tdb_rwlock_t;
+
+#define tdbRwlockInit    pthread_rwlock_init
+#define tdbRwlockDestroy pthread_rwlock_destroy
+#define tdbRwlockRdlock  pthread_rwlock_rdlock
+#define tdbRwlockWrlock  pthread_rwlock_wrlock
+#define tdbRwlockUnlock  pthread_rwlock_unlock
 
 #endif
 
@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+
+#define ALLOW_FORBID_FUNC
+#include "os.h"
+#include "tdb.h"
+
+static int tDefaultKeyCmpr(const void *pKey1, int keyLen1, const void *pKey2, int keyLen2) {
+  int mlen = keyLen1 < keyLen2 ? keyLen1 : keyLen2;
+  int cret = memcmp(pKey1, pKey2, mlen);
+  if (cret == 0) {
+    cret = (keyLen1 < keyLen2) ? -1 : ((keyLen1 > keyLen2) ? 1 : 0);
+  }
+  return cret;
+}
+
+static void *testMalloc(void *arg, size_t size) { return taosMemoryMalloc(size); }
+static void  testFree(void *arg, void *ptr) { taosMemoryFree(ptr); }
+
+static void bulkLoad(TDB *pEnv, TTB *pDb, int nData, int fillPct) {
+  TXN *txn = NULL;
+  TBB *pBulk = NULL;
+  char key[32];
+  char val[64];
+
+  tdbBegin(pEnv, &txn, testMalloc, testFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+  GTEST_ASSERT_EQ(tdbTbBulkOpen(pDb, fillPct, txn, &pBulk), 0);
+  for (int i = 0; i < nData; i++) {
+    sprintf(key, "key%08d", i);
+    sprintf(val, "value%08d", i);
+    GTEST_ASSERT_EQ(tdbTbBulkAppend(pBulk, key, strlen(key), val, strlen(val)), 0);
+  }
+  GTEST_ASSERT_EQ(tdbTbBulkClose(pBulk, 1), 0);
+  tdbCommit(pEnv, txn);
+  tdbPostCommit(pEnv, txn);
+}
+
+static void checkData(TTB *pDb, int nData) {
+  TBC  *pTbc = NULL;
+  void *pKey = NULL;
+  void *pVal = NULL;
+  int   kLen, vLen;
+  char  key[32];
+  char  val[64];
+  int   count = 0;
+
+  for (int i = 0; i < nData; i++) {
+    sprintf(key, "key%08d", i);
+    sprintf(val, "value%08d", i);
+    GTEST_ASSERT_EQ(tdbTbGet(pDb, key, strlen(key), &pVal, &vLen), 0);
+    GTEST_ASSERT_EQ(vLen, (int)strlen(val));
+    GTEST_ASSERT_EQ(memcmp(pVal, val, vLen), 0);
+  }
+
+  GTEST_ASSERT_EQ(tdbTbcOpen(pDb, &pTbc, NULL), 0);
+  tdbTbcMoveToFirst(pTbc);
+  while (tdbTbcNext(pTbc, &pKey, &kLen, &pVal, &vLen) == 0) {
+    sprintf(key, "key%08d", count);
+    GTEST_ASSERT_EQ(kLen, (int)strlen(key));
+    GTEST_ASSERT_EQ(memcmp(pKey, key, kLen), 0);
+    count++;
+  }
+  tdbTbcClose(pTbc);
+  tdbFree(pKey);
+  tdbFree(pVal);
+
+  GTEST_ASSERT_EQ(count, nData);
+}
+
+TEST(TdbBulkLoadTest, LoadAndInsert) {
+  TDB *pEnv = NULL;
+  TTB *pDb = NULL;
+  TXN *txn = NULL;
+  int  nData = 100000;
+
+  taosRemoveDir("tdb_bulk");
+  GTEST_ASSERT_EQ(tdbOpen("tdb_bulk", 4096, 256, &pEnv, 0, 0, NULL), 0);
+  GTEST_ASSERT_EQ(tdbTbOpen("bulk.db", -1, -1, tDefaultKeyCmpr, pEnv, &pDb, 0), 0);
+
+  bulkLoad(pEnv, pDb, nData, 90);
+  checkData(pDb, nData);
+
+  // the loaded tree keeps working with the normal write path
+  tdbBegin(pEnv, &txn, testMalloc, testFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+  for (int i = nData; i < nData + 1000; i++) {
+    char key[32];
+    char val[64];
+    sprintf(key, "key%08d", i);
+    sprintf(val, "value%08d", i);
+    GTEST_ASSERT_EQ(tdbTbInsert(pDb, key, strlen(key), val, strlen(val), txn), 0);
+  }
+  tdbCommit(pEnv, txn);
+  tdbPostCommit(pEnv, txn);
+  checkData(pDb, nData + 1000);
+
+  tdbTbClose(pDb);
+  GTEST_ASSERT_EQ(tdbClose(pEnv), 0);
+  taosRemoveDir("tdb_bulk");
+}
+
+TEST(TdbBulkLoadTest, RejectUnsortedAndNonEmpty) {
+  TDB *pEnv = NULL;
+  TTB *pDb = NULL;
+  TXN *txn = NULL;
+  TBB *pBulk = NULL;
+
+  taosRemoveDir("tdb_bulk2");
+  GTEST_ASSERT_EQ(tdbOpen("tdb_bulk2", 4096, 64, &pEnv, 0, 0, NULL), 0);
+  GTEST_ASSERT_EQ(tdbTbOpen("bulk.db", -1, -1, tDefaultKeyCmpr, pEnv, &pDb, 0), 0);
+
+  tdbBegin(pEnv, &txn, testMalloc, testFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+  GTEST_ASSERT_EQ(tdbTbBulkOpen(pDb, 0, txn, &pBulk), 0);
+  GTEST_ASSERT_EQ(tdbTbBulkAppend(pBulk, "key2", 4, "v", 1), 0);
+  GTEST_ASSERT_NE(tdbTbBulkAppend(pBulk, "key1", 4, "v", 1), 0);
+  GTEST_ASSERT_EQ(tdbTbBulkClose(pBulk, 1), 0);
+  tdbCommit(pEnv, txn);
+  tdbPostCommit(pEnv, txn);
+
+  tdbBegin(pEnv, &txn, testMalloc, testFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+  GTEST_ASSERT_NE(tdbTbBulkOpen(pDb, 0, txn, &pBulk), 0);
+  tdbAbort(pEnv, txn);
+
+  tdbTbClose(pDb);
+  GTEST_ASSERT_EQ(tdbClose(pEnv), 0);
+  taosRemoveDir("tdb_bulk2");
+}
+
+static int bigValLen(int i) { return 3000 + (i * 997) % 9000; }
+
+static void bigVal(char *val, int i) {
+  int vLen = bigValLen(i);
+  for (int j = 0; j < vLen; j++) {
+    val[j] = 'a' + (i + j) % 26;
+  }
+}
+
+static void bulkLoadBig(TDB *pEnv, TTB *pDb, int nData, char *val) {
+  TXN *txn = NULL;
+  TBB *pBulk = NULL;
+  char key[32];
+
+  tdbBegin(pEnv, &txn, testMalloc, testFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+  GTEST_ASSERT_EQ(tdbTbBulkOpen(pDb, 90, txn, &pBulk), 0);
+  for (int i = 0; i < nData; i++) {
+    sprintf(key, "key%08d", i);
+    bigVal(val, i);
+    GTEST_ASSERT_EQ(tdbTbBulkAppend(pBulk, key, strlen(key), val, bigValLen(i)), 0);
+  }
+  GTEST_ASSERT_EQ(tdbTbBulkClose(pBulk, 1), 0);
+  tdbCommit(pEnv, txn);
+  tdbPostCommit(pEnv, txn);
+}
+
+TEST(TdbBulkLoadTest, OverflowValues) {
+  TDB    *pEnv = NULL;
+  TTB    *pDb = NULL;
+  TXN    *txn = NULL;
+  void   *pVal = NULL;
+  int     vLen;
+  char    key[32];
+  int     nData = 2000;
+  int64_t size1 = 0, size2 = 0;
+  char   *val = (char *)taosMemoryMalloc(12000);
+
+  taosRemoveDir("tdb_bulk3");
+  GTEST_ASSERT_EQ(tdbOpen("tdb_bulk3", 4096, 256, &pEnv, 0, 0, NULL), 0);
+  GTEST_ASSERT_EQ(tdbTbOpen("bulk.db", -1, -1, tDefaultKeyCmpr, pEnv, &pDb, 0), 0);
+
+  // every value spills into overflow pages, most of them over more than one
+  bulkLoadBig(pEnv, pDb, nData, val);
+  for (int i = 0; i < nData; i++) {
+    sprintf(key, "key%08d", i);
+    bigVal(val, i);
+    GTEST_ASSERT_EQ(tdbTbGet(pDb, key, strlen(key), &pVal, &vLen), 0);
+    GTEST_ASSERT_EQ(vLen, bigValLen(i));
+    GTEST_ASSERT_EQ(memcmp(pVal, val, vLen), 0);
+  }
+  tdbFree(pVal);
+  GTEST_ASSERT_EQ(taosStatFile("tdb_bulk3/main.tdb", &size1, NULL, NULL), 0);
+
+  // deleting the rows frees every page the load used, so loading them again only grows the file by the pages of the
+  // free list itself, an overflow chain left behind by a load is never freed
+  tdbBegin(pEnv, &txn, testMalloc, testFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+  for (int i = 0; i < nData; i++) {
+    sprintf(key, "key%08d", i);
+    GTEST_ASSERT_EQ(tdbTbDelete(pDb, key, strlen(key), txn), 0);
+  }
+  tdbCommit(pEnv, txn);
+  tdbPostCommit(pEnv, txn);
+
+  bulkLoadBig(pEnv, pDb, nData, val);
+  GTEST_ASSERT_EQ(taosStatFile("tdb_bulk3/main.tdb", &size2, NULL, NULL), 0);
+  GTEST_ASSERT_LE(size2, size1 + size1 / 100);
+
+  tdbTbClose(pDb);
+  GTEST_ASSERT_EQ(tdbClose(pEnv), 0);
+  taosRemoveDir("tdb_bulk3");
+  taosMemoryFree(val);
+}
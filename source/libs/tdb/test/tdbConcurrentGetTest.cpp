@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#define ALLOW_FORBID_FUNC
+#include "os.h"
+#include "tdb.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Readers look up random keys of one table concurrently through tdbTbGet (tdbBtreeGet), with a page cache smaller
+// than the table so lookups keep recycling pages. Reports lookups per ms for a growing number of readers.
+
+static const int kPageSize = 4096;
+static const int kCachePages = 256;
+static const int kNData = 200000;
+static const int kBenchMs = 2000;
+
+static int tDefaultKeyCmpr(const void *pKey1, int keyLen1, const void *pKey2, int keyLen2) {
+  int mlen = keyLen1 < keyLen2 ? keyLen1 : keyLen2;
+  int cret = memcmp(pKey1, pKey2, mlen);
+  if (cret == 0) {
+    cret = (keyLen1 < keyLen2) ? -1 : ((keyLen1 > keyLen2) ? 1 : 0);
+  }
+  return cret;
+}
+
+static void *benchMalloc(void *arg, size_t size) { return taosMemoryMalloc(size); }
+static void  benchFree(void *arg, void *ptr) { taosMemoryFree(ptr); }
+
+static void fillDb(TDB *pEnv, TTB *pDb) {
+  TXN *txn = NULL;
+  char key[32];
+  char val[64];
+
+  tdbBegin(pEnv, &txn, benchMalloc, benchFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+  for (int i = 0; i < kNData; i++) {
+    sprintf(key, "key%08d", i);
+    sprintf(val, "value%08d", i);
+    GTEST_ASSERT_EQ(tdbTbInsert(pDb, key, strlen(key), val, strlen(val), txn), 0);
+
+    if ((i + 1) % 10000 == 0) {
+      tdbCommit(pEnv, txn);
+      tdbPostCommit(pEnv, txn);
+      tdbBegin(pEnv, &txn, benchMalloc, benchFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+    }
+  }
+  tdbCommit(pEnv, txn);
+  tdbPostCommit(pEnv, txn);
+}
+
+static void reader(TTB *pDb, int seed, std::atomic<bool> *pStop, int64_t *pOps, int64_t *pErrs) {
+  char     key[32];
+  char     val[64];
+  uint32_t r = seed;
+  int64_t  ops = 0;
+  int64_t  errs = 0;
+  void    *pVal = NULL;
+  int      vLen = 0;
+
+  while (!pStop->load()) {
+    r = r * 1103515245 + 12345;
+    int i = (r >> 8) % kNData;
+    sprintf(key, "key%08d", i);
+    sprintf(val, "value%08d", i);
+
+    if (tdbTbGet(pDb, key, strlen(key), &pVal, &vLen) < 0 || vLen != (int)strlen(val) || memcmp(pVal, val, vLen) != 0) {
+      errs++;
+    }
+    ops++;
+  }
+
+  tdbFree(pVal);
+  *pOps = ops;
+  *pErrs = errs;
+}
+
+TEST(TdbConcurrentGetTest, DISABLED_ConcurrentGet) {
+  // TEST(TdbConcurrentGetTest, ConcurrentGet) {
+  TDB *pEnv = NULL;
+  TTB *pDb = NULL;
+
+  taosRemoveDir("tdb_cget");
+  GTEST_ASSERT_EQ(tdbOpen("tdb_cget", kPageSize, kCachePages, &pEnv, 0, 0, NULL), 0);
+  GTEST_ASSERT_EQ(tdbTbOpen("cget.db", -1, -1, tDefaultKeyCmpr, pEnv, &pDb, 0), 0);
+
+  fillDb(pEnv, pDb);
+
+  for (int nReaders = 1; nReaders <= 8; nReaders *= 2) {
+    std::atomic<bool>        stop(false);
+    std::vector<int64_t>     ops(nReaders, 0);
+    std::vector<int64_t>     errs(nReaders, 0);
+    std::vector<std::thread> readers;
+
+    for (int i = 0; i < nReaders; i++) {
+      readers.emplace_back(reader, pDb, i + 1, &stop, &ops[i], &errs[i]);
+    }
+    taosMsleep(kBenchMs);
+    stop.store(true);
+    for (auto &t : readers) t.join();
+
+    int64_t total = 0;
+    int64_t totalErrs = 0;
+    for (int i = 0; i < nReaders; i++) {
+      total += ops[i];
+      totalErrs += errs[i];
+    }
+    printf("readers:%d gets:%" PRId64 " gets/ms:%" PRId64 "\n", nReaders, total, total / kBenchMs);
+    GTEST_ASSERT_EQ(totalErrs, 0);
+  }
+
+  tdbTbClose(pDb);
+  GTEST_ASSERT_EQ(tdbClose(pEnv), 0);
+  taosRemoveDir("tdb_cget");
+}
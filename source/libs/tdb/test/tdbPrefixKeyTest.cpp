@@ -0,0 +1,261 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <random>
+#include <vector>
+
+#define ALLOW_FORBID_FUNC
+#include "os.h"
+#include "tdb.h"
+
+static int tDefaultKeyCmpr(const void *pKey1, int keyLen1, const void *pKey2, int keyLen2) {
+  int mlen = keyLen1 < keyLen2 ? keyLen1 : keyLen2;
+  int cret = memcmp(pKey1, pKey2, mlen);
+  if (cret == 0) {
+    cret = (keyLen1 < keyLen2) ? -1 : ((keyLen1 > keyLen2) ? 1 : 0);
+  }
+  return cret;
+}
+
+static void *testMalloc(void *arg, size_t size) { return taosMemoryMalloc(size); }
+static void  testFree(void *arg, void *ptr) { taosMemoryFree(ptr); }
+
+// keys shaped like the tag index: a long prefix per tag value, the uid at the end
+static int genKey(char *key, int i) {
+  return sprintf(key, "suid:0000000000012345:cid:0002:tag-%04d:uid%08d", i / 1000, i);
+}
+static int genVal(char *val, int i) { return sprintf(val, "v%d", i); }
+
+static void insertData(TDB *pEnv, TTB *pDb, std::vector<int> &ids) {
+  TXN *txn = NULL;
+  char key[64];
+  char val[64];
+
+  tdbBegin(pEnv, &txn, testMalloc, testFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+  for (int i : ids) {
+    int kLen = genKey(key, i);
+    int vLen = genVal(val, i);
+    GTEST_ASSERT_EQ(tdbTbInsert(pDb, key, kLen, val, vLen, txn), 0);
+  }
+  tdbCommit(pEnv, txn);
+  tdbPostCommit(pEnv, txn);
+}
+
+static void checkData(TTB *pDb, int nData, int step) {
+  TBC  *pTbc = NULL;
+  void *pKey = NULL;
+  void *pVal = NULL;
+  int   kLen, vLen;
+  char  key[64];
+  char  val[64];
+  int   count = 0;
+
+  for (int i = 0; i < nData; i += step) {
+    int   n = genKey(key, i);
+    void *pRet = NULL;
+    GTEST_ASSERT_EQ(tdbTbGet(pDb, key, n, &pRet, &vLen), 0);
+    GTEST_ASSERT_EQ(vLen, genVal(val, i));
+    GTEST_ASSERT_EQ(memcmp(pRet, val, vLen), 0);
+    tdbFree(pRet);
+  }
+
+  GTEST_ASSERT_EQ(tdbTbcOpen(pDb, &pTbc, NULL), 0);
+  tdbTbcMoveToFirst(pTbc);
+  while (tdbTbcNext(pTbc, &pKey, &kLen, &pVal, &vLen) == 0) {
+    int n = genKey(key, count * step);
+    GTEST_ASSERT_EQ(kLen, n);
+    GTEST_ASSERT_EQ(memcmp(pKey, key, kLen), 0);
+    count++;
+  }
+  tdbTbcClose(pTbc);
+  tdbFree(pKey);
+  tdbFree(pVal);
+
+  GTEST_ASSERT_EQ(count, (nData + step - 1) / step);
+}
+
+static int64_t loadRandom(const char *dir, int32_t flags, int nData) {
+  TDB             *pEnv = NULL;
+  TTB             *pDb = NULL;
+  std::vector<int> ids(nData);
+  int64_t          size = 0;
+  char             file[128];
+
+  for (int i = 0; i < nData; i++) ids[i] = i;
+  std::shuffle(ids.begin(), ids.end(), std::mt19937(7));
+
+  taosRemoveDir(dir);
+  EXPECT_EQ(tdbOpen(dir, 4096, 256, &pEnv, 0, 0, NULL), 0);
+  EXPECT_EQ(tdbTbOpenWithFlags("pfx.db", -1, -1, tDefaultKeyCmpr, pEnv, &pDb, 0, flags), 0);
+
+  insertData(pEnv, pDb, ids);
+  checkData(pDb, nData, 1);
+
+  tdbTbClose(pDb);
+  EXPECT_EQ(tdbClose(pEnv), 0);
+
+  snprintf(file, sizeof(file), "%s/main.tdb", dir);
+  taosStatFile(file, &size, NULL, NULL);
+  return size;
+}
+
+TEST(TdbPrefixKeyTest, InsertGetIterate) {
+  int nData = 50000;
+
+  int64_t plainSize = loadRandom("tdb_pfx_plain", 0, nData);
+  int64_t pfxSize = loadRandom("tdb_pfx", TDB_TB_PREFIX_KEY, nData);
+  printf("plain: %" PRId64 " bytes, prefix compressed: %" PRId64 " bytes\n", plainSize, pfxSize);
+  GTEST_ASSERT_LT(pfxSize, plainSize);
+
+  taosRemoveDir("tdb_pfx_plain");
+  taosRemoveDir("tdb_pfx");
+}
+
+TEST(TdbPrefixKeyTest, DeleteAndReopen) {
+  TDB *pEnv = NULL;
+  TTB *pDb = NULL;
+  TXN *txn = NULL;
+  int  nData = 20000;
+  char key[64];
+
+  std::vector<int> ids(nData);
+  for (int i = 0; i < nData; i++) ids[i] = i;
+
+  taosRemoveDir("tdb_pfx_del");
+  GTEST_ASSERT_EQ(tdbOpen("tdb_pfx_del", 4096, 64, &pEnv, 0, 0, NULL), 0);
+  GTEST_ASSERT_EQ(tdbTbOpenWithFlags("pfx.db", -1, -1, tDefaultKeyCmpr, pEnv, &pDb, 0, TDB_TB_PREFIX_KEY), 0);
+  insertData(pEnv, pDb, ids);
+
+  // drop the odd keys, so pages merge and suffix cells move between pages with different prefixes
+  tdbBegin(pEnv, &txn, testMalloc, testFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+  for (int i = 1; i < nData; i += 2) {
+    GTEST_ASSERT_EQ(tdbTbDelete(pDb, key, genKey(key, i), txn), 0);
+  }
+  tdbCommit(pEnv, txn);
+  tdbPostCommit(pEnv, txn);
+  checkData(pDb, nData, 2);
+
+  tdbTbClose(pDb);
+  GTEST_ASSERT_EQ(tdbClose(pEnv), 0);
+
+  // the page format is kept by the table, whatever flags it is opened with later
+  GTEST_ASSERT_EQ(tdbOpen("tdb_pfx_del", 4096, 64, &pEnv, 0, 0, NULL), 0);
+  GTEST_ASSERT_EQ(tdbTbOpen("pfx.db", -1, -1, tDefaultKeyCmpr, pEnv, &pDb, 0), 0);
+  checkData(pDb, nData, 2);
+
+  tdbTbClose(pDb);
+  GTEST_ASSERT_EQ(tdbClose(pEnv), 0);
+  taosRemoveDir("tdb_pfx_del");
+}
+
+TEST(TdbPrefixKeyTest, BulkLoad) {
+  TDB *pEnv = NULL;
+  TTB *pDb = NULL;
+  TXN *txn = NULL;
+  TBB *pBulk = NULL;
+  int  nData = 50000;
+  char key[64];
+  char val[64];
+
+  taosRemoveDir("tdb_pfx_bulk");
+  GTEST_ASSERT_EQ(tdbOpen("tdb_pfx_bulk", 4096, 256, &pEnv, 0, 0, NULL), 0);
+  GTEST_ASSERT_EQ(tdbTbOpenWithFlags("pfx.db", -1, -1, tDefaultKeyCmpr, pEnv, &pDb, 0, TDB_TB_PREFIX_KEY), 0);
+
+  tdbBegin(pEnv, &txn, testMalloc, testFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+  GTEST_ASSERT_EQ(tdbTbBulkOpen(pDb, 0, txn, &pBulk), 0);
+  for (int i = 0; i < nData; i += 2) {
+    int kLen = genKey(key, i);
+    int vLen = genVal(val, i);
+    GTEST_ASSERT_EQ(tdbTbBulkAppend(pBulk, key, kLen, val, vLen), 0);
+  }
+  GTEST_ASSERT_EQ(tdbTbBulkClose(pBulk, 1), 0);
+  tdbCommit(pEnv, txn);
+  tdbPostCommit(pEnv, txn);
+  checkData(pDb, nData, 2);
+
+  // inserts go between the loaded keys and split the compressed leaves
+  std::vector<int> ids;
+  for (int i = 1; i < nData; i += 2) ids.push_back(i);
+  std::shuffle(ids.begin(), ids.end(), std::mt19937(11));
+  insertData(pEnv, pDb, ids);
+  checkData(pDb, nData, 1);
+
+  tdbTbClose(pDb);
+  GTEST_ASSERT_EQ(tdbClose(pEnv), 0);
+  taosRemoveDir("tdb_pfx_bulk");
+}
+
+TEST(TdbPrefixKeyTest, MixedKeys) {
+  TDB *pEnv = NULL;
+  TTB *pDb = NULL;
+  TXN *txn = NULL;
+
+  std::mt19937                       rng(13);
+  std::map<std::string, std::string> data;
+
+  taosRemoveDir("tdb_pfx_mix");
+  GTEST_ASSERT_EQ(tdbOpen("tdb_pfx_mix", 4096, 64, &pEnv, 0, 0, NULL), 0);
+  GTEST_ASSERT_EQ(tdbTbOpenWithFlags("pfx.db", -1, -1, tDefaultKeyCmpr, pEnv, &pDb, 0, TDB_TB_PREFIX_KEY), 0);
+
+  // key families with prefixes of different lengths, short keys and values large enough to overflow
+  tdbBegin(pEnv, &txn, testMalloc, testFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+  for (int i = 0; i < 30000; i++) {
+    char key[256];
+    int  family = rng() % 4;
+    int  n;
+
+    if (family == 0) {
+      n = sprintf(key, "k%u", (unsigned)(rng() % 100000));
+    } else if (family == 1) {
+      n = sprintf(key, "%0100d:%u", 1, (unsigned)(rng() % 100000));
+    } else {
+      n = sprintf(key, "suid:%d:tag-%u:%u", family, (unsigned)(rng() % 50), (unsigned)(rng() % 100000));
+    }
+
+    std::string val(rng() % 16 == 0 ? 2000 + rng() % 3000 : rng() % 32, 'a' + i % 26);
+    std::string k(key, n);
+    if (data.count(k)) {
+      GTEST_ASSERT_EQ(tdbTbUpsert(pDb, key, n, val.data(), val.size(), txn), 0);
+    } else {
+      GTEST_ASSERT_EQ(tdbTbInsert(pDb, key, n, val.data(), val.size(), txn), 0);
+    }
+    data[k] = val;
+  }
+
+  int i = 0;
+  for (auto it = data.begin(); it != data.end();) {
+    if (i++ % 3 == 0) {
+      GTEST_ASSERT_EQ(tdbTbDelete(pDb, it->first.data(), it->first.size(), txn), 0);
+      it = data.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  tdbCommit(pEnv, txn);
+  tdbPostCommit(pEnv, txn);
+
+  TBC  *pTbc = NULL;
+  void *pKey = NULL;
+  void *pVal = NULL;
+  int   kLen, vLen;
+  auto  it = data.begin();
+
+  GTEST_ASSERT_EQ(tdbTbcOpen(pDb, &pTbc, NULL), 0);
+  tdbTbcMoveToFirst(pTbc);
+  while (tdbTbcNext(pTbc, &pKey, &kLen, &pVal, &vLen) == 0) {
+    GTEST_ASSERT_TRUE(it != data.end());
+    GTEST_ASSERT_EQ(std::string((char *)pKey, kLen), it->first);
+    GTEST_ASSERT_EQ(std::string((char *)pVal, vLen), it->second);
+    ++it;
+  }
+  GTEST_ASSERT_TRUE(it == data.end());
+  tdbTbcClose(pTbc);
+  tdbFree(pKey);
+  tdbFree(pVal);
+
+  tdbTbClose(pDb);
+  GTEST_ASSERT_EQ(tdbClose(pEnv), 0);
+  taosRemoveDir("tdb_pfx_mix");
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#define ALLOW_FORBID_FUNC
+#include "os.h"
+#include "tdb.h"
+
+static int tDefaultKeyCmpr(const void *pKey1, int keyLen1, const void *pKey2, int keyLen2) {
+  int mlen = keyLen1 < keyLen2 ? keyLen1 : keyLen2;
+  int cret = memcmp(pKey1, pKey2, mlen);
+  if (cret == 0) {
+    cret = (keyLen1 < keyLen2) ? -1 : ((keyLen1 > keyLen2) ? 1 : 0);
+  }
+  return cret;
+}
+
+static void *testMalloc(void *arg, size_t size) { return taosMemoryMalloc(size); }
+static void  testFree(void *arg, void *ptr) { taosMemoryFree(ptr); }
+
+typedef std::map<std::string, std::string> SKVMap;
+
+static std::string genKey(std::mt19937 &rng) {
+  char key[64];
+  int  n = sprintf(key, "suid:0000012345:tag-%03u:uid%08u", (unsigned)(rng() % 200), (unsigned)(rng() % 10000000));
+  return std::string(key, n);
+}
+
+static std::string genVal(std::mt19937 &rng, int i) {
+  return std::string(rng() % 32 == 0 ? 1000 + rng() % 3000 : 1 + rng() % 24, 'a' + i % 26);
+}
+
+// put one batch of new and already present keys, in random order
+static void putBatch(TDB *pEnv, TTB *pDb, SKVMap &data, std::mt19937 &rng, int nPut) {
+  TXN                     *txn = NULL;
+  std::vector<std::string> keys;
+  std::vector<std::string> vals;
+  std::vector<TKV>         aKV;
+  std::map<std::string, int> seen;
+
+  while ((int)keys.size() < nPut) {
+    std::string k;
+    if (!data.empty() && rng() % 8 == 0) {
+      auto it = data.lower_bound(genKey(rng));
+      k = it == data.end() ? data.begin()->first : it->first;
+    } else {
+      k = genKey(rng);
+    }
+    if (seen.count(k)) continue;
+    seen[k] = 1;
+    keys.push_back(k);
+    vals.push_back(genVal(rng, (int)keys.size()));
+  }
+
+  for (size_t i = 0; i < keys.size(); i++) {
+    aKV.push_back(TKV{keys[i].data(), (int)keys[i].size(), vals[i].data(), (int)vals[i].size()});
+    data[keys[i]] = vals[i];
+  }
+
+  tdbBegin(pEnv, &txn, testMalloc, testFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+  GTEST_ASSERT_EQ(tdbTbPutBatch(pDb, aKV.data(), (int32_t)aKV.size(), txn), 0);
+  tdbCommit(pEnv, txn);
+  tdbPostCommit(pEnv, txn);
+}
+
+static void checkData(TTB *pDb, const SKVMap &data) {
+  TBC  *pTbc = NULL;
+  void *pKey = NULL;
+  void *pVal = NULL;
+  int   kLen, vLen;
+  auto  it = data.begin();
+
+  GTEST_ASSERT_EQ(tdbTbcOpen(pDb, &pTbc, NULL), 0);
+  tdbTbcMoveToFirst(pTbc);
+  while (tdbTbcNext(pTbc, &pKey, &kLen, &pVal, &vLen) == 0) {
+    GTEST_ASSERT_TRUE(it != data.end());
+    GTEST_ASSERT_EQ(std::string((char *)pKey, kLen), it->first);
+    GTEST_ASSERT_EQ(std::string((char *)pVal, vLen), it->second);
+    ++it;
+  }
+  GTEST_ASSERT_TRUE(it == data.end());
+  tdbTbcClose(pTbc);
+  tdbFree(pKey);
+  tdbFree(pVal);
+}
+
+static void runBatches(const char *dir, int32_t flags) {
+  TDB         *pEnv = NULL;
+  TTB         *pDb = NULL;
+  SKVMap       data;
+  std::mt19937 rng(17);
+
+  taosRemoveDir(dir);
+  GTEST_ASSERT_EQ(tdbOpen(dir, 4096, 256, &pEnv, 0, 0, NULL), 0);
+  GTEST_ASSERT_EQ(tdbTbOpenWithFlags("put.db", -1, -1, tDefaultKeyCmpr, pEnv, &pDb, 0, flags), 0);
+
+  // the first batch goes into an empty table
+  putBatch(pEnv, pDb, data, rng, 20000);
+  checkData(pDb, data);
+
+  for (int i = 0; i < 20; i++) {
+    putBatch(pEnv, pDb, data, rng, 1 + rng() % 3000);
+  }
+  checkData(pDb, data);
+
+  tdbTbClose(pDb);
+  GTEST_ASSERT_EQ(tdbClose(pEnv), 0);
+
+  GTEST_ASSERT_EQ(tdbOpen(dir, 4096, 256, &pEnv, 0, 0, NULL), 0);
+  GTEST_ASSERT_EQ(tdbTbOpenWithFlags("put.db", -1, -1, tDefaultKeyCmpr, pEnv, &pDb, 0, flags), 0);
+  checkData(pDb, data);
+  tdbTbClose(pDb);
+  GTEST_ASSERT_EQ(tdbClose(pEnv), 0);
+  taosRemoveDir(dir);
+}
+
+TEST(TdbPutBatchTest, PutBatch) { runBatches("tdb_put_batch", 0); }
+
+TEST(TdbPutBatchTest, PutBatchPrefixKey) { runBatches("tdb_put_batch_pfx", TDB_TB_PREFIX_KEY); }
+
+TEST(TdbPutBatchTest, MoveToAgain) {
+  TDB         *pEnv = NULL;
+  TTB         *pDb = NULL;
+  TBC         *pTbc = NULL;
+  SKVMap       data;
+  std::mt19937 rng(19);
+
+  taosRemoveDir("tdb_put_moveto");
+  GTEST_ASSERT_EQ(tdbOpen("tdb_put_moveto", 4096, 256, &pEnv, 0, 0, NULL), 0);
+  GTEST_ASSERT_EQ(tdbTbOpen("put.db", -1, -1, tDefaultKeyCmpr, pEnv, &pDb, 0), 0);
+  putBatch(pEnv, pDb, data, rng, 30000);
+
+  // one cursor moved to keys up and down the table lands where a new cursor does
+  GTEST_ASSERT_EQ(tdbTbcOpen(pDb, &pTbc, NULL), 0);
+  for (int i = 0; i < 5000; i++) {
+    std::string k = genKey(rng);
+    const void *pKey = NULL;
+    int         kLen = 0;
+    int         c = 0;
+
+    GTEST_ASSERT_EQ(tdbTbcMoveTo(pTbc, k.data(), (int)k.size(), &c), 0);
+    GTEST_ASSERT_EQ(tdbTbcGet(pTbc, &pKey, &kLen, NULL, NULL), 0);
+
+    std::string at((const char *)pKey, kLen);
+    auto        it = data.lower_bound(k);
+    if (c == 0) {
+      GTEST_ASSERT_EQ(at, k);
+    } else if (c < 0) {
+      GTEST_ASSERT_TRUE(it != data.end());
+      GTEST_ASSERT_EQ(at, it->first);
+    } else {
+      GTEST_ASSERT_TRUE(it != data.begin());
+      GTEST_ASSERT_EQ(at, std::prev(it)->first);
+    }
+  }
+  tdbTbcClose(pTbc);
+
+  tdbTbClose(pDb);
+  GTEST_ASSERT_EQ(tdbClose(pEnv), 0);
+  taosRemoveDir("tdb_put_moveto");
+}
@@ -0,0 +1,302 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#define ALLOW_FORBID_FUNC
+#include "os.h"
+#include "tdb.h"
+
+static int tDefaultKeyCmpr(const void *pKey1, int keyLen1, const void *pKey2, int keyLen2) {
+  int mlen = keyLen1 < keyLen2 ? keyLen1 : keyLen2;
+  int cret = memcmp(pKey1, pKey2, mlen);
+  if (cret == 0) {
+    cret = (keyLen1 < keyLen2) ? -1 : ((keyLen1 > keyLen2) ? 1 : 0);
+  }
+  return cret;
+}
+
+static void *testMalloc(void *arg, size_t size) { return taosMemoryMalloc(size); }
+static void  testFree(void *arg, void *ptr) { taosMemoryFree(ptr); }
+
+static int genKey(char *key, int i) { return sprintf(key, "key-%08d", i); }
+
+// values long enough that a few thousand keys spread over many pages, some of them overflow
+static std::string genVal(int i, int gen) {
+  std::string val = "gen" + std::to_string(gen) + ":" + std::to_string(i) + ":";
+  val.resize(i % 97 == 0 ? 3000 : 40 + i % 50, 'a' + gen % 26);
+  return val;
+}
+
+static void upsertData(TTB *pDb, TXN *txn, int from, int to, int gen) {
+  char key[32];
+  for (int i = from; i < to; i++) {
+    std::string val = genVal(i, gen);
+    GTEST_ASSERT_EQ(tdbTbUpsert(pDb, key, genKey(key, i), val.data(), val.size(), txn), 0);
+  }
+}
+
+// counts the keys the txn sees, and checks every value belongs to generation gen
+static int checkData(TTB *pDb, TXN *txn, int gen) {
+  TBC  *pTbc = NULL;
+  void *pKey = NULL;
+  void *pVal = NULL;
+  int   kLen, vLen;
+  int   count = 0;
+  char  key[32];
+
+  EXPECT_EQ(tdbTbcOpen(pDb, &pTbc, txn), 0);
+  tdbTbcMoveToFirst(pTbc);
+  while (tdbTbcNext(pTbc, &pKey, &kLen, &pVal, &vLen) == 0) {
+    std::string val = genVal(count, gen);
+    EXPECT_EQ(std::string((char *)pKey, kLen), std::string(key, genKey(key, count)));
+    EXPECT_EQ(std::string((char *)pVal, vLen), val);
+    count++;
+  }
+  tdbTbcClose(pTbc);
+  tdbFree(pKey);
+  tdbFree(pVal);
+
+  return count;
+}
+
+TEST(TdbSnapshotTest, ReadPinnedVersion) {
+  TDB *pEnv = NULL;
+  TTB *pDb = NULL;
+  TXN *txn = NULL;
+  TXN *pSnap1 = NULL;
+  TXN *pSnap2 = NULL;
+  int  nData = 5000;
+  char key[32];
+
+  taosRemoveDir("tdb_snap");
+  GTEST_ASSERT_EQ(tdbOpen("tdb_snap", 4096, 64, &pEnv, 0, 0, NULL), 0);
+  GTEST_ASSERT_EQ(tdbTbOpen("snap.db", -1, -1, tDefaultKeyCmpr, pEnv, &pDb, 0), 0);
+  GTEST_ASSERT_EQ(tdbSnapshotEnable(pEnv), 0);
+
+  tdbBegin(pEnv, &txn, testMalloc, testFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+  upsertData(pDb, txn, 0, nData, 0);
+  tdbSnapshotPublish(pEnv);
+
+  GTEST_ASSERT_EQ(tdbSnapshotBegin(pEnv, &pSnap1), 0);
+
+  // rewrite every value, grow the table and commit while the snapshot stays open
+  upsertData(pDb, txn, 0, nData * 2, 1);
+  tdbCommit(pEnv, txn);
+  tdbPostCommit(pEnv, txn);
+  tdbSnapshotPublish(pEnv);
+
+  GTEST_ASSERT_EQ(checkData(pDb, pSnap1, 0), nData);
+  GTEST_ASSERT_EQ(tdbSnapshotBegin(pEnv, &pSnap2), 0);
+  GTEST_ASSERT_EQ(checkData(pDb, pSnap2, 1), nData * 2);
+
+  // drop the second half, unpublished deletes are invisible to both snapshots
+  tdbBegin(pEnv, &txn, testMalloc, testFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+  for (int i = nData; i < nData * 2; i++) {
+    GTEST_ASSERT_EQ(tdbTbDelete(pDb, key, genKey(key, i), txn), 0);
+  }
+  GTEST_ASSERT_EQ(checkData(pDb, pSnap1, 0), nData);
+  GTEST_ASSERT_EQ(checkData(pDb, pSnap2, 1), nData * 2);
+
+  void *pVal = NULL;
+  int   vLen = 0;
+  GTEST_ASSERT_EQ(tdbTbGetWithTxn(pDb, key, genKey(key, nData), &pVal, &vLen, pSnap2), 0);
+  GTEST_ASSERT_EQ(std::string((char *)pVal, vLen), genVal(nData, 1));
+  GTEST_ASSERT_NE(tdbTbGetWithTxn(pDb, key, genKey(key, nData), &pVal, &vLen, pSnap1), 0);
+  tdbFree(pVal);
+
+  tdbSnapshotEnd(pEnv, pSnap1);
+  tdbSnapshotEnd(pEnv, pSnap2);
+
+  tdbCommit(pEnv, txn);
+  tdbPostCommit(pEnv, txn);
+  tdbSnapshotPublish(pEnv);
+  GTEST_ASSERT_EQ(checkData(pDb, NULL, 1), nData);
+
+  tdbTbClose(pDb);
+  GTEST_ASSERT_EQ(tdbClose(pEnv), 0);
+  taosRemoveDir("tdb_snap");
+}
+
+TEST(TdbSnapshotTest, ConcurrentReaders) {
+  TDB *pEnv = NULL;
+  TTB *pDb = NULL;
+  TXN *txn = NULL;
+  int  nData = 2000;
+  int  nGen = 40;
+
+  taosRemoveDir("tdb_snap_mt");
+  GTEST_ASSERT_EQ(tdbOpen("tdb_snap_mt", 4096, 64, &pEnv, 0, 0, NULL), 0);
+  GTEST_ASSERT_EQ(tdbTbOpen("snap.db", -1, -1, tDefaultKeyCmpr, pEnv, &pDb, 0), 0);
+  GTEST_ASSERT_EQ(tdbSnapshotEnable(pEnv), 0);
+
+  tdbBegin(pEnv, &txn, testMalloc, testFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+  upsertData(pDb, txn, 0, nData, 0);
+  tdbSnapshotPublish(pEnv);
+
+  // every published version holds nData keys of a single generation
+  std::atomic<int>  published(0);
+  std::atomic<bool> stop(false);
+  std::atomic<int>  nRead(0);
+  std::atomic<int>  nRetry(0);
+  auto              reader = [&]() {
+    while (!stop.load()) {
+      TXN *pSnap = NULL;
+      int  gen = published.load();
+      // the writer did not keep images while no snapshot was open, wait for its next version
+      if (tdbSnapshotBegin(pEnv, &pSnap) < 0) {
+        ASSERT_TRUE(pSnap == NULL);
+        nRetry++;
+        taosMsleep(1);
+        continue;
+      }
+
+      // the writer may publish between loading gen and pinning the snapshot
+      TBC  *pTbc = NULL;
+      void *pKey = NULL;
+      void *pVal = NULL;
+      int   kLen, vLen;
+      ASSERT_EQ(tdbTbcOpen(pDb, &pTbc, pSnap), 0);
+      tdbTbcMoveToFirst(pTbc);
+      ASSERT_EQ(tdbTbcNext(pTbc, &pKey, &kLen, &pVal, &vLen), 0);
+      int snapGen = atoi((char *)pVal + 3);
+      tdbTbcClose(pTbc);
+      tdbFree(pKey);
+      tdbFree(pVal);
+
+      ASSERT_GE(snapGen, gen);
+      ASSERT_EQ(checkData(pDb, pSnap, snapGen), nData);
+      tdbSnapshotEnd(pEnv, pSnap);
+      nRead++;
+    }
+  };
+
+  std::thread readers[4];
+  for (auto &t : readers) t = std::thread(reader);
+
+  for (int gen = 1; gen <= nGen; gen++) {
+    upsertData(pDb, txn, 0, nData, gen);
+    tdbSnapshotPublish(pEnv);
+    published.store(gen);
+
+    if (gen % 10 == 0) {
+      tdbCommit(pEnv, txn);
+      tdbPostCommit(pEnv, txn);
+      tdbBegin(pEnv, &txn, testMalloc, testFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+    }
+  }
+
+  stop.store(true);
+  for (auto &t : readers) t.join();
+  printf("%d snapshots read and %d retried while %d versions were published\n", nRead.load(), nRetry.load(), nGen);
+  GTEST_ASSERT_GT(nRead.load(), 0);
+
+  tdbCommit(pEnv, txn);
+  tdbPostCommit(pEnv, txn);
+  GTEST_ASSERT_EQ(checkData(pDb, NULL, nGen), nData);
+
+  tdbTbClose(pDb);
+  GTEST_ASSERT_EQ(tdbClose(pEnv), 0);
+  taosRemoveDir("tdb_snap_mt");
+}
+
+TEST(TdbSnapshotTest, NoImagesWithoutSnapshot) {
+  TDB *pEnv = NULL;
+  TTB *pDb = NULL;
+  TXN *txn = NULL;
+  TXN *pSnap1 = NULL;
+  TXN *pSnap2 = NULL;
+  int  nData = 2000;
+
+  taosRemoveDir("tdb_snap_nil");
+  GTEST_ASSERT_EQ(tdbOpen("tdb_snap_nil", 4096, 64, &pEnv, 0, 0, NULL), 0);
+  GTEST_ASSERT_EQ(tdbTbOpen("snap.db", -1, -1, tDefaultKeyCmpr, pEnv, &pDb, 0), 0);
+  GTEST_ASSERT_EQ(tdbSnapshotEnable(pEnv), 0);
+
+  tdbBegin(pEnv, &txn, testMalloc, testFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+  upsertData(pDb, txn, 0, nData, 0);
+  tdbSnapshotPublish(pEnv);
+
+  // the pages are changed without images while no snapshot is open, so none can begin before the next version
+  upsertData(pDb, txn, 0, nData, 1);
+  GTEST_ASSERT_NE(tdbSnapshotBegin(pEnv, &pSnap1), 0);
+  GTEST_ASSERT_TRUE(pSnap1 == NULL);
+  tdbSnapshotPublish(pEnv);
+  GTEST_ASSERT_EQ(tdbSnapshotBegin(pEnv, &pSnap1), 0);
+  GTEST_ASSERT_EQ(checkData(pDb, pSnap1, 1), nData);
+
+  // with a snapshot open the images are kept, a second snapshot begins in the middle of a version
+  upsertData(pDb, txn, 0, nData, 2);
+  GTEST_ASSERT_EQ(tdbSnapshotBegin(pEnv, &pSnap2), 0);
+  GTEST_ASSERT_EQ(checkData(pDb, pSnap1, 1), nData);
+  GTEST_ASSERT_EQ(checkData(pDb, pSnap2, 1), nData);
+  tdbSnapshotEnd(pEnv, pSnap1);
+  tdbSnapshotEnd(pEnv, pSnap2);
+
+  tdbCommit(pEnv, txn);
+  tdbPostCommit(pEnv, txn);
+  tdbSnapshotPublish(pEnv);
+  GTEST_ASSERT_EQ(checkData(pDb, NULL, 2), nData);
+
+  tdbTbClose(pDb);
+  GTEST_ASSERT_EQ(tdbClose(pEnv), 0);
+  taosRemoveDir("tdb_snap_nil");
+}
+
+TEST(TdbSnapshotTest, AbortEndsSnapshots) {
+  TDB  *pEnv = NULL;
+  TTB  *pDb = NULL;
+  TXN  *txn = NULL;
+  TXN  *pSnap1 = NULL;
+  TXN  *pSnap2 = NULL;
+  int   nData = 2000;
+  char  key[32];
+  void *pVal = NULL;
+  int   vLen = 0;
+
+  taosRemoveDir("tdb_snap_abort");
+  GTEST_ASSERT_EQ(tdbOpen("tdb_snap_abort", 4096, 64, &pEnv, 0, 0, NULL), 0);
+  GTEST_ASSERT_EQ(tdbTbOpen("snap.db", -1, -1, tDefaultKeyCmpr, pEnv, &pDb, 0), 0);
+  GTEST_ASSERT_EQ(tdbSnapshotEnable(pEnv), 0);
+
+  tdbBegin(pEnv, &txn, testMalloc, testFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+  upsertData(pDb, txn, 0, nData, 0);
+  tdbCommit(pEnv, txn);
+  tdbPostCommit(pEnv, txn);
+  tdbSnapshotPublish(pEnv);
+
+  // the published version holds changes of a txn that is aborted later
+  tdbBegin(pEnv, &txn, testMalloc, testFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+  upsertData(pDb, txn, 0, nData, 1);
+  tdbSnapshotPublish(pEnv);
+  GTEST_ASSERT_EQ(tdbSnapshotBegin(pEnv, &pSnap1), 0);
+  GTEST_ASSERT_EQ(checkData(pDb, pSnap1, 1), nData);
+
+  upsertData(pDb, txn, 0, nData, 2);
+  GTEST_ASSERT_EQ(tdbAbort(pEnv, txn), 0);
+
+  // the reverted pages hold none of the versions it pins, so it reads nothing more
+  GTEST_ASSERT_NE(tdbTbGetWithTxn(pDb, key, genKey(key, 0), &pVal, &vLen, pSnap1), 0);
+  GTEST_ASSERT_EQ(terrno, TSDB_CODE_TDB_SNAPSHOT_ABORTED);
+  tdbSnapshotEnd(pEnv, pSnap1);
+
+  // a new snapshot reads the last commit, and keeps reading it while the next txn changes the pages
+  GTEST_ASSERT_EQ(tdbSnapshotBegin(pEnv, &pSnap2), 0);
+  GTEST_ASSERT_EQ(checkData(pDb, pSnap2, 0), nData);
+  GTEST_ASSERT_EQ(checkData(pDb, NULL, 0), nData);
+
+  tdbBegin(pEnv, &txn, testMalloc, testFree, NULL, TDB_TXN_WRITE | TDB_TXN_READ_UNCOMMITTED);
+  upsertData(pDb, txn, 0, nData, 3);
+  tdbCommit(pEnv, txn);
+  tdbPostCommit(pEnv, txn);
+  tdbSnapshotPublish(pEnv);
+  GTEST_ASSERT_EQ(checkData(pDb, pSnap2, 0), nData);
+  tdbSnapshotEnd(pEnv, pSnap2);
+  GTEST_ASSERT_EQ(checkData(pDb, NULL, 3), nData);
+
+  tdbFree(pVal);
+  tdbTbClose(pDb);
+  GTEST_ASSERT_EQ(tdbClose(pEnv), 0);
+  taosRemoveDir("tdb_snap_abort");
+}
@@ -21,6 +21,7 @@
 #include "tcoding.h"
 #include "tcommon.h"
 #include "tcompare.h"
+#include "tcompression.h"
 #include "wal.h"
 
 #ifdef __cplusplus
@@ -37,6 +38,16 @@ typedef struct {
   int64_t syncedOffset;
 } SWalFileInfo;
 
+typedef struct {
+  int64_t fileFirstVer;
+  int32_t refCount;
+} SWalSegRef;
+
+typedef struct {
+  int64_t fileFirstVer;
+  SArray* pOffsets;  // SArray<int64_t>, offset of version fileFirstVer + k * WAL_SPARSE_IDX_STEP
+} SWalSparseIdx;
+
 typedef struct WalIdxEntry {
   int64_t ver;
   int64_t offset;
@@ -112,6 +123,14 @@ static inline void walBuildIdxName(SWal* pWal, int64_t fileFirstVer, char* buf)
   sprintf(buf, "%s/%020" PRId64 "." WAL_INDEX_SUFFIX, pWal->path, fileFirstVer);
 }
 
+static inline void walBuildPoolLogName(SWal* pWal, int32_t slot, char* buf) {
+  sprintf(buf, "%s/recycle%02d." WAL_LOG_SUFFIX, pWal->path, slot);
+}
+
+static inline void walBuildPoolIdxName(SWal* pWal, int32_t slot, char* buf) {
+  sprintf(buf, "%s/recycle%02d." WAL_INDEX_SUFFIX, pWal->path, slot);
+}
+
 static inline int walValidHeadCksum(SWalCkHead* pHead) {
   return taosCheckChecksum((uint8_t*)&pHead->head, sizeof(SWalCont), pHead->cksumHead);
 }
@@ -166,6 +185,37 @@ int64_t walGetSeq();
 int     walSeekWriteVer(SWal* pWal, int64_t ver);
 int32_t walRollImpl(SWal* pWal);
 
+// segment pool section
+int64_t walSegPreallocSize(SWal* pWal);
+void    walLoadSegPool(SWal* pWal);
+bool    walTakePoolSegment(SWal* pWal, int64_t fileFirstVer);
+void    walPreallocSegment(SWal* pWal, TdFilePtr pLogFile);
+int32_t walRecycleSegment(SWal* pWal, int64_t fileFirstVer);
+// segment pool section end
+
+// read cache section
+int32_t walReadCacheOpen(SWal* pWal);
+void    walReadCacheClose(SWal* pWal);
+int32_t walSegRef(SWal* pWal, int64_t fileFirstVer);
+void    walSegUnref(SWal* pWal, int64_t fileFirstVer);
+bool    walSegInUse(SWal* pWal, int64_t fileFirstVer);
+void    walTailAppend(SWal* pWal, int64_t fileFirstVer, int64_t offset, const void* head, int64_t headLen,
+                      const void* body, int64_t bodyLen);
+void    walTailReset(SWal* pWal);
+bool    walTailRead(SWal* pWal, int64_t fileFirstVer, int64_t offset, void* buf, int64_t len);
+// read cache section end
+
+// sparse index section
+int32_t walSparseIdxOpen(SWal* pWal);
+void    walSparseIdxClose(SWal* pWal);
+void    walSparseIdxLoad(SWal* pWal);
+void    walSparseIdxAppend(SWal* pWal, int64_t fileFirstVer, int64_t ver, int64_t offset);
+void    walSparseIdxTruncate(SWal* pWal, int64_t ver);
+void    walSparseIdxRemove(SWal* pWal, int64_t fileFirstVer);
+void    walSparseIdxClear(SWal* pWal);
+bool    walSparseIdxLookup(SWal* pWal, int64_t fileFirstVer, int64_t ver, int64_t* pVer, int64_t* pOffset);
+// sparse index section end
+
 #ifdef __cplusplus
 }
 #endif
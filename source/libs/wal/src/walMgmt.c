@@ -17,6 +17,7 @@
 #include "os.h"
 #include "taoserror.h"
 #include "tcompare.h"
+#include "tglobal.h"
 #include "tref.h"
 #include "walInt.h"
 
@@ -74,6 +75,15 @@ void walCleanUp() {
   }
 }
 
+static uint8_t walGetCompressAlg(const char *compressor) {
+  if (strcasecmp(compressor, "lz4") == 0) return L2_LZ4;
+  if (strcasecmp(compressor, "zstd") == 0) return L2_ZSTD;
+  if (compressor[0] != 0 && strcasecmp(compressor, "none") != 0) {
+    wWarn("invalid walCompressor:%s, wal body compression is disabled", compressor);
+  }
+  return L2_UNKNOWN;
+}
+
 SWal *walOpen(const char *path, SWalCfg *pCfg) {
   SWal *pWal = taosMemoryCalloc(1, sizeof(SWal));
   if (pWal == NULL) {
@@ -142,6 +152,18 @@ SWal *walOpen(const char *path, SWalCfg *pCfg) {
   memset(&pWal->writeHead, 0, sizeof(SWalCkHead));
   pWal->writeHead.head.protoVer = WAL_PROTO_VER;
   pWal->writeHead.magic = WAL_MAGIC;
+  pWal->compressAlg = walGetCompressAlg(tsWalCompressor);
+
+  // init read cache
+  if (walReadCacheOpen(pWal) < 0) {
+    wError("vgId:%d, failed to init read cache since %s", pWal->cfg.vgId, terrstr());
+    goto _err;
+  }
+
+  if (walSparseIdxOpen(pWal) < 0) {
+    wError("vgId:%d, failed to init sparse index since %s", pWal->cfg.vgId, terrstr());
+    goto _err;
+  }
 
   // load meta
   (void)walLoadMeta(pWal);
@@ -156,6 +178,9 @@ SWal *walOpen(const char *path, SWalCfg *pCfg) {
     goto _err;
   }
 
+  walLoadSegPool(pWal);
+  walSparseIdxLoad(pWal);
+
   // add ref
   pWal->refId = taosAddRef(tsWal.refSetId, pWal);
   if (pWal->refId < 0) {
@@ -168,6 +193,8 @@ SWal *walOpen(const char *path, SWalCfg *pCfg) {
   return pWal;
 
 _err:
+  walSparseIdxClose(pWal);
+  walReadCacheClose(pWal);
   taosArrayDestroy(pWal->fileInfoSet);
   taosHashCleanup(pWal->pRefHash);
   taosThreadMutexDestroy(&pWal->mutex);
@@ -245,6 +272,8 @@ static void walFreeObj(void *wal) {
   SWal *pWal = wal;
   wDebug("vgId:%d, wal:%p is freed", pWal->cfg.vgId, pWal);
 
+  walSparseIdxClose(pWal);
+  walReadCacheClose(pWal);
   taosThreadMutexDestroy(&pWal->mutex);
   taosMemoryFreeClear(pWal);
 }
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "taoserror.h"
+#include "tglobal.h"
+#include "walInt.h"
+
+// Segment pool: log/idx files removed by walEndSnapshot are renamed into a few recycle slots, truncated and
+// preallocated again, and handed out by walRollImpl instead of creating new files. Blocks of the log file are
+// reserved with fallocate(KEEP_SIZE), so the logical file size still tracks the written data.
+
+int64_t walSegPreallocSize(SWal *pWal) {
+  int64_t size = (int64_t)atomic_load_32(&tsWalPreallocSize) * 1024 * 1024;
+  if (size <= 0) return 0;
+  if (pWal->cfg.segSize > 0) size = TMIN(size, pWal->cfg.segSize);
+  return size;
+}
+
+static void walRemovePoolSlot(SWal *pWal, int32_t slot) {
+  char fnameStr[WAL_FILE_LEN];
+  walBuildPoolLogName(pWal, slot, fnameStr);
+  (void)taosRemoveFile(fnameStr);
+  walBuildPoolIdxName(pWal, slot, fnameStr);
+  (void)taosRemoveFile(fnameStr);
+  pWal->segPoolMask &= ~(1LL << slot);
+}
+
+void walLoadSegPool(SWal *pWal) {
+  char    logName[WAL_FILE_LEN];
+  char    idxName[WAL_FILE_LEN];
+  int32_t poolSize = atomic_load_32(&tsWalSegmentPoolSize);
+
+  pWal->segPoolMask = 0;
+  for (int32_t slot = 0; slot < WAL_SEG_POOL_MAX; slot++) {
+    walBuildPoolLogName(pWal, slot, logName);
+    walBuildPoolIdxName(pWal, slot, idxName);
+    bool hasLog = taosCheckExistFile(logName);
+    bool hasIdx = taosCheckExistFile(idxName);
+    if (hasLog && hasIdx && slot < poolSize && walSegPreallocSize(pWal) > 0) {
+      pWal->segPoolMask |= (1LL << slot);
+    } else if (hasLog || hasIdx) {
+      walRemovePoolSlot(pWal, slot);
+    }
+  }
+
+  if (pWal->segPoolMask != 0) {
+    wDebug("vgId:%d, wal segment pool loaded, mask:0x%" PRIx64, pWal->cfg.vgId, pWal->segPoolMask);
+  }
+}
+
+bool walTakePoolSegment(SWal *pWal, int64_t fileFirstVer) {
+  char fromName[WAL_FILE_LEN];
+  char toName[WAL_FILE_LEN];
+
+  for (int32_t slot = 0; slot < WAL_SEG_POOL_MAX; slot++) {
+    if ((pWal->segPoolMask & (1LL << slot)) == 0) continue;
+
+    walBuildPoolIdxName(pWal, slot, fromName);
+    walBuildIdxName(pWal, fileFirstVer, toName);
+    if (taosRenameFile(fromName, toName) != 0) {
+      wWarn("vgId:%d, failed to take pooled segment %s since %s", pWal->cfg.vgId, fromName, strerror(errno));
+      walRemovePoolSlot(pWal, slot);
+      continue;
+    }
+
+    walBuildPoolLogName(pWal, slot, fromName);
+    walBuildLogName(pWal, fileFirstVer, toName);
+    if (taosRenameFile(fromName, toName) != 0) {
+      wWarn("vgId:%d, failed to take pooled segment %s since %s", pWal->cfg.vgId, fromName, strerror(errno));
+      walRemovePoolSlot(pWal, slot);
+      continue;
+    }
+
+    pWal->segPoolMask &= ~(1LL << slot);
+    wDebug("vgId:%d, wal take pooled segment %d for file %" PRId64, pWal->cfg.vgId, slot, fileFirstVer);
+    return true;
+  }
+
+  return false;
+}
+
+void walPreallocSegment(SWal *pWal, TdFilePtr pLogFile) {
+  int64_t size = walSegPreallocSize(pWal);
+  if (size <= 0) return;
+
+  if (taosFallocateFile(pLogFile, 0, size) != 0) {
+    wWarn("vgId:%d, failed to preallocate wal segment of %" PRId64 " bytes since %s", pWal->cfg.vgId, size,
+          strerror(errno));
+  }
+}
+
+static int32_t walResetPoolFile(const char *fname, int64_t size) {
+  TdFilePtr pFile = taosOpenFile(fname, TD_FILE_WRITE);
+  if (pFile == NULL) return -1;
+
+  int32_t code = taosFtruncateFile(pFile, 0);
+  if (code == 0 && size > 0) {
+    code = taosFallocateFile(pFile, 0, size);
+  }
+  taosCloseFile(&pFile);
+  return code;
+}
+
+static int32_t walPutPoolSegment(SWal *pWal, int64_t fileFirstVer) {
+  int32_t poolSize = atomic_load_32(&tsWalSegmentPoolSize);
+  int64_t size = walSegPreallocSize(pWal);
+  int32_t slot = 0;
+
+  if (size <= 0) return -1;
+  for (; slot < poolSize && slot < WAL_SEG_POOL_MAX; slot++) {
+    if ((pWal->segPoolMask & (1LL << slot)) == 0) break;
+  }
+  if (slot >= poolSize || slot >= WAL_SEG_POOL_MAX) return -1;
+
+  char logName[WAL_FILE_LEN];
+  char idxName[WAL_FILE_LEN];
+  char fromName[WAL_FILE_LEN];
+
+  walBuildPoolLogName(pWal, slot, logName);
+  walBuildPoolIdxName(pWal, slot, idxName);
+
+  // the files are truncated below, a reader still holding them keeps the segment out of the pool. Readers ref the
+  // segment before opening it by name, so once the names are gone under the lock no new one can get the inodes.
+  taosThreadRwlockWrlock(&pWal->segRefLock);
+  if (walSegInUse(pWal, fileFirstVer)) {
+    taosThreadRwlockUnlock(&pWal->segRefLock);
+    wDebug("vgId:%d, wal file %" PRId64 " is still read, removed instead of recycled", pWal->cfg.vgId, fileFirstVer);
+    return -1;
+  }
+
+  walBuildLogName(pWal, fileFirstVer, fromName);
+  int32_t code = taosRenameFile(fromName, logName);
+  if (code == 0) {
+    walBuildIdxName(pWal, fileFirstVer, fromName);
+    code = taosRenameFile(fromName, idxName);
+  }
+  taosThreadRwlockUnlock(&pWal->segRefLock);
+
+  if (code != 0 || walResetPoolFile(logName, size) != 0 || walResetPoolFile(idxName, 0) != 0) {
+    goto _err;
+  }
+
+  pWal->segPoolMask |= (1LL << slot);
+  wDebug("vgId:%d, wal file %" PRId64 " recycled into pool slot %d", pWal->cfg.vgId, fileFirstVer, slot);
+  return 0;
+
+_err:
+  wWarn("vgId:%d, failed to recycle wal file %" PRId64 " since %s", pWal->cfg.vgId, fileFirstVer, strerror(errno));
+  walRemovePoolSlot(pWal, slot);
+  return -1;
+}
+
+int32_t walRecycleSegment(SWal *pWal, int64_t fileFirstVer) {
+  walSparseIdxRemove(pWal, fileFirstVer);
+
+  // the write file itself is dropped when all files are removed, it is still open and must not be reused
+  if (pWal->writeCur >= 0 && walPutPoolSegment(pWal, fileFirstVer) == 0) {
+    return 0;
+  }
+
+  char fnameStr[WAL_FILE_LEN];
+  walBuildLogName(pWal, fileFirstVer, fnameStr);
+  if (taosRemoveFile(fnameStr) < 0 && errno != ENOENT) {
+    wError("vgId:%d, failed to remove log file %s due to %s", pWal->cfg.vgId, fnameStr, strerror(errno));
+    return -1;
+  }
+  walBuildIdxName(pWal, fileFirstVer, fnameStr);
+  if (taosRemoveFile(fnameStr) < 0 && errno != ENOENT) {
+    wError("vgId:%d, failed to remove idx file %s due to %s", pWal->cfg.vgId, fnameStr, strerror(errno));
+    return -1;
+  }
+  return 0;
+}
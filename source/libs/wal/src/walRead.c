@@ -15,6 +15,7 @@
 
 #include "crypt.h"
 #include "taoserror.h"
+#include "tglobal.h"
 #include "wal.h"
 #include "walInt.h"
 
@@ -31,6 +32,7 @@ SWalReader *walOpenReader(SWal *pWal, SWalFilterCond *cond, int64_t id) {
   pReader->pLogFile = NULL;
   pReader->curVersion = -1;
   pReader->curFileFirstVer = -1;
+  pReader->curOffset = 0;
   pReader->capacity = 0;
   if (cond) {
     pReader->cond = *cond;
@@ -57,11 +59,21 @@ SWalReader *walOpenReader(SWal *pWal, SWalFilterCond *cond, int64_t id) {
   return pReader;
 }
 
-void walCloseReader(SWalReader *pReader) {
-  if(pReader == NULL) return;
+// the segment ref is held as long as the log file is open
+static void walReadCloseFiles(SWalReader *pReader) {
+  bool opened = pReader->pLogFile != NULL;
 
   taosCloseFile(&pReader->pIdxFile);
   taosCloseFile(&pReader->pLogFile);
+  if (opened) {
+    walSegUnref(pReader->pWal, pReader->curFileFirstVer);
+  }
+}
+
+void walCloseReader(SWalReader *pReader) {
+  if(pReader == NULL) return;
+
+  walReadCloseFiles(pReader);
   taosMemoryFreeClear(pReader->pHead);
   taosMemoryFree(pReader);
 }
@@ -130,11 +142,74 @@ void walReaderVerifyOffset(SWalReader *pWalReader, STqOffsetVal* pOffset){
   }
 }
 
+// read from the hot tail of the write file if possible, from the file otherwise
+static int64_t walReaderReadLog(SWalReader *pReader, void *buf, int64_t len) {
+  int64_t n = -1;
+
+  if (walTailRead(pReader->pWal, pReader->curFileFirstVer, pReader->curOffset, buf, len)) {
+    n = len;
+  } else {
+    n = taosPReadFile(pReader->pLogFile, buf, len, pReader->curOffset);
+  }
+
+  if (n > 0) {
+    pReader->curOffset += n;
+  }
+  return n;
+}
+
+// walk the log heads from the nearest sampled version of the sparse index, the idx file is not touched
+static int32_t walReadSeekSparse(SWalReader *pReader, int64_t fileFirstVer, int64_t ver) {
+  int64_t    baseVer = 0;
+  int64_t    offset = 0;
+  SWalCkHead head;
+
+  if (!walSparseIdxLookup(pReader->pWal, fileFirstVer, ver, &baseVer, &offset)) {
+    return -1;
+  }
+
+  pReader->curOffset = offset;
+  for (int64_t v = baseVer;; v++) {
+    int64_t headOffset = pReader->curOffset;
+    if (walReaderReadLog(pReader, &head, sizeof(SWalCkHead)) != sizeof(SWalCkHead)) {
+      return -1;
+    }
+    if (walValidHeadCksum(&head) != 0 || head.head.version != v) {
+      return -1;
+    }
+    if (v == ver) {
+      pReader->curOffset = headOffset;
+      return 0;
+    }
+
+    int64_t cryptedBodyLen = head.head.bodyLen;
+    if (pReader->pWal->cfg.encryptAlgorithm == DND_CA_SM4) {
+      cryptedBodyLen = ENCRYPTED_LEN(cryptedBodyLen);
+    }
+    pReader->curOffset += cryptedBodyLen;
+  }
+}
+
 static int64_t walReadSeekFilePos(SWalReader *pReader, int64_t fileFirstVer, int64_t ver) {
   int64_t ret = 0;
 
+  if (walReadSeekSparse(pReader, fileFirstVer, ver) == 0) {
+    return pReader->curOffset;
+  }
+
+  // the idx file is opened on the first seek the sparse index can not serve
+  if (pReader->pIdxFile == NULL) {
+    char fnameStr[WAL_FILE_LEN] = {0};
+    walBuildIdxName(pReader->pWal, fileFirstVer, fnameStr);
+    pReader->pIdxFile = taosOpenFile(fnameStr, TD_FILE_READ);
+    if (pReader->pIdxFile == NULL) {
+      terrno = TAOS_SYSTEM_ERROR(errno);
+      wError("vgId:%d, cannot open file %s, since %s", pReader->pWal->cfg.vgId, fnameStr, terrstr());
+      return -1;
+    }
+  }
+
   TdFilePtr pIdxTFile = pReader->pIdxFile;
-  TdFilePtr pLogTFile = pReader->pLogFile;
 
   // seek position
   int64_t offset = (ver - fileFirstVer) * sizeof(SWalIdxEntry);
@@ -158,42 +233,39 @@ static int64_t walReadSeekFilePos(SWalReader *pReader, int64_t fileFirstVer, int
     return -1;
   }
 
-  ret = taosLSeekFile(pLogTFile, entry.offset, SEEK_SET);
-  if (ret < 0) {
-    terrno = TAOS_SYSTEM_ERROR(errno);
-    wError("vgId:%d, failed to seek log file, index:%" PRId64 ", pos:%" PRId64 ", since %s", pReader->pWal->cfg.vgId,
-           ver, entry.offset, terrstr());
+  if (entry.offset < 0) {
+    terrno = TSDB_CODE_WAL_FILE_CORRUPTED;
+    wError("vgId:%d, invalid log file pos, index:%" PRId64 ", pos:%" PRId64, pReader->pWal->cfg.vgId, ver,
+           entry.offset);
     return -1;
   }
-  return ret;
+
+  // the log file is read positionally, only the reader offset moves
+  pReader->curOffset = entry.offset;
+  return entry.offset;
 }
 
 static int32_t walReadChangeFile(SWalReader *pReader, int64_t fileFirstVer) {
   char fnameStr[WAL_FILE_LEN] = {0};
 
-  taosCloseFile(&pReader->pIdxFile);
-  taosCloseFile(&pReader->pLogFile);
+  walReadCloseFiles(pReader);
+  pReader->curOffset = 0;
+
+  if (walSegRef(pReader->pWal, fileFirstVer) < 0) {
+    wError("vgId:%d, cannot ref wal file %" PRId64 ", since %s", pReader->pWal->cfg.vgId, fileFirstVer, terrstr());
+    return -1;
+  }
 
   walBuildLogName(pReader->pWal, fileFirstVer, fnameStr);
   TdFilePtr pLogFile = taosOpenFile(fnameStr, TD_FILE_READ);
   if (pLogFile == NULL) {
     terrno = TAOS_SYSTEM_ERROR(errno);
     wError("vgId:%d, cannot open file %s, since %s", pReader->pWal->cfg.vgId, fnameStr, terrstr());
+    walSegUnref(pReader->pWal, fileFirstVer);
     return -1;
   }
 
   pReader->pLogFile = pLogFile;
-
-  walBuildIdxName(pReader->pWal, fileFirstVer, fnameStr);
-  TdFilePtr pIdxFile = taosOpenFile(fnameStr, TD_FILE_READ);
-  if (pIdxFile == NULL) {
-    terrno = TAOS_SYSTEM_ERROR(errno);
-    wError("vgId:%d, cannot open file %s, since %s", pReader->pWal->cfg.vgId, fnameStr, terrstr());
-    return -1;
-  }
-
-  pReader->pIdxFile = pIdxFile;
-
   pReader->curFileFirstVer = fileFirstVer;
 
   return 0;
@@ -272,7 +344,7 @@ int32_t walFetchHead(SWalReader *pRead, int64_t ver) {
   }
 
   while (1) {
-    contLen = taosReadFile(pRead->pLogFile, pRead->pHead, sizeof(SWalCkHead));
+    contLen = walReaderReadLog(pRead, pRead->pHead, sizeof(SWalCkHead));
     if (contLen == sizeof(SWalCkHead)) {
       break;
     } else if (contLen == 0 && !seeked) {
@@ -315,13 +387,61 @@ int32_t walSkipFetchBody(SWalReader *pRead) {
   if(pRead->pWal->cfg.encryptAlgorithm == 1){
     cryptedBodyLen = ENCRYPTED_LEN(cryptedBodyLen);
   }
-  int64_t code = taosLSeekFile(pRead->pLogFile, cryptedBodyLen, SEEK_CUR);
-  if (code < 0) {
-    terrno = TAOS_SYSTEM_ERROR(errno);
+  pRead->curOffset += cryptedBodyLen;
+
+  pRead->curVersion++;
+  return 0;
+}
+
+// replace a compressed body by its raw content, the reader sees the entry as if it were written uncompressed
+static int32_t walDecompressBody(SWalReader *pReader) {
+  SWalCont *pReadHead = &pReader->pHead->head;
+  uint8_t   alg = WAL_BODY_CODEC(pReadHead->protoVer);
+  if (alg == L2_UNKNOWN) {
+    return 0;
+  }
+
+  if ((alg != L2_LZ4 && alg != L2_ZSTD) || pReadHead->bodyLen <= sizeof(int32_t)) {
+    terrno = TSDB_CODE_WAL_FILE_CORRUPTED;
     return -1;
   }
 
-  pRead->curVersion++;
+  int32_t rawLen = *(int32_t *)pReadHead->body;
+  if (rawLen < 0) {
+    terrno = TSDB_CODE_WAL_FILE_CORRUPTED;
+    return -1;
+  }
+
+  char *pRaw = taosMemoryMalloc(rawLen + 1);
+  if (pRaw == NULL) {
+    terrno = TSDB_CODE_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  int32_t len = compressL2Dict[alg].decomprFn(pReadHead->body + sizeof(int32_t), pReadHead->bodyLen - sizeof(int32_t),
+                                              pRaw, rawLen, TSDB_DATA_TYPE_BINARY);
+  if (len != rawLen) {
+    taosMemoryFree(pRaw);
+    terrno = TSDB_CODE_WAL_FILE_CORRUPTED;
+    return -1;
+  }
+
+  if (pReader->capacity < rawLen) {
+    SWalCkHead *ptr = (SWalCkHead *)taosMemoryRealloc(pReader->pHead, sizeof(SWalCkHead) + rawLen);
+    if (ptr == NULL) {
+      taosMemoryFree(pRaw);
+      terrno = TSDB_CODE_OUT_OF_MEMORY;
+      return -1;
+    }
+    pReader->pHead = ptr;
+    pReader->capacity = rawLen;
+    pReadHead = &pReader->pHead->head;
+  }
+
+  memcpy(pReadHead->body, pRaw, rawLen);
+  pReadHead->bodyLen = rawLen;
+  pReadHead->protoVer = WAL_PROTO_VER;
+  taosMemoryFree(pRaw);
   return 0;
 }
 
@@ -355,7 +475,7 @@ int32_t walFetchBody(SWalReader *pRead) {
     pRead->capacity = cryptedBodyLen;
   }
 
-  if (cryptedBodyLen != taosReadFile(pRead->pLogFile, pReadHead->body, cryptedBodyLen)) {
+  if (cryptedBodyLen != walReaderReadLog(pRead, pReadHead->body, cryptedBodyLen)) {
     if (plainBodyLen < 0) {
       terrno = TAOS_SYSTEM_ERROR(errno);
       wError("vgId:%d, wal fetch body error:%" PRId64 ", read request index:%" PRId64 ", since %s, 0x%"PRIx64,
@@ -383,6 +503,11 @@ int32_t walFetchBody(SWalReader *pRead) {
     return -1;
   }
 
+  if (walDecompressBody(pRead) < 0) {
+    wError("vgId:%d, wal fetch body error, index:%" PRId64 ", since decompress failed, 0x%" PRIx64, vgId, ver, id);
+    return -1;
+  }
+
   pRead->curVersion++;
   return 0;
 }
@@ -417,7 +542,7 @@ int32_t walReadVer(SWalReader *pReader, int64_t ver) {
   }
 
   while (1) {
-    contLen = taosReadFile(pReader->pLogFile, pReader->pHead, sizeof(SWalCkHead));
+    contLen = walReaderReadLog(pReader, pReader->pHead, sizeof(SWalCkHead));
     if (contLen == sizeof(SWalCkHead)) {
       break;
     } else if (contLen == 0 && !seeked) {
@@ -469,7 +594,7 @@ int32_t walReadVer(SWalReader *pReader, int64_t ver) {
     pReader->capacity = cryptedBodyLen;
   }
 
-  if ((contLen = taosReadFile(pReader->pLogFile, pReader->pHead->head.body, cryptedBodyLen)) !=
+  if ((contLen = walReaderReadLog(pReader, pReader->pHead->head.body, cryptedBodyLen)) !=
       cryptedBodyLen) {
     if (contLen < 0)
       terrno = TAOS_SYSTEM_ERROR(errno);
@@ -505,6 +630,12 @@ int32_t walReadVer(SWalReader *pReader, int64_t ver) {
     taosThreadMutexUnlock(&pReader->mutex);
     return -1;
   }
+
+  if (walDecompressBody(pReader) < 0) {
+    wError("vgId:%d, unexpected wal log, index:%" PRId64 ", since decompress failed", pReader->pWal->cfg.vgId, ver);
+    taosThreadMutexUnlock(&pReader->mutex);
+    return -1;
+  }
   pReader->curVersion++;
 
   taosThreadMutexUnlock(&pReader->mutex);
@@ -537,8 +668,8 @@ void decryptBody(SWalCfg* cfg, SWalCkHead* pHead, int32_t plainBodyLen, const ch
 
 void walReadReset(SWalReader *pReader) {
   taosThreadMutexLock(&pReader->mutex);
-  taosCloseFile(&pReader->pIdxFile);
-  taosCloseFile(&pReader->pLogFile);
+  walReadCloseFiles(pReader);
+  pReader->curOffset = 0;
   pReader->curFileFirstVer = -1;
   pReader->curVersion = -1;
   taosThreadMutexUnlock(&pReader->mutex);
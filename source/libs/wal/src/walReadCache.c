@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "taoserror.h"
+#include "tglobal.h"
+#include "walInt.h"
+
+// Read path state shared by all readers of a wal:
+// - segments whose files a reader has open are ref counted, the segment pool only takes a file no reader holds, so a
+//   recycled inode is never truncated under an open fd.
+// - the last bytes appended to the write file are kept in a sliding buffer, so readers following the head of the
+//   log are served from memory.
+
+int32_t walReadCacheOpen(SWal *pWal) {
+  if (taosThreadRwlockInit(&pWal->segRefLock, NULL) != 0) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    return -1;
+  }
+
+  if (taosThreadRwlockInit(&pWal->tailLock, NULL) != 0) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    taosThreadRwlockDestroy(&pWal->segRefLock);
+    return -1;
+  }
+
+  pWal->pSegRefs = taosArrayInit(4, sizeof(SWalSegRef));
+  if (pWal->pSegRefs == NULL) {
+    terrno = TSDB_CODE_OUT_OF_MEMORY;
+    taosThreadRwlockDestroy(&pWal->tailLock);
+    taosThreadRwlockDestroy(&pWal->segRefLock);
+    return -1;
+  }
+
+  pWal->tailBuf = NULL;
+  pWal->tailCap = (int64_t)tsWalTailCacheSize * 1024;
+  pWal->tailFileFirstVer = -1;
+  pWal->tailStart = 0;
+  pWal->tailLen = 0;
+  return 0;
+}
+
+void walReadCacheClose(SWal *pWal) {
+  if (pWal->pSegRefs == NULL) return;
+
+  taosArrayDestroy(pWal->pSegRefs);
+  pWal->pSegRefs = NULL;
+  taosMemoryFreeClear(pWal->tailBuf);
+
+  taosThreadRwlockDestroy(&pWal->tailLock);
+  taosThreadRwlockDestroy(&pWal->segRefLock);
+}
+
+static SWalSegRef *walSegRefFind(SWal *pWal, int64_t fileFirstVer) {
+  for (int32_t i = 0; i < taosArrayGetSize(pWal->pSegRefs); i++) {
+    SWalSegRef *pRef = taosArrayGet(pWal->pSegRefs, i);
+    if (pRef->fileFirstVer == fileFirstVer) return pRef;
+  }
+  return NULL;
+}
+
+// taken before a reader opens the files of a segment, held until it closes them
+int32_t walSegRef(SWal *pWal, int64_t fileFirstVer) {
+  int32_t code = 0;
+
+  taosThreadRwlockWrlock(&pWal->segRefLock);
+  SWalSegRef *pRef = walSegRefFind(pWal, fileFirstVer);
+  if (pRef) {
+    pRef->refCount++;
+  } else {
+    SWalSegRef ref = {.fileFirstVer = fileFirstVer, .refCount = 1};
+    if (taosArrayPush(pWal->pSegRefs, &ref) == NULL) {
+      terrno = TSDB_CODE_OUT_OF_MEMORY;
+      code = -1;
+    }
+  }
+  taosThreadRwlockUnlock(&pWal->segRefLock);
+  return code;
+}
+
+void walSegUnref(SWal *pWal, int64_t fileFirstVer) {
+  taosThreadRwlockWrlock(&pWal->segRefLock);
+  SWalSegRef *pRef = walSegRefFind(pWal, fileFirstVer);
+  if (pRef && --pRef->refCount <= 0) {
+    taosArrayRemove(pWal->pSegRefs, TARRAY_ELEM_IDX(pWal->pSegRefs, pRef));
+  }
+  taosThreadRwlockUnlock(&pWal->segRefLock);
+}
+
+// write lock held, so that no reader refs the segment before its files are moved away
+bool walSegInUse(SWal *pWal, int64_t fileFirstVer) { return walSegRefFind(pWal, fileFirstVer) != NULL; }
+
+void walTailAppend(SWal *pWal, int64_t fileFirstVer, int64_t offset, const void *head, int64_t headLen,
+                   const void *body, int64_t bodyLen) {
+  int64_t len = headLen + bodyLen;
+  if (pWal->tailCap <= 0) return;
+
+  taosThreadRwlockWrlock(&pWal->tailLock);
+
+  if (pWal->tailBuf == NULL) {
+    pWal->tailBuf = taosMemoryMalloc(pWal->tailCap);
+    if (pWal->tailBuf == NULL) {
+      pWal->tailCap = 0;
+      taosThreadRwlockUnlock(&pWal->tailLock);
+      return;
+    }
+  }
+
+  if (pWal->tailFileFirstVer != fileFirstVer || pWal->tailStart + pWal->tailLen != offset) {
+    pWal->tailFileFirstVer = fileFirstVer;
+    pWal->tailStart = offset;
+    pWal->tailLen = 0;
+  }
+
+  if (len > pWal->tailCap) {
+    pWal->tailStart = offset + len;
+    pWal->tailLen = 0;
+    taosThreadRwlockUnlock(&pWal->tailLock);
+    return;
+  }
+
+  if (pWal->tailLen + len > pWal->tailCap) {
+    // slide by at least half of the buffer, so the move is amortized over many appends
+    int64_t keep = TMIN(pWal->tailLen, TMIN(pWal->tailCap / 2, pWal->tailCap - len));
+    memmove(pWal->tailBuf, pWal->tailBuf + pWal->tailLen - keep, keep);
+    pWal->tailStart += pWal->tailLen - keep;
+    pWal->tailLen = keep;
+  }
+
+  memcpy(pWal->tailBuf + pWal->tailLen, head, headLen);
+  memcpy(pWal->tailBuf + pWal->tailLen + headLen, body, bodyLen);
+  pWal->tailLen += len;
+
+  taosThreadRwlockUnlock(&pWal->tailLock);
+}
+
+void walTailReset(SWal *pWal) {
+  if (pWal->tailCap <= 0) return;
+
+  taosThreadRwlockWrlock(&pWal->tailLock);
+  pWal->tailFileFirstVer = -1;
+  pWal->tailStart = 0;
+  pWal->tailLen = 0;
+  taosThreadRwlockUnlock(&pWal->tailLock);
+}
+
+bool walTailRead(SWal *pWal, int64_t fileFirstVer, int64_t offset, void *buf, int64_t len) {
+  bool hit = false;
+  if (pWal->tailCap <= 0) return false;
+
+  taosThreadRwlockRdlock(&pWal->tailLock);
+  if (pWal->tailFileFirstVer == fileFirstVer && offset >= pWal->tailStart &&
+      offset + len <= pWal->tailStart + pWal->tailLen) {
+    memcpy(buf, pWal->tailBuf + (offset - pWal->tailStart), len);
+    hit = true;
+  }
+  taosThreadRwlockUnlock(&pWal->tailLock);
+
+  return hit;
+}
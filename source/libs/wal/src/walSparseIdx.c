@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "taoserror.h"
+#include "walInt.h"
+
+// Sparse index: for the WAL_SPARSE_IDX_FILES most recent segments, the log offset of every WAL_SPARSE_IDX_STEP-th
+// version is kept in memory. Offsets of a segment are always a dense prefix, pOffsets[k] is the offset of version
+// fileFirstVer + k * WAL_SPARSE_IDX_STEP, so readers seek to the nearest sampled entry and walk the log heads from
+// there instead of reading the idx file.
+
+static void walSparseIdxDestroyEntry(void *param) { taosArrayDestroy(((SWalSparseIdx *)param)->pOffsets); }
+
+int32_t walSparseIdxOpen(SWal *pWal) {
+  if (taosThreadRwlockInit(&pWal->sparseIdxLock, NULL) != 0) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    return -1;
+  }
+
+  pWal->pSparseIdx = taosArrayInit(WAL_SPARSE_IDX_FILES, sizeof(SWalSparseIdx));
+  if (pWal->pSparseIdx == NULL) {
+    terrno = TSDB_CODE_OUT_OF_MEMORY;
+    taosThreadRwlockDestroy(&pWal->sparseIdxLock);
+    return -1;
+  }
+  return 0;
+}
+
+void walSparseIdxClose(SWal *pWal) {
+  if (pWal->pSparseIdx == NULL) return;
+
+  taosArrayDestroyEx(pWal->pSparseIdx, walSparseIdxDestroyEntry);
+  pWal->pSparseIdx = NULL;
+  taosThreadRwlockDestroy(&pWal->sparseIdxLock);
+}
+
+static int32_t walSparseIdxFind(SWal *pWal, int64_t fileFirstVer) {
+  for (int32_t i = taosArrayGetSize(pWal->pSparseIdx) - 1; i >= 0; i--) {
+    SWalSparseIdx *pIdx = taosArrayGet(pWal->pSparseIdx, i);
+    if (pIdx->fileFirstVer == fileFirstVer) return i;
+  }
+  return -1;
+}
+
+// new segments are appended in version order, the oldest one is dropped beyond WAL_SPARSE_IDX_FILES, write lock held
+static SWalSparseIdx *walSparseIdxAdd(SWal *pWal, int64_t fileFirstVer) {
+  SWalSparseIdx idx = {.fileFirstVer = fileFirstVer};
+  idx.pOffsets = taosArrayInit(64, sizeof(int64_t));
+  if (idx.pOffsets == NULL) return NULL;
+
+  if (taosArrayPush(pWal->pSparseIdx, &idx) == NULL) {
+    taosArrayDestroy(idx.pOffsets);
+    return NULL;
+  }
+
+  while (taosArrayGetSize(pWal->pSparseIdx) > WAL_SPARSE_IDX_FILES) {
+    walSparseIdxDestroyEntry(taosArrayGet(pWal->pSparseIdx, 0));
+    taosArrayRemove(pWal->pSparseIdx, 0);
+  }
+  return taosArrayGetLast(pWal->pSparseIdx);
+}
+
+static void walSparseIdxDrop(SWal *pWal, int32_t i) {
+  walSparseIdxDestroyEntry(taosArrayGet(pWal->pSparseIdx, i));
+  taosArrayRemove(pWal->pSparseIdx, i);
+}
+
+static int32_t walSparseIdxLoadFile(SWal *pWal, SWalFileInfo *pInfo, SWalSparseIdx *pIdx) {
+  char fnameStr[WAL_FILE_LEN];
+  walBuildIdxName(pWal, pInfo->firstVer, fnameStr);
+
+  TdFilePtr pIdxFile = taosOpenFile(fnameStr, TD_FILE_READ);
+  if (pIdxFile == NULL) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    return -1;
+  }
+
+  const int32_t batch = 4096;
+  SWalIdxEntry *pEntries = taosMemoryMalloc(batch * sizeof(SWalIdxEntry));
+  if (pEntries == NULL) {
+    terrno = TSDB_CODE_OUT_OF_MEMORY;
+    taosCloseFile(&pIdxFile);
+    return -1;
+  }
+
+  int32_t code = 0;
+  int64_t ver = pInfo->firstVer;
+  while (ver <= pInfo->lastVer) {
+    int64_t count = TMIN(batch, pInfo->lastVer - ver + 1);
+    int64_t size = count * sizeof(SWalIdxEntry);
+    if (taosReadFile(pIdxFile, pEntries, size) != size) {
+      terrno = TSDB_CODE_WAL_FILE_CORRUPTED;
+      code = -1;
+      break;
+    }
+
+    for (int64_t i = 0; i < count; i++, ver++) {
+      if ((ver - pInfo->firstVer) % WAL_SPARSE_IDX_STEP != 0) continue;
+      if (pEntries[i].ver != ver) {
+        terrno = TSDB_CODE_WAL_FILE_CORRUPTED;
+        code = -1;
+        break;
+      }
+      taosArrayPush(pIdx->pOffsets, &pEntries[i].offset);
+    }
+    if (code != 0) break;
+  }
+
+  taosMemoryFree(pEntries);
+  taosCloseFile(&pIdxFile);
+  return code;
+}
+
+void walSparseIdxLoad(SWal *pWal) {
+  int32_t sz = taosArrayGetSize(pWal->fileInfoSet);
+
+  taosThreadRwlockWrlock(&pWal->sparseIdxLock);
+  for (int32_t i = TMAX(0, sz - WAL_SPARSE_IDX_FILES); i < sz; i++) {
+    SWalFileInfo  *pInfo = taosArrayGet(pWal->fileInfoSet, i);
+    SWalSparseIdx *pIdx = walSparseIdxAdd(pWal, pInfo->firstVer);
+    if (pIdx == NULL) break;
+
+    if (walSparseIdxLoadFile(pWal, pInfo, pIdx) < 0) {
+      wWarn("vgId:%d, failed to load sparse index of file %" PRId64 " since %s", pWal->cfg.vgId, pInfo->firstVer,
+            terrstr());
+      walSparseIdxDrop(pWal, taosArrayGetSize(pWal->pSparseIdx) - 1);
+    }
+  }
+  taosThreadRwlockUnlock(&pWal->sparseIdxLock);
+}
+
+void walSparseIdxAppend(SWal *pWal, int64_t fileFirstVer, int64_t ver, int64_t offset) {
+  if ((ver - fileFirstVer) % WAL_SPARSE_IDX_STEP != 0) return;
+
+  taosThreadRwlockWrlock(&pWal->sparseIdxLock);
+  int32_t        i = walSparseIdxFind(pWal, fileFirstVer);
+  SWalSparseIdx *pIdx = NULL;
+  if (i >= 0) {
+    pIdx = taosArrayGet(pWal->pSparseIdx, i);
+  } else if (ver == fileFirstVer) {
+    pIdx = walSparseIdxAdd(pWal, fileFirstVer);
+  }
+
+  if (pIdx != NULL) {
+    if (taosArrayGetSize(pIdx->pOffsets) == (ver - fileFirstVer) / WAL_SPARSE_IDX_STEP) {
+      taosArrayPush(pIdx->pOffsets, &offset);
+    } else {
+      // a hole would make later lookups wrong, forget the segment and let readers use the idx file
+      walSparseIdxDrop(pWal, walSparseIdxFind(pWal, fileFirstVer));
+    }
+  }
+  taosThreadRwlockUnlock(&pWal->sparseIdxLock);
+}
+
+void walSparseIdxTruncate(SWal *pWal, int64_t ver) {
+  taosThreadRwlockWrlock(&pWal->sparseIdxLock);
+  for (int32_t i = taosArrayGetSize(pWal->pSparseIdx) - 1; i >= 0; i--) {
+    SWalSparseIdx *pIdx = taosArrayGet(pWal->pSparseIdx, i);
+    if (pIdx->fileFirstVer >= ver) {
+      walSparseIdxDrop(pWal, i);
+      continue;
+    }
+
+    int64_t keep = (ver - pIdx->fileFirstVer + WAL_SPARSE_IDX_STEP - 1) / WAL_SPARSE_IDX_STEP;
+    if (taosArrayGetSize(pIdx->pOffsets) > keep) {
+      taosArrayPopTailBatch(pIdx->pOffsets, taosArrayGetSize(pIdx->pOffsets) - keep);
+    }
+    break;
+  }
+  taosThreadRwlockUnlock(&pWal->sparseIdxLock);
+}
+
+void walSparseIdxRemove(SWal *pWal, int64_t fileFirstVer) {
+  taosThreadRwlockWrlock(&pWal->sparseIdxLock);
+  int32_t i = walSparseIdxFind(pWal, fileFirstVer);
+  if (i >= 0) walSparseIdxDrop(pWal, i);
+  taosThreadRwlockUnlock(&pWal->sparseIdxLock);
+}
+
+void walSparseIdxClear(SWal *pWal) {
+  taosThreadRwlockWrlock(&pWal->sparseIdxLock);
+  while (taosArrayGetSize(pWal->pSparseIdx) > 0) {
+    walSparseIdxDrop(pWal, 0);
+  }
+  taosThreadRwlockUnlock(&pWal->sparseIdxLock);
+}
+
+bool walSparseIdxLookup(SWal *pWal, int64_t fileFirstVer, int64_t ver, int64_t *pVer, int64_t *pOffset) {
+  bool found = false;
+
+  taosThreadRwlockRdlock(&pWal->sparseIdxLock);
+  int32_t i = walSparseIdxFind(pWal, fileFirstVer);
+  if (i >= 0 && ver >= fileFirstVer) {
+    SWalSparseIdx *pIdx = taosArrayGet(pWal->pSparseIdx, i);
+    int64_t        k = TMIN((ver - fileFirstVer) / WAL_SPARSE_IDX_STEP, (int64_t)taosArrayGetSize(pIdx->pOffsets) - 1);
+    if (k >= 0) {
+      *pVer = fileFirstVer + k * WAL_SPARSE_IDX_STEP;
+      *pOffset = *(int64_t *)taosArrayGet(pIdx->pOffsets, k);
+      found = true;
+    }
+  }
+  taosThreadRwlockUnlock(&pWal->sparseIdxLock);
+
+  return found;
+}
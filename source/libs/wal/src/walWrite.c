@@ -39,6 +39,8 @@ int32_t walRestoreFromSnapshot(SWal *pWal, int64_t ver) {
 
   taosCloseFile(&pWal->pLogFile);
   taosCloseFile(&pWal->pIdxFile);
+  walTailReset(pWal);
+  walSparseIdxClear(pWal);
 
   if (pWal->vers.firstVer != -1) {
     int32_t fileSetSize = taosArrayGetSize(pWal->fileInfoSet);
@@ -110,6 +112,9 @@ int32_t walRollback(SWal *pWal, int64_t ver) {
     return -1;
   }
 
+  walTailReset(pWal);
+  walSparseIdxTruncate(pWal, ver);
+
   // find correct file
   if (ver < walGetLastFileFirstVer(pWal)) {
     // change current files
@@ -362,22 +367,13 @@ int32_t walEndSnapshot(SWal *pWal) {
     goto END;
   }
 
-  // delete files
+  // delete files, or keep them in the segment pool for reuse
   deleteCnt = taosArrayGetSize(pWal->toDeleteFiles);
-  char fnameStr[WAL_FILE_LEN] = {0};
   pInfo = NULL;
 
   for (int i = 0; i < deleteCnt; i++) {
     pInfo = taosArrayGet(pWal->toDeleteFiles, i);
-
-    walBuildLogName(pWal, pInfo->firstVer, fnameStr);
-    if (taosRemoveFile(fnameStr) < 0 && errno != ENOENT) {
-      wError("vgId:%d, failed to remove log file %s due to %s", pWal->cfg.vgId, fnameStr, strerror(errno));
-      goto END;
-    }
-    walBuildIdxName(pWal, pInfo->firstVer, fnameStr);
-    if (taosRemoveFile(fnameStr) < 0 && errno != ENOENT) {
-      wError("vgId:%d, failed to remove idx file %s due to %s", pWal->cfg.vgId, fnameStr, strerror(errno));
+    if (walRecycleSegment(pWal, pInfo->firstVer) < 0) {
       goto END;
     }
   }
@@ -423,6 +419,7 @@ int32_t walRollImpl(SWal *pWal) {
   // create new file
   int64_t newFileFirstVer = pWal->vers.lastVer + 1;
   char    fnameStr[WAL_FILE_LEN];
+  bool    pooled = walTakePoolSegment(pWal, newFileFirstVer);
   walBuildIdxName(pWal, newFileFirstVer, fnameStr);
   pIdxFile = taosOpenFile(fnameStr, TD_FILE_CREATE | TD_FILE_WRITE | TD_FILE_APPEND);
   if (pIdxFile == NULL) {
@@ -438,6 +435,9 @@ int32_t walRollImpl(SWal *pWal) {
     code = -1;
     goto END;
   }
+  if (!pooled) {
+    walPreallocSegment(pWal, pLogFile);
+  }
   // error code was set inner
   code = walRollFileInfo(pWal);
   if (code != 0) {
@@ -487,14 +487,51 @@ static int32_t walWriteIndex(SWal *pWal, int64_t ver, int64_t offset) {
   return 0;
 }
 
+// compress body into a new buffer laid out as [raw length][codec output], return the stored length or 0 if the body
+// is kept raw
+static int32_t walCompressBody(SWal *pWal, const void *body, int32_t bodyLen, char **ppCmprBody) {
+  uint8_t alg = pWal->compressAlg;
+  if (alg == L2_UNKNOWN || bodyLen < atomic_load_32(&tsWalCompressMinSize)) {
+    return 0;
+  }
+
+  // the codec falls back to a raw copy of at most bodyLen + 1 bytes when it cannot shrink the data
+  char *pCmprBody = taosMemoryMalloc(sizeof(int32_t) + bodyLen + 1);
+  if (pCmprBody == NULL) {
+    return 0;
+  }
+
+  *(int32_t *)pCmprBody = bodyLen;
+  int32_t len = compressL2Dict[alg].comprFn(body, bodyLen, pCmprBody + sizeof(int32_t), bodyLen + 1,
+                                            TSDB_DATA_TYPE_BINARY, tsGetCompressL2Level(alg, L2_LVL_LOW));
+  if (len <= 0 || pCmprBody[sizeof(int32_t)] != 1 || sizeof(int32_t) + len >= bodyLen) {
+    taosMemoryFree(pCmprBody);
+    return 0;
+  }
+
+  *ppCmprBody = pCmprBody;
+  return sizeof(int32_t) + len;
+}
+
 static FORCE_INLINE int32_t walWriteImpl(SWal *pWal, int64_t index, tmsg_t msgType, SWalSyncInfo syncMeta,
                                          const void *body, int32_t bodyLen) {
   int64_t code = 0;
   int32_t plainBodyLen = bodyLen;
+  char   *pCmprBody = NULL;
 
   int64_t       offset = walGetCurFileOffset(pWal);
   SWalFileInfo *pFileInfo = walGetCurFileInfo(pWal);
 
+  // compressed bodies are stored with their compressed length, so offsets and checksums cover what is on disk
+  int32_t cmprBodyLen = walCompressBody(pWal, body, bodyLen, &pCmprBody);
+  if (cmprBodyLen > 0) {
+    body = pCmprBody;
+    plainBodyLen = cmprBodyLen;
+    pWal->writeHead.head.protoVer = WAL_PROTO_WITH_CODEC(WAL_PROTO_VER, pWal->compressAlg);
+  } else {
+    pWal->writeHead.head.protoVer = WAL_PROTO_VER;
+  }
+
   pWal->writeHead.head.version = index;
   pWal->writeHead.head.bodyLen = plainBodyLen;
   pWal->writeHead.head.msgType = msgType;
@@ -578,6 +615,11 @@ static FORCE_INLINE int32_t walWriteImpl(SWal *pWal, int64_t index, tmsg_t msgTy
     goto END;
   }
 
+  if (pWal->cfg.level != TAOS_WAL_SKIP) {
+    walTailAppend(pWal, pFileInfo->firstVer, offset, &pWal->writeHead, sizeof(SWalCkHead), buf, cyptedBodyLen);
+    walSparseIdxAppend(pWal, pFileInfo->firstVer, index, offset);
+  }
+
   if (pWal->cfg.encryptAlgorithm == DND_CA_SM4) {
     taosMemoryFreeClear(newBody);
     taosMemoryFreeClear(newBodyEncrypted);
@@ -594,9 +636,12 @@ static FORCE_INLINE int32_t walWriteImpl(SWal *pWal, int64_t index, tmsg_t msgTy
   pFileInfo->lastVer = index;
   pFileInfo->fileSize += sizeof(SWalCkHead) + cyptedBodyLen;
 
+  taosMemoryFree(pCmprBody);
   return 0;
 
 END:
+  taosMemoryFree(pCmprBody);
+
   // recover in a reverse order
   if (taosFtruncateFile(pWal->pLogFile, offset) < 0) {
     terrno = TAOS_SYSTEM_ERROR(errno);
@@ -693,18 +738,22 @@ int32_t walWrite(SWal *pWal, int64_t index, tmsg_t msgType, const void *body, in
   return walWriteWithSyncInfo(pWal, index, msgType, syncMeta, body, bodyLen);
 }
 
-void walFsync(SWal *pWal, bool forceFsync) {
+int32_t walFsync(SWal *pWal, bool forceFsync) {
+  int32_t code = 0;
   if (pWal->cfg.level == TAOS_WAL_SKIP) {
-    return;
+    return 0;
   }
 
   taosThreadMutexLock(&pWal->mutex);
   if (forceFsync || (pWal->cfg.level == TAOS_WAL_FSYNC && pWal->cfg.fsyncPeriod == 0)) {
     wTrace("vgId:%d, fileId:%" PRId64 ".log, do fsync", pWal->cfg.vgId, walGetCurFileFirstVer(pWal));
     if (taosFsyncFile(pWal->pLogFile) < 0) {
+      terrno = TAOS_SYSTEM_ERROR(errno);
       wError("vgId:%d, file:%" PRId64 ".log, fsync failed since %s", pWal->cfg.vgId, walGetCurFileFirstVer(pWal),
              strerror(errno));
+      code = -1;
     }
   }
   taosThreadMutexUnlock(&pWal->mutex);
+  return code;
 }
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <queue>
 
+#include "tglobal.h"
 #include "walInt.h"
 
 const char* ranStr = "tvapq02tcp";
@@ -234,6 +235,108 @@ TEST_F(WalCleanEnv, write) {
   ASSERT_EQ(code, 0);
 }
 
+TEST_F(WalCleanEnv, compressBody) {
+  pWal->compressAlg = L2_LZ4;
+
+  const int bodyLen = 8192;
+  char      body[bodyLen];
+  for (int i = 0; i < bodyLen; i++) {
+    body[i] = ranStr[i % ranStrLen];
+  }
+
+  for (int i = 0; i < 10; i++) {
+    body[0] = 'a' + i;
+    ASSERT_EQ(walWrite(pWal, i, 0, body, bodyLen), 0);
+  }
+  // a short body is stored raw
+  ASSERT_EQ(walWrite(pWal, 10, 0, (void*)ranStr, ranStrLen), 0);
+  ASSERT_LT(pWal->totSize, 10 * bodyLen);
+
+  SWalReader* pRead = walOpenReader(pWal, NULL, 0);
+  ASSERT(pRead != NULL);
+  for (int i = 0; i < 10; i++) {
+    ASSERT_EQ(walReadVer(pRead, i), 0);
+    ASSERT_EQ(pRead->pHead->head.bodyLen, bodyLen);
+    ASSERT_EQ(pRead->pHead->head.protoVer, WAL_PROTO_VER);
+    ASSERT_EQ(pRead->pHead->head.body[0], 'a' + i);
+    ASSERT_EQ(memcmp(pRead->pHead->head.body + 1, body + 1, bodyLen - 1), 0);
+  }
+  ASSERT_EQ(walReadVer(pRead, 10), 0);
+  ASSERT_EQ(pRead->pHead->head.bodyLen, ranStrLen);
+  ASSERT_EQ(memcmp(pRead->pHead->head.body, ranStr, ranStrLen), 0);
+  walCloseReader(pRead);
+}
+
+TEST_F(WalCleanEnv, readCache) {
+  for (int i = 0; i < 5; i++) {
+    ASSERT_EQ(walWrite(pWal, i, i + 1, (void*)ranStr, ranStrLen), 0);
+  }
+  ASSERT_EQ(walRollImpl(pWal), 0);
+  for (int i = 5; i < 10; i++) {
+    ASSERT_EQ(walWrite(pWal, i, i + 1, (void*)ranStr, ranStrLen), 0);
+  }
+
+  // the tail holds the write file only
+  SWalFileInfo* pLast = (SWalFileInfo*)taosArrayGetLast(pWal->fileInfoSet);
+  ASSERT_EQ(pWal->tailFileFirstVer, pLast->firstVer);
+  ASSERT_EQ(pWal->tailStart, 0);
+  ASSERT_EQ(pWal->tailLen, 5 * (sizeof(SWalCkHead) + ranStrLen));
+
+  SWalReader* pRead = walOpenReader(pWal, NULL, 0);
+  ASSERT(pRead != NULL);
+  for (int i = 0; i < 10; i++) {
+    ASSERT_EQ(walReadVer(pRead, i), 0);
+    ASSERT_EQ(pRead->pHead->head.msgType, i + 1);
+    ASSERT_EQ(memcmp(pRead->pHead->head.body, ranStr, ranStrLen), 0);
+  }
+
+  // the tail is dropped before the files are truncated, reads go to the file
+  ASSERT_EQ(walReadVer(pRead, 2), 0);
+  ASSERT_EQ(walRollback(pWal, 4), 0);
+  ASSERT_EQ(pWal->tailLen, 0);
+  ASSERT_EQ(walReadVer(pRead, 3), 0);
+  ASSERT_EQ(pRead->pHead->head.msgType, 4);
+  ASSERT_NE(walReadVer(pRead, 4), 0);
+
+  walCloseReader(pRead);
+  ASSERT_EQ(taosArrayGetSize(pWal->pSegRefs), 0);
+}
+
+TEST_F(WalCleanEnv, sparseIdx) {
+  for (int i = 0; i < 50; i++) {
+    ASSERT_EQ(walWrite(pWal, i, i + 1, (void*)ranStr, ranStrLen), 0);
+  }
+  ASSERT_EQ(walRollImpl(pWal), 0);
+  for (int i = 50; i < 100; i++) {
+    ASSERT_EQ(walWrite(pWal, i, i + 1, (void*)ranStr, ranStrLen), 0);
+  }
+  ASSERT_EQ(taosArrayGetSize(pWal->pSparseIdx), 2);
+  ASSERT_EQ(taosArrayGetSize(((SWalSparseIdx*)taosArrayGet(pWal->pSparseIdx, 0))->pOffsets), 4);
+
+  // seeks are served without the idx files
+  char fnameStr[WAL_FILE_LEN];
+  walBuildIdxName(pWal, 0, fnameStr);
+  ASSERT_EQ(taosRemoveFile(fnameStr), 0);
+  walBuildIdxName(pWal, 50, fnameStr);
+  ASSERT_EQ(taosRemoveFile(fnameStr), 0);
+
+  SWalReader* pRead = walOpenReader(pWal, NULL, 0);
+  ASSERT(pRead != NULL);
+  int vers[] = {99, 0, 17, 63, 49, 50, 31, 80};
+  for (int i = 0; i < sizeof(vers) / sizeof(vers[0]); i++) {
+    ASSERT_EQ(walReadVer(pRead, vers[i]), 0);
+    ASSERT_EQ(pRead->pHead->head.version, vers[i]);
+    ASSERT_EQ(pRead->pHead->head.msgType, vers[i] + 1);
+  }
+  ASSERT(pRead->pIdxFile == NULL);
+  walCloseReader(pRead);
+
+  walSparseIdxTruncate(pWal, 70);
+  ASSERT_EQ(taosArrayGetSize(((SWalSparseIdx*)taosArrayGetLast(pWal->pSparseIdx))->pOffsets), 2);
+  walSparseIdxTruncate(pWal, 50);
+  ASSERT_EQ(taosArrayGetSize(pWal->pSparseIdx), 1);
+}
+
 TEST_F(WalCleanEnv, rollback) {
   int code;
   for (int i = 0; i < 10; i++) {
@@ -323,6 +426,100 @@ TEST_F(WalCleanDeleteEnv, roll) {
   ASSERT_EQ(code, 0);
 }
 
+TEST_F(WalCleanDeleteEnv, segmentPool) {
+  int32_t oldPrealloc = tsWalPreallocSize;
+  tsWalPreallocSize = 1;
+
+  char    fnameStr[WAL_FILE_LEN];
+  int     code;
+  int64_t i;
+  for (i = 0; i < 100; i++) {
+    code = walWrite(pWal, i, 0, (void*)ranStr, ranStrLen);
+    ASSERT_EQ(code, 0);
+    walCommit(pWal, i);
+  }
+
+  // file 0 is rolled out and kept in the pool instead of being removed
+  ASSERT_EQ(walBeginSnapshot(pWal, i - 1, 0), 0);
+  ASSERT_EQ(walEndSnapshot(pWal), 0);
+  ASSERT_EQ(pWal->segPoolMask, 1);
+  walBuildLogName(pWal, 0, fnameStr);
+  ASSERT_FALSE(taosCheckExistFile(fnameStr));
+  walBuildPoolLogName(pWal, 0, fnameStr);
+  ASSERT_TRUE(taosCheckExistFile(fnameStr));
+
+  for (; i < 200; i++) {
+    code = walWrite(pWal, i, 0, (void*)ranStr, ranStrLen);
+    ASSERT_EQ(code, 0);
+    walCommit(pWal, i);
+  }
+
+  // the next roll takes the pooled segment
+  ASSERT_EQ(walBeginSnapshot(pWal, i - 1, 0), 0);
+  ASSERT_EQ(pWal->segPoolMask, 0);
+  walBuildLogName(pWal, 200, fnameStr);
+  int64_t size = -1;
+  ASSERT_EQ(taosStatFile(fnameStr, &size, NULL, NULL), 0);
+  ASSERT_EQ(size, 0);
+  ASSERT_EQ(walEndSnapshot(pWal), 0);
+  ASSERT_EQ(pWal->segPoolMask, 1);
+
+  code = walWrite(pWal, i, 0, (void*)ranStr, ranStrLen);
+  ASSERT_EQ(code, 0);
+  ASSERT_EQ(pWal->vers.lastVer, 200);
+
+  tsWalPreallocSize = oldPrealloc;
+}
+
+TEST_F(WalCleanDeleteEnv, segmentPoolReaderHeld) {
+  int32_t oldPrealloc = tsWalPreallocSize;
+  tsWalPreallocSize = 1;
+
+  char    fnameStr[WAL_FILE_LEN];
+  int     code;
+  int64_t i;
+  for (i = 0; i < 100; i++) {
+    code = walWrite(pWal, i, 0, (void*)ranStr, ranStrLen);
+    ASSERT_EQ(code, 0);
+    walCommit(pWal, i);
+  }
+
+  SWalReader* pRead = walOpenReader(pWal, NULL, 0);
+  ASSERT(pRead != NULL);
+  ASSERT_EQ(walReadVer(pRead, 5), 0);
+  ASSERT_EQ(pRead->curFileFirstVer, 0);
+  int64_t logSize = 0;
+  ASSERT_EQ(taosFStatFile(pRead->pLogFile, &logSize, NULL), 0);
+  ASSERT_GT(logSize, 0);
+
+  // file 0 is still open by the reader, it is removed instead of being truncated into the pool
+  ASSERT_EQ(walBeginSnapshot(pWal, i - 1, 0), 0);
+  ASSERT_EQ(walEndSnapshot(pWal), 0);
+  ASSERT_EQ(pWal->segPoolMask, 0);
+  walBuildLogName(pWal, 0, fnameStr);
+  ASSERT_FALSE(taosCheckExistFile(fnameStr));
+  walBuildPoolLogName(pWal, 0, fnameStr);
+  ASSERT_FALSE(taosCheckExistFile(fnameStr));
+
+  int64_t heldSize = 0;
+  ASSERT_EQ(taosFStatFile(pRead->pLogFile, &heldSize, NULL), 0);
+  ASSERT_EQ(heldSize, logSize);
+  walCloseReader(pRead);
+
+  for (; i < 200; i++) {
+    code = walWrite(pWal, i, 0, (void*)ranStr, ranStrLen);
+    ASSERT_EQ(code, 0);
+    walCommit(pWal, i);
+  }
+
+  // once released the segments are pooled again
+  ASSERT_EQ(walBeginSnapshot(pWal, i - 1, 0), 0);
+  ASSERT_EQ(walEndSnapshot(pWal), 0);
+  ASSERT_EQ(pWal->segPoolMask, 1);
+
+  tsWalPreallocSize = oldPrealloc;
+}
+
 TEST_F(WalKeepEnv, readHandleRead) {
   walResetEnv();
   int         code;
@@ -13,6 +13,9 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 #define ALLOW_FORBID_FUNC
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE  // O_DIRECT
+#endif
 #include "os.h"
 #include "osSemaphore.h"
 #include "zlib.h"
@@ -34,7 +37,9 @@
 
 #if !defined(_TD_DARWIN_64)
 #include <sys/sendfile.h>
+#include <sys/syscall.h>
 #endif
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #define LINUX_FILE_NO_TEXT_OPTION 0
@@ -651,6 +656,9 @@ int taosOpenFileNotStream(const char *path, int32_t tdFileOptions) {
   access |= (tdFileOptions & TD_FILE_TEXT) ? O_TEXT : 0;
   access |= (tdFileOptions & TD_FILE_EXCL) ? O_EXCL : 0;
   access |= (tdFileOptions & TD_FILE_CLOEXEC) ? O_CLOEXEC : 0;
+#ifdef O_DIRECT
+  access |= (tdFileOptions & TD_FILE_DIRECT) ? O_DIRECT : 0;
+#endif
 
   int fd = open(path, access, S_IRWXU | S_IRWXG | S_IRWXO);
   return fd;
@@ -1035,6 +1043,46 @@ bool lastErrorIsFileNotExist() { return errno == ENOENT; }
 
 #endif  // WINDOWS
 
+int64_t taosFCopyFileRange(TdFilePtr pFileOut, TdFilePtr pFileIn, int64_t *offset, int64_t size) {
+#if !defined(WINDOWS) && !defined(_TD_DARWIN_64) && defined(SYS_copy_file_range)
+  if (pFileOut == NULL || pFileIn == NULL) {
+    return 0;
+  }
+  ASSERT(pFileIn->fd >= 0 && pFileOut->fd >= 0);
+  if (pFileIn->fd < 0 || pFileOut->fd < 0) {
+    return 0;
+  }
+
+  int64_t leftbytes = size;
+  int64_t copybytes;
+
+  while (leftbytes > 0) {
+    // the kernel copies in-place (reflink or server-side copy when possible) without a trip through user space
+    copybytes = syscall(SYS_copy_file_range, pFileIn->fd, offset, pFileOut->fd, NULL, (size_t)leftbytes, 0);
+    if (copybytes == -1) {
+      if (errno == EINTR || errno == EAGAIN) {
+        continue;
+      } else if (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP) {
+        // not supported by kernel or file system, output position is kept so sendfile can take over
+        int64_t sentbytes = taosFSendFile(pFileOut, pFileIn, offset, leftbytes);
+        if (sentbytes < 0) return -1;
+        return size - leftbytes + sentbytes;
+      } else {
+        return -1;
+      }
+    } else if (copybytes == 0) {
+      return size - leftbytes;
+    }
+
+    leftbytes -= copybytes;
+  }
+
+  return size;
+#else
+  return taosFSendFile(pFileOut, pFileIn, offset, size);
+#endif
+}
+
 TdFilePtr taosOpenFile(const char *path, int32_t tdFileOptions) {
   FILE *fp = NULL;
 #ifdef WINDOWS
@@ -1194,6 +1242,81 @@ int32_t taosFsyncFile(TdFilePtr pFile) {
   return 0;
 }
 
+int32_t taosFdatasyncFile(TdFilePtr pFile) {
+  if (pFile == NULL) {
+    return 0;
+  }
+
+  if (pFile->fp != NULL) return fflush(pFile->fp);
+#ifdef WINDOWS
+  if (pFile->hFile != NULL) {
+    if (pFile->tdFileOptions & TD_FILE_WRITE_THROUGH) {
+      return 0;
+    }
+    return !FlushFileBuffers(pFile->hFile);
+#elif defined(_TD_DARWIN_64)
+  if (pFile->fd >= 0) {
+    return fsync(pFile->fd);
+#else
+  if (pFile->fd >= 0) {
+    return fdatasync(pFile->fd);
+#endif
+  }
+  return 0;
+}
+
+int32_t taosFallocateFile(TdFilePtr pFile, int64_t offset, int64_t len) {
+  if (pFile == NULL || len <= 0) {
+    return 0;
+  }
+
+#if defined(WINDOWS) || defined(_TD_DARWIN_64)
+  return 0;
+#else
+  ASSERT(pFile->fd >= 0);
+  if (pFile->fd < 0) {
+    return 0;
+  }
+  // reserve blocks without changing the file size, so appends and size based recovery keep working
+  int32_t code = fallocate(pFile->fd, FALLOC_FL_KEEP_SIZE, offset, len);
+  if (code < 0 && (errno == EOPNOTSUPP || errno == ENOSYS)) {
+    return 0;
+  }
+  return code;
+#endif
+}
+
+void *taosMmapReadOnlyFile(TdFilePtr pFile, int64_t size) {
+  if (pFile == NULL || size <= 0) {
+    return NULL;
+  }
+
+#ifdef WINDOWS
+  return NULL;
+#else
+  if (pFile->fd < 0) {
+    return NULL;
+  }
+  void *ptr = mmap(NULL, (size_t)size, PROT_READ, MAP_SHARED, pFile->fd, 0);
+  if (ptr == MAP_FAILED) {
+    return NULL;
+  }
+  return ptr;
+#endif
+}
+
+int32_t taosMunmapFile(void *ptr, int64_t size) {
+  if (ptr == NULL) {
+    return 0;
+  }
+
+#ifdef WINDOWS
+  return 0;
+#else
+  return munmap(ptr, (size_t)size);
+#endif
+}
+
 void taosFprintfFile(TdFilePtr pFile, const char *format, ...) {
   if (pFile == NULL || pFile->fp == NULL) {
     return;
@@ -168,6 +168,49 @@ TEST(osTest, osFile) {
   //printf("remove file success");
 }
 
+TEST(osTest, osFileCopyRange) {
+  char   *fnameFrom = "./osfilecopyfrom.txt";
+  char   *fnameTo = "./osfilecopyto.txt";
+  int64_t size = 1024 * 1024 + 17;
+  char   *buf = (char *)taosMemoryMalloc(size);
+  ASSERT_NE(buf, nullptr);
+  for (int64_t i = 0; i < size; ++i) {
+    buf[i] = (char)(i % 251);
+  }
+
+  TdFilePtr pFrom = taosOpenFile(fnameFrom, TD_FILE_WRITE | TD_FILE_CREATE | TD_FILE_TRUNC);
+  ASSERT_NE(pFrom, nullptr);
+  ASSERT_EQ(taosWriteFile(pFrom, buf, size), size);
+  taosCloseFile(&pFrom);
+
+  pFrom = taosOpenFile(fnameFrom, TD_FILE_READ);
+  ASSERT_NE(pFrom, nullptr);
+  TdFilePtr pTo = taosOpenFile(fnameTo, TD_FILE_WRITE | TD_FILE_CREATE | TD_FILE_TRUNC);
+  ASSERT_NE(pTo, nullptr);
+
+  // copy in two steps, the input offset is advanced and the output position follows
+  int64_t offset = 0;
+  ASSERT_EQ(taosFCopyFileRange(pTo, pFrom, &offset, 4096), 4096);
+  ASSERT_EQ(offset, 4096);
+  ASSERT_EQ(taosFCopyFileRange(pTo, pFrom, &offset, size - 4096), size - 4096);
+  ASSERT_EQ(offset, size);
+  taosCloseFile(&pFrom);
+  taosCloseFile(&pTo);
+
+  char *rbuf = (char *)taosMemoryMalloc(size);
+  ASSERT_NE(rbuf, nullptr);
+  pTo = taosOpenFile(fnameTo, TD_FILE_READ);
+  ASSERT_NE(pTo, nullptr);
+  ASSERT_EQ(taosReadFile(pTo, rbuf, size), size);
+  ASSERT_EQ(memcmp(buf, rbuf, size), 0);
+  taosCloseFile(&pTo);
+
+  taosMemoryFree(buf);
+  taosMemoryFree(rbuf);
+  taosRemoveFile(fnameFrom);
+  taosRemoveFile(fnameTo);
+}
+
 #ifndef OSFILE_PERFORMANCE_TEST
 
 #define MAX_WORDS          100